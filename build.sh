@@ -239,7 +239,7 @@ createassets() {
   #shellcheck disable=SC2086
   #shellcheck disable=SC2002
   cat $JSFILES >> "$MYMPD_BUILDDIR/htdocs/js/combined.js"
-  $ZIP "$MYMPD_BUILDDIR/htdocs/js/combined.js"
+  $ZIPCAT "$MYMPD_BUILDDIR/htdocs/js/combined.js" > "$MYMPD_BUILDDIR/htdocs/js/combined.js.gz"
 
   #serviceworker
   $ZIPCAT "$MYMPD_BUILDDIR/htdocs/sw.min.js" > "$MYMPD_BUILDDIR/htdocs/sw.js.gz"
@@ -257,7 +257,7 @@ createassets() {
   CSSFILES="dist/bootstrap/compiled/custom.css $MYMPD_BUILDDIR/htdocs/css/*.min.css"
   #shellcheck disable=SC2086
   cat $CSSFILES > "$MYMPD_BUILDDIR/htdocs/css/combined.css"
-  $ZIP "$MYMPD_BUILDDIR/htdocs/css/combined.css"
+  $ZIPCAT "$MYMPD_BUILDDIR/htdocs/css/combined.css" > "$MYMPD_BUILDDIR/htdocs/css/combined.css.gz"
 
   echo "Compressing i18n json"
   jq -r "select(.missingPhrases < 100) | keys[]" "$STARTPATH/src/i18n/json/i18n.json" | grep -v "default" | \
@@ -285,6 +285,35 @@ createassets() {
   cp -v dist/material-icons/MaterialIcons-Regular.woff2 "$MYMPD_BUILDDIR/htdocs/assets/"
   $ZIPCAT dist/material-icons/ligatures.json > "$MYMPD_BUILDDIR/htdocs/assets/ligatures.json.gz"
 
+  BROTLI_ASSETS="0"
+  if check_cmd_silent brotli
+  then
+    echo "Creating brotli compressed assets"
+    BROTLI_ASSETS="1"
+    for ASSET in index.html js/combined.js css/combined.css
+    do
+      if ! brotli -q 11 -c "$MYMPD_BUILDDIR/htdocs/$ASSET" > "$MYMPD_BUILDDIR/htdocs/$ASSET.br"
+      then
+        echo_warn "Creating $ASSET.br failed"
+        BROTLI_ASSETS="0"
+      fi
+    done
+    if [ "$BROTLI_ASSETS" = "0" ]
+    then
+      # embed all or none of the brotli variants
+      rm -f "$MYMPD_BUILDDIR/htdocs/index.html.br" "$MYMPD_BUILDDIR/htdocs/js/combined.js.br" \
+        "$MYMPD_BUILDDIR/htdocs/css/combined.css.br"
+    fi
+  else
+    echo "Skip creation of brotli compressed assets, brotli not found"
+  fi
+
+  create_etags
+  if [ "$BROTLI_ASSETS" = "1" ]
+  then
+    echo "#define MYMPD_EMBEDDED_BROTLI" >> "$MYMPD_BUILDDIR/htdocs/etags.h"
+  fi
+
   [ -z "${MYMPD_ENABLE_LUA+x}" ] && MYMPD_ENABLE_LUA="ON"
   if [ "${MYMPD_ENABLE_LUA}" = "on" ] || [ "${MYMPD_ENABLE_LUA}" = "ON" ]
   then
@@ -296,6 +325,19 @@ createassets() {
   return 0
 }
 
+create_etags() {
+  echo "Creating etags for embedded assets"
+  ETAGS_FILE="$MYMPD_BUILDDIR/htdocs/etags.h"
+  echo "//generated by build.sh, content hashes and brotli variants of the embedded assets" > "$ETAGS_FILE"
+  find "$MYMPD_BUILDDIR/htdocs" -type f \( -name "*.gz" -o -name "*.br" -o -name "*.png" -o -name "*.woff2" \) | sort | \
+    while read -r F
+    do
+      NAME=$(printf "%s" "${F#"$MYMPD_BUILDDIR/htdocs/"}" | tr -c "a-zA-Z0-9" "_")
+      HASH=$(sha1sum "$F" | cut -c1-16)
+      printf '#define ETAG_%s "\\"%s\\""\n' "$NAME" "$HASH" >> "$ETAGS_FILE"
+    done
+}
+
 lualibs() {
   [ -z "${MYMPD_ENABLE_MYGPIOD+x}" ] && MYMPD_ENABLE_MYGPIOD="OFF"
   [ -z "${MYMPD_BUILDDIR+x}" ] && MYMPD_BUILDDIR="release"
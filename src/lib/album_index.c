@@ -0,0 +1,477 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Inverted tag index for the album cache
+ */
+
+#include "compile_time.h"
+#include "src/lib/album_index.h"
+
+#include "src/lib/casefold.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/rax_extras.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/search.h"
+#include "src/lib/utility.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+/**
+ * The index maps case-folded tag values and their trigrams to sorted lists of album ids.
+ * Values are folded with casefold_cat, like the matcher folds them, so that the
+ * candidates are always a superset of the matching albums.
+ * The candidates are verified against compact album records, their interned tag
+ * values carry folded copies like the values of the song cache.
+ * Lookups return a superset of the matching albums, the caller must verify the
+ * candidates with search_expression_song.
+ */
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Length of the n-grams for the contains operator
+ */
+#define NGRAM_LEN 3
+
+static void index_add(rax *rt, sds key, unsigned id);
+static struct t_album_postings *lookup_tag(struct t_album_index *album_index, enum mpd_tag_type tag,
+        enum search_operators op, const char *value);
+static struct t_album_postings *lookup_any(struct t_album_index *album_index, enum search_operators op,
+        const char *value, const struct t_mpd_tags *any_tag_types);
+static struct t_album_postings *lookup_prefix(struct t_album_index *album_index, sds prefix);
+static struct t_album_postings *lookup_trigrams(struct t_album_index *album_index, sds lower, size_t offset);
+static struct t_album_postings *postings_new(void);
+static void postings_append(struct t_album_postings *postings, unsigned id);
+static struct t_album_postings *postings_copy(const struct t_album_postings *src);
+static struct t_album_postings *postings_intersect(struct t_album_postings *a, struct t_album_postings *b);
+static void postings_mark(const struct t_album_postings *postings, uint8_t *bits);
+static struct t_album_postings *postings_from_bits(const uint8_t *bits, unsigned len);
+static void free_postings_rax(rax *rt);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates the inverted index for the album cache
+ * @param album_cache album cache radix tree
+ * @return newly allocated album index
+ */
+struct t_album_index *album_index_new(rax *album_cache) {
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    struct t_album_index *album_index = malloc_assert(sizeof(struct t_album_index));
+    album_index->albums_len = 0;
+    album_index->albums = malloc_assert((size_t)(album_cache->numele + 1) * sizeof(struct mpd_song *));
+    album_index->records = malloc_assert((size_t)(album_cache->numele + 1) * sizeof(struct t_song_cache_song *));
+    album_index->strings = raxNew();
+    album_index->values = raxNew();
+    album_index->trigrams = raxNew();
+    struct t_mpd_tags all_tags;
+    all_tags.len = 0;
+    for (unsigned i = 0; i < MPD_TAG_COUNT; i++) {
+        all_tags.tags[all_tags.len++] = (enum mpd_tag_type)i;
+    }
+
+    sds key = sdsempty();
+    sds lower = sdsempty();
+    raxIterator iter;
+    raxStart(&iter, album_cache);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct mpd_song *album = (struct mpd_song *)iter.data;
+        unsigned id = album_index->albums_len++;
+        album_index->albums[id] = (struct mpd_song *)iter.data;
+        album_index->records[id] = song_cache_song_new(album_index->strings, album, &all_tags);
+        // index all tags of the album
+        for (unsigned i = 0; i < MPD_TAG_COUNT; i++) {
+            enum mpd_tag_type tag = (enum mpd_tag_type)i;
+            const char *value;
+            unsigned idx = 0;
+            while ((value = mpd_song_get_tag(album, tag, idx)) != NULL) {
+                idx++;
+                sdsclear(lower);
+                lower = casefold_cat(lower, value);
+                // full value
+                sdsclear(key);
+                key = sds_catchar(key, (char)tag);
+                key = sdscatsds(key, lower);
+                index_add(album_index->values, key, id);
+                // trigrams
+                size_t len = sdslen(lower);
+                for (size_t j = 0; j + NGRAM_LEN <= len; j++) {
+                    sdsclear(key);
+                    key = sds_catchar(key, (char)tag);
+                    key = sdscatlen(key, lower + j, NGRAM_LEN);
+                    index_add(album_index->trigrams, key, id);
+                }
+            }
+        }
+    }
+    raxStop(&iter);
+    FREE_SDS(key);
+    FREE_SDS(lower);
+    MYMPD_LOG_DEBUG(NULL, "Album index: %u albums, %" PRIu64 " values, %" PRIu64 " trigrams",
+        album_index->albums_len, album_index->values->numele, album_index->trigrams->numele);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(NULL, "Album index creation");
+    #endif
+    return album_index;
+}
+
+/**
+ * Frees the album index
+ * @param album_index pointer to album index
+ * @return NULL
+ */
+void *album_index_free(struct t_album_index *album_index) {
+    if (album_index == NULL) {
+        return NULL;
+    }
+    free_postings_rax(album_index->values);
+    free_postings_rax(album_index->trigrams);
+    for (unsigned i = 0; i < album_index->albums_len; i++) {
+        FREE_PTR(album_index->records[i]);
+    }
+    FREE_PTR(album_index->records);
+    rax_free_data(album_index->strings, NULL);
+    FREE_PTR(album_index->albums);
+    FREE_PTR(album_index);
+    return NULL;
+}
+
+/**
+ * Gets the candidate albums for a parsed search expression.
+ * Operators that can not be answered by the index are ignored,
+ * the caller must verify the candidates with search_expression_song.
+ * @param album_index pointer to album index
+ * @param expr_list expression list returned by parse_search_expression_to_list
+ * @param any_tag_types tags for special "any" tag in expression
+ * @return newly allocated sorted list of candidate album ids,
+ *         NULL if no part of the expression could be answered by the index
+ */
+struct t_album_postings *album_index_lookup(struct t_album_index *album_index, const struct t_list *expr_list,
+        const struct t_mpd_tags *any_tag_types)
+{
+    struct t_album_postings *result = NULL;
+    struct t_list_node *current = expr_list->head;
+    while (current != NULL) {
+        int tag;
+        enum search_operators op;
+        const char *value;
+        search_expression_get(current, &tag, &op, &value);
+        struct t_album_postings *matches = NULL;
+        if (tag == SEARCH_FILTER_ANY_TAG) {
+            matches = lookup_any(album_index, op, value, any_tag_types);
+        }
+        else if (tag >= 0) {
+            matches = lookup_tag(album_index, (enum mpd_tag_type)tag, op, value);
+        }
+        if (matches != NULL) {
+            result = result == NULL
+                ? matches
+                : postings_intersect(result, matches);
+            if (result->len == 0) {
+                break;
+            }
+        }
+        current = current->next;
+    }
+    return result;
+}
+
+/**
+ * Frees a postings list
+ * @param postings pointer to postings list
+ * @return NULL
+ */
+void *album_postings_free(struct t_album_postings *postings) {
+    if (postings == NULL) {
+        return NULL;
+    }
+    FREE_PTR(postings->ids);
+    FREE_PTR(postings);
+    return NULL;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Adds an album id to the postings list for key
+ * @param rt radix tree of postings lists
+ * @param key the key
+ * @param id album id
+ */
+static void index_add(rax *rt, sds key, unsigned id) {
+    void *data;
+    if (raxFind(rt, (unsigned char *)key, sdslen(key), &data) == 0) {
+        data = postings_new();
+        raxInsert(rt, (unsigned char *)key, sdslen(key), data, NULL);
+    }
+    postings_append((struct t_album_postings *)data, id);
+}
+
+/**
+ * Gets the candidate albums for an expression on a single tag
+ * @param album_index pointer to album index
+ * @param tag tag to match
+ * @param op search operator
+ * @param value value to match
+ * @return newly allocated postings list or NULL if the index can not answer the expression
+ */
+static struct t_album_postings *lookup_tag(struct t_album_index *album_index, enum mpd_tag_type tag,
+        enum search_operators op, const char *value)
+{
+    if (tag >= MPD_TAG_COUNT) {
+        return NULL;
+    }
+    sds lower = casefold_cat(sdsempty(), value);
+    sds key = sds_catchar(sdsempty(), (char)tag);
+    key = sdscatsds(key, lower);
+    FREE_SDS(lower);
+    struct t_album_postings *matches = NULL;
+    switch(op) {
+        case SEARCH_OP_EQUAL: {
+            void *data;
+            matches = raxFind(album_index->values, (unsigned char *)key, sdslen(key), &data) == 1
+                ? postings_copy((struct t_album_postings *)data)
+                : postings_new();
+            break;
+        }
+        case SEARCH_OP_STARTS_WITH:
+            matches = lookup_prefix(album_index, key);
+            break;
+        case SEARCH_OP_CONTAINS:
+            // tag byte + at least one trigram
+            if (sdslen(key) > NGRAM_LEN) {
+                matches = lookup_trigrams(album_index, key, 1);
+            }
+            break;
+        default:
+            break;
+    }
+    FREE_SDS(key);
+    return matches;
+}
+
+/**
+ * Gets the candidate albums for an expression on the special any tag
+ * @param album_index pointer to album index
+ * @param op search operator
+ * @param value value to match
+ * @param any_tag_types tags to search
+ * @return newly allocated postings list or NULL if the index can not answer the expression
+ */
+static struct t_album_postings *lookup_any(struct t_album_index *album_index, enum search_operators op,
+        const char *value, const struct t_mpd_tags *any_tag_types)
+{
+    uint8_t *bits = malloc_assert(album_index->albums_len / 8 + 1);
+    memset(bits, 0, album_index->albums_len / 8 + 1);
+    for (unsigned i = 0; i < any_tag_types->len; i++) {
+        struct t_album_postings *matches = lookup_tag(album_index, any_tag_types->tags[i], op, value);
+        if (matches == NULL) {
+            FREE_PTR(bits);
+            return NULL;
+        }
+        postings_mark(matches, bits);
+        album_postings_free(matches);
+    }
+    struct t_album_postings *result = postings_from_bits(bits, album_index->albums_len);
+    FREE_PTR(bits);
+    return result;
+}
+
+/**
+ * Gets the union of the postings lists of all values starting with prefix
+ * @param album_index pointer to album index
+ * @param prefix tag byte + case-folded prefix
+ * @return newly allocated postings list
+ */
+static struct t_album_postings *lookup_prefix(struct t_album_index *album_index, sds prefix) {
+    size_t prefix_len = sdslen(prefix);
+    uint8_t *bits = malloc_assert(album_index->albums_len / 8 + 1);
+    memset(bits, 0, album_index->albums_len / 8 + 1);
+    raxIterator iter;
+    raxStart(&iter, album_index->values);
+    raxSeek(&iter, ">=", (unsigned char *)prefix, prefix_len);
+    while (raxNext(&iter)) {
+        if (iter.key_len < prefix_len ||
+            memcmp(iter.key, prefix, prefix_len) != 0)
+        {
+            break;
+        }
+        postings_mark((struct t_album_postings *)iter.data, bits);
+    }
+    raxStop(&iter);
+    struct t_album_postings *result = postings_from_bits(bits, album_index->albums_len);
+    FREE_PTR(bits);
+    return result;
+}
+
+/**
+ * Gets the intersection of the postings lists of all trigrams of a value
+ * @param album_index pointer to album index
+ * @param lower tag byte + case-folded value
+ * @param offset start of the value in lower
+ * @return newly allocated postings list
+ */
+static struct t_album_postings *lookup_trigrams(struct t_album_index *album_index, sds lower, size_t offset) {
+    struct t_album_postings *result = NULL;
+    unsigned char key[NGRAM_LEN + 1];
+    key[0] = (unsigned char)lower[0];
+    size_t len = sdslen(lower);
+    for (size_t i = offset; i + NGRAM_LEN <= len; i++) {
+        memcpy(key + 1, lower + i, NGRAM_LEN);
+        void *data;
+        if (raxFind(album_index->trigrams, key, NGRAM_LEN + 1, &data) == 0) {
+            album_postings_free(result);
+            return postings_new();
+        }
+        struct t_album_postings *matches = postings_copy((struct t_album_postings *)data);
+        result = result == NULL
+            ? matches
+            : postings_intersect(result, matches);
+        if (result->len == 0) {
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * Creates an empty postings list
+ * @return newly allocated postings list
+ */
+static struct t_album_postings *postings_new(void) {
+    struct t_album_postings *postings = malloc_assert(sizeof(struct t_album_postings));
+    postings->len = 0;
+    postings->size = 0;
+    postings->ids = NULL;
+    return postings;
+}
+
+/**
+ * Appends an id to the postings list, ids must be appended in ascending order
+ * @param postings postings list
+ * @param id id to append
+ */
+static void postings_append(struct t_album_postings *postings, unsigned id) {
+    if (postings->len > 0 &&
+        postings->ids[postings->len - 1] == id)
+    {
+        return;
+    }
+    if (postings->len == postings->size) {
+        postings->size = postings->size == 0
+            ? 4
+            : postings->size * 2;
+        postings->ids = realloc_assert(postings->ids, postings->size * sizeof(unsigned));
+    }
+    postings->ids[postings->len++] = id;
+}
+
+/**
+ * Copies a postings list
+ * @param src postings list to copy
+ * @return newly allocated postings list
+ */
+static struct t_album_postings *postings_copy(const struct t_album_postings *src) {
+    struct t_album_postings *postings = postings_new();
+    if (src->len > 0) {
+        postings->ids = malloc_assert(src->len * sizeof(unsigned));
+        memcpy(postings->ids, src->ids, src->len * sizeof(unsigned));
+        postings->len = src->len;
+        postings->size = src->len;
+    }
+    return postings;
+}
+
+/**
+ * Intersects two postings lists, the result is written to a and b is freed
+ * @param a first postings list
+ * @param b second postings list
+ * @return pointer to a
+ */
+static struct t_album_postings *postings_intersect(struct t_album_postings *a, struct t_album_postings *b) {
+    unsigned i = 0;
+    unsigned j = 0;
+    unsigned len = 0;
+    while (i < a->len &&
+           j < b->len)
+    {
+        if (a->ids[i] < b->ids[j]) {
+            i++;
+        }
+        else if (a->ids[i] > b->ids[j]) {
+            j++;
+        }
+        else {
+            a->ids[len++] = a->ids[i];
+            i++;
+            j++;
+        }
+    }
+    a->len = len;
+    album_postings_free(b);
+    return a;
+}
+
+/**
+ * Sets the bits for all ids of the postings list
+ * @param postings postings list
+ * @param bits bitset
+ */
+static void postings_mark(const struct t_album_postings *postings, uint8_t *bits) {
+    for (unsigned i = 0; i < postings->len; i++) {
+        bits[postings->ids[i] / 8] |= (uint8_t)(1U << (postings->ids[i] % 8));
+    }
+}
+
+/**
+ * Creates a postings list from a bitset
+ * @param bits bitset
+ * @param len number of bits
+ * @return newly allocated postings list
+ */
+static struct t_album_postings *postings_from_bits(const uint8_t *bits, unsigned len) {
+    struct t_album_postings *postings = postings_new();
+    for (unsigned id = 0; id < len; id++) {
+        if (bits[id / 8] == 0) {
+            // skip empty bytes
+            id += 7 - id % 8;
+            continue;
+        }
+        if ((bits[id / 8] & (1U << (id % 8))) != 0) {
+            postings_append(postings, id);
+        }
+    }
+    return postings;
+}
+
+/**
+ * Frees a radix tree with postings lists
+ * @param rt radix tree
+ */
+static void free_postings_rax(rax *rt) {
+    raxIterator iter;
+    raxStart(&iter, rt);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        album_postings_free((struct t_album_postings *)iter.data);
+    }
+    raxStop(&iter);
+    raxFree(rt);
+}
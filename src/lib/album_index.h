@@ -0,0 +1,56 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Inverted tag index for the album cache
+ */
+
+#ifndef MYMPD_ALBUM_INDEX_H
+#define MYMPD_ALBUM_INDEX_H
+
+#include "dist/libmympdclient/include/mpd/client.h"
+#include "dist/rax/rax.h"
+#include "src/lib/cache_rax_song.h"
+#include "src/lib/fields.h"
+#include "src/lib/list.h"
+
+/**
+ * Sorted list of album ids
+ */
+struct t_album_postings {
+    unsigned len;   //!< number of ids
+    unsigned size;  //!< allocated number of ids
+    unsigned *ids;  //!< album ids in ascending order
+};
+
+/**
+ * Inverted index for the album cache.
+ * The album id is the position of the album in the album cache.
+ */
+struct t_album_index {
+    unsigned albums_len;        //!< number of albums
+    struct mpd_song **albums;   //!< maps the album id to the album
+    struct t_song_cache_song **records;  //!< maps the album id to a record with folded tag values
+    rax *strings;               //!< interned tag values of the records
+    rax *values;                //!< tag byte + case-folded value -> struct t_album_postings
+    rax *trigrams;              //!< tag byte + case-folded trigram -> struct t_album_postings
+};
+
+/**
+ * Album cache with its index, handed over from the mpd_worker to the mympd_api thread
+ */
+struct t_album_cache_update {
+    rax *album_cache;                   //!< the new album cache
+    struct t_album_index *album_index;  //!< index for the new album cache
+};
+
+struct t_album_index *album_index_new(rax *album_cache);
+void *album_index_free(struct t_album_index *album_index);
+struct t_album_postings *album_index_lookup(struct t_album_index *album_index, const struct t_list *expr_list,
+        const struct t_mpd_tags *any_tag_types);
+void *album_postings_free(struct t_album_postings *postings);
+
+#endif
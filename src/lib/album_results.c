@@ -0,0 +1,96 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief LRU cache for sorted album list results
+ */
+
+#include "compile_time.h"
+#include "src/lib/album_results.h"
+
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds_extras.h"
+
+#include <limits.h>
+
+/**
+ * The LRU is a list with the most recently used result at the head.
+ * The results reference albums from the album cache, the list must be
+ * cleared before the album cache is replaced.
+ */
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates the lookup key for an album list result
+ * @param key already allocated sds string to append the key
+ * @param expression mpd search expression
+ * @param sort_by sort type
+ * @param sort_tag tag to sort by
+ * @param any_tag_types tags for special "any" tag in expression
+ * @return pointer to key
+ */
+sds album_results_key(sds key, const char *expression, enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
+        const struct t_mpd_tags *any_tag_types)
+{
+    key = sdscatfmt(key, "%i:%i:", (int)sort_by, (int)sort_tag);
+    for (unsigned i = 0; i < any_tag_types->len; i++) {
+        key = sdscatfmt(key, "%i,", (int)any_tag_types->tags[i]);
+    }
+    key = sdscatfmt(key, ":%s", expression);
+    return key;
+}
+
+/**
+ * Gets a result from the LRU and marks it as most recently used
+ * @param lru the lru list
+ * @param key lookup key
+ * @return the result or NULL if not found
+ */
+const struct t_album_results *album_results_get(struct t_list *lru, const char *key) {
+    unsigned idx = list_get_node_idx(lru, key);
+    if (idx == UINT_MAX) {
+        return NULL;
+    }
+    if (idx > 0) {
+        list_move_item_pos(lru, idx, 0);
+    }
+    return (const struct t_album_results *)lru->head->user_data;
+}
+
+/**
+ * Adds a result to the LRU and evicts the least recently used result
+ * @param lru the lru list
+ * @param key lookup key
+ * @param albums sorted album list, data must be the album
+ * @return the added result
+ */
+const struct t_album_results *album_results_add(struct t_list *lru, const char *key, rax *albums) {
+    struct t_album_results *results = malloc_assert(sizeof(struct t_album_results) + albums->numele * sizeof(struct mpd_song *));
+    results->len = 0;
+    raxIterator iter;
+    raxStart(&iter, albums);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        results->albums[results->len++] = (struct mpd_song *)iter.data;
+    }
+    raxStop(&iter);
+    list_insert(lru, key, 0, NULL, results);
+    list_crop(lru, ALBUM_RESULTS_CACHE_MAX, list_free_cb_ptr_user_data);
+    return results;
+}
+
+/**
+ * Clears the LRU
+ * @param lru the lru list
+ */
+void album_results_clear(struct t_list *lru) {
+    MYMPD_LOG_DEBUG(NULL, "Clearing album list results");
+    list_clear_user_data(lru, list_free_cb_ptr_user_data);
+}
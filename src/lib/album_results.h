@@ -0,0 +1,34 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief LRU cache for sorted album list results
+ */
+
+#ifndef MYMPD_ALBUM_RESULTS_H
+#define MYMPD_ALBUM_RESULTS_H
+
+#include "dist/libmympdclient/include/mpd/client.h"
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/fields.h"
+#include "src/lib/list.h"
+
+/**
+ * Sorted album list result
+ */
+struct t_album_results {
+    unsigned len;                 //!< number of albums
+    struct mpd_song *albums[];    //!< albums in ascending sort order, pointers into the album cache
+};
+
+sds album_results_key(sds key, const char *expression, enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
+        const struct t_mpd_tags *any_tag_types);
+const struct t_album_results *album_results_get(struct t_list *lru, const char *key);
+const struct t_album_results *album_results_add(struct t_list *lru, const char *key, rax *albums);
+void album_results_clear(struct t_list *lru);
+
+#endif
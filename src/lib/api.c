@@ -16,6 +16,9 @@
 #include "src/lib/msg_queue.h"
 #include "src/lib/sds_extras.h"
 
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 /**
@@ -23,15 +26,79 @@
  */
 static const char *mympd_cmd_strs[] = { MYMPD_CMDS(GEN_STR) };
 
+/**
+ * myMPD API method ids sorted by name for the binary search in get_cmd_id
+ */
+static enum mympd_cmd_ids mympd_cmd_sorted[TOTAL_API_COUNT];
+
+/**
+ * Size of the bitsets indexed by the myMPD API method ids
+ */
+#define CMD_BITSET_SIZE (TOTAL_API_COUNT / 8 + 1)
+
+/**
+ * Methods that are accessible through the http api
+ */
+static uint8_t mympd_cmd_public[CMD_BITSET_SIZE];
+
+/**
+ * Methods that need authentication if a pin is set
+ */
+static uint8_t mympd_cmd_protected[CMD_BITSET_SIZE];
+
+/**
+ * Methods that are accessible by scripts
+ */
+static uint8_t mympd_cmd_script[CMD_BITSET_SIZE];
+
+/**
+ * Guard for the one time initialization of the lookup tables
+ */
+static pthread_once_t mympd_cmd_tables_once = PTHREAD_ONCE_INIT;
+
+/**
+ * State of the streamed response of the current thread
+ */
+struct t_response_stream {
+    bool enabled;                //!< true if the current response can be streamed
+    unsigned long conn_id;       //!< mongoose connection id
+    unsigned id;                 //!< the jsonrpc id
+    enum mympd_cmd_ids cmd_id;   //!< the jsonrpc method as enum
+    const char *partition;       //!< mpd partition
+    bool started;                //!< true if a chunk was pushed
+    bool aborted;                //!< true if the response can not be finished
+};
+
+/**
+ * Streamed response, only the myMPD API thread enables it
+ */
+static _Thread_local struct t_response_stream response_stream;
+
+static void cmd_tables_init(void);
+static int cmd_sorted_cmp(const void *a, const void *b);
+static void cmd_bitset_set(uint8_t *bitset, enum mympd_cmd_ids cmd_id);
+static bool cmd_bitset_get(const uint8_t *bitset, enum mympd_cmd_ids cmd_id);
+
 /**
  * Converts a string to the mympd_cmd_ids enum
  * @param cmd string to convert
  * @return enum mympd_cmd_ids
  */
 enum mympd_cmd_ids get_cmd_id(const char *cmd) {
-    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
-        if (strcmp(cmd, mympd_cmd_strs[i]) == 0) {
-            return i;
+    pthread_once(&mympd_cmd_tables_once, cmd_tables_init);
+    unsigned low = 0;
+    unsigned high = TOTAL_API_COUNT;
+    while (low < high) {
+        unsigned mid = low + (high - low) / 2;
+        int rc = strcmp(cmd, mympd_cmd_strs[mympd_cmd_sorted[mid]]);
+        if (rc == 0) {
+            return mympd_cmd_sorted[mid];
+        }
+        if (rc < 0) {
+            high = mid;
+        }
+        else {
+            low = mid + 1;
         }
     }
     return GENERAL_API_UNKNOWN;
@@ -55,50 +122,18 @@ const char *get_cmd_id_method_name(enum mympd_cmd_ids cmd_id) {
  * @return true if protected else false
  */
 bool is_protected_api_method(enum mympd_cmd_ids cmd_id) {
-    switch(cmd_id) {
-        case MYMPD_API_CONNECTION_SAVE:
-        case MYMPD_API_CACHE_DISK_CLEAR:
-        case MYMPD_API_CACHE_DISK_CROP:
-        case MYMPD_API_MOUNT_MOUNT:
-        case MYMPD_API_MOUNT_UNMOUNT:
-        case MYMPD_API_PARTITION_NEW:
-        case MYMPD_API_PARTITION_RM:
-        case MYMPD_API_PARTITION_SAVE:
-        case MYMPD_API_PARTITION_OUTPUT_MOVE:
-        case MYMPD_API_PLAYER_OUTPUT_ATTRIBUTES_SET:
-        case MYMPD_API_PLAYLIST_RM_ALL:
-        case MYMPD_API_SESSION_LOGOUT:
-        case MYMPD_API_SESSION_VALIDATE:
-        case MYMPD_API_SETTINGS_SET:
-        case MYMPD_API_SCRIPT_RM:
-        case MYMPD_API_SCRIPT_SAVE:
-        case MYMPD_API_TIMER_RM:
-        case MYMPD_API_TIMER_SAVE:
-        case MYMPD_API_TIMER_TOGGLE:
-        case MYMPD_API_TRIGGER_RM:
-        case MYMPD_API_TRIGGER_SAVE:
-        case MYMPD_API_LOGLEVEL:
-        case MYMPD_API_SCRIPT_VAR_DELETE:
-        case MYMPD_API_SCRIPT_VAR_LIST:
-        case MYMPD_API_SCRIPT_VAR_SET:
-            return true;
-        default:
-            return false;
-    }
+    pthread_once(&mympd_cmd_tables_once, cmd_tables_init);
+    return cmd_bitset_get(mympd_cmd_protected, cmd_id);
 }
 
 /**
- * Defines methods that are public
+ * Defines methods that are accessible by the http api
  * @param cmd_id myMPD API method
  * @return true if public else false
  */
 bool is_public_api_method(enum mympd_cmd_ids cmd_id) {
-    if (cmd_id <= INTERNAL_API_COUNT ||
-        cmd_id >= TOTAL_API_COUNT)
-    {
-        return false;
-    }
-    return true;
+    pthread_once(&mympd_cmd_tables_once, cmd_tables_init);
+    return cmd_bitset_get(mympd_cmd_public, cmd_id);
 }
 
 /**
@@ -107,19 +142,8 @@ bool is_public_api_method(enum mympd_cmd_ids cmd_id) {
  * @return true if public else false
  */
 bool is_script_api_method(enum mympd_cmd_ids cmd_id) {
-    switch(cmd_id) {
-        case INTERNAL_API_SCRIPT_INIT:
-        case INTERNAL_API_JUKEBOX_CREATED:
-        case INTERNAL_API_JUKEBOX_ERROR:
-            return true;
-        default:
-        if (cmd_id <= INTERNAL_API_COUNT ||
-            cmd_id >= TOTAL_API_COUNT)
-        {
-            return false;
-        }
-    }
-    return true;
+    pthread_once(&mympd_cmd_tables_once, cmd_tables_init);
+    return cmd_bitset_get(mympd_cmd_script, cmd_id);
 }
 
 /**
@@ -146,6 +170,8 @@ bool is_mympd_only_api_method(enum mympd_cmd_ids cmd_id) {
     switch(cmd_id) {
         case INTERNAL_API_ALBUMCACHE_SKIPPED:
         case INTERNAL_API_ALBUMCACHE_ERROR:
+        case INTERNAL_API_CACHE_DISK_NEGATIVE_CLEAR:
+        case INTERNAL_API_SONGCACHE_CREATED:
         case INTERNAL_API_JUKEBOX_REFILL:
         case INTERNAL_API_JUKEBOX_REFILL_ADD:
         case INTERNAL_API_WEBRADIODB_CREATED:
@@ -202,6 +228,7 @@ bool is_mympd_only_api_method(enum mympd_cmd_ids cmd_id) {
  */
 bool is_mpdworker_only_api_method(enum mympd_cmd_ids cmd_id) {
     switch(cmd_id) {
+        case INTERNAL_API_CACHE_DISK_NEGATIVE_CLEAR:
         case MYMPD_API_CACHE_DISK_CLEAR:
         case MYMPD_API_CACHE_DISK_CROP:
         case MYMPD_API_WEBRADIODB_UPDATE:
@@ -211,6 +238,47 @@ bool is_mpdworker_only_api_method(enum mympd_cmd_ids cmd_id) {
     }
 }
 
+/**
+ * Checks if the method is read-only and can be handled by the mpd_worker pool
+ * @param cmd_id method id
+ * @return true if method can be handled by the pool, else false
+ */
+bool is_mpd_worker_pool_api_method(enum mympd_cmd_ids cmd_id) {
+    switch(cmd_id) {
+        case MYMPD_API_DATABASE_FILESYSTEM_LIST:
+        case MYMPD_API_DATABASE_SEARCH:
+        case MYMPD_API_DATABASE_TAG_LIST:
+        case MYMPD_API_PLAYLIST_CONTENT_LIST:
+        case MYMPD_API_PLAYLIST_LIST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Checks if the request should be routed to the mpd_worker pool.
+ * Only requests from the webserver are routed, a search and the tag list
+ * stay on the mympd_api thread if the song cache is loaded.
+ * @param request the work request
+ * @param song_cache true if the song cache is loaded
+ * @return true if the request should be handled by the pool, else false
+ */
+bool is_mpd_worker_pool_request(struct t_work_request *request, bool song_cache) {
+    if (request->type != REQUEST_TYPE_DEFAULT ||
+        is_mpd_worker_pool_api_method(request->cmd_id) == false)
+    {
+        return false;
+    }
+    if ((request->cmd_id == MYMPD_API_DATABASE_SEARCH || request->cmd_id == MYMPD_API_DATABASE_TAG_LIST) &&
+        song_cache == true)
+    {
+        // searching the song cache is faster
+        return false;
+    }
+    return true;
+}
+
 /**
  * Sends a websocket message to all clients in a partition
  * @param message the message to send
@@ -325,6 +393,14 @@ void free_request(struct t_work_request *request) {
     }
 }
 
+/**
+ * Callback function to free user_data of type t_work_request.
+ * @param current list node
+ */
+void list_free_cb_request_user_data(struct t_list_node *current) {
+    free_request((struct t_work_request *)current->user_data);
+}
+
 /**
  * Frees the response struct
  * @param response response struct to free
@@ -344,6 +420,13 @@ void free_response(struct t_work_response *response) {
  * @return true on success, else false
  */
 bool push_response(struct t_work_response *response) {
+    if (response->type == RESPONSE_TYPE_DEFAULT &&
+        response_stream.aborted == true &&
+        response->conn_id == response_stream.conn_id)
+    {
+        MYMPD_LOG_WARN(response->partition, "Aborting streamed response for connection %lu", response->conn_id);
+        response->type = RESPONSE_TYPE_ABORT;
+    }
     switch(response->type) {
         case RESPONSE_TYPE_DEFAULT:
         case RESPONSE_TYPE_NOTIFY_CLIENT:
@@ -356,6 +439,12 @@ bool push_response(struct t_work_response *response) {
         case RESPONSE_TYPE_RAW:
             MYMPD_LOG_DEBUG(NULL, "Push raw response to webserver queue for connection %lu with %lu bytes", response->conn_id, (unsigned long)sdslen(response->data));
             return mympd_queue_push(web_server_queue, response, 0);
+        case RESPONSE_TYPE_CHUNK:
+            MYMPD_LOG_DEBUG(NULL, "Push response chunk to webserver queue for connection %lu with %lu bytes", response->conn_id, (unsigned long)sdslen(response->data));
+            return mympd_queue_push(web_server_queue, response, 0);
+        case RESPONSE_TYPE_ABORT:
+            MYMPD_LOG_DEBUG(NULL, "Push response abort to webserver queue for connection %lu", response->conn_id);
+            return mympd_queue_push(web_server_queue, response, 0);
         case RESPONSE_TYPE_SCRIPT:
             #ifdef MYMPD_ENABLE_LUA
                 MYMPD_LOG_DEBUG(NULL, "Push response to script_worker_queue for thread %u: %s", response->id, response->data);
@@ -401,3 +490,153 @@ bool push_request(struct t_work_request *request, unsigned id) {
             return mympd_queue_push(mympd_api_queue, request, id);
     }
 }
+
+/**
+ * Enables streaming of the response for this request.
+ * Only responses for http connections are streamed.
+ * @param request the request that is handled
+ */
+void response_stream_begin(struct t_work_request *request) {
+    response_stream.enabled = request->type == REQUEST_TYPE_DEFAULT &&
+        request->conn_id > 0;
+    response_stream.conn_id = request->conn_id;
+    response_stream.id = request->id;
+    response_stream.cmd_id = request->cmd_id;
+    response_stream.partition = request->partition;
+    response_stream.started = false;
+    response_stream.aborted = false;
+}
+
+/**
+ * Disables streaming of the response
+ */
+void response_stream_end(void) {
+    response_stream.enabled = false;
+    response_stream.partition = NULL;
+    response_stream.started = false;
+    response_stream.aborted = false;
+}
+
+/**
+ * Pushes the buffer as a chunk of the response to the webserver,
+ * if streaming is enabled and the buffer has reached HTTP_CHUNK_SIZE.
+ * The response must be finished with a RESPONSE_TYPE_DEFAULT response.
+ * @param buffer buffer with the already printed part of the response
+ * @return pointer to buffer or a new empty buffer if the chunk was pushed
+ */
+sds response_stream_flush(sds buffer) {
+    if (response_stream.enabled == false ||
+        sdslen(buffer) < HTTP_CHUNK_SIZE)
+    {
+        return buffer;
+    }
+    struct t_work_response *response = create_response_new(RESPONSE_TYPE_CHUNK, response_stream.conn_id,
+        response_stream.id, response_stream.cmd_id, response_stream.partition);
+    FREE_SDS(response->data);
+    response->data = buffer;
+    push_response(response);
+    response_stream.started = true;
+    return sdsMakeRoomFor(sdsempty(), HTTP_CHUNK_SIZE);
+}
+
+/**
+ * Marks the streamed response as aborted, if chunks were already pushed.
+ * The already sent part can not be replaced by an error response,
+ * the final response closes the connection instead.
+ * @return true if the response is aborted, false if nothing was streamed
+ */
+bool response_stream_abort(void) {
+    if (response_stream.started == false) {
+        return false;
+    }
+    response_stream.aborted = true;
+    return true;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Initializes the lookup tables for the myMPD API methods
+ */
+static void cmd_tables_init(void) {
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        mympd_cmd_sorted[i] = (enum mympd_cmd_ids)i;
+    }
+    qsort(mympd_cmd_sorted, TOTAL_API_COUNT, sizeof(enum mympd_cmd_ids), cmd_sorted_cmp);
+
+    // all methods above INTERNAL_API_COUNT are public and accessible by scripts
+    for (unsigned i = INTERNAL_API_COUNT + 1; i < TOTAL_API_COUNT; i++) {
+        cmd_bitset_set(mympd_cmd_public, (enum mympd_cmd_ids)i);
+        cmd_bitset_set(mympd_cmd_script, (enum mympd_cmd_ids)i);
+    }
+    // internal methods for scripts
+    cmd_bitset_set(mympd_cmd_script, INTERNAL_API_SCRIPT_INIT);
+    cmd_bitset_set(mympd_cmd_script, INTERNAL_API_JUKEBOX_CREATED);
+    cmd_bitset_set(mympd_cmd_script, INTERNAL_API_JUKEBOX_ERROR);
+
+    static const enum mympd_cmd_ids protected_cmds[] = {
+        MYMPD_API_CONNECTION_SAVE,
+        MYMPD_API_CACHE_DISK_CLEAR,
+        MYMPD_API_CACHE_DISK_CROP,
+        MYMPD_API_MOUNT_MOUNT,
+        MYMPD_API_MOUNT_UNMOUNT,
+        MYMPD_API_PARTITION_NEW,
+        MYMPD_API_PARTITION_RM,
+        MYMPD_API_PARTITION_SAVE,
+        MYMPD_API_PARTITION_OUTPUT_MOVE,
+        MYMPD_API_PLAYER_OUTPUT_ATTRIBUTES_SET,
+        MYMPD_API_PLAYLIST_RM_ALL,
+        MYMPD_API_SESSION_LOGOUT,
+        MYMPD_API_SESSION_VALIDATE,
+        MYMPD_API_SETTINGS_SET,
+        MYMPD_API_SCRIPT_RM,
+        MYMPD_API_SCRIPT_SAVE,
+        MYMPD_API_TIMER_RM,
+        MYMPD_API_TIMER_SAVE,
+        MYMPD_API_TIMER_TOGGLE,
+        MYMPD_API_TRIGGER_RM,
+        MYMPD_API_TRIGGER_SAVE,
+        MYMPD_API_LOGLEVEL,
+        MYMPD_API_SCRIPT_VAR_DELETE,
+        MYMPD_API_SCRIPT_VAR_LIST,
+        MYMPD_API_SCRIPT_VAR_SET,
+    };
+    for (size_t i = 0; i < sizeof(protected_cmds) / sizeof(protected_cmds[0]); i++) {
+        cmd_bitset_set(mympd_cmd_protected, protected_cmds[i]);
+    }
+}
+
+/**
+ * Compares two myMPD API method ids by name
+ * @param a pointer to first id
+ * @param b pointer to second id
+ * @return strcmp result of the names
+ */
+static int cmd_sorted_cmp(const void *a, const void *b) {
+    return strcmp(mympd_cmd_strs[*(const enum mympd_cmd_ids *)a],
+        mympd_cmd_strs[*(const enum mympd_cmd_ids *)b]);
+}
+
+/**
+ * Sets the bit for a myMPD API method
+ * @param bitset bitset to modify
+ * @param cmd_id myMPD API method
+ */
+static void cmd_bitset_set(uint8_t *bitset, enum mympd_cmd_ids cmd_id) {
+    bitset[cmd_id / 8] |= (uint8_t)(1U << (cmd_id % 8));
+}
+
+/**
+ * Gets the bit for a myMPD API method
+ * @param bitset bitset to check
+ * @param cmd_id myMPD API method
+ * @return true if the bit is set, else false
+ */
+static bool cmd_bitset_get(const uint8_t *bitset, enum mympd_cmd_ids cmd_id) {
+    if (cmd_id >= TOTAL_API_COUNT) {
+        return false;
+    }
+    return (bitset[cmd_id / 8] & (1U << (cmd_id % 8))) != 0;
+}
@@ -30,6 +30,8 @@
     X(INTERNAL_API_ALBUMCACHE_CREATED) \
     X(INTERNAL_API_ALBUMCACHE_ERROR) \
     X(INTERNAL_API_ALBUMCACHE_SKIPPED) \
+    X(INTERNAL_API_CACHE_DISK_NEGATIVE_CLEAR) \
+    X(INTERNAL_API_SONGCACHE_CREATED) \
     X(INTERNAL_API_JUKEBOX_CREATED) \
     X(INTERNAL_API_JUKEBOX_ERROR) \
     X(INTERNAL_API_JUKEBOX_REFILL) \
@@ -268,7 +270,9 @@ enum work_response_types {
     RESPONSE_TYPE_DISCARD,           //!< Response will be discarded
     RESPONSE_TYPE_RAW,               //!< Raw http message
     RESPONSE_TYPE_SCRIPT_DIALOG,     //!< Script dialog
-    RESPONSE_TYPE_REDIRECT           //!< Send a redirect
+    RESPONSE_TYPE_REDIRECT,          //!< Send a redirect
+    RESPONSE_TYPE_CHUNK,             //!< Part of a streamed api response, the RESPONSE_TYPE_DEFAULT response ends it
+    RESPONSE_TYPE_ABORT              //!< Aborts a streamed api response by closing the connection
 };
 
 /**
@@ -334,6 +338,8 @@ bool is_public_api_method(enum mympd_cmd_ids cmd_id);
 bool is_script_api_method(enum mympd_cmd_ids cmd_id);
 bool is_mympd_only_api_method(enum mympd_cmd_ids cmd_id);
 bool is_mpdworker_only_api_method(enum mympd_cmd_ids cmd_id);
+bool is_mpd_worker_pool_api_method(enum mympd_cmd_ids cmd_id);
+bool is_mpd_worker_pool_request(struct t_work_request *request, bool song_cache);
 void ws_notify(sds message, const char *partition);
 void ws_notify_client(sds message, unsigned request_id);
 void ws_script_dialog(sds message, unsigned request_id);
@@ -343,8 +349,13 @@ struct t_work_response *create_response_new(enum work_response_types type, unsig
 struct t_work_request *create_request(enum work_request_types type, unsigned long conn_id,
         unsigned request_id, enum mympd_cmd_ids cmd_id, const char *data, const char *partition);
 void free_request(struct t_work_request *request);
+void list_free_cb_request_user_data(struct t_list_node *current);
 void free_response(struct t_work_response *response);
 bool push_response(struct t_work_response *response);
 bool push_request(struct t_work_request *request, unsigned id);
+void response_stream_begin(struct t_work_request *request);
+void response_stream_end(void);
+sds response_stream_flush(sds buffer);
+bool response_stream_abort(void);
 
 #endif
@@ -15,15 +15,18 @@
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
 #include "src/lib/sds_extras.h"
+#include "src/lib/utility.h"
 
 #include <dirent.h>
 #include <errno.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <time.h>
 
 // private definitions
 
 static int crop_dir(sds cache_basedir, const char *type, int keepdays);
+static int clear_negative_dir(sds cache_basedir, const char *type);
 
 // public functions
 
@@ -55,6 +58,106 @@ void cache_disk_crop(struct t_config *config) {
     crop_dir(config->cachedir, DIR_CACHE_MISC, config->cache_misc_keep_days);
 }
 
+/**
+ * Returns the filename of the negative cache entry for an uri.
+ * A negative cache entry is an empty file that marks an unsuccessful lookup,
+ * it expires with the other files of the cache type.
+ * @param cachedir cache directory
+ * @param type cache subdir
+ * @param uri uri of the song
+ * @param offset number of the image, 0 for lyrics
+ * @return path as newly allocated sds string
+ */
+sds cache_disk_negative_get_name(const char *cachedir, const char *type, const char *uri, int offset) {
+    sds filename = sds_hash_sha1(uri);
+    sds filepath = sdscatfmt(sdsempty(), "%s/%s/%S-%i.none", cachedir, type, filename, offset);
+    FREE_SDS(filename);
+    return filepath;
+}
+
+/**
+ * Checks for a valid negative cache entry.
+ * The entry is stale if the media file or its directory was modified after it was written,
+ * stale entries are removed.
+ * @param cachedir cache directory
+ * @param type cache subdir
+ * @param uri uri of the song
+ * @param offset number of the image, 0 for lyrics
+ * @param media_file full path of the song, NULL to check only the existence of the entry
+ * @return true if a valid negative cache entry exists, else false
+ */
+bool cache_disk_negative_check(const char *cachedir, const char *type, const char *uri, int offset, const char *media_file) {
+    sds filepath = cache_disk_negative_get_name(cachedir, type, uri, offset);
+    time_t mtime = get_mtime(filepath);
+    if (mtime == 0) {
+        FREE_SDS(filepath);
+        return false;
+    }
+    bool valid = true;
+    if (media_file != NULL) {
+        sds media_dir = sds_dirname(sdsnew(media_file));
+        if (get_mtime(media_file) > mtime ||
+            get_mtime(media_dir) > mtime)
+        {
+            MYMPD_LOG_DEBUG(NULL, "Removing stale negative %s cache entry for \"%s\"", type, uri);
+            rm_file(filepath);
+            valid = false;
+        }
+        FREE_SDS(media_dir);
+    }
+    if (valid == true) {
+        MYMPD_LOG_DEBUG(NULL, "Found negative %s cache entry for \"%s\"", type, uri);
+    }
+    FREE_SDS(filepath);
+    return valid;
+}
+
+/**
+ * Writes a negative cache entry
+ * @param cachedir cache directory
+ * @param type cache subdir
+ * @param uri uri of the song
+ * @param offset number of the image, 0 for lyrics
+ * @return true on success, else false
+ */
+bool cache_disk_negative_write(const char *cachedir, const char *type, const char *uri, int offset) {
+    sds filepath = cache_disk_negative_get_name(cachedir, type, uri, offset);
+    MYMPD_LOG_DEBUG(NULL, "Writing negative %s cache entry for \"%s\"", type, uri);
+    bool rc = write_data_to_file(filepath, "", 0);
+    FREE_SDS(filepath);
+    return rc;
+}
+
+/**
+ * Removes a negative cache entry, if it exists
+ * @param cachedir cache directory
+ * @param type cache subdir
+ * @param uri uri of the song
+ * @param offset number of the image, 0 for lyrics
+ */
+void cache_disk_negative_remove(const char *cachedir, const char *type, const char *uri, int offset) {
+    sds filepath = cache_disk_negative_get_name(cachedir, type, uri, offset);
+    try_rm_file(filepath);
+    FREE_SDS(filepath);
+}
+
+/**
+ * Removes all negative cover and lyrics cache entries.
+ * Without access to the music directory the entries can not be validated
+ * against the media files, they are removed after each database change.
+ * @param config pointer to static config
+ */
+void cache_disk_negative_clear(struct t_config *config) {
+    if (config->cache_cover_keep_days != CACHE_DISK_DISABLED) {
+        clear_negative_dir(config->cachedir, DIR_CACHE_COVER);
+    }
+    if (config->cache_lyrics_keep_days != CACHE_DISK_DISABLED) {
+        clear_negative_dir(config->cachedir, DIR_CACHE_LYRICS);
+    }
+}
+
+// private functions
+
 /**
  * Crops a specific cache dir
  * @param cache_basedir cache basedir
@@ -104,3 +207,47 @@ static int crop_dir(sds cache_basedir, const char *type, int keepdays) {
     FREE_SDS(cache_path);
     return rc == true ? num_deleted : -1;
 }
+
+/**
+ * Removes the negative cache entries from a specific cache dir
+ * @param cache_basedir cache basedir
+ * @param type cache subdir
+ * @return deleted file count on success, else -1
+ */
+static int clear_negative_dir(sds cache_basedir, const char *type) {
+    int num_deleted = 0;
+    sds cache_path = sdscatfmt(sdsempty(), "%S/%s", cache_basedir, type);
+    errno = 0;
+    DIR *cache_dir = opendir(cache_path);
+    if (cache_dir == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Error opening directory \"%s\"", cache_path);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        FREE_SDS(cache_path);
+        return -1;
+    }
+
+    struct dirent *next_file;
+    sds filepath = sdsempty();
+    while ((next_file = readdir(cache_dir)) != NULL ) {
+        if (next_file->d_type != DT_REG) {
+            continue;
+        }
+        const char *ext = get_extension_from_filename(next_file->d_name);
+        if (ext == NULL ||
+            strcmp(ext, "none") != 0)
+        {
+            continue;
+        }
+        sdsclear(filepath);
+        filepath = sdscatfmt(filepath, "%S/%s", cache_path, next_file->d_name);
+        if (rm_file(filepath) == true) {
+            num_deleted++;
+        }
+    }
+    closedir(cache_dir);
+    FREE_SDS(filepath);
+
+    MYMPD_LOG_INFO(NULL, "Deleted %d negative entries from %s cache", num_deleted, type);
+    FREE_SDS(cache_path);
+    return num_deleted;
+}
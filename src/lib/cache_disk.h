@@ -11,6 +11,7 @@
 #ifndef MYMPD_CACHE_DISK_H
 #define MYMPD_CACHE_DISK_H
 
+#include "dist/sds/sds.h"
 #include "src/lib/config_def.h"
 
 #include <stdbool.h>
@@ -25,5 +26,10 @@ enum cache_disk_conf {
 
 void cache_disk_clear(struct t_config *config);
 void cache_disk_crop(struct t_config *config);
+sds cache_disk_negative_get_name(const char *cachedir, const char *type, const char *uri, int offset);
+bool cache_disk_negative_check(const char *cachedir, const char *type, const char *uri, int offset, const char *media_file);
+bool cache_disk_negative_write(const char *cachedir, const char *type, const char *uri, int offset);
+void cache_disk_negative_remove(const char *cachedir, const char *type, const char *uri, int offset);
+void cache_disk_negative_clear(struct t_config *config);
 
 #endif
@@ -11,6 +11,7 @@
 #include "compile_time.h"
 #include "src/lib/cache_disk_images.h"
 
+#include "src/lib/cache_disk.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
 #include "src/lib/mimetype.h"
@@ -63,6 +64,8 @@ sds cache_disk_images_write_file(sds cachedir, const char *type, const char *uri
     bool rc = write_data_to_file(filepath, binary, sdslen(binary));
     if (rc == false) {
         FREE_SDS(filepath);
+        return filepath;
     }
+    cache_disk_negative_remove(cachedir, type, uri, offset);
     return filepath;
 }
@@ -11,6 +11,7 @@
 #include "compile_time.h"
 #include "src/lib/cache_disk_lyrics.h"
 
+#include "src/lib/cache_disk.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
 #include "src/lib/sds_extras.h"
@@ -48,6 +49,8 @@ sds cache_disk_lyrics_write_file(const char *cachedir, const char *uri, const ch
     bool rc = write_data_to_file(filepath, str, strlen(str));
     if (rc == false) {
         FREE_SDS(filepath);
+        return filepath;
     }
+    cache_disk_negative_remove(cachedir, DIR_CACHE_LYRICS, uri, 0);
     return filepath;
 }
@@ -22,6 +22,7 @@
 struct t_cache {
     bool building;             //!< true if the mpd_worker thread is creating the cache
     rax *cache;                //!< pointer to the cache
+    rax *strings;              //!< pool of interned strings referenced by the cache entries, NULL if not used
     pthread_rwlock_t rwlock;   //!< pthreads read-write lock object
 };
 
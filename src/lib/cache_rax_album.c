@@ -100,9 +100,10 @@ bool album_cache_remove(sds workdir) {
  * @param album_cache pointer to t_cache struct
  * @param workdir myMPD working directory
  * @param album_config album configuration
+ * @param db_update pointer to set the mpd database update time the cache was built from, can be NULL
  * @return bool true on success, else false
  */
-bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_albums_config *album_config) {
+bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_albums_config *album_config, time_t *db_update) {
     #ifdef MYMPD_DEBUG
         MEASURE_INIT
         MEASURE_START
@@ -138,6 +139,14 @@ bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_a
         return NULL;
     }
 
+    // the database update time is missing in caches of older versions
+    if (db_update != NULL) {
+        mpack_node_t db_update_node = mpack_node_map_cstr_optional(root, "dbUpdate");
+        *db_update = mpack_node_is_missing(db_update_node) == false
+            ? (time_t)mpack_node_u64(db_update_node)
+            : 0;
+    }
+
     // read tags array
     struct t_mpd_tags *album_tags = malloc_assert(sizeof(struct t_mpd_tags));
     mpd_tags_reset(album_tags);
@@ -205,10 +214,13 @@ bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_a
  * @param workdir myMPD working directory
  * @param album_tags album tags to write
  * @param album_config album configuration
+ * @param db_update mpd database update time the cache was built from
  * @param free_data true=free the album cache, else not
  * @return bool true on success, else false
  */
-bool album_cache_write(struct t_cache *album_cache, sds workdir, const struct t_mpd_tags *album_tags, const struct t_albums_config *album_config, bool free_data) {
+bool album_cache_write(struct t_cache *album_cache, sds workdir, const struct t_mpd_tags *album_tags,
+        const struct t_albums_config *album_config, time_t db_update, bool free_data)
+{
     if (album_cache->cache == NULL) {
         MYMPD_LOG_DEBUG(NULL, "Album cache is NULL not saving anything");
         return true;
@@ -227,6 +239,7 @@ bool album_cache_write(struct t_cache *album_cache, sds workdir, const struct t_
     mpack_build_map(&writer);
     mpack_write_kv(&writer, "albumMode", album_config->mode);
     mpack_write_kv(&writer, "albumGroupTag", album_config->group_tag);
+    mpack_write_kv(&writer, "dbUpdate", (uint64_t)db_update);
     mpack_write_cstr(&writer, "tags");
     mpack_start_array(&writer, (uint32_t)album_tags->len);
     for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
@@ -548,6 +561,24 @@ bool album_cache_append_tags(struct mpd_song *album,
     return true;
 }
 
+/**
+ * Merges a partial album built from another range of songs into the album.
+ * The album must be built from the songs before the partial album.
+ * @param album mpd_song struct representing the album
+ * @param part mpd_song struct representing the partial album
+ * @param tags tags to merge
+ * @return true on success, else false
+ */
+bool album_cache_merge(struct mpd_song *album, const struct mpd_song *part, const struct t_mpd_tags *tags) {
+    album_cache_set_last_modified(album, part);
+    album_cache_inc_total_time(album, part);
+    if (part->pos > album->pos) {
+        album->pos = part->pos;
+    }
+    album->prio += part->prio;
+    return album_cache_append_tags(album, part, tags);
+}
+
 /**
  * Copies all values from a tag to another tag
  * @param song pointer to a mpd_song struct
@@ -579,6 +610,87 @@ void album_cache_set_uri(struct mpd_song *album, const char *uri) {
     (void)snprintf(album->uri, len, "%s", uri);
 }
 
+/**
+ * Sums up the song counts of the albums per album name.
+ * Names of albums with multiple album names are added to names,
+ * their song count can not be assigned to one name.
+ * @param album_cache pointer to the album cache
+ * @param names rax to add the names of albums with multiple album names
+ * @return newly allocated rax with the album names as key and the song count as value
+ */
+rax *album_cache_count_names(rax *album_cache, rax *names) {
+    rax *counts = raxNew();
+    raxIterator iter;
+    raxStart(&iter, album_cache);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct mpd_song *album = (struct mpd_song *)iter.data;
+        const char *name = mpd_song_get_tag(album, MPD_TAG_ALBUM, 0);
+        if (name == NULL) {
+            continue;
+        }
+        if (mpd_song_get_tag(album, MPD_TAG_ALBUM, 1) != NULL) {
+            unsigned j = 0;
+            while ((name = mpd_song_get_tag(album, MPD_TAG_ALBUM, j)) != NULL) {
+                raxInsert(names, (unsigned char *)name, strlen(name), NULL, NULL);
+                j++;
+            }
+            continue;
+        }
+        size_t name_len = strlen(name);
+        void *data;
+        uintptr_t count = raxFind(counts, (unsigned char *)name, name_len, &data) == 1
+            ? (uintptr_t)data
+            : 0;
+        count += album_get_song_count(album);
+        raxInsert(counts, (unsigned char *)name, name_len, (void *)count, NULL);
+    }
+    raxStop(&iter);
+    return counts;
+}
+
+/**
+ * Removes all albums with one of the names from the album cache.
+ * The other names of removed albums are added to the names,
+ * their songs must be fetched again.
+ * @param album_cache pointer to the album cache
+ * @param names album names to remove
+ */
+void album_cache_remove_names(rax *album_cache, rax *names) {
+    uint64_t names_count;
+    do {
+        names_count = names->numele;
+        raxIterator iter;
+        raxStart(&iter, album_cache);
+        raxSeek(&iter, "^", NULL, 0);
+        while (raxNext(&iter)) {
+            struct mpd_song *album = (struct mpd_song *)iter.data;
+            bool remove = false;
+            unsigned j = 0;
+            const char *name;
+            while ((name = mpd_song_get_tag(album, MPD_TAG_ALBUM, j)) != NULL) {
+                if (raxFind(names, (unsigned char *)name, strlen(name), NULL) == 1) {
+                    remove = true;
+                    break;
+                }
+                j++;
+            }
+            if (remove == false) {
+                continue;
+            }
+            j = 0;
+            while ((name = mpd_song_get_tag(album, MPD_TAG_ALBUM, j)) != NULL) {
+                raxTryInsert(names, (unsigned char *)name, strlen(name), NULL, NULL);
+                j++;
+            }
+            raxRemove(album_cache, iter.key, iter.key_len, NULL);
+            raxSeek(&iter, ">", iter.key, iter.key_len);
+            mpd_song_free(album);
+        }
+        raxStop(&iter);
+    } while (names_count != names->numele);
+}
+
 /**
  * Private functions
  */
@@ -17,13 +17,15 @@
 #include "src/lib/fields.h"
 
 #include <stdbool.h>
+#include <time.h>
 
 enum album_modes parse_album_mode(const char *mode_str);
 const char *lookup_album_mode(enum album_modes mode);
 
 bool album_cache_remove(sds workdir);
-bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_albums_config *album_config);
-bool album_cache_write(struct t_cache *album_cache, sds workdir, const struct t_mpd_tags *album_tags, const struct t_albums_config *album_config, bool free_data);
+bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_albums_config *album_config, time_t *db_update);
+bool album_cache_write(struct t_cache *album_cache, sds workdir, const struct t_mpd_tags *album_tags,
+        const struct t_albums_config *album_config, time_t db_update, bool free_data);
 
 sds album_cache_get_key(sds albumkey, const struct mpd_song *song, const struct t_albums_config *album_config);
 struct mpd_song *album_cache_get_album(struct t_cache *album_cache, sds key);
@@ -43,7 +45,10 @@ void album_cache_inc_total_time(struct mpd_song *album, const struct mpd_song *s
 void album_cache_set_song_count(struct mpd_song *album, unsigned count);
 void album_cache_inc_song_count(struct mpd_song *album);
 bool album_cache_append_tags(struct mpd_song *album, const struct mpd_song *song, const struct t_mpd_tags *tags);
+bool album_cache_merge(struct mpd_song *album, const struct mpd_song *part, const struct t_mpd_tags *tags);
 bool album_cache_copy_tags(struct mpd_song *song, enum mpd_tag_type src, enum mpd_tag_type dst);
 void album_cache_set_uri(struct mpd_song *album, const char *uri);
+rax *album_cache_count_names(rax *album_cache, rax *names);
+void album_cache_remove_names(rax *album_cache, rax *names);
 
 #endif
@@ -0,0 +1,545 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Song cache
+ */
+
+#include "compile_time.h"
+#include "src/lib/cache_rax_song.h"
+
+#include "dist/libmympdclient/include/mpd/client.h"
+#include "dist/libmympdclient/src/isong.h"
+#include "dist/mpack/mpack.h"
+#include "dist/rax/rax.h"
+#include "src/lib/casefold.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/mpack.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/utility.h"
+#include "src/mpd_client/tags.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * myMPD saves the songs of the mpd database as compact records in the song cache.
+ * cache: rax keyed by song uri, data is a struct t_song_cache_song
+ * strings: rax keyed by tag value, data is a struct t_song_cache_string
+ * Each distinct tag value is saved only once in the strings pool.
+ */
+
+/**
+ * Private definitions
+ */
+
+static const char *song_cache_intern(rax *strings, enum mpd_tag_type tag, const char *value);
+static struct mpd_song *song_from_mpack_node(mpack_node_t song_node, const struct t_mpd_tags *tags);
+static void free_rax_data(rax *rt);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes the radix trees of the song cache
+ * @param song_cache pointer to t_cache struct
+ */
+void song_cache_init(struct t_cache *song_cache) {
+    song_cache->cache = raxNew();
+    song_cache->strings = raxNew();
+}
+
+/**
+ * Removes the song cache file
+ * @param workdir myMPD working directory
+ * @return bool true on success, else false
+ */
+bool song_cache_remove(sds workdir) {
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_SONGCACHE);
+    int rc = try_rm_file(filepath);
+    FREE_SDS(filepath);
+    return rc == RM_FILE_ERROR
+        ? false
+        : true;
+}
+
+/**
+ * Reads the song cache from disc
+ * @param song_cache pointer to t_cache struct
+ * @param workdir myMPD working directory
+ * @return bool true on success, else false
+ */
+bool song_cache_read(struct t_cache *song_cache, sds workdir) {
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_SONGCACHE);
+    if (testfile_read(filepath) == false) {
+        FREE_SDS(filepath);
+        return false;
+    }
+
+    mpack_tree_t tree;
+    mpack_tree_init_filename(&tree, filepath, 0);
+    mpack_tree_set_error_handler(&tree, log_mpack_node_error);
+    FREE_SDS(filepath);
+    mpack_tree_parse(&tree);
+    mpack_node_t root = mpack_tree_root(&tree);
+
+    // read tags array
+    struct t_mpd_tags *song_tags = malloc_assert(sizeof(struct t_mpd_tags));
+    mpd_tags_reset(song_tags);
+
+    mpack_node_t tags_node = mpack_node_map_cstr(root, "tags");
+    size_t len = mpack_node_array_length(tags_node);
+    for (size_t i = 0; i < len; i++) {
+        mpack_node_t value_node = mpack_node_array_at(tags_node, i);
+        char *value = mpack_node_cstr_alloc(value_node, JSONRPC_STR_MAX);
+        if (value == NULL) {
+            break;
+        }
+        enum mpd_tag_type tag = mpd_tag_name_parse(value);
+        if (tag != MPD_TAG_UNKNOWN) {
+            song_tags->tags[song_tags->len++] = tag;
+        }
+        else {
+            MYMPD_LOG_ERROR(NULL, "Unkown MPD tag type: \"%s\"", value);
+        }
+        MPACK_FREE(value);
+    }
+
+    // read songs array
+    mpack_node_t songs_node = mpack_node_map_cstr(root, "songs");
+    len = mpack_node_array_length(songs_node);
+    song_cache->building = true;
+    song_cache_init(song_cache);
+
+    for (size_t i = 0; i < len; i++) {
+        mpack_node_t song_node = mpack_node_array_at(songs_node, i);
+        struct mpd_song *song = song_from_mpack_node(song_node, song_tags);
+        if (song != NULL) {
+            if (song_cache_insert(song_cache, song, song_tags) == false) {
+                MYMPD_LOG_ERROR(NULL, "Duplicate uri in song cache file found: %s", mpd_song_get_uri(song));
+            }
+            mpd_song_free(song);
+        }
+    }
+    // clean up and check for errors
+    bool rc = mpack_tree_destroy(&tree) != mpack_ok
+        ? false
+        : true;
+    if (rc == false) {
+        MYMPD_LOG_ERROR("default", "Reading song cache failed, discarding cache");
+        song_cache_remove(workdir);
+        song_cache_free(song_cache);
+    }
+    else {
+        MYMPD_LOG_INFO(NULL, "Read %" PRIu64 " song(s) from disc", song_cache->cache->numele);
+    }
+    FREE_PTR(song_tags);
+    song_cache->building = false;
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(NULL, "Song cache read");
+    #endif
+    return rc;
+}
+
+/**
+ * Saves the song cache to disc in mpack format
+ * @param song_cache pointer to t_cache struct
+ * @param workdir myMPD working directory
+ * @param song_tags song tags to write
+ * @param free_data true=free the song cache, else not
+ * @return bool true on success, else false
+ */
+bool song_cache_write(struct t_cache *song_cache, sds workdir, const struct t_mpd_tags *song_tags, bool free_data) {
+    if (song_cache->cache == NULL) {
+        MYMPD_LOG_DEBUG(NULL, "Song cache is NULL not saving anything");
+        return true;
+    }
+    MYMPD_LOG_INFO(NULL, "Saving song cache to disc");
+    mpack_writer_t writer;
+    sds tmp_file = sdscatfmt(sdsempty(), "%S/%s/%s.XXXXXX", workdir, DIR_WORK_TAGS, FILENAME_SONGCACHE);
+    FILE *fp = open_tmp_file(tmp_file);
+    if (fp == NULL) {
+        FREE_SDS(tmp_file);
+        return false;
+    }
+    // init mpack
+    mpack_writer_init_stdfile(&writer, fp, true);
+    mpack_writer_set_error_handler(&writer, log_mpack_write_error);
+    mpack_build_map(&writer);
+    mpack_write_cstr(&writer, "tags");
+    mpack_start_array(&writer, (uint32_t)song_tags->len);
+    for (unsigned tagnr = 0; tagnr < song_tags->len; ++tagnr) {
+        mpack_write_cstr(&writer, mpd_tag_name(song_tags->tags[tagnr]));
+    }
+    mpack_finish_array(&writer);
+    mpack_write_cstr(&writer, "songs");
+    mpack_start_array(&writer, (uint32_t)song_cache->cache->numele);
+    raxIterator iter;
+    raxStart(&iter, song_cache->cache);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_song_cache_song *song = (struct t_song_cache_song *)iter.data;
+        mpack_build_map(&writer);
+        mpack_write_kv(&writer, "uri", song->uri);
+        mpack_write_kv(&writer, "Duration", song->duration_ms);
+        mpack_write_kv(&writer, "Last-Modified", (uint64_t)song->last_modified);
+        mpack_write_kv(&writer, "Added", (uint64_t)song->added);
+        // values of the same tag are consecutive
+        unsigned i = 0;
+        while (i < song->tags_len) {
+            enum mpd_tag_type tag = song->tags[i].tag;
+            mpack_write_cstr(&writer, mpd_tag_name(tag));
+            mpack_build_array(&writer);
+            for (; i < song->tags_len && song->tags[i].tag == tag; i++) {
+                mpack_write_cstr(&writer, song->tags[i].value);
+            }
+            mpack_complete_array(&writer);
+        }
+        mpack_complete_map(&writer);
+    }
+    raxStop(&iter);
+    mpack_finish_array(&writer);
+    mpack_complete_map(&writer);
+    if (free_data == true) {
+        song_cache_free(song_cache);
+    }
+    // finish writing
+    bool rc = mpack_writer_destroy(&writer) != mpack_ok
+        ? false
+        : true;
+    if (rc == false) {
+        rm_file(tmp_file);
+        MYMPD_LOG_ERROR("default", "An error occurred encoding the data");
+        FREE_SDS(tmp_file);
+        return false;
+    }
+    // rename tmp file
+    sds filepath = sdscatlen(sdsempty(), tmp_file, sdslen(tmp_file) - 7);
+    errno = 0;
+    if (rename(tmp_file, filepath) == -1) {
+        MYMPD_LOG_ERROR(NULL, "Rename file from \"%s\" to \"%s\" failed", tmp_file, filepath);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        rm_file(tmp_file);
+        rc = false;
+    }
+    FREE_SDS(filepath);
+    FREE_SDS(tmp_file);
+    return rc;
+}
+
+/**
+ * Frees the song cache
+ * @param song_cache pointer to t_cache struct
+ */
+void song_cache_free(struct t_cache *song_cache) {
+    if (song_cache->cache != NULL) {
+        MYMPD_LOG_DEBUG(NULL, "Freeing song cache");
+        free_rax_data(song_cache->cache);
+        song_cache->cache = NULL;
+    }
+    if (song_cache->strings != NULL) {
+        free_rax_data(song_cache->strings);
+        song_cache->strings = NULL;
+    }
+}
+
+/**
+ * Inserts a song in the song cache
+ * @param song_cache pointer to t_cache struct
+ * @param song song to insert
+ * @param tags tags to save
+ * @return true on success, false if the uri is already in the cache
+ */
+bool song_cache_insert(struct t_cache *song_cache, const struct mpd_song *song, const struct t_mpd_tags *tags) {
+    const char *uri = mpd_song_get_uri(song);
+    size_t uri_len = strlen(uri);
+    if (raxFind(song_cache->cache, (unsigned char *)uri, uri_len, NULL) == 1) {
+        return false;
+    }
+    struct t_song_cache_song *entry = song_cache_song_new(song_cache->strings, song, tags);
+    raxInsert(song_cache->cache, (unsigned char *)uri, uri_len, entry, NULL);
+    return true;
+}
+
+/**
+ * Creates a compact song record with interned tag values
+ * @param strings strings pool for the tag values
+ * @param song song to convert
+ * @param tags tags to save
+ * @return newly allocated song record, free it with free
+ */
+struct t_song_cache_song *song_cache_song_new(rax *strings, const struct mpd_song *song, const struct t_mpd_tags *tags) {
+    const char *uri = mpd_song_get_uri(song);
+    size_t uri_len = strlen(uri);
+    unsigned tags_len = 0;
+    for (unsigned tagnr = 0; tagnr < tags->len; ++tagnr) {
+        unsigned idx = 0;
+        while (mpd_song_get_tag(song, tags->tags[tagnr], idx) != NULL) {
+            idx++;
+        }
+        tags_len += idx;
+    }
+    // allocate the record, the tags array and the uri in one block
+    size_t tags_size = tags_len * sizeof(struct t_song_cache_tag);
+    struct t_song_cache_song *entry = malloc_assert(sizeof(struct t_song_cache_song) + tags_size + uri_len + 1);
+    char *entry_uri = (char *)entry->tags + tags_size;
+    memcpy(entry_uri, uri, uri_len + 1);
+    entry->uri = entry_uri;
+    entry->duration_ms = mpd_song_get_duration_ms(song);
+    if (entry->duration_ms == 0) {
+        entry->duration_ms = mpd_song_get_duration(song) * 1000;
+    }
+    entry->last_modified = mpd_song_get_last_modified(song);
+    entry->added = mpd_song_get_added(song);
+    entry->tags_len = 0;
+    for (unsigned tagnr = 0; tagnr < tags->len; ++tagnr) {
+        enum mpd_tag_type tag = tags->tags[tagnr];
+        const char *value;
+        unsigned idx = 0;
+        while ((value = mpd_song_get_tag(song, tag, idx)) != NULL) {
+            entry->tags[entry->tags_len].tag = tag;
+            entry->tags[entry->tags_len].value = song_cache_intern(strings, tag, value);
+            entry->tags_len++;
+            idx++;
+        }
+    }
+    return entry;
+}
+
+/**
+ * Gets a song from the song cache
+ * @param song_cache pointer to t_cache struct
+ * @param uri song uri
+ * @return the cached song or NULL if not found
+ */
+struct t_song_cache_song *song_cache_get_song(struct t_cache *song_cache, const char *uri) {
+    if (song_cache->cache == NULL) {
+        return NULL;
+    }
+    void *data;
+    if (raxFind(song_cache->cache, (unsigned char *)uri, strlen(uri), &data) == 0) {
+        return NULL;
+    }
+    return (struct t_song_cache_song *)data;
+}
+
+/**
+ * Gets a tag value of a cached song
+ * @param song cached song
+ * @param tag mpd tag type
+ * @param idx index of the value
+ * @return the tag value or NULL if not found
+ */
+const char *song_cache_get_tag(const struct t_song_cache_song *song, enum mpd_tag_type tag, unsigned idx) {
+    for (unsigned i = 0; i < song->tags_len; i++) {
+        if (song->tags[i].tag == tag) {
+            if (idx == 0) {
+                return song->tags[i].value;
+            }
+            idx--;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Gets the interned string struct of a tag value
+ * @param value tag value returned by song_cache_get_tag
+ * @return the interned string with the folded value
+ */
+const struct t_song_cache_string *song_cache_get_string(const char *value) {
+    return (const struct t_song_cache_string *)(const void *)(value - offsetof(struct t_song_cache_string, value));
+}
+
+/**
+ * Gets the duration of a cached song in seconds
+ * @param song cached song
+ * @return duration in seconds
+ */
+unsigned song_cache_get_duration(const struct t_song_cache_song *song) {
+    return song->duration_ms / 1000;
+}
+
+/**
+ * Creates a mpd_song struct from a cached song
+ * @param song cached song
+ * @return newly allocated mpd_song struct
+ */
+struct mpd_song *song_cache_to_mpd_song(const struct t_song_cache_song *song) {
+    struct mpd_song *mpd_song = mpd_song_new(song->uri);
+    mpd_song->duration_ms = song->duration_ms;
+    mpd_song->duration = song->duration_ms / 1000;
+    mpd_song->last_modified = song->last_modified;
+    mpd_song->added = song->added;
+    for (unsigned i = 0; i < song->tags_len; i++) {
+        mympd_mpd_song_add_tag_dedup(mpd_song, song->tags[i].tag, song->tags[i].value);
+    }
+    return mpd_song;
+}
+
+/**
+ * Constructs the sort key for a cached song, same as get_sort_key
+ * @param key already allocated sds string to append the key
+ * @param sort_by sort type
+ * @param sort_tag tag to sort by
+ * @param song cached song
+ * @return pointer to key
+ */
+sds song_cache_get_sort_key(sds key, enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
+        const struct t_song_cache_song *song)
+{
+    if (sort_by == SORT_BY_LAST_MODIFIED) {
+        key = sds_pad_int((int64_t)song->last_modified, key);
+    }
+    else if (sort_by == SORT_BY_ADDED) {
+        key = sds_pad_int((int64_t)song->added, key);
+    }
+    else if (is_numeric_tag(sort_tag) == true) {
+        const char *value = song_cache_get_tag(song, sort_tag, 0);
+        size_t value_len = value == NULL
+            ? 0
+            : strlen(value);
+        for (size_t i = value_len; i < PADDING_LENGTH; i++) {
+            key = sdscatlen(key, "0", 1);
+        }
+        if (value != NULL) {
+            key = sdscatlen(key, value, value_len);
+        }
+    }
+    else if (sort_tag > MPD_TAG_UNKNOWN) {
+        const char *value;
+        unsigned idx = 0;
+        while ((value = song_cache_get_tag(song, sort_tag, idx)) != NULL) {
+            if (idx++ > 0) {
+                key = sdscatlen(key, ", ", 2);
+            }
+            key = sdscat(key, value);
+        }
+        if (idx == 0 &&
+            sort_tag == MPD_TAG_TITLE)
+        {
+            // title fallback to name and filename
+            value = song_cache_get_tag(song, MPD_TAG_NAME, 0);
+            if (value != NULL) {
+                key = sdscat(key, value);
+            }
+            else {
+                key = sdscat(key, song->uri);
+                basename_uri(key);
+            }
+        }
+        if (sdslen(key) == 0) {
+            key = sdscatlen(key, "zzzzzzzzzz", 10);
+        }
+    }
+    key = sdscatfmt(key, "::%s", song->uri);
+    sds_utf8_tolower(key);
+    return key;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Returns the pooled copy of a tag value, adds it to the pool if not found
+ * @param strings strings pool
+ * @param tag tag type the value is used for
+ * @param value tag value
+ * @return pointer to the pooled value
+ */
+static const char *song_cache_intern(rax *strings, enum mpd_tag_type tag, const char *value) {
+    size_t len = strlen(value);
+    void *data;
+    struct t_song_cache_string *str;
+    if (raxFind(strings, (unsigned char *)value, len, &data) == 1) {
+        str = (struct t_song_cache_string *)data;
+    }
+    else {
+        // the folded value is stored after the value, if it differs
+        sds folded = casefold_cat(sdsempty(), value);
+        bool differs = strcmp(folded, value) != 0;
+        size_t folded_size = differs == true
+            ? sdslen(folded) + 1
+            : 0;
+        str = malloc_assert(sizeof(struct t_song_cache_string) + len + 1 + folded_size);
+        str->tags = 0;
+        memcpy(str->value, value, len + 1);
+        if (differs == true) {
+            char *folded_value = str->value + len + 1;
+            memcpy(folded_value, folded, folded_size);
+            str->folded = folded_value;
+        }
+        else {
+            str->folded = str->value;
+        }
+        str->folded_len = sdslen(folded);
+        FREE_SDS(folded);
+        raxInsert(strings, (unsigned char *)value, len, str, NULL);
+    }
+    str->tags |= (uint64_t)1 << tag;
+    return str->value;
+}
+
+/**
+ * Creates a mpd_song struct from cache
+ * @param song_node mpack node to parse
+ * @param tags tags to read
+ * @return struct mpd_song* allocated mpd_song struct
+ */
+static struct mpd_song *song_from_mpack_node(mpack_node_t song_node, const struct t_mpd_tags *tags) {
+    struct mpd_song *song = NULL;
+    char *uri = mpack_node_cstr_alloc(mpack_node_map_cstr(song_node, "uri"), JSONRPC_STR_MAX);
+    if (uri != NULL) {
+        song = mpd_song_new(uri);
+        song->duration_ms = mpack_node_uint(mpack_node_map_cstr(song_node, "Duration"));
+        song->duration = song->duration_ms / 1000;
+        song->last_modified = mpack_node_int(mpack_node_map_cstr(song_node, "Last-Modified"));
+        song->added = mpack_node_int(mpack_node_map_cstr(song_node, "Added"));
+        for (size_t i = 0; i < tags->len; i++) {
+            mpack_node_t value_node = mpack_node_map_cstr_optional(song_node, mpd_tag_name(tags->tags[i]));
+            if (mpack_node_is_missing(value_node) == true) {
+                continue;
+            }
+            size_t len = mpack_node_array_length(value_node);
+            for (size_t j = 0; j < len; j++) {
+                char *value = mpack_node_cstr_alloc(mpack_node_array_at(value_node, j), JSONRPC_STR_MAX);
+                if (value != NULL) {
+                    mympd_mpd_song_add_tag_dedup(song, tags->tags[i], value);
+                    MPACK_FREE(value);
+                }
+            }
+        }
+        MPACK_FREE(uri);
+    }
+    return song;
+}
+
+/**
+ * Frees the data of a radix tree and the tree itself
+ * @param rt radix tree to free
+ */
+static void free_rax_data(rax *rt) {
+    raxIterator iter;
+    raxStart(&iter, rt);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        free(iter.data);
+    }
+    raxStop(&iter);
+    raxFree(rt);
+}
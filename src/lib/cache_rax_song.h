@@ -0,0 +1,69 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Song cache
+ */
+
+#ifndef MYMPD_CACHE_RAX_SONG_H
+#define MYMPD_CACHE_RAX_SONG_H
+
+#include "dist/sds/sds.h"
+#include "src/lib/cache_rax.h"
+#include "src/lib/fields.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Interned string of the song cache
+ */
+struct t_song_cache_string {
+    uint64_t tags;         //!< bitmask of the tags this value is used for
+    const char *folded;    //!< value folded to lower case, points to value if identical
+    size_t folded_len;     //!< length of the folded value
+    char value[];          //!< the null terminated string, followed by the folded string if different
+};
+
+/**
+ * Tag value of a cached song
+ */
+struct t_song_cache_tag {
+    enum mpd_tag_type tag;  //!< tag type
+    const char *value;      //!< interned tag value, owned by the strings pool of the cache
+};
+
+/**
+ * Compact song record for the song cache.
+ * The struct, the tag values array and the uri are allocated in one block.
+ */
+struct t_song_cache_song {
+    const char *uri;                  //!< song uri
+    unsigned duration_ms;             //!< duration in milliseconds
+    time_t last_modified;             //!< last modification time
+    time_t added;                     //!< added to the mpd database time
+    unsigned tags_len;                //!< number of tag values
+    struct t_song_cache_tag tags[];   //!< tag values, values of the same tag are consecutive
+};
+
+void song_cache_init(struct t_cache *song_cache);
+bool song_cache_remove(sds workdir);
+bool song_cache_read(struct t_cache *song_cache, sds workdir);
+bool song_cache_write(struct t_cache *song_cache, sds workdir, const struct t_mpd_tags *song_tags, bool free_data);
+void song_cache_free(struct t_cache *song_cache);
+
+bool song_cache_insert(struct t_cache *song_cache, const struct mpd_song *song, const struct t_mpd_tags *tags);
+struct t_song_cache_song *song_cache_song_new(rax *strings, const struct mpd_song *song, const struct t_mpd_tags *tags);
+struct t_song_cache_song *song_cache_get_song(struct t_cache *song_cache, const char *uri);
+const char *song_cache_get_tag(const struct t_song_cache_song *song, enum mpd_tag_type tag, unsigned idx);
+const struct t_song_cache_string *song_cache_get_string(const char *value);
+unsigned song_cache_get_duration(const struct t_song_cache_song *song);
+struct mpd_song *song_cache_to_mpd_song(const struct t_song_cache_song *song);
+sds song_cache_get_sort_key(sds key, enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
+        const struct t_song_cache_song *song);
+
+#endif
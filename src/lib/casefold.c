@@ -0,0 +1,263 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Case-folded strings and substring search
+ */
+
+#include "compile_time.h"
+#include "src/lib/casefold.h"
+
+#include "dist/utf8/utf8.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+/**
+ * Strings are folded codepoint by codepoint to lower case, like utf8casestr
+ * compares them. A substring search in the folded strings is a plain byte
+ * search, the folded needle is calculated once for many haystacks.
+ */
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Size of the stack buffer to fold haystacks in casefold_contains
+ */
+#define CASEFOLD_BUFFER_SIZE 1024
+
+static const char *fold_utf8_char(const char *p, char *out, size_t *out_len);
+#ifdef __SSE2__
+static const char *find_sse2(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
+#endif
+
+/**
+ * Public functions
+ */
+
+/**
+ * Folds a string to lower case
+ * @param str null terminated string to fold
+ * @param buf buffer for the folded string
+ * @param size size of the buffer
+ * @return length of the folded string or CASEFOLD_OVERFLOW if the buffer is too small
+ */
+size_t casefold(const char *str, char *buf, size_t size) {
+    size_t len = 0;
+    const char *p = str;
+    while (*p != '\0') {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x80) {
+            // ascii fast path
+            if (len + 1 >= size) {
+                return CASEFOLD_OVERFLOW;
+            }
+            buf[len++] = c >= 'A' && c <= 'Z'
+                ? (char)(c | 0x20)
+                : (char)c;
+            p++;
+            continue;
+        }
+        char folded[4];
+        size_t folded_len;
+        p = fold_utf8_char(p, folded, &folded_len);
+        if (len + folded_len >= size) {
+            return CASEFOLD_OVERFLOW;
+        }
+        memcpy(buf + len, folded, folded_len);
+        len += folded_len;
+    }
+    if (len >= size) {
+        return CASEFOLD_OVERFLOW;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * Appends the string folded to lower case
+ * @param s sds string to append
+ * @param str null terminated string to fold
+ * @return pointer to s
+ */
+sds casefold_cat(sds s, const char *str) {
+    const char *p = str;
+    while (*p != '\0') {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x80) {
+            // ascii fast path
+            const char lower = c >= 'A' && c <= 'Z'
+                ? (char)(c | 0x20)
+                : (char)c;
+            s = sdscatlen(s, &lower, 1);
+            p++;
+            continue;
+        }
+        char folded[4];
+        size_t folded_len;
+        p = fold_utf8_char(p, folded, &folded_len);
+        s = sdscatlen(s, folded, folded_len);
+    }
+    return s;
+}
+
+/**
+ * Finds the first occurrence of needle in haystack.
+ * Uses SSE2 if available, else the scalar implementation.
+ * @param haystack string to search in
+ * @param haystack_len length of haystack
+ * @param needle string to search for
+ * @param needle_len length of needle
+ * @return pointer to the first occurrence or NULL if not found
+ */
+const char *casefold_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len) {
+    if (needle_len == 0) {
+        return haystack;
+    }
+    if (needle_len > haystack_len) {
+        return NULL;
+    }
+    #ifdef __SSE2__
+        return find_sse2(haystack, haystack_len, needle, needle_len);
+    #else
+        return casefold_find_scalar(haystack, haystack_len, needle, needle_len);
+    #endif
+}
+
+/**
+ * Finds the first occurrence of needle in haystack.
+ * Portable implementation: scans for the first byte of needle with memchr
+ * and checks the last byte before comparing the whole needle.
+ * @param haystack string to search in
+ * @param haystack_len length of haystack
+ * @param needle string to search for
+ * @param needle_len length of needle
+ * @return pointer to the first occurrence or NULL if not found
+ */
+const char *casefold_find_scalar(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len) {
+    if (needle_len == 0) {
+        return haystack;
+    }
+    if (needle_len > haystack_len) {
+        return NULL;
+    }
+    const char *p = haystack;
+    const char *last = haystack + haystack_len - needle_len;
+    const char needle_last = needle[needle_len - 1];
+    while (p <= last) {
+        p = memchr(p, needle[0], (size_t)(last - p) + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (p[needle_len - 1] == needle_last &&
+            memcmp(p, needle, needle_len) == 0)
+        {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+/**
+ * Case insensitive substring search for strings without a cached folded copy.
+ * Same result as utf8casestr(haystack, needle) != NULL.
+ * @param haystack null terminated string to search in
+ * @param needle folded string to search for
+ * @param needle_len length of needle
+ * @return true if haystack contains needle, else false
+ */
+bool casefold_contains(const char *haystack, const char *needle, size_t needle_len) {
+    if (needle_len == 0) {
+        return true;
+    }
+    char buf[CASEFOLD_BUFFER_SIZE];
+    size_t len = casefold(haystack, buf, sizeof(buf));
+    if (len == CASEFOLD_OVERFLOW) {
+        // very long string, fold it on the heap
+        sds folded = casefold_cat(sdsempty(), haystack);
+        bool rc = casefold_find(folded, sdslen(folded), needle, needle_len) != NULL;
+        sdsfree(folded);
+        return rc;
+    }
+    return casefold_find(buf, len, needle, needle_len) != NULL;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Folds one utf8 encoded character to lower case.
+ * Invalid sequences are copied bytewise.
+ * @param p pointer to the character
+ * @param out buffer for the folded character, at least 4 bytes
+ * @param out_len length of the folded character
+ * @return pointer to the next character
+ */
+static const char *fold_utf8_char(const char *p, char *out, size_t *out_len) {
+    size_t size = utf8codepointcalcsize(p);
+    for (size_t i = 1; i < size; i++) {
+        if (((unsigned char)p[i] & 0xc0) != 0x80) {
+            // invalid or truncated sequence
+            out[0] = p[0];
+            *out_len = 1;
+            return p + 1;
+        }
+    }
+    utf8_int32_t cp;
+    utf8codepoint(p, &cp);
+    utf8_int32_t lwr_cp = utf8lwrcodepoint(cp);
+    if (lwr_cp == cp ||
+        size == 1)
+    {
+        memcpy(out, p, size);
+        *out_len = size;
+    }
+    else {
+        *out_len = utf8codepointsize(lwr_cp);
+        utf8catcodepoint(out, lwr_cp, *out_len);
+    }
+    return p + size;
+}
+
+#ifdef __SSE2__
+/**
+ * Finds the first occurrence of needle in haystack with SSE2.
+ * Compares the first and last byte of needle for 16 positions at once,
+ * only candidates matching both are compared completely.
+ * @param haystack string to search in
+ * @param haystack_len length of haystack
+ * @param needle string to search for, not empty
+ * @param needle_len length of needle, not greater than haystack_len
+ * @return pointer to the first occurrence or NULL if not found
+ */
+static const char *find_sse2(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    for (; i + needle_len - 1 + 16 <= haystack_len; i += 16) {
+        const __m128i block_first = _mm_loadu_si128((const __m128i *)(const void *)(haystack + i));
+        const __m128i block_last = _mm_loadu_si128((const __m128i *)(const void *)(haystack + i + needle_len - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+        while (mask != 0) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(haystack + i + bit, needle, needle_len) == 0) {
+                return haystack + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    // remaining positions
+    return casefold_find_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+#endif
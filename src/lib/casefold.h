@@ -0,0 +1,31 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Case-folded strings and substring search
+ */
+
+#ifndef MYMPD_LIB_CASEFOLD_H
+#define MYMPD_LIB_CASEFOLD_H
+
+#include "dist/sds/sds.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Return value of casefold if the buffer is too small
+ */
+#define CASEFOLD_OVERFLOW SIZE_MAX
+
+size_t casefold(const char *str, char *buf, size_t size);
+sds casefold_cat(sds s, const char *str);
+const char *casefold_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
+const char *casefold_find_scalar(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
+bool casefold_contains(const char *haystack, const char *needle, size_t needle_len);
+
+#endif
@@ -44,9 +44,11 @@ struct t_config {
     bool http;                      //!< enable listening on plain http_port
     bool log_to_syslog;             //!< enable syslog logging
     bool save_caches;               //!< true = save caches between restart
+    bool song_cache;                //!< true = create the song cache
     bool ssl;                       //!< enable listening on ssl_port
     bool stickers;                  //!< enable sticker support
     bool stickers_pad_int;          //!< enable the padding of integer sticker values
+    bool stickers_mirror;           //!< keep an in memory mirror of the song stickers
     bool webradiodb;                //!< enable webradiodb support
     struct t_albums_config albums;  //!< album specific config
     int cache_cover_keep_days;      //!< expiration time for cover cache files in days
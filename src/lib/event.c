@@ -56,7 +56,7 @@ bool event_pfd_add_fd(struct mympd_pfds *pfds, int fd, enum pfd_type type, struc
  */
 int event_eventfd_create(void) {
     errno = 0;
-    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
     if (fd == -1) {
         MYMPD_LOG_ERROR(NULL, "Unable to create eventfd");
         MYMPD_LOG_ERRNO(NULL, errno);
@@ -80,7 +80,7 @@ bool event_eventfd_write(int fd) {
 }
 
 /**
- * Reads from an eventfd
+ * Reads from an eventfd and resets its counter
  * @param fd read from this fd
  * @return true on success, else false
  */
@@ -119,6 +119,7 @@ const char *lookup_pfd_type(enum pfd_type type) {
         case PFD_TYPE_TIMER_MPD_CONNECT: return "connect timer";
         case PFD_TYPE_TIMER_SCROBBLE: return "scrobble timer";
         case PFD_TYPE_TIMER_JUKEBOX: return "jukebox timer";
+        case PFD_TYPE_TIMER_STICKERDB: return "stickerdb timer";
     }
     return "invalid";
 }
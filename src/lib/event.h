@@ -16,14 +16,14 @@
 #include <stdbool.h>
 
 /**
- * Poll fd types
+ * Poll fd types, the timer types are also used for the timers in the timer heap
  */
 enum pfd_type {
     /* MPD connection for partitions */
     PFD_TYPE_PARTITION = 0x1,
     /* MPD connection for stickerdb */
     PFD_TYPE_STICKERDB = 0x2,
-    /* myMPD timers */
+    /* Timer heap (poll fd) and myMPD timers */
     PFD_TYPE_TIMER = 0x4,
     /* Message queue */
     PFD_TYPE_QUEUE = 0x8,
@@ -32,7 +32,9 @@ enum pfd_type {
     /* Scrobble timer */
     PFD_TYPE_TIMER_SCROBBLE = 0x20,
     /* Jukebox timer */
-    PFD_TYPE_TIMER_JUKEBOX = 0x40
+    PFD_TYPE_TIMER_JUKEBOX = 0x40,
+    /* Timer for pending stickerdb writes */
+    PFD_TYPE_TIMER_STICKERDB = 0x80
 };
 
 /**
@@ -219,6 +219,57 @@ sds sds_getfile_from_fp(sds s, FILE *fp, size_t max, bool remove_newline, int *n
     return s;
 }
 
+/**
+ * Reads a whole binary file in the sds string s.
+ * The content is not modified, the size is taken from fstat.
+ * @param s an already allocated sds string that should hold the file content
+ * @param file_path filename to read
+ * @param max maximum bytes to read
+ * @param nread Number of bytes read,
+ *              -1 error reading file,
+ *              -2 file is too big
+ * @return pointer to s
+ */
+sds sds_getfile_binary(sds s, const char *file_path, size_t max, int *nread) {
+    sdsclear(s);
+    errno = 0;
+    FILE *fp = fopen(file_path, OPEN_FLAGS_READ);
+    if (fp == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Error opening file \"%s\"", file_path);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        *nread = -1;
+        return s;
+    }
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error getting size of file \"%s\"", file_path);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        (void) fclose(fp);
+        *nread = -1;
+        return s;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size > max) {
+        MYMPD_LOG_ERROR(NULL, "File \"%s\" is too big, max size is %lu", file_path, (unsigned long)max);
+        (void) fclose(fp);
+        *nread = -2;
+        return s;
+    }
+    s = sdsMakeRoomFor(s, size);
+    size_t len = fread(s, 1, size, fp);
+    if (len != size) {
+        MYMPD_LOG_ERROR(NULL, "Error reading file \"%s\"", file_path);
+        (void) fclose(fp);
+        s[0] = '\0';
+        *nread = -1;
+        return s;
+    }
+    (void) fclose(fp);
+    sdsIncrLen(s, (ssize_t)len);
+    *nread = (int)len;
+    return s;
+}
+
 /**
  * Checks if a filename can be opened read-only
  * @param filename filename to check
@@ -12,13 +12,16 @@
 #include "src/lib/jsonrpc.h"
 
 #include "dist/mjson/mjson.h"
+#include "dist/rax/rax.h"
 #include "src/lib/api.h"
 #include "src/lib/convert.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/sticker.h"
 #include "src/mpd_client/tags.h"
 
+#include <stdint.h>
 #include <string.h>
 
 /**
@@ -36,6 +39,36 @@ static void set_parse_error(struct t_jsonrpc_parse_error *error, const char *pat
 static const char *jsonrpc_facility_name(enum jsonrpc_facilities facility);
 static const char *jsonrpc_severity_name(enum jsonrpc_severities severity);
 static const char *jsonrpc_event_name(enum jsonrpc_events event);
+static int json_find(sds s, const char *path, const char **p, int *n);
+static int json_get_number(sds s, const char *path, double *value);
+static bool json_index_add(const char *path, size_t path_len, int type, int off, int len);
+static void json_index_object(const char *buf, int off, int len, sds *path);
+
+/**
+ * Token of the parsed json document
+ */
+struct t_json_token {
+    int type;  //!< mjson token type
+    int off;   //!< offset of the value in the document
+    int len;   //!< length of the value
+};
+
+/**
+ * Json document parsed once into a flat token array with a path index
+ */
+struct t_json_index {
+    const char *buf;               //!< the indexed document
+    int len;                       //!< length of the document
+    rax *paths;                    //!< path to index in the tokens array
+    struct t_json_token *tokens;   //!< the tokens
+    unsigned tokens_len;           //!< number of tokens
+    unsigned tokens_size;          //!< allocated number of tokens
+};
+
+/**
+ * The json index of the request processed by this thread
+ */
+static _Thread_local struct t_json_index *json_index;
 
 /**
  * Names for enum jsonrpc_events
@@ -600,6 +633,45 @@ void jsonrpc_parse_error_clear(struct t_jsonrpc_parse_error *parse_error) {
     FREE_SDS(parse_error->path);
 }
 
+/**
+ * Parses the json document once and indexes the paths of all object members.
+ * The json_get_* functions of this thread use the index for lookups in this document
+ * until json_index_free is called.
+ * @param s json document to index
+ */
+void json_index_create(sds s) {
+    json_index_free();
+    const char *p;
+    int n;
+    int vtype = mjson_find(s, (int)sdslen(s), "$", &p, &n);
+    if (vtype != MJSON_TOK_OBJECT) {
+        return;
+    }
+    json_index = malloc_assert(sizeof(struct t_json_index));
+    json_index->buf = s;
+    json_index->len = (int)sdslen(s);
+    json_index->paths = raxNew();
+    json_index->tokens_len = 0;
+    json_index->tokens_size = 32;
+    json_index->tokens = malloc_assert(json_index->tokens_size * sizeof(struct t_json_token));
+    json_index_add("$", 1, vtype, (int)(p - s), n);
+    sds path = sdsnewlen("$", 1);
+    json_index_object(s, (int)(p - s), n, &path);
+    FREE_SDS(path);
+}
+
+/**
+ * Frees the json index of this thread
+ */
+void json_index_free(void) {
+    if (json_index == NULL) {
+        return;
+    }
+    raxFree(json_index->paths);
+    FREE_PTR(json_index->tokens);
+    FREE_PTR(json_index);
+}
+
 /**
  * Helper function to get myMPD fields out of a jsonrpc request
  * and return a validated json array
@@ -628,9 +700,13 @@ bool json_get_fields_as_string(sds s, sds *fields, struct t_jsonrpc_parse_error
  * @return true on success else false
  */
 bool json_get_bool(sds s, const char *path, bool *result, struct t_jsonrpc_parse_error *error) {
-    int v = 0;
-    if (mjson_get_bool(s, (int)sdslen(s), path, &v) != 0) {
-        *result = v == 1
+    const char *p;
+    int n;
+    int vtype = json_find(s, path, &p, &n);
+    if (vtype == MJSON_TOK_TRUE ||
+        vtype == MJSON_TOK_FALSE)
+    {
+        *result = vtype == MJSON_TOK_TRUE
             ? true
             : false;
         return true;
@@ -663,7 +739,7 @@ bool json_get_int_max(sds s, const char *path, int *result, struct t_jsonrpc_par
  */
 bool json_get_int(sds s, const char *path, int min, int max, int *result, struct t_jsonrpc_parse_error *error) {
     double value;
-    if (mjson_get_number(s, (int)sdslen(s), path, &value) != 0) {
+    if (json_get_number(s, path, &value) != 0) {
         if (value >= JSONRPC_INT_MIN &&
             value <= JSONRPC_INT_MAX)
         {
@@ -693,7 +769,7 @@ bool json_get_int(sds s, const char *path, int min, int max, int *result, struct
  */
 bool json_get_time_max(sds s, const char *path, time_t *result, struct t_jsonrpc_parse_error *error) {
     double value;
-    if (mjson_get_number(s, (int)sdslen(s), path, &value) != 0) {
+    if (json_get_number(s, path, &value) != 0) {
         if (value >= JSONRPC_TIME_MIN &&
             value <= JSONRPC_TIME_MAX)
         {
@@ -733,7 +809,7 @@ bool json_get_int64_max(sds s, const char *path, int64_t *result, struct t_jsonr
  */
 bool json_get_int64(sds s, const char *path, int64_t min, int64_t max, int64_t *result, struct t_jsonrpc_parse_error *error) {
     double value;
-    if (mjson_get_number(s, (int)sdslen(s), path, &value) != 0) {
+    if (json_get_number(s, path, &value) != 0) {
         if (value >= (double)JSONRPC_INT64_MIN &&
             value <= (double)JSONRPC_INT64_MAX)
         {
@@ -775,7 +851,7 @@ bool json_get_uint_max(sds s, const char *path, unsigned *result, struct t_jsonr
  */
 bool json_get_uint(sds s, const char *path, unsigned min, unsigned max, unsigned *result, struct t_jsonrpc_parse_error *error) {
     double value;
-    if (mjson_get_number(s, (int)sdslen(s), path, &value) != 0) {
+    if (json_get_number(s, path, &value) != 0) {
         if (value >= JSONRPC_UINT_MIN &&
             value <= JSONRPC_UINT_MAX)
         {
@@ -877,7 +953,7 @@ bool json_iterate_object(sds s, const char *path, iterate_callback icb, void *ic
     }
     const char *p;
     int n;
-    int otype = mjson_find(s, (int)sdslen(s), path, &p, &n);
+    int otype = json_find(s, path, &p, &n);
     if (otype != MJSON_TOK_OBJECT &&
         otype != MJSON_TOK_ARRAY)
     {
@@ -1162,7 +1238,7 @@ bool json_get_fields(sds s, const char *path, struct t_fields *tags, int max_ele
 bool json_find_key(sds s, const char *path) {
     const char *p;
     int n;
-    int vtype = mjson_find(s, (int)sdslen(s), path, &p, &n);
+    int vtype = json_find(s, path, &p, &n);
     return vtype == MJSON_TOK_INVALID ? false : true;
 }
 
@@ -1175,7 +1251,7 @@ bool json_find_key(sds s, const char *path) {
 sds json_get_key_as_sds(sds s, const char *path) {
     const char *p;
     int n;
-    if (mjson_find(s, (int)sdslen(s), path, &p, &n) == MJSON_TOK_INVALID) {
+    if (json_find(s, path, &p, &n) == MJSON_TOK_INVALID) {
         return false;
     }
     return sdsnewlen(p, (size_t)n);
@@ -1322,7 +1398,7 @@ static bool json_get_string_unescape(sds s, const char *path, size_t min, size_t
     }
     const char *p;
     int n;
-    int vtype = mjson_find(s, (int)sdslen(s), path, &p, &n);
+    int vtype = json_find(s, path, &p, &n);
     if (vtype != MJSON_TOK_STRING) {
         *result = NULL;
         set_parse_error(error, path, "", "JSON path \"%s\" not found or value is not string type, found type is \"%s\"",
@@ -1362,3 +1438,100 @@ static bool json_get_string_unescape(sds s, const char *path, size_t min, size_t
 
     return true;
 }
+
+/**
+ * Finds the value for a json path, uses the json index if the document is indexed
+ * @param s json document
+ * @param path mjson path expression
+ * @param p pointer to set to the value
+ * @param n pointer to set to the value length
+ * @return mjson token type, MJSON_TOK_INVALID if not found
+ */
+static int json_find(sds s, const char *path, const char **p, int *n) {
+    if (json_index == NULL ||
+        json_index->buf != s ||
+        json_index->len != (int)sdslen(s) ||
+        strchr(path, '[') != NULL)
+    {
+        return mjson_find(s, (int)sdslen(s), path, p, n);
+    }
+    void *data;
+    if (raxFind(json_index->paths, (unsigned char *)path, strlen(path), &data) == 0) {
+        return MJSON_TOK_INVALID;
+    }
+    const struct t_json_token *token = &json_index->tokens[(uintptr_t)data];
+    *p = s + token->off;
+    *n = token->len;
+    return token->type;
+}
+
+/**
+ * Gets a number by json path
+ * @param s json document
+ * @param path mjson path expression
+ * @param value pointer to set to the number
+ * @return 1 on success, else 0
+ */
+static int json_get_number(sds s, const char *path, double *value) {
+    const char *p;
+    int n;
+    if (json_find(s, path, &p, &n) != MJSON_TOK_NUMBER) {
+        return 0;
+    }
+    return mjson_get_number(p, n, "$", value);
+}
+
+/**
+ * Adds a token to the json index
+ * @param path path of the value
+ * @param path_len length of the path
+ * @param type mjson token type
+ * @param off offset of the value in the document
+ * @param len length of the value
+ * @return true on success, false if the path is already indexed
+ */
+static bool json_index_add(const char *path, size_t path_len, int type, int off, int len) {
+    //mjson_find returns the first match for duplicate keys
+    if (raxTryInsert(json_index->paths, (unsigned char *)path, path_len, (void *)(uintptr_t)json_index->tokens_len, NULL) == 0) {
+        return false;
+    }
+    if (json_index->tokens_len == json_index->tokens_size) {
+        json_index->tokens_size *= 2;
+        json_index->tokens = realloc_assert(json_index->tokens, json_index->tokens_size * sizeof(struct t_json_token));
+    }
+    struct t_json_token *token = &json_index->tokens[json_index->tokens_len++];
+    token->type = type;
+    token->off = off;
+    token->len = len;
+    return true;
+}
+
+/**
+ * Adds the members of a json object to the json index, recurses into objects.
+ * Arrays are indexed as one token, its members are iterated by the callers.
+ * @param buf the json document
+ * @param off offset of the object in the document
+ * @param len length of the object
+ * @param path pointer to the path of the object
+ */
+static void json_index_object(const char *buf, int off, int len, sds *path) {
+    int koff = 0;
+    int klen = 0;
+    int voff = 0;
+    int vlen = 0;
+    int vtype = 0;
+    size_t path_len = sdslen(*path);
+    for (int next = 0; (next = mjson_next(buf + off, len, next, &koff, &klen, &voff, &vlen, &vtype)) != 0;) {
+        if (klen < 2) {
+            continue;
+        }
+        *path = sdscatlen(*path, ".", 1);
+        *path = sdscatlen(*path, buf + off + koff + 1, (size_t)(klen - 2));
+        if (json_index_add(*path, sdslen(*path), vtype, off + voff, vlen) == true &&
+            vtype == MJSON_TOK_OBJECT)
+        {
+            json_index_object(buf, off + voff, vlen, path);
+        }
+        sdssubstr(*path, 0, path_len);
+    }
+}
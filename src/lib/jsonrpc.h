@@ -154,6 +154,8 @@ bool json_iterate_object(sds s, const char *path, iterate_callback icb, void *ic
 bool json_get_fields(sds s, const char *path, struct t_fields *tags, int max_elements, struct t_jsonrpc_parse_error *error);
 bool json_get_tag_values(sds s, const char *path, struct mpd_song *song, validate_callback vcb, int max_elements, struct t_jsonrpc_parse_error *error);
 
+void json_index_create(sds s);
+void json_index_free(void);
 bool json_find_key(sds s, const char *path);
 sds json_get_key_as_sds(sds s, const char *path);
 
@@ -18,8 +18,20 @@
 #include "src/lib/random.h"
 #include "src/lib/sds_extras.h"
 
+#include <stdint.h>
 #include <string.h>
 
+/**
+ * Private definitions
+ */
+
+static void list_index_update(struct t_list *l, struct t_list_node *n, int delta);
+static bool list_index_find(const struct t_list *l, char type, const char *str);
+
+/**
+ * Public functions
+ */
+
 /**
  * Mallocs a new list and inits it.
  * @return allocated empty list
@@ -71,6 +83,61 @@ void list_init(struct t_list *l) {
     l->length = 0;
     l->head = NULL;
     l->tail = NULL;
+    l->index = NULL;
+}
+
+/**
+ * Enables the index for keys and values of the list.
+ * The index is maintained by all list functions and speeds up lookups by key.
+ * It is dropped by clearing the list, nodes keys and values must not be
+ * modified directly while the index is enabled.
+ * @param l pointer to list
+ */
+void list_index_enable(struct t_list *l) {
+    if (l->index != NULL) {
+        return;
+    }
+    l->index = raxNew();
+    struct t_list_node *current = l->head;
+    while (current != NULL) {
+        list_index_update(l, current, 1);
+        current = current->next;
+    }
+}
+
+/**
+ * Checks if the list contains a node with the key
+ * @param l pointer to list
+ * @param key key to check
+ * @return true if the key exists, else false
+ */
+bool list_has_key(const struct t_list *l, const char *key) {
+    if (l->index != NULL) {
+        return list_index_find(l, 'k', key);
+    }
+    return list_get_node(l, key) != NULL;
+}
+
+/**
+ * Checks if the list contains a node with the value
+ * @param l pointer to list
+ * @param value value_p to check
+ * @return true if the value exists, else false
+ */
+bool list_has_value(const struct t_list *l, const char *value) {
+    if (l->index != NULL) {
+        return list_index_find(l, 'v', value);
+    }
+    struct t_list_node *current = l->head;
+    while (current != NULL) {
+        if (current->value_p != NULL &&
+            strcmp(current->value_p, value) == 0)
+        {
+            return true;
+        }
+        current = current->next;
+    }
+    return false;
 }
 
 /**
@@ -102,6 +169,9 @@ void *list_free(struct t_list *l) {
  * @param free_cb
  */
 void list_clear_user_data(struct t_list *l, user_data_callback free_cb) {
+    if (l->index != NULL) {
+        raxFree(l->index);
+    }
     struct t_list_node *current = l->head;
     struct t_list_node *tmp = NULL;
     while (current != NULL) {
@@ -157,6 +227,11 @@ void list_free_cb_ptr_user_data(struct t_list_node *current) {
  * @return int index of the key, UINT_MAX if not found
  */
 unsigned list_get_node_idx(const struct t_list *l, const char *key) {
+    if (l->index != NULL &&
+        list_index_find(l, 'k', key) == false)
+    {
+        return UINT_MAX;
+    }
     struct t_list_node *current = l->head;
     unsigned i = 0;
     while (current != NULL) {
@@ -176,6 +251,11 @@ unsigned list_get_node_idx(const struct t_list *l, const char *key) {
  * @return pointer to list node
  */
 struct t_list_node *list_get_node(const struct t_list *l, const char *key) {
+    if (l->index != NULL &&
+        list_index_find(l, 'k', key) == false)
+    {
+        return NULL;
+    }
     struct t_list_node *current = l->head;
     while (current != NULL) {
         if (strcmp(current->key, key) == 0) {
@@ -270,6 +350,8 @@ bool list_move_item_pos(struct t_list *l, unsigned from, unsigned to) {
     }
 
     l->length++;
+    //list_node_extract removed the node from the index
+    list_index_update(l, node, 1);
 
     return true;
 }
@@ -362,6 +444,7 @@ bool list_push_len(struct t_list *l, const char *key, size_t key_len, int64_t va
     n->value_p = value_p != NULL ? sdsnewlen(value_p, value_len) : NULL;
     n->user_data = user_data;
     n->next = NULL;
+    list_index_update(l, n, 1);
 
     if (l->head == NULL) {
         //first entry in the list
@@ -395,6 +478,7 @@ bool list_insert(struct t_list *l, const char *key, int64_t value_i,
     n->value_i = value_i;
     n->value_p = value_p != NULL ? sdsnew(value_p) : NULL;
     n->user_data = user_data;
+    list_index_update(l, n, 1);
 
     //switch head pointer
     n->next = l->head;
@@ -489,6 +573,7 @@ bool list_replace_len_user_data(struct t_list *l, unsigned idx, const char *key,
     }
     struct t_list_node *current = list_node_at(l, idx);
 
+    list_index_update(l, current, -1);
     current->key = sds_replacelen(current->key, key, key_len);
     current->value_i = value_i;
     if (value_p != NULL) {
@@ -497,6 +582,7 @@ bool list_replace_len_user_data(struct t_list *l, unsigned idx, const char *key,
     else if (current->value_p != NULL) {
         FREE_SDS(current->value_p);
     }
+    list_index_update(l, current, 1);
     if (current->user_data != NULL &&
         free_cb != NULL)
     {
@@ -588,6 +674,11 @@ bool list_remove_node_by_key(struct t_list *l, const char *key) {
  * @return bool true on success, else false
  */
 bool list_remove_node_by_key_user_data(struct t_list *l, const char *key, user_data_callback free_cb) {
+    if (l->index != NULL &&
+        list_index_find(l, 'k', key) == false)
+    {
+        return false;
+    }
     struct t_list_node *current = l->head;
     unsigned i = 0;
     while (current != NULL) {
@@ -644,6 +735,7 @@ struct t_list_node *list_node_extract(struct t_list *l, unsigned idx) {
         l->tail = previous;
     }
     l->length--;
+    list_index_update(l, current, -1);
 
     //null out this node's next value since it's not part of a list anymore
     current->next = NULL;
@@ -696,7 +788,11 @@ void list_crop(struct t_list *l, unsigned length, user_data_callback free_cb) {
         return;
     }
     if (length == 0) {
+        bool indexed = l->index != NULL;
         list_clear(l);
+        if (indexed == true) {
+            list_index_enable(l);
+        }
         return;
     }
     unsigned idx = length - 1;
@@ -704,6 +800,7 @@ void list_crop(struct t_list *l, unsigned length, user_data_callback free_cb) {
     struct t_list_node *current = last->next;
     while (current != NULL) {
         struct t_list_node *next = current->next;
+        list_index_update(l, current, -1);
         list_node_free_user_data(current, free_cb);
         current = next;
     }
@@ -762,35 +859,98 @@ static bool list_sort_cmp_key(struct t_list_node *current, struct t_list_node *n
     return false;
 }
 
+/**
+ * Merges two sorted node chains
+ * @param left first sorted chain
+ * @param right second sorted chain
+ * @param direction sort direction
+ * @param sort_cb compare function
+ * @param tail pointer to set to the last node of the merged chain
+ * @return head of the merged chain
+ */
+static struct t_list_node *list_sort_merge(struct t_list_node *left, struct t_list_node *right,
+        enum list_sort_direction direction, list_sort_callback sort_cb, struct t_list_node **tail)
+{
+    struct t_list_node head;
+    struct t_list_node *current = &head;
+    while (left != NULL && right != NULL) {
+        //take from the left chain on equal nodes to keep the sort stable
+        if (sort_cb(left, right, direction) == true) {
+            current->next = right;
+            right = right->next;
+        }
+        else {
+            current->next = left;
+            left = left->next;
+        }
+        current = current->next;
+    }
+    current->next = left != NULL
+        ? left
+        : right;
+    while (current->next != NULL) {
+        current = current->next;
+    }
+    *tail = current;
+    return head.next;
+}
+
+/**
+ * Detaches a chain of up to count nodes
+ * @param start first node of the chain
+ * @param count max number of nodes
+ * @return first node after the detached chain
+ */
+static struct t_list_node *list_sort_split(struct t_list_node *start, unsigned count) {
+    for (unsigned i = 1; start != NULL && i < count; i++) {
+        start = start->next;
+    }
+    if (start == NULL) {
+        return NULL;
+    }
+    struct t_list_node *rest = start->next;
+    start->next = NULL;
+    return rest;
+}
+
 /**
  * The list sorting function.
- * Note that the sort is not very efficient, use it only for short lists.
+ * This is a stable bottom-up merge sort that relinks the nodes.
  * @param l pointer to list to sort
  * @param direction sort direction
  * @param sort_cb compare function
  * @return true on success, else false
  */
 bool list_sort_by_callback(struct t_list *l, enum list_sort_direction direction, list_sort_callback sort_cb) {
-    int swapped;
-    struct t_list_node *ptr1;
-    struct t_list_node *lptr = NULL;
-
     if (l->head == NULL) {
         return false;
     }
 
-    do {
-        swapped = 0;
-        ptr1 = l->head;
-        while (ptr1->next != lptr) {
-            if (sort_cb(ptr1, ptr1->next, direction) == true) {
-                list_swap_item(ptr1, ptr1->next);
-                swapped = 1;
+    struct t_list_node *head = l->head;
+    struct t_list_node *tail = l->tail;
+    for (unsigned width = 1; width < l->length; width *= 2) {
+        struct t_list_node *rest = head;
+        struct t_list_node *merged_head = NULL;
+        struct t_list_node *merged_tail = NULL;
+        while (rest != NULL) {
+            struct t_list_node *left = rest;
+            struct t_list_node *right = list_sort_split(left, width);
+            rest = list_sort_split(right, width);
+            struct t_list_node *chain_tail;
+            struct t_list_node *chain_head = list_sort_merge(left, right, direction, sort_cb, &chain_tail);
+            if (merged_tail == NULL) {
+                merged_head = chain_head;
+            }
+            else {
+                merged_tail->next = chain_head;
             }
-            ptr1 = ptr1->next;
+            merged_tail = chain_tail;
         }
-        lptr = ptr1;
-    } while (swapped);
+        head = merged_head;
+        tail = merged_tail;
+    }
+    l->head = head;
+    l->tail = tail;
     return true;
 }
 
@@ -823,3 +983,59 @@ bool list_sort_by_value_p(struct t_list *l, enum list_sort_direction direction)
 bool list_sort_by_key(struct t_list *l, enum list_sort_direction direction) {
     return list_sort_by_callback(l, direction, list_sort_cmp_key);
 }
+
+/**
+ * Private functions
+ */
+
+/**
+ * Adds or removes the key and value of a node to the list index
+ * @param l pointer to list
+ * @param n list node
+ * @param delta 1 to add, -1 to remove
+ */
+static void list_index_update(struct t_list *l, struct t_list_node *n, int delta) {
+    if (l->index == NULL) {
+        return;
+    }
+    sds entries[2];
+    entries[0] = sdscatsds(sdsnewlen("k", 1), n->key);
+    entries[1] = n->value_p != NULL
+        ? sdscatsds(sdsnewlen("v", 1), n->value_p)
+        : NULL;
+    for (unsigned i = 0; i < 2; i++) {
+        if (entries[i] == NULL) {
+            continue;
+        }
+        //the data pointer is the number of nodes with this key or value
+        void *data;
+        uintptr_t count = raxFind(l->index, (unsigned char *)entries[i], sdslen(entries[i]), &data) == 1
+            ? (uintptr_t)data
+            : 0;
+        if (delta > 0) {
+            raxInsert(l->index, (unsigned char *)entries[i], sdslen(entries[i]), (void *)(count + 1), NULL);
+        }
+        else if (count > 1) {
+            raxInsert(l->index, (unsigned char *)entries[i], sdslen(entries[i]), (void *)(count - 1), NULL);
+        }
+        else {
+            raxRemove(l->index, (unsigned char *)entries[i], sdslen(entries[i]), NULL);
+        }
+        FREE_SDS(entries[i]);
+    }
+}
+
+/**
+ * Looks up a key or value in the list index
+ * @param l pointer to list
+ * @param type 'k' for keys, 'v' for values
+ * @param str string to lookup
+ * @return true if found, else false
+ */
+static bool list_index_find(const struct t_list *l, char type, const char *str) {
+    sds lookup = sdscat(sdsnewlen(&type, 1), str);
+    void *data;
+    bool found = raxFind(l->index, (unsigned char *)lookup, sdslen(lookup), &data) == 1;
+    FREE_SDS(lookup);
+    return found;
+}
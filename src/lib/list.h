@@ -11,6 +11,7 @@
 #ifndef MYMPD_LIST_H
 #define MYMPD_LIST_H
 
+#include "dist/rax/rax.h"
 #include "dist/sds/sds.h"
 
 #include <stdbool.h>
@@ -33,6 +34,7 @@ struct t_list {
     unsigned length;           //!< length of the list
     struct t_list_node *head;  //!< pointer to first node
     struct t_list_node *tail;  //!< pointer to last node
+    rax *index;                //!< optional index of keys and values, NULL if not enabled
 };
 
 /**
@@ -62,6 +64,9 @@ struct t_list *list_new(void);
 struct t_list *list_dup(struct t_list *l);
 bool list_append(struct t_list *dst, struct t_list *src);
 void list_init(struct t_list *l);
+void list_index_enable(struct t_list *l);
+bool list_has_key(const struct t_list *l, const char *key);
+bool list_has_value(const struct t_list *l, const char *value);
 void list_clear(struct t_list *l);
 void *list_free(struct t_list *l);
 void list_clear_user_data(struct t_list *l, user_data_callback free_cb);
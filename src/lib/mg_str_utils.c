@@ -14,6 +14,15 @@
 #include "src/lib/convert.h"
 #include "src/lib/sds_extras.h"
 
+#include <ctype.h>
+
+// Private definitions
+
+static struct mg_str mg_str_trim(struct mg_str str);
+static bool qvalue_is_positive(struct mg_str qvalue);
+
+// Public functions
+
 /**
  * Converts a mg_str to int
  * @param str pointer to struct mg_str
@@ -43,3 +52,92 @@ unsigned mg_str_to_uint(const struct mg_str *str) {
         ? i
         : 0;
 }
+
+/**
+ * Checks if a content coding is acceptable for the client.
+ * Parses the Accept-Encoding header value as defined in RFC 9110,
+ * codings with a qvalue of 0 are not acceptable.
+ * @param accept_encoding value of the Accept-Encoding header
+ * @param coding content coding to check, e.g. "br"
+ * @return true if the coding is acceptable, else false
+ */
+bool mg_str_accepts_encoding(const struct mg_str *accept_encoding, const char *coding) {
+    struct mg_str list = *accept_encoding;
+    struct mg_str entry;
+    bool wildcard = false;
+    while (mg_span(list, &entry, &list, ',')) {
+        struct mg_str name;
+        struct mg_str params;
+        struct mg_str param;
+        mg_span(entry, &name, &params, ';');
+        bool positive = true;
+        while (mg_span(params, &param, &params, ';')) {
+            param = mg_str_trim(param);
+            if (param.len >= 2 &&
+                (param.buf[0] == 'q' || param.buf[0] == 'Q') &&
+                param.buf[1] == '=')
+            {
+                positive = qvalue_is_positive(mg_str_n(param.buf + 2, param.len - 2));
+            }
+        }
+        name = mg_str_trim(name);
+        if (mg_strcasecmp(name, mg_str(coding)) == 0) {
+            return positive;
+        }
+        if (mg_strcmp(name, mg_str("*")) == 0) {
+            wildcard = positive;
+        }
+    }
+    return wildcard;
+}
+
+// Private functions
+
+/**
+ * Removes leading and trailing whitespace
+ * @param str mongoose string
+ * @return trimmed string, it points to the same buffer
+ */
+static struct mg_str mg_str_trim(struct mg_str str) {
+    while (str.len > 0 && isspace((unsigned char)str.buf[0])) {
+        str.buf++;
+        str.len--;
+    }
+    while (str.len > 0 && isspace((unsigned char)str.buf[str.len - 1])) {
+        str.len--;
+    }
+    return str;
+}
+
+/**
+ * Checks if a qvalue is greater than 0.
+ * qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] )
+ * @param qvalue the qvalue
+ * @return true if the qvalue is valid and greater than 0, else false
+ */
+static bool qvalue_is_positive(struct mg_str qvalue) {
+    if (qvalue.len == 0 ||
+        (qvalue.buf[0] != '0' && qvalue.buf[0] != '1'))
+    {
+        return false;
+    }
+    if (qvalue.len > 1 &&
+        (qvalue.buf[1] != '.' || qvalue.len > 5))
+    {
+        return false;
+    }
+    bool positive = qvalue.buf[0] == '1';
+    for (size_t i = 2; i < qvalue.len; i++) {
+        if (isdigit((unsigned char)qvalue.buf[i]) == 0) {
+            return false;
+        }
+        if (qvalue.buf[i] != '0') {
+            if (qvalue.buf[0] == '1') {
+                // values greater than 1 are invalid
+                return false;
+            }
+            positive = true;
+        }
+    }
+    return positive;
+}
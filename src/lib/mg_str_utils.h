@@ -15,5 +15,6 @@
 
 int mg_str_to_int(const struct mg_str *str);
 unsigned mg_str_to_uint(const struct mg_str *str);
+bool mg_str_accepts_encoding(const struct mg_str *accept_encoding, const char *coding);
 
 #endif
@@ -22,6 +22,8 @@
 #endif
 
 #include <errno.h>
+#include <sched.h>
+#include <string.h>
 
 /*
  Message queue implementation to transfer messages between threads asynchronously
@@ -30,6 +32,20 @@
 //private definitions
 static bool check_for_queue_id(struct t_mympd_queue *queue, unsigned id);
 static void free_queue_node(struct t_mympd_msg *n, enum mympd_queue_types type);
+static void free_queue_data(void *data, enum mympd_queue_types type);
+static void queue_wakeup(struct t_mympd_queue *queue);
+static struct t_mympd_ring *ring_new(void);
+static bool ring_push(struct t_mympd_ring *ring, void *data, unsigned id);
+static void *ring_shift(struct t_mympd_ring *ring);
+static void *ring_free(struct t_mympd_ring *ring, enum mympd_queue_types type);
+static bool queue_list_push(struct t_mympd_queue *queue, void *data, unsigned id);
+static void *queue_list_shift(struct t_mympd_queue *queue, unsigned id);
+static int queue_list_expire_age(struct t_mympd_queue *queue, time_t max_age_s);
+static void *ring_mode_shift(struct t_mympd_queue *queue);
+static void mailbox_push(struct t_mympd_queue *queue, struct t_mympd_msg *msg);
+static void *mailbox_shift(struct t_mympd_queue *queue, unsigned id);
+static void *mailbox_mode_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id);
+static int mailbox_expire_age(struct t_mympd_queue *queue, time_t max_age_s);
 static void free_queue_node_extra(void *extra, enum mympd_cmd_ids cmd_id);
 static int unlock_mutex(pthread_mutex_t *mutex);
 static void set_wait_time(int timeout_ms, struct timespec *max_wait);
@@ -40,17 +56,25 @@ static void set_wait_time(int timeout_ms, struct timespec *max_wait);
  * Creates a thread safe message queue
  * @param name description of the queue
  * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ * @param mode the queue mode
  * @param event create an eventfd?
  * @return pointer to allocated and initialized queue struct
  */
 struct t_mympd_queue *mympd_queue_create(const char *name, enum mympd_queue_types type,
-        bool event) {
+        enum mympd_queue_modes mode, bool event) {
     struct t_mympd_queue *queue = malloc_assert(sizeof(struct t_mympd_queue));
     queue->head = NULL;
     queue->tail = NULL;
     queue->length = 0;
     queue->name = name;
     queue->type = type;
+    queue->mode = mode;
+    queue->ring = mode == QUEUE_MODE_RING
+        ? ring_new()
+        : NULL;
+    queue->mailbox = mode == QUEUE_MODE_MAILBOX
+        ? raxNew()
+        : NULL;
     queue->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
     queue->wakeup = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
     queue->event_fd = event == true
@@ -67,7 +91,18 @@ struct t_mympd_queue *mympd_queue_create(const char *name, enum mympd_queue_type
  * @return NULL
  */
 void *mympd_queue_free(struct t_mympd_queue *queue) {
-    mympd_queue_expire_age(queue, 0);
+    if (queue->mode == QUEUE_MODE_MAILBOX) {
+        mailbox_expire_age(queue, 0);
+    }
+    else {
+        queue_list_expire_age(queue, 0);
+    }
+    if (queue->ring != NULL) {
+        queue->ring = ring_free(queue->ring, queue->type);
+    }
+    if (queue->mailbox != NULL) {
+        raxFree(queue->mailbox);
+    }
     event_fd_close(queue->event_fd);
     FREE_PTR(queue);
     return NULL;
@@ -81,40 +116,29 @@ void *mympd_queue_free(struct t_mympd_queue *queue) {
  * @return true on success else false
  */
 bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id) {
-    int rc = pthread_mutex_lock(&queue->mutex);
-    if (rc != 0) {
-        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
-        return false;
-    }
-    struct t_mympd_msg* new_node = malloc_assert(sizeof(struct t_mympd_msg));
-    new_node->data = data;
-    new_node->id = id;
-    new_node->timestamp = time(NULL);
-    new_node->next = NULL;
-    queue->length++;
-    if (queue->head == NULL &&
-        queue->tail == NULL)
-    {
-        queue->head = queue->tail = new_node;
-    }
-    else {
-        queue->tail->next = new_node;
-        queue->tail = new_node;
+    if (queue->mode == QUEUE_MODE_RING) {
+        //use the overflow list if the ring is full or the overflow list is not empty to keep the order
+        if (atomic_load_explicit(&queue->ring->overflow, memory_order_acquire) > 0 ||
+            ring_push(queue->ring, data, id) == false)
+        {
+            if (queue_list_push(queue, data, id) == false) {
+                return false;
+            }
+        }
+        queue_wakeup(queue);
+        return true;
     }
-    if (unlock_mutex(&queue->mutex) != 0) {
+    if (queue_list_push(queue, data, id) == false) {
         return false;
     }
-    rc = pthread_cond_signal(&queue->wakeup);
+    int rc = queue->mode == QUEUE_MODE_MAILBOX
+        ? pthread_cond_broadcast(&queue->wakeup)
+        : pthread_cond_signal(&queue->wakeup);
     if (rc != 0) {
         MYMPD_LOG_ERROR(NULL, "Error in pthread_cond_signal: %d", rc);
         return 0;
     }
-    if (queue->event_fd > -1) {
-        event_eventfd_write(queue->event_fd);
-    }
-    else if (queue->mg_mgr != NULL) {
-        mg_wakeup(queue->mg_mgr, queue->mg_conn_id, "Q", 1);
-    }
+    queue_wakeup(queue);
     return true;
 }
 
@@ -124,10 +148,25 @@ bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id) {
  * @param timeout_ms timeout in ms to wait for a queue entry,
  *                   0 to wait infinite
  *                   -1 for no wait
+ *                   ring mode supports only -1
  * @param id 0 for first entry or specific id
- * @return t_work_request or t_work_response
+ *           ring mode supports only 0
+ * @return t_work_request or t_work_response,
+ *         NULL if the queue is empty or the arguments are not supported by the queue mode
  */
 void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id) {
+    if (queue->mode == QUEUE_MODE_RING) {
+        if (timeout_ms != -1 ||
+            id != 0)
+        {
+            MYMPD_LOG_ERROR(NULL, "Queue %s supports only shifting the first entry without waiting", queue->name);
+            return NULL;
+        }
+        return ring_mode_shift(queue);
+    }
+    if (queue->mode == QUEUE_MODE_MAILBOX) {
+        return mailbox_mode_shift(queue, timeout_ms, id);
+    }
     //lock the queue
     int rc = pthread_mutex_lock(&queue->mutex);
     if (rc != 0) {
@@ -158,53 +197,207 @@ void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id
             }
         }
     }
-    if (queue->head != NULL) {
-        //queue has entry
-        struct t_mympd_msg *current = NULL;
-        struct t_mympd_msg *previous = NULL;
+    void *data = queue_list_shift(queue, id);
+    unlock_mutex(&queue->mutex);
+    return data;
+}
 
-        for (current = queue->head; current != NULL; previous = current, current = current->next) {
-            if (id == 0 ||
-                id == current->id)
-            {
-                void *data = current->data;
-                if (previous == NULL) {
-                    //Fix beginning pointer
-                    queue->head = current->next;
-                }
-                else {
-                    //Fix previous nodes next to skip over the removed node.
-                    previous->next = current->next;
-                }
-                //Fix tail
-                if (queue->tail == current) {
-                    queue->tail = previous;
-                }
-                FREE_PTR(current);
-                queue->length--;
-                MYMPD_LOG_DEBUG(NULL, "Queue \"%s\": %u entries", queue->name, queue->length);
-                unlock_mutex(&queue->mutex);
-                return data;
-            }
-            MYMPD_LOG_DEBUG(NULL, "Skipping queue entry with id %u", current->id);
-        }
+/**
+ * Wakes up all threads waiting in mympd_queue_shift.
+ * The waiters return NULL if the queue is still empty.
+ * @param queue pointer to the queue
+ */
+void mympd_queue_wakeup_all(struct t_mympd_queue *queue) {
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return;
     }
+    pthread_cond_broadcast(&queue->wakeup);
     unlock_mutex(&queue->mutex);
-    return NULL;
 }
 
 /**
  * Expire entries from the queue by age
  * @param queue pointer to the queue
  * @param max_age_s max age of nodes in seconds
- * @return number of expired nodes
+ * @return number of expired nodes, ring mode is not supported
  */
 int mympd_queue_expire_age(struct t_mympd_queue *queue, time_t max_age_s) {
+    if (queue->mode == QUEUE_MODE_RING) {
+        // only the consumer thread can remove messages from the ring
+        MYMPD_LOG_ERROR(NULL, "Queue %s does not support expiring entries", queue->name);
+        return 0;
+    }
     int rc = pthread_mutex_lock(&queue->mutex);
     if (rc != 0) {
         MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
         return 0;
     }
+    int expired_count = queue->mode == QUEUE_MODE_MAILBOX
+        ? mailbox_expire_age(queue, max_age_s)
+        : queue_list_expire_age(queue, max_age_s);
+    unlock_mutex(&queue->mutex);
+    return expired_count;
+}
+
+//privat functions
+
+/**
+ * Checks if queue has a entry with requested id
+ * @param queue Pointer to the queue
+ * @param id 0 for first entry or specific id
+ * @return true if there is an entry, else false
+ */
+static bool check_for_queue_id(struct t_mympd_queue *queue, unsigned id) {
+    if (queue->length == 0) {
+        MYMPD_LOG_DEBUG(NULL, "Queue %s is empty", queue->name);
+        return false;
+    }
+    if (id == 0) {
+        return true;
+    }
+    struct t_mympd_msg *current = queue->head;
+    while (current != NULL) {
+        if (current->id == id) {
+            return true;
+        }
+        current = current->next;
+    }
+    MYMPD_LOG_DEBUG(NULL, "No entry with id %u found in queue %s", id, queue->name);
+    return false;
+}
+
+/**
+ * Frees a queue node, node must be detached from queue
+ * @param node to free
+ * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ */
+static void free_queue_node(struct t_mympd_msg *node, enum mympd_queue_types type) {
+    free_queue_data(node->data, type);
+    //free the node itself
+    FREE_PTR(node);
+}
+
+/**
+ * Frees the data of a queue node
+ * @param data t_work_request or t_work_response
+ * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ */
+static void free_queue_data(void *data, enum mympd_queue_types type) {
+    if (type == QUEUE_TYPE_REQUEST) {
+        struct t_work_request *request = data;
+        free_queue_node_extra(request->extra, request->cmd_id);
+        free_request(request);
+    }
+    else {
+        //QUEUE_TYPE_RESPONSE
+        struct t_work_response *response = data;
+        free_queue_node_extra(response->extra, response->cmd_id);
+        free_response(response);
+    }
+}
+
+/**
+ * Wakes up the event loop of the consumer
+ * @param queue pointer to the queue
+ */
+static void queue_wakeup(struct t_mympd_queue *queue) {
+    if (queue->event_fd > -1) {
+        event_eventfd_write(queue->event_fd);
+    }
+    else if (queue->mg_mgr != NULL) {
+        mg_wakeup(queue->mg_mgr, queue->mg_conn_id, "Q", 1);
+    }
+}
+
+/**
+ * Appends a message to the list, locks the queue.
+ * The list is the queue itself for list mode, the overflow list for ring mode and
+ * the mailbox for mailbox mode.
+ * @param queue pointer to the queue
+ * @param data struct t_work_request or t_work_response
+ * @param id id of the queue entry
+ * @return true on success else false
+ */
+static bool queue_list_push(struct t_mympd_queue *queue, void *data, unsigned id) {
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return false;
+    }
+    struct t_mympd_msg* new_node = malloc_assert(sizeof(struct t_mympd_msg));
+    new_node->data = data;
+    new_node->id = id;
+    new_node->timestamp = time(NULL);
+    new_node->next = NULL;
+    queue->length++;
+    if (queue->mode == QUEUE_MODE_MAILBOX) {
+        mailbox_push(queue, new_node);
+    }
+    else if (queue->head == NULL &&
+        queue->tail == NULL)
+    {
+        queue->head = queue->tail = new_node;
+    }
+    else {
+        queue->tail->next = new_node;
+        queue->tail = new_node;
+    }
+    if (queue->ring != NULL) {
+        atomic_fetch_add_explicit(&queue->ring->overflow, 1, memory_order_release);
+    }
+    return unlock_mutex(&queue->mutex) == 0;
+}
+
+/**
+ * Removes the first entry or the entry with specific id from the list,
+ * queue must be locked.
+ * @param queue pointer to the queue
+ * @param id 0 for first entry or specific id
+ * @return t_work_request or t_work_response
+ */
+static void *queue_list_shift(struct t_mympd_queue *queue, unsigned id) {
+    struct t_mympd_msg *current = NULL;
+    struct t_mympd_msg *previous = NULL;
+    for (current = queue->head; current != NULL; previous = current, current = current->next) {
+        if (id == 0 ||
+            id == current->id)
+        {
+            void *data = current->data;
+            if (previous == NULL) {
+                //Fix beginning pointer
+                queue->head = current->next;
+            }
+            else {
+                //Fix previous nodes next to skip over the removed node.
+                previous->next = current->next;
+            }
+            //Fix tail
+            if (queue->tail == current) {
+                queue->tail = previous;
+            }
+            FREE_PTR(current);
+            queue->length--;
+            if (queue->ring != NULL) {
+                atomic_fetch_sub_explicit(&queue->ring->overflow, 1, memory_order_release);
+            }
+            MYMPD_LOG_DEBUG(NULL, "Queue \"%s\": %u entries", queue->name, queue->length);
+            return data;
+        }
+        MYMPD_LOG_DEBUG(NULL, "Skipping queue entry with id %u", current->id);
+    }
+    return NULL;
+}
+
+/**
+ * Expires entries from the list by age, the caller must hold the lock.
+ * The list is the queue itself for list mode and the overflow list for ring mode.
+ * @param queue pointer to the queue
+ * @param max_age_s max age of nodes in seconds, 0 to remove all nodes
+ * @return number of expired nodes
+ */
+static int queue_list_expire_age(struct t_mympd_queue *queue, time_t max_age_s) {
     int expired_count = 0;
     if (queue->head != NULL) {
         //queue has entry
@@ -236,6 +429,9 @@ int mympd_queue_expire_age(struct t_mympd_queue *queue, time_t max_age_s) {
                 }
                 free_queue_node(to_remove, queue->type);
                 queue->length--;
+                if (queue->ring != NULL) {
+                    atomic_fetch_sub_explicit(&queue->ring->overflow, 1, memory_order_release);
+                }
                 expired_count++;
             }
             else {
@@ -246,57 +442,269 @@ int mympd_queue_expire_age(struct t_mympd_queue *queue, time_t max_age_s) {
         }
     }
 
-    unlock_mutex(&queue->mutex);
     return expired_count;
 }
 
-//privat functions
+/**
+ * Creates the lock-free ring
+ * @return newly allocated ring
+ */
+static struct t_mympd_ring *ring_new(void) {
+    struct t_mympd_ring *ring = malloc_assert(sizeof(struct t_mympd_ring));
+    ring->slots = malloc_assert(MSG_QUEUE_RING_SIZE * sizeof(struct t_mympd_ring_slot));
+    for (size_t i = 0; i < MSG_QUEUE_RING_SIZE; i++) {
+        atomic_init(&ring->slots[i].seq, i);
+    }
+    atomic_init(&ring->enqueue_pos, 0);
+    ring->dequeue_pos = 0;
+    atomic_init(&ring->overflow, 0);
+    return ring;
+}
 
 /**
- * Checks if queue has a entry with requested id
- * @param queue Pointer to the queue
- * @param id 0 for first entry or specific id
- * @return true if there is an entry, else false
+ * Frees the ring and the data of all remaining messages
+ * @param ring the ring
+ * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ * @return NULL
  */
-static bool check_for_queue_id(struct t_mympd_queue *queue, unsigned id) {
-    if (queue->length == 0) {
-        MYMPD_LOG_DEBUG(NULL, "Queue %s is empty", queue->name);
-        return false;
+static void *ring_free(struct t_mympd_ring *ring, enum mympd_queue_types type) {
+    void *data;
+    while ((data = ring_shift(ring)) != NULL) {
+        free_queue_data(data, type);
     }
-    if (id == 0) {
-        return true;
+    FREE_PTR(ring->slots);
+    FREE_PTR(ring);
+    return NULL;
+}
+
+/**
+ * Claims a slot in the ring and publishes the message
+ * @param ring the ring
+ * @param data struct t_work_request or t_work_response
+ * @param id id of the queue entry
+ * @return true on success, false if the ring is full
+ */
+static bool ring_push(struct t_mympd_ring *ring, void *data, unsigned id) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    struct t_mympd_ring_slot *slot;
+    for (;;) {
+        slot = &ring->slots[pos & (MSG_QUEUE_RING_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+            //pos was updated by the failed exchange
+        }
+        else if (seq < pos) {
+            //the slot was not consumed yet, ring is full
+            return false;
+        }
+        else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
     }
-    struct t_mympd_msg *current = queue->head;
-    while (current != NULL) {
-        if (current->id == id) {
-            return true;
+    slot->msg.data = data;
+    slot->msg.id = id;
+    slot->msg.timestamp = time(NULL);
+    slot->msg.next = NULL;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Gets the first message from the ring, must be called only by the consumer
+ * @param ring the ring
+ * @return t_work_request or t_work_response or NULL if the ring is empty
+ */
+static void *ring_shift(struct t_mympd_ring *ring) {
+    size_t pos = ring->dequeue_pos;
+    struct t_mympd_ring_slot *slot = &ring->slots[pos & (MSG_QUEUE_RING_SIZE - 1)];
+    while (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+        if (atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed) == pos) {
+            //ring is empty
+            return NULL;
         }
-        current = current->next;
+        //the slot is claimed but not yet published
+        sched_yield();
     }
-    MYMPD_LOG_DEBUG(NULL, "No entry with id %u found in queue %s", id, queue->name);
-    return false;
+    void *data = slot->msg.data;
+    atomic_store_explicit(&slot->seq, pos + MSG_QUEUE_RING_SIZE, memory_order_release);
+    ring->dequeue_pos = pos + 1;
+    return data;
 }
 
 /**
- * Frees a queue node, node must be detached from queue
- * @param node to free
- * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ * Gets the first message of a queue in ring mode
+ * @param queue pointer to the queue
+ * @return t_work_request or t_work_response or NULL if the queue is empty
  */
-static void free_queue_node(struct t_mympd_msg *node, enum mympd_queue_types type) {
-    //free data
-    if (type == QUEUE_TYPE_REQUEST) {
-        struct t_work_request *request = node->data;
-        free_queue_node_extra(request->extra, request->cmd_id);
-        free_request(request);
+static void *ring_mode_shift(struct t_mympd_queue *queue) {
+    void *data = ring_shift(queue->ring);
+    if (data != NULL ||
+        atomic_load_explicit(&queue->ring->overflow, memory_order_acquire) == 0)
+    {
+        return data;
+    }
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return NULL;
+    }
+    data = queue_list_shift(queue, 0);
+    unlock_mutex(&queue->mutex);
+    return data;
+}
+
+/**
+ * Appends a message to the chain of its id in the mailbox, queue must be locked
+ * @param queue pointer to the queue
+ * @param msg message to append
+ */
+static void mailbox_push(struct t_mympd_queue *queue, struct t_mympd_msg *msg) {
+    void *data;
+    if (raxFind(queue->mailbox, (unsigned char *)&msg->id, sizeof(msg->id), &data) == 1) {
+        struct t_mympd_msg *current = data;
+        while (current->next != NULL) {
+            current = current->next;
+        }
+        current->next = msg;
+        return;
+    }
+    raxInsert(queue->mailbox, (unsigned char *)&msg->id, sizeof(msg->id), msg, NULL);
+}
+
+/**
+ * Removes the first message for the id from the mailbox, queue must be locked
+ * @param queue pointer to the queue
+ * @param id 0 for any message or specific id
+ * @return t_work_request or t_work_response or NULL if not found
+ */
+static void *mailbox_shift(struct t_mympd_queue *queue, unsigned id) {
+    struct t_mympd_msg *msg = NULL;
+    if (id == 0) {
+        raxIterator iter;
+        raxStart(&iter, queue->mailbox);
+        raxSeek(&iter, "^", NULL, 0);
+        if (raxNext(&iter)) {
+            msg = iter.data;
+        }
+        raxStop(&iter);
     }
     else {
-        //QUEUE_TYPE_RESPONSE
-        struct t_work_response *response = node->data;
-        free_queue_node_extra(response->extra, response->cmd_id);
-        free_response(response);
+        void *data;
+        if (raxFind(queue->mailbox, (unsigned char *)&id, sizeof(id), &data) == 1) {
+            msg = data;
+        }
     }
-    //free the node itself
-    FREE_PTR(node);
+    if (msg == NULL) {
+        return NULL;
+    }
+    if (msg->next != NULL) {
+        raxInsert(queue->mailbox, (unsigned char *)&msg->id, sizeof(msg->id), msg->next, NULL);
+    }
+    else {
+        raxRemove(queue->mailbox, (unsigned char *)&msg->id, sizeof(msg->id), NULL);
+    }
+    void *data = msg->data;
+    FREE_PTR(msg);
+    queue->length--;
+    return data;
+}
+
+/**
+ * Gets the message with specific id from a queue in mailbox mode
+ * @param queue pointer to the queue
+ * @param timeout_ms timeout in ms to wait for a queue entry,
+ *                   0 to wait infinite
+ *                   -1 for no wait
+ * @param id 0 for any entry or specific id
+ * @return t_work_request or t_work_response
+ */
+static void *mailbox_mode_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id) {
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return NULL;
+    }
+    struct timespec max_wait = {0, 0};
+    if (timeout_ms > 0) {
+        set_wait_time(timeout_ms, &max_wait);
+    }
+    void *data;
+    //other ids wake up all waiting threads, wait until the message arrives or the timeout is reached
+    while ((data = mailbox_shift(queue, id)) == NULL &&
+           timeout_ms > -1)
+    {
+        rc = timeout_ms > 0
+            ? pthread_cond_timedwait(&queue->wakeup, &queue->mutex, &max_wait)
+            : pthread_cond_wait(&queue->wakeup, &queue->mutex);
+        if (rc != 0) {
+            if (rc != ETIMEDOUT) {
+                MYMPD_LOG_ERROR(NULL, "Error in pthread_cond_timedwait: %d", rc);
+            }
+            data = mailbox_shift(queue, id);
+            break;
+        }
+    }
+    unlock_mutex(&queue->mutex);
+    return data;
+}
+
+/**
+ * Expire entries from the mailbox by age, queue must be locked
+ * @param queue pointer to the queue
+ * @param max_age_s max age of nodes in seconds, 0 to remove all nodes
+ * @return number of expired nodes
+ */
+static int mailbox_expire_age(struct t_mympd_queue *queue, time_t max_age_s) {
+    int expired_count = 0;
+    time_t expire_time = time(NULL) - max_age_s;
+    unsigned *empty_ids = malloc_assert((queue->mailbox->numele + 1) * sizeof(unsigned));
+    unsigned empty_len = 0;
+    raxIterator iter;
+    raxStart(&iter, queue->mailbox);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_mympd_msg *head = NULL;
+        struct t_mympd_msg *tail = NULL;
+        struct t_mympd_msg *current = iter.data;
+        while (current != NULL) {
+            struct t_mympd_msg *next = current->next;
+            if (max_age_s == 0 ||
+                current->timestamp < expire_time)
+            {
+                free_queue_node(current, queue->type);
+                queue->length--;
+                expired_count++;
+            }
+            else {
+                current->next = NULL;
+                if (tail == NULL) {
+                    head = current;
+                }
+                else {
+                    tail->next = current;
+                }
+                tail = current;
+            }
+            current = next;
+        }
+        if (head == NULL) {
+            memcpy(&empty_ids[empty_len++], iter.key, sizeof(unsigned));
+        }
+        else if (head != iter.data) {
+            raxInsert(queue->mailbox, iter.key, iter.key_len, head, NULL);
+        }
+    }
+    raxStop(&iter);
+    for (unsigned i = 0; i < empty_len; i++) {
+        raxRemove(queue->mailbox, (unsigned char *)&empty_ids[i], sizeof(unsigned), NULL);
+    }
+    FREE_PTR(empty_ids);
+    return expired_count;
 }
 
 /**
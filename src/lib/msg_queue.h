@@ -11,8 +11,12 @@
 #ifndef MYMPD_QUEUE_H
 #define MYMPD_QUEUE_H
 
+#include "dist/rax/rax.h"
+
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <time.h>
 
 /**
@@ -23,6 +27,15 @@ enum mympd_queue_types {
     QUEUE_TYPE_RESPONSE  //!< queue holds only t_work_response entries
 };
 
+/**
+ * Queue modes
+ */
+enum mympd_queue_modes {
+    QUEUE_MODE_LIST,    //!< mutex protected list, supports waiting and shifting by id
+    QUEUE_MODE_RING,    //!< lock-free multi-producer single-consumer ring, supports only non-blocking shifts of the first entry
+    QUEUE_MODE_MAILBOX  //!< mutex protected mailbox keyed by id, for responses waited for by id
+};
+
 /**
  * A message in the queue
  */
@@ -33,13 +46,34 @@ struct t_mympd_msg {
     struct t_mympd_msg *next;  //!< pointer to next message
 };
 
+/**
+ * Slot of the lock-free ring
+ */
+struct t_mympd_ring_slot {
+    atomic_size_t seq;       //!< sequence number of the slot
+    struct t_mympd_msg msg;  //!< the message, next is not used
+};
+
+/**
+ * Bounded lock-free multi-producer single-consumer ring
+ */
+struct t_mympd_ring {
+    atomic_size_t enqueue_pos;         //!< next position to claim for producers
+    size_t dequeue_pos;                //!< next position to read, owned by the consumer
+    atomic_uint overflow;              //!< number of messages in the overflow list of the queue
+    struct t_mympd_ring_slot *slots;   //!< preallocated slots
+};
+
 /**
  * Struct for the thread save message queue
  */
 struct t_mympd_queue {
-    unsigned length;              //!< length of the queue
+    unsigned length;              //!< length of the queue, ring mode: length of the overflow list
     struct t_mympd_msg *head;     //!< pointer to first message
     struct t_mympd_msg *tail;     //!< pointer to last message
+    enum mympd_queue_modes mode;  //!< the queue mode
+    struct t_mympd_ring *ring;    //!< lock-free ring for QUEUE_MODE_RING
+    rax *mailbox;                 //!< id to message chain for QUEUE_MODE_MAILBOX
     pthread_mutex_t mutex;        //!< the mutex
     pthread_cond_t wakeup;        //!< condition variable for the mutex
     const char *name;             //!< descriptive name
@@ -52,9 +86,10 @@ struct t_mympd_queue {
 };
 
 struct t_mympd_queue *mympd_queue_create(const char *name, enum mympd_queue_types type,
-        bool event);
+        enum mympd_queue_modes mode, bool event);
 void *mympd_queue_free(struct t_mympd_queue *queue);
 bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id);
 void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id);
+void mympd_queue_wakeup_all(struct t_mympd_queue *queue);
 int mympd_queue_expire_age(struct t_mympd_queue *queue, time_t max_age_s);
 #endif
@@ -11,7 +11,11 @@
 #include "compile_time.h"
 #include "src/lib/mympd_state.h"
 
+#include "src/lib/album_index.h"
+#include "src/lib/api.h"
+#include "src/lib/album_results.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/cache_rax_song.h"
 #include "src/lib/event.h"
 #include "src/lib/last_played.h"
 #include "src/lib/mem.h"
@@ -20,6 +24,7 @@
 #include "src/lib/utility.h"
 #include "src/lib/webradio.h"
 #include "src/mpd_client/presets.h"
+#include "src/mpd_client/stickerdb.h"
 #include "src/mympd_api/home.h"
 #include "src/mympd_api/timer.h"
 #include "src/mympd_api/trigger.h"
@@ -33,12 +38,13 @@
  */
 void mympd_state_save(struct t_mympd_state *mympd_state, bool free_data) {
     // write album cache to disc
-    // only for simple mode to save the cached uris
+    // only for simple mode to save the cached uris,
+    // the simple mode is never updated incrementally and needs no database update time
     if (mympd_state->config->save_caches == true &&
         mympd_state->config->albums.mode == ALBUM_MODE_SIMPLE)
     {
         album_cache_write(&mympd_state->album_cache, mympd_state->config->workdir,
-            &mympd_state->mpd_state->tags_album, &mympd_state->config->albums, true);
+            &mympd_state->mpd_state->tags_album, &mympd_state->config->albums, 0, true);
     }
     struct t_partition_state *partition_state = mympd_state->partition_state;
     while (partition_state != NULL) {
@@ -109,9 +115,12 @@ void mympd_state_default(struct t_mympd_state *mympd_state, struct t_config *con
     //mpd shared state
     mympd_state->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
     mpd_state_default(mympd_state->mpd_state, config);
+    //timers of the mympd_api thread
+    mympd_timer_heap_init(&mympd_state->timer_heap);
     //mpd partition state
     mympd_state->partition_state = malloc_assert(sizeof(struct t_partition_state));
     partition_state_default(mympd_state->partition_state, MPD_PARTITION_DEFAULT, mympd_state->mpd_state, config);
+    partition_state_timers_init(mympd_state->partition_state, &mympd_state->timer_heap);
     // stickerdb
     // use the partition struct to store the mpd connection for the stickerdb
     mympd_state->stickerdb = malloc_assert(sizeof(struct t_stickerdb_state));
@@ -119,18 +128,34 @@ void mympd_state_default(struct t_mympd_state *mympd_state, struct t_config *con
     // do not use the shared mpd_state - we can connect to another mpd server for stickers
     mympd_state->stickerdb->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
     mpd_state_default(mympd_state->stickerdb->mpd_state, config);
+    // the stickerdb connection of the mympd_api thread receives the sticker idle events
+    mympd_state->stickerdb->mirror_enabled = config->stickers_mirror;
+    // and coalesces the counter writes
+    mympd_state->stickerdb->pending = raxNew();
+    mympd_timer_entry_init(&mympd_state->stickerdb->timer_pending, &mympd_state->timer_heap, PFD_TYPE_TIMER_STICKERDB, NULL, NULL);
     //triggers;
     list_init(&mympd_state->trigger_list);
+    //global states
+    state_store_init(&mympd_state->state_store);
     //home icons
     list_init(&mympd_state->home_list);
     //timer
-    mympd_api_timer_timerlist_init(&mympd_state->timer_list);
+    mympd_api_timer_timerlist_init(&mympd_state->timer_list, &mympd_state->timer_heap);
     //album cache
     cache_init(&mympd_state->album_cache);
+    cache_init(&mympd_state->song_cache);
+    mympd_state->album_index = NULL;
+    list_init(&mympd_state->album_results);
     //init last played songs list
     mympd_state->last_played_count = MYMPD_LAST_PLAYED_COUNT;
     //poll fds
     event_pfd_init(&mympd_state->pfds);
+    mympd_state->loop_stats.wakeups = 0;
+    mympd_state->loop_stats.requests = 0;
+    mympd_state->loop_stats.last_batch = 0;
+    mympd_state->loop_stats.max_batch = 0;
+    mympd_state->loop_stats.capped = 0;
+    mympd_state->mpd_worker_pool = NULL;
     //webradios
     mympd_state->webradiodb = webradios_new();
     mympd_state->webradio_favorites = webradios_new();
@@ -143,6 +168,8 @@ void mympd_state_default(struct t_mympd_state *mympd_state, struct t_config *con
 void mympd_state_free(struct t_mympd_state *mympd_state) {
     //trigger
     mympd_api_trigger_list_clear(&mympd_state->trigger_list);
+    //global states
+    state_store_clear(&mympd_state->state_store);
     //home icons
     list_clear(&mympd_state->home_list);
     //timer
@@ -159,9 +186,15 @@ void mympd_state_free(struct t_mympd_state *mympd_state) {
     //stickerdb
     mpd_state_free(mympd_state->stickerdb->mpd_state);
     stickerdb_state_free(mympd_state->stickerdb);
+    //timers of the mympd_api thread
+    mympd_timer_heap_clear(&mympd_state->timer_heap);
     //caches
+    album_results_clear(&mympd_state->album_results);
+    mympd_state->album_index = album_index_free(mympd_state->album_index);
     album_cache_free(&mympd_state->album_cache);
     cache_free(&mympd_state->album_cache);
+    song_cache_free(&mympd_state->song_cache);
+    cache_free(&mympd_state->song_cache);
     //webradioDB
     webradios_free(mympd_state->webradiodb);
     webradios_free(mympd_state->webradio_favorites);
@@ -326,6 +359,7 @@ void partition_state_default(struct t_partition_state *partition_state, const ch
     sanitize_filename(partition_dir);
     partition_state->state_dir = sdscatfmt(sdsempty(), "%s/%S", DIR_WORK_STATE, partition_dir);
     FREE_SDS(partition_dir);
+    state_store_init(&partition_state->state_store);
     partition_state->conn = NULL;
     partition_state->conn_state = MPD_DISCONNECTED;
     partition_state->play_state = MPD_STATE_UNKNOWN;
@@ -371,11 +405,10 @@ void partition_state_default(struct t_partition_state *partition_state, const ch
     //lists
     list_init(&partition_state->last_played);
     list_init(&partition_state->preset_list);
+    list_init(&partition_state->requests);
     preset_list_load(partition_state);
-    //timers
-    partition_state->timer_fd_jukebox = mympd_timer_create(CLOCK_MONOTONIC, 0, 0);
-    partition_state->timer_fd_scrobble = mympd_timer_create(CLOCK_MONOTONIC, 0, 0);
-    partition_state->timer_fd_mpd_connect = mympd_timer_create(CLOCK_MONOTONIC, 0, 0);
+    //timers, disabled until partition_state_timers_init is called
+    partition_state_timers_init(partition_state, NULL);
     //events
     partition_state->waiting_events = 0;
 }
@@ -389,6 +422,7 @@ void partition_state_free(struct t_partition_state *partition_state) {
     FREE_SDS(partition_state->highlight_color);
     FREE_SDS(partition_state->highlight_color_contrast);
     FREE_SDS(partition_state->state_dir);
+    state_store_clear(&partition_state->state_store);
     if (partition_state->song != NULL) {
         mpd_song_free(partition_state->song);
     }
@@ -400,16 +434,28 @@ void partition_state_free(struct t_partition_state *partition_state) {
     //lists
     list_clear(&partition_state->last_played);
     list_clear(&partition_state->preset_list);
+    list_clear_user_data(&partition_state->requests, list_free_cb_request_user_data);
     //local playback
     FREE_SDS(partition_state->stream_uri);
     //timers
-    mympd_timer_close(partition_state->timer_fd_jukebox);
-    mympd_timer_close (partition_state->timer_fd_scrobble);
-    mympd_timer_close(partition_state->timer_fd_mpd_connect);
+    mympd_timer_entry_cancel(&partition_state->timer_jukebox);
+    mympd_timer_entry_cancel(&partition_state->timer_scrobble);
+    mympd_timer_entry_cancel(&partition_state->timer_mpd_connect);
     //struct itself
     FREE_PTR(partition_state);
 }
 
+/**
+ * Initializes the timers of a partition
+ * @param partition_state pointer to t_partition_state struct
+ * @param timer_heap heap to schedule the timers, NULL disables the timers
+ */
+void partition_state_timers_init(struct t_partition_state *partition_state, struct t_timer_heap *timer_heap) {
+    mympd_timer_entry_init(&partition_state->timer_jukebox, timer_heap, PFD_TYPE_TIMER_JUKEBOX, partition_state, NULL);
+    mympd_timer_entry_init(&partition_state->timer_scrobble, timer_heap, PFD_TYPE_TIMER_SCROBBLE, partition_state, NULL);
+    mympd_timer_entry_init(&partition_state->timer_mpd_connect, timer_heap, PFD_TYPE_TIMER_MPD_CONNECT, partition_state, NULL);
+}
+
 /**
  * Sets jukebox state defaults
  * @param jukebox_state pointer to t_jukebox_state struct
@@ -477,6 +523,12 @@ void stickerdb_state_default(struct t_stickerdb_state *stickerdb, struct t_confi
     stickerdb->conn_state = MPD_DISCONNECTED;
     stickerdb->conn = NULL;
     stickerdb->name = sdsnew("stickerdb");
+    stickerdb->mirror_enabled = false;
+    stickerdb->mirror = NULL;
+    stickerdb->mirror_user_defined = false;
+    stickerdb->mirror_own_events = false;
+    stickerdb->pending = NULL;
+    mympd_timer_entry_init(&stickerdb->timer_pending, NULL, PFD_TYPE_TIMER_STICKERDB, NULL, NULL);
 }
 
 /**
@@ -484,6 +536,9 @@ void stickerdb_state_default(struct t_stickerdb_state *stickerdb, struct t_confi
  * @param stickerdb pointer to struct
  */
 void stickerdb_state_free(struct t_stickerdb_state *stickerdb) {
+    stickerdb_mirror_clear(stickerdb);
+    stickerdb_pending_clear(stickerdb);
+    mympd_timer_entry_cancel(&stickerdb->timer_pending);
     FREE_SDS(stickerdb->name);
     FREE_PTR(stickerdb);
 }
@@ -18,6 +18,8 @@
 #include "src/lib/event.h"
 #include "src/lib/fields.h"
 #include "src/lib/list.h"
+#include "src/lib/state_store.h"
+#include "src/lib/timer.h"
 #include "src/lib/webradio.h"
 
 #include <time.h>
@@ -152,6 +154,7 @@ struct t_partition_state {
     sds highlight_color;                   //!< highlight color
     sds highlight_color_contrast;          //!< highlight contrast color
     sds state_dir;                         //!< partition state folder
+    struct t_state_store state_store;      //!< partition states
     struct t_partition_state *next;        //!< pointer to next partition;
     bool is_default;                       //!< flag for the mpd default partition
     enum mpd_idle idle_mask;               //!< mpd idle mask
@@ -162,14 +165,28 @@ struct t_partition_state {
     //lists
     struct t_list last_played;             //!< last_played list
     struct t_list preset_list;             //!< Playback presets
+    struct t_list requests;                //!< api requests to handle with the next idle pass
     //timers
-    int timer_fd_jukebox;                  //!< Timerfd for jukebox runs
-    int timer_fd_scrobble;                 //!< Timerfd for scrobble event
-    int timer_fd_mpd_connect;              //!< Timerfd for mpd reconnection
+    struct t_timer_entry timer_jukebox;      //!< Timer for jukebox runs
+    struct t_timer_entry timer_scrobble;     //!< Timer for scrobble event
+    struct t_timer_entry timer_mpd_connect;  //!< Timer for mpd reconnection
     //events
     enum pfd_type waiting_events;          //!< Bitmask for events
 };
 
+struct t_mpd_worker_pool;
+
+/**
+ * Counters of the mympd_api event loop
+ */
+struct t_mympd_api_loop_stats {
+    uint64_t wakeups;                      //!< wakeups by the mympd_api queue
+    uint64_t requests;                     //!< requests shifted from the mympd_api queue
+    unsigned last_batch;                   //!< requests shifted by the last wakeup
+    unsigned max_batch;                    //!< max requests shifted by one wakeup
+    unsigned capped;                       //!< wakeups that reached MYMPD_API_QUEUE_BATCH_MAX
+};
+
 /**
  * Holds stickerdb specific states
  */
@@ -180,6 +197,14 @@ struct t_stickerdb_state {
     struct mpd_connection *conn;           //!< mpd connection object from libmpdclient
     enum mpd_conn_states conn_state;       //!< mpd connection state
     sds name;                              //!< name for logging
+    //sticker mirror
+    bool mirror_enabled;                   //!< keep an in memory mirror of the song stickers
+    rax *mirror;                           //!< song stickers by uri as t_sticker, NULL if not populated
+    bool mirror_user_defined;              //!< the mirror includes the user defined stickers
+    bool mirror_own_events;                //!< own writes have queued sticker idle events
+    //coalesced writes
+    rax *pending;                          //!< pending sticker writes as t_sticker_pending, NULL if writes are not coalesced
+    struct t_timer_entry timer_pending;    //!< timer to flush the pending sticker writes
 };
 
 /**
@@ -207,6 +232,7 @@ struct t_timer_list {
     unsigned last_id;                   //!< highest timer id in the list
     int active;                         //!< number of enabled timers
     struct t_list list;                 //!< timer definition
+    struct t_timer_heap *heap;          //!< heap to schedule the timers
 };
 
 /**
@@ -228,9 +254,13 @@ struct t_mympd_state {
     struct t_partition_state *partition_state;      //!< list of partition states
     struct t_stickerdb_state *stickerdb;            //!< states for stickerdb connection
     struct mympd_pfds pfds;                         //!< fds to poll in the event loop
+    struct t_mympd_api_loop_stats loop_stats;       //!< counters of the event loop
+    struct t_mpd_worker_pool *mpd_worker_pool;      //!< pool of mpd_worker threads for read-only requests
+    struct t_timer_heap timer_heap;                 //!< schedules all timers of the mympd_api thread
     struct t_timer_list timer_list;                 //!< list of timers
     struct t_list home_list;                        //!< list of home icons
     struct t_list trigger_list;                     //!< list of triggers
+    struct t_state_store state_store;               //!< global states
     sds tag_list_search;                            //!< comma separated string of tags for search
     sds tag_list_browse;                            //!< comma separated string of tags for browse
     bool smartpls;                                  //!< enable smart playlists
@@ -268,6 +298,9 @@ struct t_mympd_state {
     sds booklet_name;                               //!< name of the booklet files
     sds info_txt_name;                              //!< name of album info files
     struct t_cache album_cache;                     //!< the album cache created by the mpd_worker thread
+    struct t_cache song_cache;                      //!< the song cache created by the mpd_worker thread
+    struct t_album_index *album_index;              //!< inverted tag index for the album cache
+    struct t_list album_results;                    //!< LRU of sorted album list results
     unsigned last_played_count;                     //!< number of songs to keep in the last played list (disk + memory)
     struct t_webradios *webradiodb;                 //!< WebradioDB
     struct t_webradios *webradio_favorites;         //!< webradio favorites
@@ -290,6 +323,7 @@ void mpd_state_free(struct t_mpd_state *mpd_state);
 void partition_state_default(struct t_partition_state *partition_state, const char *name,
         struct t_mpd_state *mpd_state, struct t_config *config);
 void partition_state_free(struct t_partition_state *partition_state);
+void partition_state_timers_init(struct t_partition_state *partition_state, struct t_timer_heap *timer_heap);
 
 void stickerdb_state_default(struct t_stickerdb_state *stickerdb, struct t_config *config);
 void stickerdb_state_free(struct t_stickerdb_state *stickerdb);
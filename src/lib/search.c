@@ -12,6 +12,7 @@
 #include "src/lib/search.h"
 
 #include "dist/utf8/utf8.h"
+#include "src/lib/casefold.h"
 #include "src/lib/convert.h"
 #include "src/lib/datetime.h"
 #include "src/lib/log.h"
@@ -31,30 +32,6 @@
  * Private definitions
  */
 
-/**
- * Search operators like them from MPD
- */
-enum search_operators {
-    SEARCH_OP_EQUAL,
-    SEARCH_OP_STARTS_WITH,
-    SEARCH_OP_CONTAINS,
-    SEARCH_OP_NOT_EQUAL,
-    SEARCH_OP_REGEX,
-    SEARCH_OP_NOT_REGEX,
-    SEARCH_OP_NEWER
-};
-
-/**
- * Search filter types
- */
-enum search_filters {
-    SEARCH_FILTER_ANY_TAG = -2,
-    SEARCH_FILTER_MODIFIED_SINCE = -3,
-    SEARCH_FILTER_ADDED_SINCE = -4,
-    SEARCH_FILTER_FILE = -5,
-    SEARCH_FILTER_BITRATE = -6
-};
-
 /**
  * Struct to hold a parsed search expression triple
  */
@@ -62,10 +39,29 @@ struct t_search_expression {
     int tag;                   //!< tag to search in
     enum search_operators op;  //!< search operator
     sds value;                 //!< value to match
+    sds value_folded;          //!< value folded to lower case for the contains operator
     int64_t value_i;           //!< integer value to match
     pcre2_code *re_compiled;   //!< compiled regex if operator is a regex
 };
 
+/**
+ * Callback to get a tag value of a song
+ */
+typedef const char *(*get_tag_callback)(const void *song, enum mpd_tag_type tag, unsigned idx);
+
+/**
+ * Callback to get the folded copy of a tag value, returns NULL if not available
+ */
+typedef const char *(*get_folded_callback)(const char *value, size_t *len);
+
+static const char *get_tag_mpd_song(const void *song, enum mpd_tag_type tag, unsigned idx);
+static const char *get_tag_cached_song(const void *song, enum mpd_tag_type tag, unsigned idx);
+static const char *get_folded_cached_song(const char *value, size_t *len);
+static bool contains_folded(const char *value, get_folded_callback get_folded, const struct t_search_expression *expr);
+static bool search_song_by_callback(const void *song, get_tag_callback get_tag, get_folded_callback get_folded, const char *uri,
+        time_t last_modified, time_t added, const struct t_list *expr_list, const struct t_mpd_tags *any_tag_types, bool exact);
+static bool match_value(const char *value, get_folded_callback get_folded, const struct t_search_expression *expr, bool exact);
+static sds *split_search_expression(const char *expression, int *count);
 static void *free_search_expression(struct t_search_expression *expr);
 static void free_search_expression_node(struct t_list_node *current);
 static pcre2_code *compile_regex(char *regex_str);
@@ -84,7 +80,7 @@ static bool cmp_regex(pcre2_code *re_compiled, const char *value);
 struct t_list *parse_search_expression_to_list(const char *expression, enum search_type type) {
     struct t_list *expr_list = list_new();
     int count = 0;
-    sds *tokens = sdssplitlen(expression, (ssize_t)strlen(expression), ") AND (", 7, &count);
+    sds *tokens = split_search_expression(expression, &count);
     sds tag = sdsempty();
     sds op = sdsempty();
     for (int j = 0; j < count; j++) {
@@ -93,6 +89,7 @@ struct t_list *parse_search_expression_to_list(const char *expression, enum sear
         sdsclear(op);
         struct t_search_expression *expr = malloc_assert(sizeof(struct t_search_expression));
         expr->value = sdsempty();
+        expr->value_folded = NULL;
         expr->re_compiled = NULL;
         char *p = tokens[j];
         char *end = p + sdslen(tokens[j]) - 1; //ignore concluding apostrophe
@@ -217,6 +214,12 @@ struct t_list *parse_search_expression_to_list(const char *expression, enum sear
                     }
                 }
             }
+            if (expr->op == SEARCH_OP_CONTAINS ||
+                expr->tag == SEARCH_FILTER_FILE)
+            {
+                //fold once for all values to search in
+                expr->value_folded = casefold_cat(sdsempty(), expr->value);
+            }
             list_push(expr_list, "", 0, NULL, expr);
             MYMPD_LOG_DEBUG(NULL, "Parsed expression tag: \"%s\", op: \"%s\", value:\"%s\"", tag, op, expr->value);
         }
@@ -252,29 +255,85 @@ void *free_search_expression_list(struct t_list *expr_list) {
  * @return expression result
  */
 bool search_expression_song(const struct mpd_song *song, const struct t_list *expr_list, const struct t_mpd_tags *any_tag_types) {
-    struct t_mpd_tags one_tag;
+    return search_song_by_callback(song, get_tag_mpd_song, NULL, mpd_song_get_uri(song),
+        mpd_song_get_last_modified(song), mpd_song_get_added(song), expr_list, any_tag_types, false);
+}
+
+/**
+ * Implements search expressions for songs from the song cache.
+ * @param song pointer to cached song
+ * @param expr_list expression list returned by parse_search_expression
+ * @param any_tag_types tags for special "any" tag in expression
+ * @param exact true to compare case-sensitive like mpd find,
+ *              false to compare case-insensitive like mpd search
+ * @return expression result
+ */
+bool search_expression_cached_song(const struct t_song_cache_song *song, const struct t_list *expr_list,
+        const struct t_mpd_tags *any_tag_types, bool exact)
+{
+    return search_song_by_callback(song, get_tag_cached_song, get_folded_cached_song, song->uri,
+        song->last_modified, song->added, expr_list, any_tag_types, exact);
+}
+
+/**
+ * Checks if the search expression was parsed completely.
+ * parse_search_expression_to_list stops at the first invalid part.
+ * @param expression mpd search expression
+ * @param expr_list expression list returned by parse_search_expression
+ * @return true if all parts of the expression are in the list, else false
+ */
+bool search_expression_is_complete(const char *expression, const struct t_list *expr_list) {
+    int count = 0;
+    sds *tokens = split_search_expression(expression, &count);
+    sdsfreesplitres(tokens, count);
+    return count > 0 &&
+        expr_list->length == (unsigned)count;
+}
+
+/**
+ * Gets the parsed values of a search expression list node
+ * @param node list node from the list returned by parse_search_expression_to_list
+ * @param tag pointer to set the tag, a mpd_tag_type or search_filters value
+ * @param op pointer to set the operator
+ * @param value pointer to set the value to match
+ */
+void search_expression_get(const struct t_list_node *node, int *tag, enum search_operators *op, const char **value) {
+    const struct t_search_expression *expr = (const struct t_search_expression *)node->user_data;
+    *tag = expr->tag;
+    *op = expr->op;
+    *value = expr->value;
+}
+
+/**
+ * Implements search expressions for webradios.
+ * @param webradio pointer to webradio struct
+ * @param expr_list expression list returned by parse_search_expression
+ * @param any_tag_types tags for special "any" tag in expression
+ * @return expression result
+ */
+bool search_expression_webradio(const struct t_webradio_data *webradio, const struct t_list *expr_list, const struct t_webradio_tags *any_tag_types) {
+    struct t_webradio_tags one_tag;
     one_tag.len = 1;
     struct t_list_node *current = expr_list->head;
     while (current != NULL) {
         struct t_search_expression *expr = (struct t_search_expression *)current->user_data;
-        if (expr->tag == SEARCH_FILTER_MODIFIED_SINCE) {
-            if (expr->value_i > mpd_song_get_last_modified(song)) {
-                return false;
-            }
-        }
-        else if (expr->tag == SEARCH_FILTER_ADDED_SINCE) {
-            if (expr->value_i > mpd_song_get_added(song)) {
-                return false;
+        if (expr->tag == SEARCH_FILTER_BITRATE) {
+            struct t_list_node *uris = webradio->uris.head;
+            bool rc = false;
+            while (uris != NULL) {
+                if (expr->value_i > uris->value_i) {
+                    rc = true;
+                    break;
+                }
+                uris = uris->next;
             }
-        }
-        else if (expr->tag == SEARCH_FILTER_FILE) {
-            if (utf8casestr(mpd_song_get_uri(song), expr->value) == NULL) {
+            if (rc == false) {
                 return false;
             }
         }
         else {
-            one_tag.tags[0] = (enum mpd_tag_type)expr->tag;
-            const struct t_mpd_tags *tags = expr->tag == SEARCH_FILTER_ANY_TAG
+            one_tag.tags[0] = (enum webradio_tag_type)expr->tag;
+            const struct t_webradio_tags *tags = expr->tag == SEARCH_FILTER_ANY_TAG
                 ? any_tag_types  //any - use provided tags
                 : &one_tag;      //use only selected tag
 
@@ -283,9 +342,9 @@ bool search_expression_song(const struct mpd_song *song, const struct t_list *ex
                 rc = true;
                 unsigned j = 0;
                 const char *value = NULL;
-                while ((value = mpd_song_get_tag(song, tags->tags[i], j)) != NULL) {
+                while ((value = webradio_get_tag(webradio, tags->tags[i], j)) != NULL) {
                     j++;
-                    if ((expr->op == SEARCH_OP_CONTAINS && utf8casestr(value, expr->value) == NULL) ||
+                    if ((expr->op == SEARCH_OP_CONTAINS && contains_folded(value, NULL, expr) == false) ||
                         (expr->op == SEARCH_OP_STARTS_WITH && utf8ncasecmp(expr->value, value, sdslen(expr->value)) != 0) ||
                         (expr->op == SEARCH_OP_EQUAL && utf8casecmp(value, expr->value) != 0) ||
                         (expr->op == SEARCH_OP_REGEX && cmp_regex(expr->re_compiled, value) == false))
@@ -334,35 +393,106 @@ bool search_expression_song(const struct mpd_song *song, const struct t_list *ex
 }
 
 /**
- * Implements search expressions for webradios.
- * @param webradio pointer to webradio struct
+ * Private functions
+ */
+
+/**
+ * Tag getter for mpd_song structs
+ * @param song pointer to mpd song struct
+ * @param tag mpd tag type
+ * @param idx value index
+ * @return tag value or NULL
+ */
+static const char *get_tag_mpd_song(const void *song, enum mpd_tag_type tag, unsigned idx) {
+    return mpd_song_get_tag((const struct mpd_song *)song, tag, idx);
+}
+
+/**
+ * Tag getter for cached songs, AlbumArtist falls back to Artist like in MPD
+ * @param song pointer to cached song
+ * @param tag mpd tag type
+ * @param idx value index
+ * @return tag value or NULL
+ */
+static const char *get_tag_cached_song(const void *song, enum mpd_tag_type tag, unsigned idx) {
+    const struct t_song_cache_song *cached = (const struct t_song_cache_song *)song;
+    const char *value = song_cache_get_tag(cached, tag, idx);
+    if (value == NULL &&
+        tag == MPD_TAG_ALBUM_ARTIST &&
+        song_cache_get_tag(cached, MPD_TAG_ALBUM_ARTIST, 0) == NULL)
+    {
+        return song_cache_get_tag(cached, MPD_TAG_ARTIST, idx);
+    }
+    return value;
+}
+
+/**
+ * Folded value getter for cached songs, the song cache interns the folded values
+ * @param value tag value of a cached song
+ * @param len pointer to set the length of the folded value
+ * @return folded value
+ */
+static const char *get_folded_cached_song(const char *value, size_t *len) {
+    const struct t_song_cache_string *str = song_cache_get_string(value);
+    *len = str->folded_len;
+    return str->folded;
+}
+
+/**
+ * Case insensitive contains match against the folded expression value
+ * @param value value to search in
+ * @param get_folded getter for the folded value, NULL to fold it on the fly
+ * @param expr search expression
+ * @return true if value contains the expression value, else false
+ */
+static bool contains_folded(const char *value, get_folded_callback get_folded, const struct t_search_expression *expr) {
+    if (get_folded != NULL) {
+        size_t folded_len;
+        const char *folded = get_folded(value, &folded_len);
+        return casefold_find(folded, folded_len, expr->value_folded, sdslen(expr->value_folded)) != NULL;
+    }
+    return casefold_contains(value, expr->value_folded, sdslen(expr->value_folded));
+}
+
+/**
+ * Implements search expressions for songs, tags are retrieved through a callback.
+ * @param song pointer to the song
+ * @param get_tag tag getter for the song
+ * @param get_folded getter for folded tag values, NULL to fold them on the fly
+ * @param uri song uri
+ * @param last_modified last modification time of the song
+ * @param added added time of the song
  * @param expr_list expression list returned by parse_search_expression
  * @param any_tag_types tags for special "any" tag in expression
+ * @param exact true for case-sensitive string comparison
  * @return expression result
  */
-bool search_expression_webradio(const struct t_webradio_data *webradio, const struct t_list *expr_list, const struct t_webradio_tags *any_tag_types) {
-    struct t_webradio_tags one_tag;
+static bool search_song_by_callback(const void *song, get_tag_callback get_tag, get_folded_callback get_folded, const char *uri,
+        time_t last_modified, time_t added, const struct t_list *expr_list, const struct t_mpd_tags *any_tag_types, bool exact)
+{
+    struct t_mpd_tags one_tag;
     one_tag.len = 1;
     struct t_list_node *current = expr_list->head;
     while (current != NULL) {
         struct t_search_expression *expr = (struct t_search_expression *)current->user_data;
-        if (expr->tag == SEARCH_FILTER_BITRATE) {
-            struct t_list_node *uris = webradio->uris.head;
-            bool rc = false;
-            while (uris != NULL) {
-                if (expr->value_i > uris->value_i) {
-                    rc = true;
-                    break;
-                }
-                uris = uris->next;
+        if (expr->tag == SEARCH_FILTER_MODIFIED_SINCE) {
+            if (expr->value_i > last_modified) {
+                return false;
             }
-            if (rc == false) {
+        }
+        else if (expr->tag == SEARCH_FILTER_ADDED_SINCE) {
+            if (expr->value_i > added) {
+                return false;
+            }
+        }
+        else if (expr->tag == SEARCH_FILTER_FILE) {
+            if (contains_folded(uri, NULL, expr) == false) {
                 return false;
             }
         }
         else {
-            one_tag.tags[0] = (enum webradio_tag_type)expr->tag;
-            const struct t_webradio_tags *tags = expr->tag == SEARCH_FILTER_ANY_TAG
+            one_tag.tags[0] = (enum mpd_tag_type)expr->tag;
+            const struct t_mpd_tags *tags = expr->tag == SEARCH_FILTER_ANY_TAG
                 ? any_tag_types  //any - use provided tags
                 : &one_tag;      //use only selected tag
 
@@ -371,18 +501,20 @@ bool search_expression_webradio(const struct t_webradio_data *webradio, const st
                 rc = true;
                 unsigned j = 0;
                 const char *value = NULL;
-                while ((value = webradio_get_tag(webradio, tags->tags[i], j)) != NULL) {
+                while ((value = get_tag(song, tags->tags[i], j)) != NULL) {
                     j++;
-                    if ((expr->op == SEARCH_OP_CONTAINS && utf8casestr(value, expr->value) == NULL) ||
-                        (expr->op == SEARCH_OP_STARTS_WITH && utf8ncasecmp(expr->value, value, sdslen(expr->value)) != 0) ||
-                        (expr->op == SEARCH_OP_EQUAL && utf8casecmp(value, expr->value) != 0) ||
-                        (expr->op == SEARCH_OP_REGEX && cmp_regex(expr->re_compiled, value) == false))
+                    if ((expr->op == SEARCH_OP_CONTAINS ||
+                         expr->op == SEARCH_OP_STARTS_WITH ||
+                         expr->op == SEARCH_OP_EQUAL ||
+                         expr->op == SEARCH_OP_REGEX) &&
+                        match_value(value, get_folded, expr, exact) == false)
                     {
                         //expression does not match
                         rc = false;
                     }
-                    else if ((expr->op == SEARCH_OP_NOT_EQUAL && utf8casecmp(value, expr->value) == 0) ||
-                            (expr->op == SEARCH_OP_NOT_REGEX && cmp_regex(expr->re_compiled, value) == true))
+                    else if ((expr->op == SEARCH_OP_NOT_EQUAL ||
+                              expr->op == SEARCH_OP_NOT_REGEX) &&
+                             match_value(value, get_folded, expr, exact) == true)
                     {
                         //negated match operator - exit instantly
                         rc = false;
@@ -422,8 +554,46 @@ bool search_expression_webradio(const struct t_webradio_data *webradio, const st
 }
 
 /**
- * Private functions
+ * Matches a tag value against the value of a string expression.
+ * The negated operators are matched as their positive counterparts.
+ * @param value tag value
+ * @param get_folded getter for the folded value, NULL to fold it on the fly
+ * @param expr search expression
+ * @param exact true for case-sensitive string comparison
+ * @return true if value matches, else false
+ */
+static bool match_value(const char *value, get_folded_callback get_folded, const struct t_search_expression *expr, bool exact) {
+    switch(expr->op) {
+        case SEARCH_OP_CONTAINS:
+            return exact == true
+                ? strstr(value, expr->value) != NULL
+                : contains_folded(value, get_folded, expr);
+        case SEARCH_OP_STARTS_WITH:
+            return exact == true
+                ? strncmp(expr->value, value, sdslen(expr->value)) == 0
+                : utf8ncasecmp(expr->value, value, sdslen(expr->value)) == 0;
+        case SEARCH_OP_EQUAL:
+        case SEARCH_OP_NOT_EQUAL:
+            return exact == true
+                ? strcmp(value, expr->value) == 0
+                : utf8casecmp(value, expr->value) == 0;
+        case SEARCH_OP_REGEX:
+        case SEARCH_OP_NOT_REGEX:
+            return cmp_regex(expr->re_compiled, value);
+        default:
+            return false;
+    }
+}
+
+/**
+ * Splits a mpd search expression in its parts
+ * @param expression mpd search expression
+ * @param count pointer to set the number of parts
+ * @return array of the parts, free it with sdsfreesplitres
  */
+static sds *split_search_expression(const char *expression, int *count) {
+    return sdssplitlen(expression, (ssize_t)strlen(expression), ") AND (", 7, count);
+}
 
 /**
  * Frees the t_search_expression struct
@@ -432,6 +602,7 @@ bool search_expression_webradio(const struct t_webradio_data *webradio, const st
  */
 void *free_search_expression(struct t_search_expression *expr) {
     FREE_SDS(expr->value);
+    FREE_SDS(expr->value_folded);
     FREE_PTR(expr->re_compiled);
     FREE_PTR(expr);
     return NULL;
@@ -12,6 +12,7 @@
 #define MYMPD_LIB_SEARCH_H
 
 #include "dist/libmympdclient/include/mpd/client.h"
+#include "src/lib/cache_rax_song.h"
 #include "src/lib/fields.h"
 #include "src/lib/webradio.h"
 
@@ -25,9 +26,37 @@ enum search_type {
     SEARCH_TYPE_WEBRADIO
 };
 
+/**
+ * Search operators like them from MPD
+ */
+enum search_operators {
+    SEARCH_OP_EQUAL,
+    SEARCH_OP_STARTS_WITH,
+    SEARCH_OP_CONTAINS,
+    SEARCH_OP_NOT_EQUAL,
+    SEARCH_OP_REGEX,
+    SEARCH_OP_NOT_REGEX,
+    SEARCH_OP_NEWER
+};
+
+/**
+ * Search filter types
+ */
+enum search_filters {
+    SEARCH_FILTER_ANY_TAG = -2,
+    SEARCH_FILTER_MODIFIED_SINCE = -3,
+    SEARCH_FILTER_ADDED_SINCE = -4,
+    SEARCH_FILTER_FILE = -5,
+    SEARCH_FILTER_BITRATE = -6
+};
+
 struct t_list *parse_search_expression_to_list(const char *expression, enum search_type type);
 void *free_search_expression_list(struct t_list *expr_list);
 bool search_expression_song(const struct mpd_song *song, const struct t_list *expr_list, const struct t_mpd_tags *any_tag_types);
+bool search_expression_cached_song(const struct t_song_cache_song *song, const struct t_list *expr_list,
+        const struct t_mpd_tags *any_tag_types, bool exact);
+bool search_expression_is_complete(const char *expression, const struct t_list *expr_list);
+void search_expression_get(const struct t_list_node *node, int *tag, enum search_operators *op, const char **value);
 bool search_expression_webradio(const struct t_webradio_data *webradio, const struct t_list *expr_list, const struct t_webradio_tags *any_tag_types);
 
 #endif
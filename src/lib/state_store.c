@@ -0,0 +1,460 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief State store implementation
+ */
+
+#include "compile_time.h"
+#include "src/lib/state_store.h"
+
+#include "src/lib/convert.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/log.h"
+#include "src/lib/mpack.h"
+#include "src/lib/sds_extras.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+/**
+ * The state store keeps all states of a scope in one mpack file.
+ * It is read once and written with a tmp file that is renamed.
+ * Plain state files, one file per state, in the state directory are imported
+ * on first access and removed after the next successful save.
+ * This migrates old state directories and allows manual edits.
+ */
+
+/**
+ * Private definitions
+ */
+
+static void state_store_values_free(rax *values);
+static void state_store_legacy_read(struct t_state_store *store);
+static bool state_store_legacy_import(struct t_state_store *store, const char *name, validate_callback vcb);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty state store
+ * @param store pointer to state store
+ */
+void state_store_init(struct t_state_store *store) {
+    store->workdir = NULL;
+    store->dir = NULL;
+    store->values = NULL;
+    store->legacy = NULL;
+    list_init(&store->imported);
+    store->dirty = false;
+}
+
+/**
+ * Frees the content of the state store
+ * @param store pointer to state store
+ */
+void state_store_clear(struct t_state_store *store) {
+    FREE_SDS(store->workdir);
+    FREE_SDS(store->dir);
+    if (store->values != NULL) {
+        state_store_values_free(store->values);
+        store->values = NULL;
+    }
+    if (store->legacy != NULL) {
+        raxFree(store->legacy);
+        store->legacy = NULL;
+    }
+    list_clear(&store->imported);
+    store->dirty = false;
+}
+
+/**
+ * Reads the state store file and looks for plain state files to import
+ * @param store pointer to state store
+ * @param workdir myMPD working directory
+ * @param dir state directory relative to workdir
+ * @return true if the state store file was read, else false
+ */
+bool state_store_load(struct t_state_store *store, sds workdir, const char *dir) {
+    state_store_clear(store);
+    store->workdir = sdsdup(workdir);
+    store->dir = sdsnew(dir);
+    store->values = raxNew();
+    state_store_legacy_read(store);
+
+    sds filepath = sdscatfmt(sdsempty(), "%S/%S/%s", store->workdir, store->dir, FILENAME_STATE);
+    if (testfile_read(filepath) == false) {
+        MYMPD_LOG_DEBUG(NULL, "State store \"%s\" does not exist", filepath);
+        FREE_SDS(filepath);
+        return false;
+    }
+    mpack_tree_t tree;
+    mpack_tree_init_filename(&tree, filepath, 0);
+    mpack_tree_set_error_handler(&tree, log_mpack_node_error);
+    mpack_tree_parse(&tree);
+    mpack_node_t root = mpack_tree_root(&tree);
+    size_t len = mpack_node_map_count(root);
+    for (size_t i = 0; i < len; i++) {
+        mpack_node_t key = mpack_node_map_key_at(root, i);
+        mpack_node_t value = mpack_node_map_value_at(root, i);
+        if (mpack_node_type(key) != mpack_type_str ||
+            mpack_node_type(value) != mpack_type_str)
+        {
+            continue;
+        }
+        sds data = sdsnewlen(mpack_node_str(value), mpack_node_data_len(value));
+        if (raxTryInsert(store->values, (unsigned char *)mpack_node_str(key), mpack_node_data_len(key), data, NULL) == 0) {
+            FREE_SDS(data);
+        }
+    }
+    bool rc = mpack_tree_destroy(&tree) != mpack_ok
+        ? false
+        : true;
+    if (rc == false) {
+        MYMPD_LOG_ERROR(NULL, "Reading state store \"%s\" failed", filepath);
+    }
+    else {
+        MYMPD_LOG_DEBUG(NULL, "Read %" PRIu64 " states from \"%s\"", store->values->numele, filepath);
+    }
+    FREE_SDS(filepath);
+    return rc;
+}
+
+/**
+ * Writes the state store file if values were changed.
+ * The file is written to a tmp file and renamed afterwards.
+ * @param store pointer to state store
+ * @return true on success, else false
+ */
+bool state_store_save(struct t_state_store *store) {
+    if (store->values == NULL ||
+        store->dirty == false)
+    {
+        return true;
+    }
+    sds state_dir = sdscatfmt(sdsempty(), "%S/%S", store->workdir, store->dir);
+    if (testdir(store->dir, state_dir, true, true) >= DIR_CREATE_FAILED) {
+        FREE_SDS(state_dir);
+        return false;
+    }
+    sds tmp_file = sdscatfmt(sdsempty(), "%S/%s.XXXXXX", state_dir, FILENAME_STATE);
+    FREE_SDS(state_dir);
+    FILE *fp = open_tmp_file(tmp_file);
+    if (fp == NULL) {
+        FREE_SDS(tmp_file);
+        return false;
+    }
+    mpack_writer_t writer;
+    mpack_writer_init_stdfile(&writer, fp, false);
+    mpack_writer_set_error_handler(&writer, log_mpack_write_error);
+    mpack_start_map(&writer, (uint32_t)store->values->numele);
+    raxIterator iter;
+    raxStart(&iter, store->values);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        mpack_write_str(&writer, (char *)iter.key, (uint32_t)iter.key_len);
+        sds value = (sds)iter.data;
+        mpack_write_str(&writer, value, (uint32_t)sdslen(value));
+    }
+    raxStop(&iter);
+    mpack_finish_map(&writer);
+    bool rc = mpack_writer_destroy(&writer) != mpack_ok
+        ? false
+        : true;
+    rc = rename_tmp_file(fp, tmp_file, rc);
+    FREE_SDS(tmp_file);
+    if (rc == false) {
+        return false;
+    }
+    store->dirty = false;
+    // the imported values are now saved in the state store
+    struct t_list_node *current;
+    while ((current = list_shift_first(&store->imported)) != NULL) {
+        sds filepath = sdscatfmt(sdsempty(), "%S/%S/%S", store->workdir, store->dir, current->key);
+        rm_file(filepath);
+        FREE_SDS(filepath);
+        list_node_free(current);
+    }
+    return true;
+}
+
+/**
+ * Checks if a state is set
+ * @param store pointer to state store
+ * @param name name of the state
+ * @return true if the state is set, else false
+ */
+bool state_store_exists(struct t_state_store *store, const char *name) {
+    if (store->legacy != NULL &&
+        raxFind(store->legacy, (unsigned char *)name, strlen(name), NULL) == 1)
+    {
+        return true;
+    }
+    return store->values != NULL &&
+        raxFind(store->values, (unsigned char *)name, strlen(name), NULL) == 1;
+}
+
+/**
+ * Sets a state, the state store must be saved with state_store_save
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param value value to set
+ */
+void state_store_set(struct t_state_store *store, const char *name, const char *value) {
+    if (store->values == NULL) {
+        store->values = raxNew();
+    }
+    size_t name_len = strlen(name);
+    void *old_data;
+    if (raxFind(store->values, (unsigned char *)name, name_len, &old_data) == 1) {
+        if (strcmp((sds)old_data, value) == 0) {
+            return;
+        }
+        raxRemove(store->values, (unsigned char *)name, name_len, NULL);
+        FREE_SDS(old_data);
+    }
+    raxInsert(store->values, (unsigned char *)name, name_len, sdsnew(value), NULL);
+    store->dirty = true;
+}
+
+/**
+ * Reads a string state or sets the default value if not exists or value is invalid
+ * Frees the default value.
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param def_value default value as sds string (is freed by this function)
+ * @param vcb validation callback from validate.h
+ * @param write if true set the default value if the state does not exist
+ * @return newly allocated sds string
+ */
+sds state_store_rw_string_sds(struct t_state_store *store, const char *name, sds def_value, validate_callback vcb, bool write) {
+    sds value = state_store_rw_string(store, name, def_value, vcb, write);
+    FREE_SDS(def_value);
+    return value;
+}
+
+/**
+ * Reads a string state or sets the default value if not exists or value is invalid.
+ * Empty values are replaced by the default value.
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param def_value default value as c string
+ * @param vcb validation callback from validate.h
+ * @param write if true set the default value if the state does not exist
+ * @return newly allocated sds string
+ */
+sds state_store_rw_string(struct t_state_store *store, const char *name, const char *def_value,
+        validate_callback vcb, bool write)
+{
+    state_store_legacy_import(store, name, vcb);
+    void *data;
+    if (store->values == NULL ||
+        raxFind(store->values, (unsigned char *)name, strlen(name), &data) == 0)
+    {
+        if (write == true) {
+            state_store_set(store, name, def_value);
+        }
+        return sdsnew(def_value);
+    }
+    sds value = (sds)data;
+    if (sdslen(value) == 0) {
+        return sdsnew(def_value);
+    }
+    sds result = sdsdup(value);
+    if (vcb != NULL &&
+        vcb(result) == false)
+    {
+        MYMPD_LOG_ERROR(NULL, "Validation failed for state \"%s\"", name);
+        sdsclear(result);
+        return sdscat(result, def_value);
+    }
+    MYMPD_LOG_DEBUG(NULL, "State %s: %s", name, result);
+    return result;
+}
+
+/**
+ * Reads a bool state or sets the default value if not exists or value is invalid
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param def_value default value
+ * @param write if true set the default value if the state does not exist
+ * @return the state value
+ */
+bool state_store_rw_bool(struct t_state_store *store, const char *name, bool def_value, bool write) {
+    bool value = def_value;
+    sds line = state_store_rw_string(store, name, def_value == true ? "true" : "false", NULL, write);
+    if (sdslen(line) > 0) {
+        value = line[0] == 't'
+            ? true
+            : false;
+    }
+    FREE_SDS(line);
+    return value;
+}
+
+/**
+ * Reads an int state or sets the default value if not exists or value is invalid
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param def_value default value
+ * @param min minimum value
+ * @param max maximum value
+ * @param write if true set the default value if the state does not exist
+ * @return the state value
+ */
+int state_store_rw_int(struct t_state_store *store, const char *name, int def_value, int min, int max, bool write) {
+    sds def_value_str = sdsfromlonglong((long long)def_value);
+    sds line = state_store_rw_string(store, name, def_value_str, NULL, write);
+    FREE_SDS(def_value_str);
+    int value;
+    enum str2int_errno rc = str2int(&value, line);
+    FREE_SDS(line);
+    if (rc != STR2INT_SUCCESS) {
+        return def_value;
+    }
+    if (value >= min && value <= max) {
+        return value;
+    }
+    return def_value;
+}
+
+/**
+ * Reads an unsigned state or sets the default value if not exists or value is invalid
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param def_value default value
+ * @param min minimum value
+ * @param max maximum value
+ * @param write if true set the default value if the state does not exist
+ * @return the state value
+ */
+unsigned state_store_rw_uint(struct t_state_store *store, const char *name, unsigned def_value, unsigned min, unsigned max, bool write) {
+    sds def_value_str = sdsfromlonglong((long long)def_value);
+    sds line = state_store_rw_string(store, name, def_value_str, NULL, write);
+    FREE_SDS(def_value_str);
+    unsigned value;
+    enum str2int_errno rc = str2uint(&value, line);
+    FREE_SDS(line);
+    if (rc != STR2INT_SUCCESS) {
+        return def_value;
+    }
+    if (value >= min && value <= max) {
+        return value;
+    }
+    return def_value;
+}
+
+/**
+ * Reads a tag name state, parses it to a mpd_tag_type or sets the default value if not exists or value is invalid
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param def_value default value as mpd_tag_type
+ * @param write if true set the default value if the state does not exist
+ * @return parsed string as mpd_tag_type
+ */
+enum mpd_tag_type state_store_rw_tag(struct t_state_store *store, const char *name, enum mpd_tag_type def_value, bool write) {
+    sds line = state_store_rw_string(store, name, mpd_tag_name(def_value), NULL, write);
+    enum mpd_tag_type value = sdslen(line) > 0
+        ? mpd_tag_name_iparse(line)
+        : def_value;
+    FREE_SDS(line);
+    return value == MPD_TAG_UNKNOWN
+        ? def_value
+        : value;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Frees the values of the state store
+ * @param values rax tree to free
+ */
+static void state_store_values_free(rax *values) {
+    raxIterator iter;
+    raxStart(&iter, values);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        FREE_SDS(iter.data);
+    }
+    raxStop(&iter);
+    raxFree(values);
+}
+
+/**
+ * Collects the plain state files of the state directory.
+ * State names do not contain a dot, files with a dot are other state files.
+ * @param store pointer to state store
+ */
+static void state_store_legacy_read(struct t_state_store *store) {
+    sds state_dir = sdscatfmt(sdsempty(), "%S/%S", store->workdir, store->dir);
+    errno = 0;
+    DIR *dir = opendir(state_dir);
+    if (dir == NULL) {
+        if (errno != ENOENT) {
+            MYMPD_LOG_ERROR(NULL, "Can not open directory \"%s\"", state_dir);
+            MYMPD_LOG_ERRNO(NULL, errno);
+        }
+        FREE_SDS(state_dir);
+        return;
+    }
+    FREE_SDS(state_dir);
+    store->legacy = raxNew();
+    struct dirent *next_file;
+    while ((next_file = readdir(dir)) != NULL) {
+        if (next_file->d_type != DT_REG ||
+            strchr(next_file->d_name, '.') != NULL)
+        {
+            continue;
+        }
+        raxInsert(store->legacy, (unsigned char *)next_file->d_name, strlen(next_file->d_name), NULL, NULL);
+    }
+    closedir(dir);
+}
+
+/**
+ * Imports a plain state file into the state store
+ * @param store pointer to state store
+ * @param name name of the state
+ * @param vcb validation callback from validate.h
+ * @return true if a plain state file was imported, else false
+ */
+static bool state_store_legacy_import(struct t_state_store *store, const char *name, validate_callback vcb) {
+    size_t name_len = strlen(name);
+    if (store->legacy == NULL ||
+        raxRemove(store->legacy, (unsigned char *)name, name_len, NULL) == 0)
+    {
+        return false;
+    }
+    sds filepath = sdscatfmt(sdsempty(), "%S/%S/%s", store->workdir, store->dir, name);
+    int nread = 0;
+    sds value = sds_getfile(sdsempty(), filepath, LINE_LENGTH_MAX, true, true, &nread);
+    FREE_SDS(filepath);
+    bool rc = false;
+    if (nread < 0) {
+        MYMPD_LOG_ERROR(NULL, "Can not import state \"%s\"", name);
+    }
+    else if (nread > 0 &&
+        vcb != NULL &&
+        vcb(value) == false)
+    {
+        MYMPD_LOG_ERROR(NULL, "Validation failed for state \"%s\"", name);
+    }
+    else {
+        MYMPD_LOG_INFO(NULL, "Importing state \"%s/%s\"", store->dir, name);
+        state_store_set(store, name, value);
+        // set the dirty flag also for unchanged values to remove the plain state file
+        store->dirty = true;
+        list_push(&store->imported, name, 0, NULL, NULL);
+        rc = true;
+    }
+    FREE_SDS(value);
+    return rc;
+}
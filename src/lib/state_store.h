@@ -0,0 +1,47 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief State store implementation
+ */
+
+#ifndef MYMPD_STATE_STORE_H
+#define MYMPD_STATE_STORE_H
+
+#include "dist/libmympdclient/include/mpd/client.h"
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/list.h"
+#include "src/lib/validate.h"
+
+#include <stdbool.h>
+
+/**
+ * Key/value store for the states of one scope (global or partition)
+ */
+struct t_state_store {
+    sds workdir;            //!< myMPD working directory
+    sds dir;                //!< state directory relative to workdir
+    rax *values;            //!< state values, key is the state name, data a sds string
+    rax *legacy;            //!< plain state files found in the state directory
+    struct t_list imported; //!< imported plain state files to remove after the next save
+    bool dirty;             //!< true if values were changed since the last save
+};
+
+void state_store_init(struct t_state_store *store);
+void state_store_clear(struct t_state_store *store);
+bool state_store_load(struct t_state_store *store, sds workdir, const char *dir);
+bool state_store_save(struct t_state_store *store);
+bool state_store_exists(struct t_state_store *store, const char *name);
+void state_store_set(struct t_state_store *store, const char *name, const char *value);
+sds state_store_rw_string_sds(struct t_state_store *store, const char *name, sds def_value, validate_callback vcb, bool write);
+sds state_store_rw_string(struct t_state_store *store, const char *name, const char *def_value, validate_callback vcb, bool write);
+bool state_store_rw_bool(struct t_state_store *store, const char *name, bool def_value, bool write);
+int state_store_rw_int(struct t_state_store *store, const char *name, int def_value, int min, int max, bool write);
+unsigned state_store_rw_uint(struct t_state_store *store, const char *name, unsigned def_value, unsigned min, unsigned max, bool write);
+enum mpd_tag_type state_store_rw_tag(struct t_state_store *store, const char *name, enum mpd_tag_type def_value, bool write);
+
+#endif
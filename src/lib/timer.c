@@ -5,7 +5,7 @@
 */
 
 /*! \file
- * \brief Timerfd helpers
+ * \brief Timerfd helpers and the timer heap
  */
 
 #include "compile_time.h"
@@ -13,11 +13,28 @@
 
 #include "src/lib/datetime.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 
 #include <errno.h>
 #include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
 
+// Private definitions
+
+/**
+ * Nanoseconds per second
+ */
+#define SEC_NSEC 1000000000LL
+
+static void heap_insert(struct t_timer_heap *heap, struct t_timer_entry *timer);
+static void heap_remove(struct t_timer_heap *heap, size_t pos);
+static void heap_swap(struct t_timer_heap *heap, size_t a, size_t b);
+static void heap_sift_up(struct t_timer_heap *heap, size_t pos);
+static void heap_sift_down(struct t_timer_heap *heap, size_t pos);
+
+// Public functions
+
 /**
  * Creates a new timer
  * @param clock one off CLOCK_MONOTONIC or CLOCK_REALTIME
@@ -114,3 +131,282 @@ void mympd_timer_close(int fd) {
         close(fd);
     }
 }
+
+/**
+ * Returns the current time of the monotonic clock
+ * @return time in nanoseconds
+ */
+int64_t mympd_timer_now(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1) {
+        MYMPD_LOG_ERROR(NULL, "Error getting monotonic time");
+        return 0;
+    }
+    return (int64_t)ts.tv_sec * SEC_NSEC + ts.tv_nsec;
+}
+
+/**
+ * Initializes the timer heap and creates its timerfd
+ * @param heap pointer to already allocated timer heap
+ */
+void mympd_timer_heap_init(struct t_timer_heap *heap) {
+    heap->fd = mympd_timer_create(CLOCK_MONOTONIC, 0, 0);
+    heap->entries = NULL;
+    heap->len = 0;
+    heap->size = 0;
+    heap->armed = -1;
+}
+
+/**
+ * Unschedules all timers, frees the heap and closes its timerfd
+ * @param heap pointer to timer heap
+ */
+void mympd_timer_heap_clear(struct t_timer_heap *heap) {
+    for (size_t i = 0; i < heap->len; i++) {
+        heap->entries[i]->pos = TIMER_HEAP_POS_NONE;
+    }
+    FREE_PTR(heap->entries);
+    heap->len = 0;
+    heap->size = 0;
+    heap->armed = -1;
+    mympd_timer_close(heap->fd);
+    heap->fd = -1;
+}
+
+/**
+ * Arms the timerfd for the earliest expiration in the heap
+ * or disarms it if no timer is scheduled.
+ * The timerfd is only set if the earliest expiration has changed.
+ * @param heap pointer to timer heap
+ * @return true on success, else false
+ */
+bool mympd_timer_heap_arm(struct t_timer_heap *heap) {
+    if (heap->fd == -1) {
+        return false;
+    }
+    int64_t expires = heap->len > 0
+        ? heap->entries[0]->expires
+        : -1;
+    if (expires == heap->armed) {
+        return true;
+    }
+    struct itimerspec its;
+    its.it_interval.tv_sec = 0;
+    its.it_interval.tv_nsec = 0;
+    if (expires > -1) {
+        its.it_value.tv_sec = (time_t)(expires / SEC_NSEC);
+        its.it_value.tv_nsec = (long)(expires % SEC_NSEC);
+        if (its.it_value.tv_sec == 0 &&
+            its.it_value.tv_nsec == 0)
+        {
+            // zero disarms the timer
+            its.it_value.tv_nsec = 1;
+        }
+    }
+    else {
+        its.it_value.tv_sec = 0;
+        its.it_value.tv_nsec = 0;
+    }
+    errno = 0;
+    if (timerfd_settime(heap->fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        MYMPD_LOG_ERROR(NULL, "Can not set expiration for timer heap");
+        MYMPD_LOG_ERRNO(NULL, errno);
+        return false;
+    }
+    heap->armed = expires;
+    return true;
+}
+
+/**
+ * Returns the next timer that is expired at the given time.
+ * Interval timers are rescheduled, one shot timers are removed from the heap
+ * before they are returned. Call it in a loop until it returns NULL.
+ * @param heap pointer to timer heap
+ * @param now current time from mympd_timer_now
+ * @return expired timer or NULL if no timer is expired
+ */
+struct t_timer_entry *mympd_timer_heap_next_expired(struct t_timer_heap *heap, int64_t now) {
+    if (heap->len == 0 ||
+        heap->entries[0]->expires > now)
+    {
+        return NULL;
+    }
+    // the timerfd is disarmed after its expiration
+    heap->armed = -1;
+    struct t_timer_entry *timer = heap->entries[0];
+    if (timer->interval > 0) {
+        int64_t interval = (int64_t)timer->interval * SEC_NSEC;
+        timer->expires += interval;
+        if (timer->expires <= now) {
+            // skip missed expirations
+            timer->expires = now + interval;
+        }
+        heap_sift_down(heap, 0);
+    }
+    else {
+        heap_remove(heap, 0);
+    }
+    return timer;
+}
+
+/**
+ * Initializes a timer
+ * @param timer pointer to already allocated timer
+ * @param heap timer heap to schedule the timer in, NULL disables the timer
+ * @param type timer type
+ * @param partition_state partition for the timer or NULL
+ * @param data pointer to user data or NULL
+ */
+void mympd_timer_entry_init(struct t_timer_entry *timer, struct t_timer_heap *heap, enum pfd_type type,
+        struct t_partition_state *partition_state, void *data)
+{
+    timer->heap = heap;
+    timer->type = type;
+    timer->partition_state = partition_state;
+    timer->data = data;
+    timer->expires = 0;
+    timer->interval = 0;
+    timer->pos = TIMER_HEAP_POS_NONE;
+}
+
+/**
+ * Sets the relative timeout and interval for a timer,
+ * same semantics as mympd_timer_set.
+ * @param timer pointer to timer
+ * @param timeout relative timeout in seconds
+ * @param interval interval in seconds
+ * @return true on success, else false
+ */
+bool mympd_timer_entry_set(struct t_timer_entry *timer, int timeout, int interval) {
+    if (timer->heap == NULL) {
+        MYMPD_LOG_DEBUG(NULL, "Unable to set timeout, timer is disabled");
+        return false;
+    }
+    if (timeout <= 0 &&
+        interval <= 0)
+    {
+        mympd_timer_entry_cancel(timer);
+        return true;
+    }
+    timer->expires = mympd_timer_now() + (int64_t)timeout * SEC_NSEC;
+    timer->interval = interval > 0
+        ? interval
+        : 0;
+    if (timer->pos == TIMER_HEAP_POS_NONE) {
+        heap_insert(timer->heap, timer);
+    }
+    else {
+        heap_sift_up(timer->heap, timer->pos);
+        heap_sift_down(timer->heap, timer->pos);
+    }
+    return true;
+}
+
+/**
+ * Removes the timer from its heap
+ * @param timer pointer to timer
+ */
+void mympd_timer_entry_cancel(struct t_timer_entry *timer) {
+    if (timer->heap == NULL ||
+        timer->pos == TIMER_HEAP_POS_NONE)
+    {
+        return;
+    }
+    heap_remove(timer->heap, timer->pos);
+}
+
+// Private functions
+
+/**
+ * Inserts a timer in the heap
+ * @param heap pointer to timer heap
+ * @param timer timer to insert
+ */
+static void heap_insert(struct t_timer_heap *heap, struct t_timer_entry *timer) {
+    if (heap->len == heap->size) {
+        heap->size = heap->size == 0
+            ? 16
+            : heap->size * 2;
+        heap->entries = realloc_assert(heap->entries, heap->size * sizeof(struct t_timer_entry *));
+    }
+    timer->pos = heap->len;
+    heap->entries[heap->len] = timer;
+    heap->len++;
+    heap_sift_up(heap, timer->pos);
+}
+
+/**
+ * Removes the timer at pos from the heap
+ * @param heap pointer to timer heap
+ * @param pos position of the timer
+ */
+static void heap_remove(struct t_timer_heap *heap, size_t pos) {
+    heap->entries[pos]->pos = TIMER_HEAP_POS_NONE;
+    heap->len--;
+    if (pos == heap->len) {
+        return;
+    }
+    struct t_timer_entry *last = heap->entries[heap->len];
+    heap->entries[pos] = last;
+    last->pos = pos;
+    heap_sift_up(heap, pos);
+    heap_sift_down(heap, last->pos);
+}
+
+/**
+ * Swaps two timers in the heap
+ * @param heap pointer to timer heap
+ * @param a position of the first timer
+ * @param b position of the second timer
+ */
+static void heap_swap(struct t_timer_heap *heap, size_t a, size_t b) {
+    struct t_timer_entry *tmp = heap->entries[a];
+    heap->entries[a] = heap->entries[b];
+    heap->entries[b] = tmp;
+    heap->entries[a]->pos = a;
+    heap->entries[b]->pos = b;
+}
+
+/**
+ * Moves the timer at pos up to restore the heap order
+ * @param heap pointer to timer heap
+ * @param pos position of the timer
+ */
+static void heap_sift_up(struct t_timer_heap *heap, size_t pos) {
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (heap->entries[parent]->expires <= heap->entries[pos]->expires) {
+            break;
+        }
+        heap_swap(heap, parent, pos);
+        pos = parent;
+    }
+}
+
+/**
+ * Moves the timer at pos down to restore the heap order
+ * @param heap pointer to timer heap
+ * @param pos position of the timer
+ */
+static void heap_sift_down(struct t_timer_heap *heap, size_t pos) {
+    while (true) {
+        size_t smallest = pos;
+        size_t left = 2 * pos + 1;
+        size_t right = left + 1;
+        if (left < heap->len &&
+            heap->entries[left]->expires < heap->entries[smallest]->expires)
+        {
+            smallest = left;
+        }
+        if (right < heap->len &&
+            heap->entries[right]->expires < heap->entries[smallest]->expires)
+        {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            return;
+        }
+        heap_swap(heap, pos, smallest);
+        pos = smallest;
+    }
+}
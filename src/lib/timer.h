@@ -5,13 +5,49 @@
 */
 
 /*! \file
- * \brief Timerfd helpers
+ * \brief Timerfd helpers and the timer heap
  */
 
 #ifndef MYMPD_LIB_TIMER_H
 #define MYMPD_LIB_TIMER_H
 
+#include "src/lib/event.h"
+
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct t_partition_state;
+struct t_timer_heap;
+
+/**
+ * Timer scheduled in a timer heap
+ */
+struct t_timer_entry {
+    struct t_timer_heap *heap;                   //!< heap to schedule the timer, NULL = timer is disabled
+    enum pfd_type type;                          //!< timer type, used to dispatch the expiration
+    struct t_partition_state *partition_state;   //!< partition for the timer or NULL
+    void *data;                                  //!< pointer to user data
+    int64_t expires;                             //!< monotonic expiration time in nanoseconds
+    int interval;                                //!< reschedule interval in seconds, 0 = one shot
+    size_t pos;                                  //!< position in the heap, TIMER_HEAP_POS_NONE if not scheduled
+};
+
+/**
+ * Binary min-heap of timers driven by a single timerfd
+ */
+struct t_timer_heap {
+    int fd;                            //!< timerfd armed for the earliest expiration
+    struct t_timer_entry **entries;    //!< timers ordered by expiration time
+    size_t len;                        //!< number of scheduled timers
+    size_t size;                       //!< allocated size of entries
+    int64_t armed;                     //!< expiration the timerfd is armed for, -1 = disarmed
+};
+
+/**
+ * Position of timers that are not scheduled
+ */
+#define TIMER_HEAP_POS_NONE SIZE_MAX
 
 int mympd_timer_create(int clock, int timeout, int interval);
 bool mympd_timer_read(int fd);
@@ -19,4 +55,14 @@ bool mympd_timer_set(int timer_fd, int timeout, int interval);
 void mympd_timer_log_next_expire(int timer_fd);
 void mympd_timer_close(int fd);
 
+int64_t mympd_timer_now(void);
+void mympd_timer_heap_init(struct t_timer_heap *heap);
+void mympd_timer_heap_clear(struct t_timer_heap *heap);
+bool mympd_timer_heap_arm(struct t_timer_heap *heap);
+struct t_timer_entry *mympd_timer_heap_next_expired(struct t_timer_heap *heap, int64_t now);
+void mympd_timer_entry_init(struct t_timer_entry *timer, struct t_timer_heap *heap, enum pfd_type type,
+        struct t_partition_state *partition_state, void *data);
+bool mympd_timer_entry_set(struct t_timer_entry *timer, int timeout, int interval);
+void mympd_timer_entry_cancel(struct t_timer_entry *timer);
+
 #endif
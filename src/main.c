@@ -66,9 +66,6 @@ const char *__asan_default_options(void) {
 
 //global variables
 _Atomic int mpd_worker_threads;
-#ifdef MYMPD_ENABLE_LUA
-    _Atomic int script_worker_threads;
-#endif
 //signal handler
 sig_atomic_t s_signal_received;
 //message queues
@@ -371,9 +368,6 @@ int main(int argc, char **argv) {
 
     //set initial states
     mpd_worker_threads = 0;
-    #ifdef MYMPD_ENABLE_LUA
-        script_worker_threads = 0;
-    #endif
     s_signal_received = 0;
     struct t_config *config = NULL;
     struct t_mg_user_data *mg_user_data = NULL;
@@ -397,11 +391,11 @@ int main(int argc, char **argv) {
     //only owner should have rw access
     umask(0077);
 
-    mympd_api_queue = mympd_queue_create("mympd_api_queue", QUEUE_TYPE_REQUEST, true);
-    web_server_queue = mympd_queue_create("web_server_queue", QUEUE_TYPE_RESPONSE, false);
+    mympd_api_queue = mympd_queue_create("mympd_api_queue", QUEUE_TYPE_REQUEST, QUEUE_MODE_RING, true);
+    web_server_queue = mympd_queue_create("web_server_queue", QUEUE_TYPE_RESPONSE, QUEUE_MODE_RING, false);
     #ifdef MYMPD_ENABLE_LUA
-        script_queue = mympd_queue_create("script_queue", QUEUE_TYPE_REQUEST, false);
-        script_worker_queue = mympd_queue_create("script_worker_queue", QUEUE_TYPE_RESPONSE, false);
+        script_queue = mympd_queue_create("script_queue", QUEUE_TYPE_REQUEST, QUEUE_MODE_LIST, false);
+        script_worker_queue = mympd_queue_create("script_worker_queue", QUEUE_TYPE_RESPONSE, QUEUE_MODE_MAILBOX, false);
     #endif
 
     //mympd config defaults
@@ -13,7 +13,6 @@
 
 #include "dist/libmympdclient/include/mpd/client.h"
 #include "src/lib/env.h"
-#include "src/lib/filehandler.h"
 #include "src/lib/log.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/validate.h"
@@ -36,14 +35,11 @@
  * @param mympd_state pointer to mympd_state structure
  */
 void mpd_client_autoconf(struct t_mympd_state *mympd_state) {
-    //skip autoconfiguration if mpd_host state file is configured
-    sds state_file = sdscatfmt(sdsempty(), "%S/%s/mpd_host", mympd_state->config->workdir, DIR_WORK_STATE);
-    if (testfile_read(state_file) == true) {
+    //skip autoconfiguration if mpd_host state is configured
+    if (state_store_exists(&mympd_state->state_store, "mpd_host") == true) {
         MYMPD_LOG_NOTICE(NULL, "Skipping myMPD autoconfiguration");
-        FREE_SDS(state_file);
         return;
     }
-    FREE_SDS(state_file);
 
     //autoconfigure mpd connection
     MYMPD_LOG_NOTICE(NULL, "Starting myMPD autoconfiguration");
@@ -12,6 +12,7 @@
 #include "src/mpd_client/errorhandler.h"
 
 #include "dist/libmympdclient/include/mpd/client.h"
+#include "src/lib/api.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/log.h"
 #include "src/lib/timer.h"
@@ -40,7 +41,7 @@ static bool check_error_and_recover(struct t_partition_state *partition_state, s
 void mympd_set_mpd_failure(struct t_partition_state *partition_state, const char *errormessage) {
     MYMPD_LOG_ERROR(partition_state->name, "%s", errormessage);
     mpd_client_disconnect(partition_state);
-    mympd_timer_set(partition_state->timer_fd_mpd_connect, 0, 5);
+    mympd_timer_entry_set(&partition_state->timer_mpd_connect, 0, 5);
 }
 
 /**
@@ -156,6 +157,8 @@ static bool check_error_and_recover(struct t_partition_state *partition_state, s
         sdsclear(*buffer);
         switch(response_type) {
             case RESPONSE_TYPE_JSONRPC_RESPONSE:
+                //parts of a streamed response are already sent
+                response_stream_abort();
                 *buffer = jsonrpc_respond_message_phrase(*buffer, cmd_id, request_id,
                     JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "MPD error for command %{cmd}: %{msg}", 4, "cmd", command, "msg", error_msg);
                 break;
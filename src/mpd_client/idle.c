@@ -11,6 +11,7 @@
 #include "compile_time.h"
 #include "src/mpd_client/idle.h"
 
+#include "src/lib/api.h"
 #include "src/lib/datetime.h"
 #include "src/lib/event.h"
 #include "src/lib/jsonrpc.h"
@@ -37,7 +38,8 @@
  * Private definitions
  */
 
-static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state);
+static bool mpd_client_handle_offline_request(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
         struct t_work_request *request);
 static void mpd_client_parse_idle(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, unsigned idle_bitmask);
 
@@ -49,38 +51,51 @@ static void mpd_client_parse_idle(struct t_mympd_state *mympd_state, struct t_pa
  * This is the central function to handle api requests and mpd events.
  * It is called from the mympd_api thread.
  * @param mympd_state pointer to the mympd state struct
- * @param request work request from the mympd_api queue
+ * @param requests work requests from the mympd_api queue, the list is emptied
  */
-void mpd_client_idle(struct t_mympd_state *mympd_state, struct t_work_request *request) {
+void mpd_client_idle(struct t_mympd_state *mympd_state, struct t_list *requests) {
+    // dispatch the requests to the partitions, the order is preserved per partition
+    struct t_list_node *current;
+    while ((current = list_shift_first(requests)) != NULL) {
+        struct t_work_request *request = (struct t_work_request *)current->user_data;
+        list_node_free(current);
+        struct t_partition_state *partition_state = partitions_get_by_name(mympd_state, request->partition);
+        if (partition_state != NULL) {
+            list_push(&partition_state->requests, "", 0, NULL, request);
+            partition_state->waiting_events |= PFD_TYPE_QUEUE;
+            continue;
+        }
+        // request is for an unknown partition
+        mpd_client_discard_request(request);
+    }
     // iterate through all partitions
     struct t_partition_state *partition_state = mympd_state->partition_state;
     do {
         if (partition_state->waiting_events > 0 ||
             partition_state->set_conn_options == true)
         {
-            if (partition_state->waiting_events & PFD_TYPE_QUEUE) {
-                mpd_client_idle_partition(mympd_state, partition_state, request);
-                request = NULL;
-            }
-            else {
-                mpd_client_idle_partition(mympd_state, partition_state, NULL);
-            }
+            mpd_client_idle_partition(mympd_state, partition_state);
             partition_state->waiting_events = 0;
         }
     } while ((partition_state = partition_state->next) != NULL);
-    // cleanup
-    if (request != NULL) {
-        // request was for unknown partition, discard it
-        MYMPD_LOG_WARN(NULL, "Discarding request for unknown partition \"%s\"", request->partition);
-        if (request->type == REQUEST_TYPE_DEFAULT) {
-            struct t_work_response *response = create_response(request);
-            response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
-                JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Unknown partition");
-            MYMPD_LOG_DEBUG(NULL, "Send http response to connection %lu: %s", request->conn_id, response->data);
-            mympd_queue_push(web_server_queue, response, 0);
-        }
-        free_request(request);
+}
+
+/**
+ * Discards a request for an unknown or removed partition.
+ * Responds with an error and frees the request.
+ * @param request the request to discard
+ */
+void mpd_client_discard_request(struct t_work_request *request) {
+    MYMPD_LOG_WARN(NULL, "Discarding request for unknown partition \"%s\"", request->partition);
+    if (request->type == REQUEST_TYPE_DEFAULT ||
+        request->type == REQUEST_TYPE_SCRIPT)
+    {
+        struct t_work_response *response = create_response(request);
+        response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+            JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Unknown partition");
+        push_response(response);
     }
+    free_request(request);
 }
 
 /**
@@ -112,46 +127,23 @@ void mpd_client_scrobble(struct t_mympd_state *mympd_state, struct t_partition_s
 
 /**
  * This function checks the mpd connection state, handles api requests and mpd events per partition.
+ * All queued api requests of the partition are handled with one noidle/idle cycle.
  * @param mympd_state pointer to mympd state
  * @param partition_state pointer to the partition state
- * @param request api request
  */
-static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        struct t_work_request *request)
-{
-    if (request != NULL) {
-        if (is_mpd_disconnected_api_method(request->cmd_id) == true &&
-            partition_state->conn_state != MPD_CONNECTED)
-        {
-            // Handle request if MPD is not connected
-            MYMPD_LOG_DEBUG(partition_state->name, "Handle request \"%s\"", get_cmd_id_method_name(request->cmd_id));
-            mympd_api_handler(mympd_state, partition_state, request);
-            partition_state->waiting_events &= ~(unsigned)PFD_TYPE_QUEUE;
-            request = NULL;
-        }
-        else if (is_mympd_only_api_method(request->cmd_id) == true) {
-            // Request that can be handled without a MPD connection
-            MYMPD_LOG_DEBUG(partition_state->name, "Handle request \"%s\"", get_cmd_id_method_name(request->cmd_id));
-            mympd_api_handler(mympd_state, partition_state, request);
-            partition_state->waiting_events &= ~(unsigned)PFD_TYPE_QUEUE;
-            request = NULL;
-        }
-        else if (partition_state->conn_state != MPD_CONNECTED) {
-            // Respond with error if MPD is not connected
-            if (request->type != REQUEST_TYPE_DISCARD) {
-                struct t_work_response *response = create_response(request);
-                response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
-                    JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "MPD disconnected");
-                MYMPD_LOG_DEBUG(partition_state->name, "Send http response to connection %lu: %s", request->conn_id, response->data);
-                push_response(response);
-            }
-            else {
-                MYMPD_LOG_WARN(partition_state->name, "Discarding request %s, MPD disconnected.", get_cmd_id_method_name(request->cmd_id));
-            }
-            free_request(request);
-            partition_state->waiting_events &= ~(unsigned)PFD_TYPE_QUEUE;
-            request = NULL;
-        }
+static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state) {
+    // handle the leading requests that need no mpd connection,
+    // stop at the first request that needs it to preserve the order
+    struct t_list_node *current;
+    while (partition_state->requests.head != NULL &&
+        mpd_client_handle_offline_request(mympd_state, partition_state,
+            (struct t_work_request *)partition_state->requests.head->user_data) == true)
+    {
+        current = list_shift_first(&partition_state->requests);
+        list_node_free(current);
+    }
+    if (partition_state->requests.head == NULL) {
+        partition_state->waiting_events &= ~(unsigned)PFD_TYPE_QUEUE;
     }
 
     // Check if we need to exit the idle mode
@@ -162,6 +154,14 @@ static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct
     MYMPD_LOG_DEBUG(partition_state->name, "Leaving mpd idle mode");
     if (mpd_send_noidle(partition_state->conn) == false) {
         mympd_check_error_and_recover(partition_state, NULL, "mpd_send_noidle");
+        // respond to the remaining requests
+        while ((current = list_shift_first(&partition_state->requests)) != NULL) {
+            struct t_work_request *request = (struct t_work_request *)current->user_data;
+            list_node_free(current);
+            if (mpd_client_handle_offline_request(mympd_state, partition_state, request) == false) {
+                mympd_api_handler(mympd_state, partition_state, request);
+            }
+        }
         return;
     }
     if (partition_state->waiting_events & PFD_TYPE_PARTITION) {
@@ -183,11 +183,14 @@ static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct
     if (partition_state->waiting_events & PFD_TYPE_TIMER_JUKEBOX) {
         jukebox_run(mympd_state, partition_state, &mympd_state->album_cache);
     }
-    // an api request is there
-    if (request != NULL) {
-        //Handle request
-        MYMPD_LOG_DEBUG(partition_state->name, "Handle API request \"%s\"", get_cmd_id_method_name(request->cmd_id));
-        mympd_api_handler(mympd_state, partition_state, request);
+    // handle the api requests in order
+    while ((current = list_shift_first(&partition_state->requests)) != NULL) {
+        struct t_work_request *request = (struct t_work_request *)current->user_data;
+        list_node_free(current);
+        if (mpd_client_handle_offline_request(mympd_state, partition_state, request) == false) {
+            MYMPD_LOG_DEBUG(partition_state->name, "Handle API request \"%s\"", get_cmd_id_method_name(request->cmd_id));
+            mympd_api_handler(mympd_state, partition_state, request);
+        }
     }
     // re-enter idle mode
     if (partition_state->conn_state == MPD_CONNECTED) {
@@ -198,6 +201,48 @@ static void mpd_client_idle_partition(struct t_mympd_state *mympd_state, struct
     }
 }
 
+/**
+ * Handles api requests that do not need or can not use the mpd connection.
+ * @param mympd_state pointer to mympd state
+ * @param partition_state pointer to the partition state
+ * @param request api request
+ * @return true if the request was handled and freed, else false
+ */
+static bool mpd_client_handle_offline_request(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        struct t_work_request *request)
+{
+    if (is_mpd_disconnected_api_method(request->cmd_id) == true &&
+        partition_state->conn_state != MPD_CONNECTED)
+    {
+        // Handle request if MPD is not connected
+        MYMPD_LOG_DEBUG(partition_state->name, "Handle request \"%s\"", get_cmd_id_method_name(request->cmd_id));
+        mympd_api_handler(mympd_state, partition_state, request);
+        return true;
+    }
+    if (is_mympd_only_api_method(request->cmd_id) == true) {
+        // Request that can be handled without a MPD connection
+        MYMPD_LOG_DEBUG(partition_state->name, "Handle request \"%s\"", get_cmd_id_method_name(request->cmd_id));
+        mympd_api_handler(mympd_state, partition_state, request);
+        return true;
+    }
+    if (partition_state->conn_state != MPD_CONNECTED) {
+        // Respond with error if MPD is not connected
+        if (request->type != REQUEST_TYPE_DISCARD) {
+            struct t_work_response *response = create_response(request);
+            response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+                JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "MPD disconnected");
+            MYMPD_LOG_DEBUG(partition_state->name, "Send http response to connection %lu: %s", request->conn_id, response->data);
+            push_response(response);
+        }
+        else {
+            MYMPD_LOG_WARN(partition_state->name, "Discarding request %s, MPD disconnected.", get_cmd_id_method_name(request->cmd_id));
+        }
+        free_request(request);
+        return true;
+    }
+    return false;
+}
+
 /**
  * Handles mpd idle events
  * @param mympd_state pointer to partition state
@@ -220,6 +265,14 @@ static void mpd_client_parse_idle(struct t_mympd_state *mympd_state, struct t_pa
                     //database has changed - global event
                     MYMPD_LOG_INFO(partition_state->name, "MPD database has changed");
                     buffer = jsonrpc_event(buffer, JSONRPC_EVENT_UPDATE_DATABASE);
+                    //negative cache entries can be validated only with access to the music directory,
+                    //clear them in a worker thread
+                    if (sdslen(mympd_state->mpd_state->music_directory_value) == 0) {
+                        struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0,
+                            INTERNAL_API_CACHE_DISK_NEGATIVE_CLEAR, NULL, MPD_PARTITION_DEFAULT);
+                        request->data = jsonrpc_end(request->data);
+                        mympd_queue_push(mympd_api_queue, request, 0);
+                    }
                     //add timer for cache updates
                     if (mympd_state->mpd_state->feat.tags == true) {
                         mympd_api_timer_replace(&mympd_state->timer_list, 2, TIMER_ONE_SHOT_REMOVE,
@@ -14,6 +14,7 @@
 #include "src/lib/api.h"
 #include "src/lib/mympd_state.h"
 
-void mpd_client_idle(struct t_mympd_state *mympd_state, struct t_work_request *request);
+void mpd_client_idle(struct t_mympd_state *mympd_state, struct t_list *requests);
+void mpd_client_discard_request(struct t_work_request *request);
 void mpd_client_scrobble(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state);
 #endif
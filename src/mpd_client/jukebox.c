@@ -102,7 +102,7 @@ void jukebox_clear_all(struct t_mympd_state *mympd_state) {
  */
 void jukebox_disable(struct t_partition_state *partition_state) {
     MYMPD_LOG_DEBUG(partition_state->name, "Disabling jukebox timer");
-    mympd_timer_set(partition_state->timer_fd_jukebox, 0, 0);
+    mympd_timer_entry_set(&partition_state->timer_jukebox, 0, 0);
 }
 
 /**
@@ -365,5 +365,7 @@ static struct t_list *jukebox_get_last_played(struct t_partition_state *partitio
     }
 
     MYMPD_LOG_DEBUG(partition_state->name, "Jukebox last_played list length: %u", queue_list->length);
+    //the list is checked for each candidate of the random selection
+    list_index_enable(queue_list);
     return queue_list;
 }
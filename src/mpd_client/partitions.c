@@ -20,7 +20,9 @@
 #include "src/mpd_client/connection.h"
 #include "src/mpd_client/errorhandler.h"
 #include "src/mpd_client/features.h"
+#include "src/mpd_client/idle.h"
 #include "src/mpd_client/jukebox.h"
+#include "src/mpd_worker/pool.h"
 #include "src/mympd_api/settings.h"
 #include "src/mympd_api/status.h"
 #include "src/mympd_api/timer.h"
@@ -29,6 +31,16 @@
 
 #include <string.h>
 
+/**
+ * Private definitions
+ */
+
+static void partitions_discard_requests(struct t_partition_state *partition_state);
+
+/**
+ * Public functions
+ */
+
 /**
  * Connects to MPD and switches to the defined partition
  * @param mympd_state Pointer to mympd_state
@@ -49,6 +61,7 @@ bool partitions_connect(struct t_mympd_state *mympd_state, struct t_partition_st
             return false;
         }
         mpd_client_mpd_features(mympd_state, partition_state);
+        mpd_worker_pool_configure(mympd_state);
         // initiate cache updates
         if (mympd_state->mpd_state->feat.tags == true) {
             mympd_api_timer_replace(&mympd_state->timer_list, 2, TIMER_ONE_SHOT_REMOVE,
@@ -82,7 +95,7 @@ bool partitions_connect(struct t_mympd_state *mympd_state, struct t_partition_st
     FREE_SDS(buffer);
 
     // disarm connect timer
-    mympd_timer_set(partition_state->timer_fd_mpd_connect, 0, 0);
+    mympd_timer_entry_set(&partition_state->timer_mpd_connect, 0, 0);
 
     // jukebox
     if (partition_state->jukebox.mode != JUKEBOX_OFF &&
@@ -129,6 +142,7 @@ void partitions_list_clear(struct t_mympd_state *mympd_state) {
         MYMPD_LOG_INFO(NULL, "Removing partition \"%s\" from the partition list", current->name);
         struct t_partition_state *next = current->next;
         //free partition state
+        partitions_discard_requests(current);
         partition_state_free(current);
         current = next;
     }
@@ -170,6 +184,7 @@ bool partitions_populate(struct t_mympd_state *mympd_state) {
             MYMPD_LOG_INFO(NULL, "Removing partition \"%s\" from the partition list", current->name);
             struct t_partition_state *next = current->next;
             //free partition state
+            partitions_discard_requests(current);
             partition_state_free(current);
             //partition was removed from mpd
             previous->next = next;
@@ -214,11 +229,28 @@ void partitions_add(struct t_mympd_state *mympd_state, const char *name) {
     partition_state->next = malloc_assert(sizeof(struct t_partition_state));
     //set default partition state
     partition_state_default(partition_state->next, name, mympd_state->mpd_state, mympd_state->config);
+    partition_state_timers_init(partition_state->next, &mympd_state->timer_heap);
     //read partition specific state from disc
     mympd_api_settings_statefiles_partition_read(partition_state->next);
     last_played_file_read(partition_state->next);
     //set connect timer
-    mympd_timer_set(partition_state->next->timer_fd_mpd_connect, 0, 5);
+    mympd_timer_entry_set(&partition_state->next->timer_mpd_connect, 0, 5);
     //push settings to web_server_queue
     settings_to_webserver(mympd_state);
 }
+
+/**
+ * Private functions
+ */
+
+/**
+ * Responds to the queued requests of a partition that is removed
+ * @param partition_state pointer to the partition state
+ */
+static void partitions_discard_requests(struct t_partition_state *partition_state) {
+    struct t_list_node *current;
+    while ((current = list_shift_first(&partition_state->requests)) != NULL) {
+        mpd_client_discard_request((struct t_work_request *)current->user_data);
+        list_node_free(current);
+    }
+}
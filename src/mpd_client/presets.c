@@ -16,6 +16,7 @@
 #include "src/lib/list.h"
 #include "src/lib/log.h"
 #include "src/lib/sds_extras.h"
+#include "src/lib/state_store.h"
 #include "src/mympd_api/requests.h"
 #include "src/mympd_api/settings.h"
 
@@ -33,7 +34,12 @@ bool preset_apply(struct t_partition_state *partition_state, sds preset_name, sd
     if (preset != NULL) {
         struct t_jsonrpc_parse_error parse_error;
         jsonrpc_parse_error_init(&parse_error);
-        if (json_iterate_object(preset->value_p, "$", mympd_api_settings_mpd_options_set, partition_state, NULL, NULL, 100, &parse_error) == true) {
+        bool rc = json_iterate_object(preset->value_p, "$", mympd_api_settings_mpd_options_set, partition_state, NULL, NULL, 100, &parse_error);
+        // write all changed settings at once
+        if (state_store_save(&partition_state->state_store) == false) {
+            rc = false;
+        }
+        if (rc == true) {
             if (partition_state->jukebox.mode != JUKEBOX_OFF) {
                 mympd_api_request_jukebox_restart(partition_state->name);
             }
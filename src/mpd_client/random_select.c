@@ -339,7 +339,16 @@ static long check_uniq_tag(const char *uri, const char *value, struct t_list *qu
         return RANDOM_ADD_UNIQ_IS_UNIQ;
     }
     // check mpd queue and last_played
-    struct t_list_node *current = queue_list->head;
+    if (queue_list->index != NULL) {
+        if (list_has_key(queue_list, uri) == true ||
+            (value != NULL && list_has_value(queue_list, value) == true))
+        {
+            return RANDOM_ADD_UNIQ_IN_QUEUE;
+        }
+    }
+    struct t_list_node *current = queue_list->index == NULL
+        ? queue_list->head
+        : NULL;
     while(current != NULL) {
         if (strcmp(current->key, uri) == 0) {
             return RANDOM_ADD_UNIQ_IN_QUEUE;
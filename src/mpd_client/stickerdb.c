@@ -15,9 +15,11 @@
 #include "src/lib/convert.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/mympd_state.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/sticker.h"
+#include "src/lib/timer.h"
 #include "src/lib/utility.h"
 #include "src/mympd_api/requests.h"
 
@@ -29,18 +31,63 @@
 
 // Private definitions
 
+/**
+ * Entry of the sticker mirror
+ */
+struct t_sticker_mirror_entry {
+    struct t_sticker sticker;  //!< sticker values
+    unsigned mympd_set;        //!< bitmask of the myMPD stickers that are set
+};
+
+/**
+ * Pending sticker write of the coalesced write path
+ */
+struct t_sticker_pending {
+    enum mympd_sticker_type type;  //!< MPD sticker type
+    sds uri;                       //!< sticker uri
+    sds name;                      //!< sticker name
+    int64_t value;                 //!< value to set or increment
+    bool inc;                      //!< true if value is an increment
+};
+
+static rax *sticker_mirror_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type);
+static bool sticker_mirror_populate(struct t_stickerdb_state *stickerdb);
+static bool sticker_mirror_add_name(struct t_stickerdb_state *stickerdb, const char *name);
 static bool get_sticker_types(struct t_stickerdb_state *stickerdb);
 static bool sticker_search_add_value_constraint(struct t_stickerdb_state *stickerdb, enum mpd_sticker_operator op, const char *value);
 static bool sticker_search_add_sort(struct t_stickerdb_state *stickerdb, enum mpd_sticker_sort sort, bool desc);
 static bool sticker_search_add_window(struct t_stickerdb_state *stickerdb, unsigned start, unsigned end);
 
 static struct t_sticker *get_sticker_all(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, struct t_sticker *sticker, bool user_defined);
+static void get_sticker_all_pipelined(struct t_stickerdb_state *stickerdb, const char *type_name, struct t_list *pending, bool user_defined);
+static void recv_sticker_all(struct t_stickerdb_state *stickerdb, struct t_sticker *sticker, bool user_defined);
 static sds get_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
 static int64_t get_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
 static bool set_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name, const char *value);
 static bool set_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name, int64_t value);
+static sds sticker_int64_format(struct t_stickerdb_state *stickerdb, int64_t value);
 static bool inc_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
+static bool inc_set_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri,
+        const char *name_inc, const char *name_timestamp, int64_t timestamp);
+static void sticker_mirror_inc(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
+static sds sticker_pending_key(enum mympd_sticker_type type, const char *uri, const char *name);
+static bool sticker_pending_add(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name, int64_t value, bool inc);
+static struct t_sticker_pending *sticker_pending_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name);
+static int64_t sticker_pending_apply_value(const struct t_sticker_pending *entry, int64_t value);
+static sds sticker_pending_apply_str(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name, sds value);
+static void sticker_pending_apply_all(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, struct t_sticker *sticker, bool user_defined);
+static bool sticker_pending_commit(struct t_stickerdb_state *stickerdb);
+static void sticker_pending_list(struct t_stickerdb_state *stickerdb, struct t_list *entries, bool inc);
+static void sticker_pending_remove(struct t_stickerdb_state *stickerdb, struct t_list_node *node);
+static void sticker_pending_resolve_value(struct t_sticker_pending *entry, int64_t current);
+static bool sticker_pending_resolve(struct t_stickerdb_state *stickerdb);
+static bool sticker_pending_write(struct t_stickerdb_state *stickerdb);
 static bool remove_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
+static bool stickerdb_leave_idle(struct t_stickerdb_state *stickerdb, bool own_events);
 static bool stickerdb_connect_mpd(struct t_stickerdb_state *stickerdb);
 static bool check_sticker_support(struct t_stickerdb_state *stickerdb);
 
@@ -114,6 +161,7 @@ bool stickerdb_connect(struct t_stickerdb_state *stickerdb) {
  * @param stickerdb pointer to stickerdb state
  */
 void stickerdb_disconnect(struct t_stickerdb_state *stickerdb) {
+    stickerdb_mirror_clear(stickerdb);
     if (stickerdb->conn != NULL) {
         MYMPD_LOG_INFO(stickerdb->name, "Disconnecting from mpd");
         mpd_connection_free(stickerdb->conn);
@@ -130,6 +178,8 @@ void stickerdb_disconnect(struct t_stickerdb_state *stickerdb) {
  */
 bool stickerdb_idle(struct t_stickerdb_state *stickerdb) {
     MYMPD_LOG_DEBUG("stickerdb", "Discarding idle events");
+    // stickers were changed by another client
+    stickerdb_mirror_clear(stickerdb);
     mympd_api_request_trigger_event_emit(TRIGGER_MPD_STICKER, MPD_PARTITION_DEFAULT);
     return stickerdb_exit_idle(stickerdb) &&
         stickerdb_enter_idle(stickerdb);
@@ -142,6 +192,18 @@ bool stickerdb_idle(struct t_stickerdb_state *stickerdb) {
  */
 bool stickerdb_enter_idle(struct t_stickerdb_state *stickerdb) {
     MYMPD_LOG_DEBUG("stickerdb", "Entering idle mode");
+    if (stickerdb->mirror_own_events == true) {
+        // discard the idle events of our own writes, they are already applied to the mirror.
+        // changes of other clients while we were idle are detected by stickerdb_exit_idle,
+        // only changes during our own command sequence are merged with our events.
+        stickerdb->mirror_own_events = false;
+        if (mpd_send_idle_mask(stickerdb->conn, MPD_IDLE_STICKER) == false ||
+            stickerdb_leave_idle(stickerdb, true) == false)
+        {
+            stickerdb_mirror_clear(stickerdb);
+        }
+        mympd_api_request_trigger_event_emit(TRIGGER_MPD_STICKER, MPD_PARTITION_DEFAULT);
+    }
     // the idle events are discarded in the mympd api loop
     if (mpd_send_idle_mask(stickerdb->conn, MPD_IDLE_STICKER) == false) {
         MYMPD_LOG_ERROR("stickerdb", "Error entering idle mode");
@@ -152,17 +214,183 @@ bool stickerdb_enter_idle(struct t_stickerdb_state *stickerdb) {
 }
 
 /**
- * Exits the idle mode, ignoring all idle events
+ * Exits the idle mode.
+ * Sticker events received while idle are changes of other clients,
+ * they invalidate the sticker mirror.
  * @param stickerdb pointer to the stickerdb state
  * @return true on success, else false
  */
 bool stickerdb_exit_idle(struct t_stickerdb_state *stickerdb) {
-    MYMPD_LOG_DEBUG("stickerdb", "Exiting idle mode");
-    if (mpd_send_noidle(stickerdb->conn) == false) {
-        MYMPD_LOG_ERROR("stickerdb", "Error exiting idle mode");
+    return stickerdb_leave_idle(stickerdb, false);
+}
+
+/**
+ * Frees the sticker mirror
+ * @param stickerdb pointer to the stickerdb state
+ */
+void stickerdb_mirror_clear(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->mirror == NULL) {
+        return;
     }
-    mpd_response_finish(stickerdb->conn);
-    return stickerdb_check_error_and_recover(stickerdb, "mpd_run_noidle");
+    MYMPD_LOG_DEBUG("stickerdb", "Clearing sticker mirror");
+    raxIterator iter;
+    raxStart(&iter, stickerdb->mirror);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker_mirror_entry *entry = (struct t_sticker_mirror_entry *)iter.data;
+        sticker_struct_clear(&entry->sticker);
+        FREE_PTR(entry);
+    }
+    raxStop(&iter);
+    raxFree(stickerdb->mirror);
+    stickerdb->mirror = NULL;
+    stickerdb->mirror_user_defined = false;
+    stickerdb->mirror_own_events = false;
+}
+
+/**
+ * Sets or removes a sticker in the sticker mirror
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ * @param value sticker value or NULL to remove the sticker
+ */
+void stickerdb_mirror_update(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name, const char *value)
+{
+    if (stickerdb->mirror == NULL ||
+        type != STICKER_TYPE_SONG)
+    {
+        return;
+    }
+    enum mympd_sticker_names sticker_name = sticker_name_parse(name);
+    if (sticker_name == STICKER_UNKNOWN &&
+        stickerdb->mirror_user_defined == false)
+    {
+        return;
+    }
+    size_t uri_len = strlen(uri);
+    void *data;
+    struct t_sticker_mirror_entry *entry;
+    if (raxFind(stickerdb->mirror, (unsigned char *)uri, uri_len, &data) == 1) {
+        entry = (struct t_sticker_mirror_entry *)data;
+    }
+    else if (value != NULL) {
+        entry = malloc_assert(sizeof(struct t_sticker_mirror_entry));
+        sticker_struct_init(&entry->sticker);
+        entry->mympd_set = 0;
+        raxInsert(stickerdb->mirror, (unsigned char *)uri, uri_len, entry, NULL);
+    }
+    else {
+        return;
+    }
+    if (sticker_name != STICKER_UNKNOWN) {
+        if (value != NULL) {
+            int64_t num;
+            entry->sticker.mympd[sticker_name] = str2int64(&num, value) == STR2INT_SUCCESS
+                ? num
+                : 0;
+            entry->mympd_set |= 1U << sticker_name;
+        }
+        else {
+            entry->sticker.mympd[sticker_name] = sticker_name == STICKER_LIKE
+                ? STICKER_LIKE_NEUTRAL
+                : 0;
+            entry->mympd_set &= ~(1U << sticker_name);
+        }
+        return;
+    }
+    unsigned idx = list_get_node_idx(&entry->sticker.user, name);
+    if (value == NULL) {
+        list_remove_node(&entry->sticker.user, idx);
+    }
+    else if (idx == UINT_MAX) {
+        list_push(&entry->sticker.user, name, 0, value, NULL);
+    }
+    else {
+        list_replace(&entry->sticker.user, idx, name, 0, value, NULL);
+    }
+}
+
+/**
+ * Writes the coalesced sticker writes to MPD.
+ * Counter increments are resolved against the current sticker values and
+ * all values are written with command lists. Entries that could not be written
+ * because of a connection error are kept and the flush timer is rearmed.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+bool stickerdb_pending_flush(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->pending == NULL ||
+        stickerdb->pending->numele == 0)
+    {
+        return true;
+    }
+    if (stickerdb_connect(stickerdb) == false) {
+        MYMPD_LOG_WARN(stickerdb->name, "Postponing %" PRIu64 " pending sticker writes", stickerdb->pending->numele);
+        mympd_timer_entry_set(&stickerdb->timer_pending, STICKER_PENDING_FLUSH_DELAY, 0);
+        return false;
+    }
+    bool rc = sticker_pending_commit(stickerdb);
+    if (stickerdb->conn_state == MPD_CONNECTED) {
+        stickerdb_enter_idle(stickerdb);
+    }
+    if (stickerdb->pending->numele > 0) {
+        mympd_timer_entry_set(&stickerdb->timer_pending, STICKER_PENDING_FLUSH_DELAY, 0);
+    }
+    return rc;
+}
+
+/**
+ * Discards the pending sticker writes and frees the pending rax
+ * @param stickerdb pointer to the stickerdb state
+ */
+void stickerdb_pending_clear(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->pending == NULL) {
+        return;
+    }
+    if (stickerdb->pending->numele > 0) {
+        MYMPD_LOG_WARN(stickerdb->name, "Discarding %" PRIu64 " pending sticker writes", stickerdb->pending->numele);
+    }
+    raxIterator iter;
+    raxStart(&iter, stickerdb->pending);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker_pending *entry = (struct t_sticker_pending *)iter.data;
+        FREE_SDS(entry->uri);
+        FREE_SDS(entry->name);
+        FREE_PTR(entry);
+    }
+    raxStop(&iter);
+    raxFree(stickerdb->pending);
+    stickerdb->pending = NULL;
+}
+
+/**
+ * Discards the pending write of a sticker.
+ * A direct write or remove of the sticker supersedes the buffered write.
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ */
+void stickerdb_pending_discard(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
+    if (stickerdb->pending == NULL ||
+        stickerdb->pending->numele == 0)
+    {
+        return;
+    }
+    sds key = sticker_pending_key(type, uri, name);
+    void *data;
+    if (raxRemove(stickerdb->pending, (unsigned char *)key, sdslen(key), &data) == 1) {
+        struct t_sticker_pending *entry = (struct t_sticker_pending *)data;
+        MYMPD_LOG_DEBUG(stickerdb->name, "Discarding pending write for sticker \"%s\" -> %s", uri, name);
+        FREE_SDS(entry->uri);
+        FREE_SDS(entry->name);
+        FREE_PTR(entry);
+    }
+    FREE_SDS(key);
 }
 
 /**
@@ -214,7 +442,7 @@ sds stickerdb_get_batch(struct t_stickerdb_state *stickerdb, enum mympd_sticker_
         return sdsempty();
     }
     sds value = get_sticker_value(stickerdb, type, uri, name);
-    return value;
+    return sticker_pending_apply_str(stickerdb, type, uri, name, value);
 }
 
 /**
@@ -233,6 +461,7 @@ sds stickerdb_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type t
         return sdsempty();
     }
     sds value = get_sticker_value(stickerdb, type, uri, name);
+    value = sticker_pending_apply_str(stickerdb, type, uri, name, value);
     stickerdb_enter_idle(stickerdb);
     return value;
 }
@@ -252,7 +481,7 @@ int64_t stickerdb_get_int64_batch(struct t_stickerdb_state *stickerdb, enum mymp
         return value;
     }
     value = get_sticker_int64(stickerdb, type, uri, name);
-    return value;
+    return sticker_pending_apply_value(sticker_pending_get(stickerdb, type, uri, name), value);
 }
 
 /**
@@ -272,6 +501,7 @@ int64_t stickerdb_get_int64(struct t_stickerdb_state *stickerdb, enum mympd_stic
         return false;
     }
     value = get_sticker_int64(stickerdb, type, uri, name);
+    value = sticker_pending_apply_value(sticker_pending_get(stickerdb, type, uri, name), value);
     stickerdb_enter_idle(stickerdb);
     return value;
 }
@@ -323,7 +553,9 @@ struct t_sticker *stickerdb_get_all_batch(struct t_stickerdb_state *stickerdb, e
     if (is_streamuri(uri) == true) {
         return NULL;
     }
-    return get_sticker_all(stickerdb, type, uri, sticker, user_defined);
+    sticker = get_sticker_all(stickerdb, type, uri, sticker, user_defined);
+    sticker_pending_apply_all(stickerdb, type, uri, sticker, user_defined);
+    return sticker;
 }
 
 /**
@@ -343,10 +575,93 @@ struct t_sticker *stickerdb_get_all(struct t_stickerdb_state *stickerdb, enum my
         return NULL;
     }
     sticker = get_sticker_all(stickerdb, type, uri, sticker, user_defined);
+    sticker_pending_apply_all(stickerdb, type, uri, sticker, user_defined);
     stickerdb_enter_idle(stickerdb);
     return sticker;
 }
 
+/**
+ * Gets all stickers for a list of uris, e.g. the rows of a result page.
+ * The stickers are read from the sticker mirror or are fetched with
+ * pipelined command lists, one sticker list command per uri.
+ * You must manage the idle state manually.
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uris list of sticker uris, duplicates and stream uris are skipped
+ * @param user_defined get user defines stickers?
+ * @return newly allocated radix tree with uri as key and t_sticker as value,
+ *         free it with stickerdb_free_all_multi
+ */
+rax *stickerdb_get_all_multi(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, struct t_list *uris, bool user_defined) {
+    rax *stickers = raxNew();
+    const char *type_name = mympd_sticker_type_name_lookup(type);
+    if (type_name == NULL) {
+        return stickers;
+    }
+    rax *mirror = sticker_mirror_get(stickerdb, type);
+    bool use_mirror = mirror != NULL &&
+        (user_defined == false || stickerdb->mirror_user_defined == true);
+    struct t_list pending;
+    list_init(&pending);
+    struct t_list_node *current = uris->head;
+    while (current != NULL) {
+        if (is_streamuri(current->key) == false) {
+            struct t_sticker *sticker = malloc_assert(sizeof(struct t_sticker));
+            sticker_struct_init(sticker);
+            if (raxTryInsert(stickers, (unsigned char *)current->key, sdslen(current->key), sticker, NULL) == 0) {
+                // duplicate uri
+                FREE_PTR(sticker);
+            }
+            else if (use_mirror == true) {
+                get_sticker_all(stickerdb, type, current->key, sticker, user_defined);
+            }
+            else {
+                list_push(&pending, current->key, 0, NULL, sticker);
+            }
+        }
+        current = current->next;
+    }
+    if (pending.length > 0) {
+        get_sticker_all_pipelined(stickerdb, type_name, &pending, user_defined);
+    }
+    // the stickers are owned by the radix tree
+    list_clear(&pending);
+    if (stickerdb->pending != NULL &&
+        stickerdb->pending->numele > 0)
+    {
+        raxIterator iter;
+        raxStart(&iter, stickers);
+        raxSeek(&iter, "^", NULL, 0);
+        while (raxNext(&iter)) {
+            sds uri = sdsnewlen(iter.key, iter.key_len);
+            sticker_pending_apply_all(stickerdb, type, uri, (struct t_sticker *)iter.data, user_defined);
+            FREE_SDS(uri);
+        }
+        raxStop(&iter);
+    }
+    return stickers;
+}
+
+/**
+ * Frees the result of stickerdb_get_all_multi
+ * @param stickers pointer to stickers rax tree
+ */
+void stickerdb_free_all_multi(rax *stickers) {
+    if (stickers == NULL) {
+        return;
+    }
+    raxIterator iter;
+    raxStart(&iter, stickers);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker *sticker = (struct t_sticker *)iter.data;
+        sticker_struct_clear(sticker);
+        FREE_PTR(sticker);
+    }
+    raxStop(&iter);
+    raxFree(stickers);
+}
+
 /**
  * Gets all stickers by name
  * @param stickerdb pointer to the stickerdb state
@@ -373,6 +688,8 @@ rax *stickerdb_find_stickers_by_name_value(struct t_stickerdb_state *stickerdb,
     if (stickerdb_connect(stickerdb) == false) {
         return NULL;
     }
+    // the search runs in MPD, write the pending stickers first
+    sticker_pending_commit(stickerdb);
     const char *type_name = mympd_sticker_type_name_lookup(type);
     if (type_name == NULL) {
         return NULL;
@@ -435,6 +752,8 @@ struct t_list *stickerdb_find_stickers_sorted(struct t_stickerdb_state *stickerd
     if (stickerdb_connect(stickerdb) == false) {
         return NULL;
     }
+    // the search runs in MPD, write the pending stickers first
+    sticker_pending_commit(stickerdb);
     const char *type_name = mympd_sticker_type_name_lookup(type);
     if (type_name == NULL) {
         return NULL;
@@ -551,6 +870,9 @@ bool stickerdb_inc(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type
     if (is_streamuri(uri) == true) {
         return true;
     }
+    if (sticker_pending_add(stickerdb, type, uri, name, 1, true) == true) {
+        return true;
+    }
     if (stickerdb_connect(stickerdb) == false) {
         return false;
     }
@@ -587,11 +909,13 @@ bool stickerdb_inc_set(struct t_stickerdb_state *stickerdb, enum mympd_sticker_t
     if (is_streamuri(uri) == true) {
         return true;
     }
+    if (sticker_pending_add(stickerdb, type, uri, sticker_name_lookup(name_timestamp), (int64_t)timestamp, false) == true) {
+        return sticker_pending_add(stickerdb, type, uri, sticker_name_lookup(name_inc), 1, true);
+    }
     if (stickerdb_connect(stickerdb) == false) {
         return false;
     }
-    bool rc = set_sticker_int64(stickerdb, type, uri, sticker_name_lookup(name_timestamp), (int64_t)timestamp) &&
-        inc_sticker(stickerdb, type, uri, sticker_name_lookup(name_inc));
+    bool rc = inc_set_sticker(stickerdb, type, uri, sticker_name_lookup(name_inc), sticker_name_lookup(name_timestamp), (int64_t)timestamp);
     stickerdb_enter_idle(stickerdb);
     return rc;
 }
@@ -710,6 +1034,108 @@ static bool get_sticker_types(struct t_stickerdb_state *stickerdb) {
     return true;
 }
 
+/**
+ * Returns the sticker mirror and populates it on demand.
+ * The stickerdb connection must not be in idle mode.
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type, only song stickers are mirrored
+ * @return the sticker mirror or NULL if not available
+ */
+static rax *sticker_mirror_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type) {
+    if (stickerdb->mirror_enabled == false ||
+        type != STICKER_TYPE_SONG)
+    {
+        return NULL;
+    }
+    if (stickerdb->mirror == NULL &&
+        sticker_mirror_populate(stickerdb) == false)
+    {
+        stickerdb_mirror_clear(stickerdb);
+    }
+    return stickerdb->mirror;
+}
+
+/**
+ * Populates the sticker mirror with one sticker find command per sticker name.
+ * User defined sticker names can only be listed by MPD 0.24 and later.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool sticker_mirror_populate(struct t_stickerdb_state *stickerdb) {
+    MYMPD_LOG_INFO(stickerdb->name, "Populating the sticker mirror");
+    stickerdb->mirror = raxNew();
+    stickerdb->mirror_user_defined = stickerdb->mpd_state->feat.advsticker;
+    struct t_list names;
+    list_init(&names);
+    for (unsigned i = 0; i < STICKER_COUNT; i++) {
+        list_push(&names, sticker_name_lookup((enum mympd_sticker_names)i), 0, NULL, NULL);
+    }
+    if (stickerdb->mirror_user_defined == true) {
+        struct mpd_pair *pair;
+        if (mpd_send_stickernamestypes(stickerdb->conn, mympd_sticker_type_name_lookup(STICKER_TYPE_SONG))) {
+            while ((pair = mpd_recv_pair(stickerdb->conn)) != NULL) {
+                if (strcmp(pair->name, "name") == 0 &&
+                    sticker_name_parse(pair->value) == STICKER_UNKNOWN)
+                {
+                    list_push(&names, pair->value, 0, NULL, NULL);
+                }
+                mpd_return_pair(stickerdb->conn, pair);
+            }
+        }
+        mpd_response_finish(stickerdb->conn);
+        if (stickerdb_check_error_and_recover(stickerdb, "mpd_send_stickernamestypes") == false) {
+            list_clear(&names);
+            return false;
+        }
+    }
+    bool rc = true;
+    struct t_list_node *current = names.head;
+    while (current != NULL) {
+        if (sticker_mirror_add_name(stickerdb, current->key) == false) {
+            rc = false;
+            break;
+        }
+        current = current->next;
+    }
+    list_clear(&names);
+    MYMPD_LOG_DEBUG("stickerdb", "Sticker mirror populated with %" PRIu64 " songs", stickerdb->mirror->numele);
+    return rc;
+}
+
+/**
+ * Adds all song stickers with this name to the sticker mirror
+ * @param stickerdb pointer to the stickerdb state
+ * @param name sticker name
+ * @return true on success, else false
+ */
+static bool sticker_mirror_add_name(struct t_stickerdb_state *stickerdb, const char *name) {
+    struct mpd_pair *pair;
+    size_t name_len = strlen(name);
+    sds file = sdsempty();
+    if (mpd_sticker_search_begin(stickerdb->conn, mympd_sticker_type_name_lookup(STICKER_TYPE_SONG), NULL, name) == false) {
+        mpd_sticker_search_cancel(stickerdb->conn);
+        FREE_SDS(file);
+        return false;
+    }
+    if (mpd_sticker_search_commit(stickerdb->conn) == true) {
+        while ((pair = mpd_recv_pair(stickerdb->conn)) != NULL) {
+            if (strcmp(pair->name, "file") == 0) {
+                file = sds_replace(file, pair->value);
+            }
+            else if (strcmp(pair->name, "sticker") == 0 &&
+                     strlen(pair->value) > name_len &&
+                     pair->value[name_len] == '=')
+            {
+                stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, file, name, pair->value + name_len + 1);
+            }
+            mpd_return_sticker(stickerdb->conn, pair);
+        }
+    }
+    mpd_response_finish(stickerdb->conn);
+    FREE_SDS(file);
+    return stickerdb_check_error_and_recover(stickerdb, "mpd_sticker_search_commit");
+}
+
 /**
  * Adds a mpd sticker search value constraint if value is not NULL
  * @param stickerdb pointer to the stickerdb state
@@ -767,33 +1193,109 @@ static bool sticker_search_add_window(struct t_stickerdb_state *stickerdb, unsig
 static struct t_sticker *get_sticker_all(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
         const char *uri, struct t_sticker *sticker, bool user_defined)
 {
-    struct mpd_pair *pair;
     sticker_struct_init(sticker);
     const char *type_name = mympd_sticker_type_name_lookup(type);
     if (type_name == NULL) {
         return sticker;
     }
-    if (mpd_send_sticker_list(stickerdb->conn, type_name, uri)) {
-        while ((pair = mpd_recv_sticker(stickerdb->conn)) != NULL) {
-            enum mympd_sticker_names sticker_name = sticker_name_parse(pair->name);
-            if (sticker_name != STICKER_UNKNOWN) {
-                int num;
-                enum str2int_errno rc = str2int(&num, pair->value);
-                sticker->mympd[sticker_name] = rc == STR2INT_SUCCESS
-                    ? num
-                    : 0;
-            }
-            else if (user_defined == true) {
-                list_push(&sticker->user, pair->name, 0, pair->value, NULL);
+    rax *mirror = sticker_mirror_get(stickerdb, type);
+    if (mirror != NULL &&
+        (user_defined == false || stickerdb->mirror_user_defined == true))
+    {
+        void *data;
+        if (raxFind(mirror, (unsigned char *)uri, strlen(uri), &data) == 1) {
+            struct t_sticker_mirror_entry *entry = (struct t_sticker_mirror_entry *)data;
+            memcpy(sticker->mympd, entry->sticker.mympd, sizeof(sticker->mympd));
+            if (user_defined == true) {
+                list_append(&sticker->user, &entry->sticker.user);
             }
-            mpd_return_sticker(stickerdb->conn, pair);
         }
+        return sticker;
+    }
+    if (mpd_send_sticker_list(stickerdb->conn, type_name, uri)) {
+        recv_sticker_all(stickerdb, sticker, user_defined);
     }
     mpd_response_finish(stickerdb->conn);
     stickerdb_check_error_and_recover(stickerdb, "mpd_send_sticker_list");
     return sticker;
 }
 
+/**
+ * Gets all stickers for the uris of the pending list with command lists.
+ * A failing command aborts the command list, the remaining uris are
+ * fetched with a new command list.
+ * @param stickerdb pointer to the stickerdb state
+ * @param type_name MPD sticker type name
+ * @param pending list of uris with an initialized t_sticker struct as user_data
+ * @param user_defined get user defines stickers?
+ */
+static void get_sticker_all_pipelined(struct t_stickerdb_state *stickerdb, const char *type_name, struct t_list *pending, bool user_defined) {
+    struct t_list_node *current = pending->head;
+    while (current != NULL) {
+        struct t_list_node *first = current;
+        unsigned count = 0;
+        bool rc = mpd_command_list_begin(stickerdb->conn, true);
+        while (rc == true &&
+               current != NULL &&
+               count < MPD_COMMANDS_MAX)
+        {
+            rc = mpd_send_sticker_list(stickerdb->conn, type_name, current->key);
+            current = current->next;
+            count++;
+        }
+        if (rc == false ||
+            mpd_command_list_end(stickerdb->conn) == false)
+        {
+            mpd_response_finish(stickerdb->conn);
+            stickerdb_check_error_and_recover(stickerdb, "mpd_send_sticker_list");
+            return;
+        }
+        // demultiplex the responses
+        struct t_list_node *node = first;
+        for (unsigned i = 0; i < count; i++) {
+            if (i > 0) {
+                if (mpd_response_next(stickerdb->conn) == false) {
+                    break;
+                }
+                node = node->next;
+            }
+            recv_sticker_all(stickerdb, (struct t_sticker *)node->user_data, user_defined);
+        }
+        mpd_response_finish(stickerdb->conn);
+        if (stickerdb_check_error_and_recover(stickerdb, "mpd_send_sticker_list") == false) {
+            if (stickerdb->conn_state == MPD_FAILURE) {
+                return;
+            }
+            // continue after the failed uri
+            current = node->next;
+        }
+    }
+}
+
+/**
+ * Receives the response of a sticker list command
+ * @param stickerdb pointer to the stickerdb state
+ * @param sticker pointer to an initialized t_sticker struct to populate
+ * @param user_defined get user defines stickers?
+ */
+static void recv_sticker_all(struct t_stickerdb_state *stickerdb, struct t_sticker *sticker, bool user_defined) {
+    struct mpd_pair *pair;
+    while ((pair = mpd_recv_sticker(stickerdb->conn)) != NULL) {
+        enum mympd_sticker_names sticker_name = sticker_name_parse(pair->name);
+        if (sticker_name != STICKER_UNKNOWN) {
+            int num;
+            enum str2int_errno rc = str2int(&num, pair->value);
+            sticker->mympd[sticker_name] = rc == STR2INT_SUCCESS
+                ? num
+                : 0;
+        }
+        else if (user_defined == true) {
+            list_push(&sticker->user, pair->name, 0, pair->value, NULL);
+        }
+        mpd_return_sticker(stickerdb->conn, pair);
+    }
+}
+
 /**
  * Gets a string value from sticker
  * @param stickerdb pointer to the stickerdb state
@@ -830,13 +1332,33 @@ static sds get_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_sti
  * @param name sticker name
  * @return number
  */
-int64_t get_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
+static int64_t get_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
     struct mpd_pair *pair;
     int64_t value = 0;
     const char *type_name = mympd_sticker_type_name_lookup(type);
     if (type_name == NULL) {
         return value;
     }
+    rax *mirror = sticker_mirror_get(stickerdb, type);
+    enum mympd_sticker_names sticker_name = sticker_name_parse(name);
+    if (mirror != NULL &&
+        (sticker_name != STICKER_UNKNOWN || stickerdb->mirror_user_defined == true))
+    {
+        void *data;
+        if (raxFind(mirror, (unsigned char *)uri, strlen(uri), &data) == 1) {
+            struct t_sticker_mirror_entry *entry = (struct t_sticker_mirror_entry *)data;
+            if (sticker_name == STICKER_UNKNOWN) {
+                struct t_list_node *node = list_get_node(&entry->sticker.user, name);
+                if (node != NULL) {
+                    str2int64(&value, node->value_p);
+                }
+            }
+            else if ((entry->mympd_set & (1U << sticker_name)) != 0) {
+                value = entry->sticker.mympd[sticker_name];
+            }
+        }
+        return value;
+    }
     if (mpd_send_sticker_list(stickerdb->conn, type_name, uri)) {
         while ((pair = mpd_recv_sticker(stickerdb->conn)) != NULL) {
             if (strcmp(pair->name, name) == 0) {
@@ -865,8 +1387,16 @@ static bool set_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_st
         return false;
     }
     MYMPD_LOG_INFO(stickerdb->name, "Setting sticker %s: \"%s\" -> %s: %s", type_name, uri, name, value);
+    stickerdb_pending_discard(stickerdb, type, uri, name);
     mpd_run_sticker_set(stickerdb->conn, type_name, uri, name, value);
-    return stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_set");
+    if (stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_set") == false) {
+        return false;
+    }
+    if (stickerdb->mirror != NULL) {
+        stickerdb_mirror_update(stickerdb, type, uri, name, value);
+        stickerdb->mirror_own_events = true;
+    }
+    return true;
 }
 
 /**
@@ -879,6 +1409,19 @@ static bool set_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_st
  * @return true on success, else false
  */
 static bool set_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name, int64_t value) {
+    sds value_str = sticker_int64_format(stickerdb, value);
+    bool rc = set_sticker_value(stickerdb, type, uri, name, value_str);
+    FREE_SDS(value_str);
+    return rc;
+}
+
+/**
+ * Formats an int64_t sticker value, pads it with zeros if configured
+ * @param stickerdb pointer to the stickerdb state
+ * @param value number to format
+ * @return newly allocated sds string
+ */
+static sds sticker_int64_format(struct t_stickerdb_state *stickerdb, int64_t value) {
     sds value_str = sdsfromlonglong((long long)value);
     if (stickerdb->config->stickers_pad_int == true &&
         stickerdb->mpd_state->feat.advsticker == false)
@@ -894,9 +1437,7 @@ static bool set_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_st
         FREE_SDS(value_str);
         value_str = pad_str;
     }
-    bool rc = set_sticker_value(stickerdb, type, uri, name, value_str);
-    FREE_SDS(value_str);
-    return rc;
+    return value_str;
 }
 
 /**
@@ -908,6 +1449,21 @@ static bool set_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_st
  * @return true on success, else false
  */
 static bool inc_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
+    if (stickerdb->mpd_state->feat.advsticker == true) {
+        // MPD increments the value itself
+        const char *type_name = mympd_sticker_type_name_lookup(type);
+        if (type_name == NULL) {
+            return false;
+        }
+        MYMPD_LOG_INFO(stickerdb->name, "Incrementing sticker %s: \"%s\" -> %s", type_name, uri, name);
+        mpd_send_command(stickerdb->conn, "sticker", "inc", type_name, uri, name, "1", NULL);
+        mpd_response_finish(stickerdb->conn);
+        if (stickerdb_check_error_and_recover(stickerdb, "sticker inc") == false) {
+            return false;
+        }
+        sticker_mirror_inc(stickerdb, type, uri, name);
+        return true;
+    }
     int64_t value = get_sticker_int64(stickerdb, type, uri, name);
     if (value < INT_MAX) {
         value++;
@@ -915,6 +1471,466 @@ static bool inc_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_
     return set_sticker_int64(stickerdb, type, uri, name, value);
 }
 
+/**
+ * Increments a sticker and sets a timestamp sticker
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name_inc sticker name for counter
+ * @param name_timestamp sticker name for timestamp
+ * @param timestamp timestamp to set
+ * @return true on success, else false
+ */
+static bool inc_set_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri,
+        const char *name_inc, const char *name_timestamp, int64_t timestamp)
+{
+    if (stickerdb->mpd_state->feat.advsticker == false) {
+        return set_sticker_int64(stickerdb, type, uri, name_timestamp, timestamp) &&
+            inc_sticker(stickerdb, type, uri, name_inc);
+    }
+    const char *type_name = mympd_sticker_type_name_lookup(type);
+    if (type_name == NULL) {
+        return false;
+    }
+    // both commands in one roundtrip
+    MYMPD_LOG_INFO(stickerdb->name, "Setting sticker %s: \"%s\" -> %s: %" PRId64 " and incrementing %s",
+        type_name, uri, name_timestamp, timestamp, name_inc);
+    sds value_str = sdsfromlonglong((long long)timestamp);
+    if (mpd_command_list_begin(stickerdb->conn, false)) {
+        if (mpd_send_sticker_set(stickerdb->conn, type_name, uri, name_timestamp, value_str) == true) {
+            mpd_send_command(stickerdb->conn, "sticker", "inc", type_name, uri, name_inc, "1", NULL);
+        }
+        mpd_command_list_end(stickerdb->conn);
+    }
+    mpd_response_finish(stickerdb->conn);
+    if (stickerdb_check_error_and_recover(stickerdb, "sticker inc") == false) {
+        FREE_SDS(value_str);
+        return false;
+    }
+    if (stickerdb->mirror != NULL) {
+        stickerdb_mirror_update(stickerdb, type, uri, name_timestamp, value_str);
+        stickerdb->mirror_own_events = true;
+    }
+    FREE_SDS(value_str);
+    sticker_mirror_inc(stickerdb, type, uri, name_inc);
+    return true;
+}
+
+/**
+ * Increments a sticker value in the mirror after MPD has incremented it
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ */
+static void sticker_mirror_inc(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
+    if (stickerdb->mirror == NULL ||
+        type != STICKER_TYPE_SONG)
+    {
+        return;
+    }
+    // with advanced sticker commands the mirror includes the user defined stickers
+    int64_t value = get_sticker_int64(stickerdb, type, uri, name);
+    sds value_str = sdsfromlonglong((long long)(value + 1));
+    stickerdb_mirror_update(stickerdb, type, uri, name, value_str);
+    stickerdb->mirror_own_events = true;
+    FREE_SDS(value_str);
+}
+
+/**
+ * Creates the key of a pending sticker write
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ * @return newly allocated sds string
+ */
+static sds sticker_pending_key(enum mympd_sticker_type type, const char *uri, const char *name) {
+    // the name length separates the name from the uri
+    return sdscatfmt(sdsempty(), "%i:%u:%s%s", (int)type, (unsigned)strlen(name), name, uri);
+}
+
+/**
+ * Adds a write to the pending sticker writes.
+ * Writes are only coalesced if the stickerdb is connected and
+ * MPD does not support the sticker inc command.
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ * @param value value to set or increment
+ * @param inc true to increment the sticker, false to set it
+ * @return true if the write was added, false if it must be written immediately
+ */
+static bool sticker_pending_add(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name, int64_t value, bool inc)
+{
+    if (stickerdb->pending == NULL ||
+        stickerdb->conn_state != MPD_CONNECTED ||
+        stickerdb->mpd_state->feat.advsticker == true ||
+        mympd_sticker_type_name_lookup(type) == NULL)
+    {
+        return false;
+    }
+    sds key = sticker_pending_key(type, uri, name);
+    void *data;
+    if (raxFind(stickerdb->pending, (unsigned char *)key, sdslen(key), &data) == 1) {
+        struct t_sticker_pending *entry = (struct t_sticker_pending *)data;
+        if (inc == true) {
+            // increments an already pending increment or value
+            entry->value = entry->value < INT_MAX - value
+                ? entry->value + value
+                : INT_MAX;
+        }
+        else {
+            entry->value = value;
+            entry->inc = false;
+        }
+        FREE_SDS(key);
+        return true;
+    }
+    struct t_sticker_pending *entry = malloc_assert(sizeof(struct t_sticker_pending));
+    entry->type = type;
+    entry->uri = sdsnew(uri);
+    entry->name = sdsnew(name);
+    entry->value = value;
+    entry->inc = inc;
+    raxInsert(stickerdb->pending, (unsigned char *)key, sdslen(key), entry, NULL);
+    FREE_SDS(key);
+    if (stickerdb->pending->numele == 1) {
+        mympd_timer_entry_set(&stickerdb->timer_pending, STICKER_PENDING_FLUSH_DELAY, 0);
+    }
+    return true;
+}
+
+/**
+ * Gets the pending write of a sticker
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ * @return pending write or NULL if there is none
+ */
+static struct t_sticker_pending *sticker_pending_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name)
+{
+    if (stickerdb->pending == NULL ||
+        stickerdb->pending->numele == 0)
+    {
+        return NULL;
+    }
+    sds key = sticker_pending_key(type, uri, name);
+    void *data;
+    int rc = raxFind(stickerdb->pending, (unsigned char *)key, sdslen(key), &data);
+    FREE_SDS(key);
+    return rc == 1
+        ? (struct t_sticker_pending *)data
+        : NULL;
+}
+
+/**
+ * Applies a pending write to a value read from MPD or the sticker mirror
+ * @param entry pending write or NULL
+ * @param value current value
+ * @return value including the pending write
+ */
+static int64_t sticker_pending_apply_value(const struct t_sticker_pending *entry, int64_t value) {
+    if (entry == NULL) {
+        return value;
+    }
+    if (entry->inc == false) {
+        return entry->value;
+    }
+    return value < INT_MAX - entry->value
+        ? value + entry->value
+        : INT_MAX;
+}
+
+/**
+ * Applies a pending write to a sticker string value
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param name sticker name
+ * @param value current value, is replaced if there is a pending write
+ * @return pointer to value
+ */
+static sds sticker_pending_apply_str(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name, sds value)
+{
+    const struct t_sticker_pending *entry = sticker_pending_get(stickerdb, type, uri, name);
+    if (entry == NULL) {
+        return value;
+    }
+    int64_t num = 0;
+    str2int64(&num, value);
+    sdsclear(value);
+    return sdscatfmt(value, "%I", sticker_pending_apply_value(entry, num));
+}
+
+/**
+ * Applies the pending writes for an uri to a populated sticker struct
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @param uri sticker uri
+ * @param sticker populated sticker struct
+ * @param user_defined sticker includes the user defined stickers
+ */
+static void sticker_pending_apply_all(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, struct t_sticker *sticker, bool user_defined)
+{
+    if (sticker == NULL ||
+        stickerdb->pending == NULL ||
+        stickerdb->pending->numele == 0)
+    {
+        return;
+    }
+    raxIterator iter;
+    raxStart(&iter, stickerdb->pending);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_sticker_pending *entry = (const struct t_sticker_pending *)iter.data;
+        if (entry->type != type ||
+            strcmp(entry->uri, uri) != 0)
+        {
+            continue;
+        }
+        enum mympd_sticker_names sticker_name = sticker_name_parse(entry->name);
+        if (sticker_name != STICKER_UNKNOWN) {
+            sticker->mympd[sticker_name] = sticker_pending_apply_value(entry, sticker->mympd[sticker_name]);
+        }
+        else if (user_defined == true) {
+            struct t_list_node *node = list_get_node(&sticker->user, entry->name);
+            int64_t num = 0;
+            if (node != NULL) {
+                str2int64(&num, node->value_p);
+            }
+            sds value = sdsfromlonglong((long long)sticker_pending_apply_value(entry, num));
+            if (node != NULL) {
+                node->value_p = sds_replace(node->value_p, value);
+            }
+            else {
+                list_push(&sticker->user, entry->name, 0, value, NULL);
+            }
+            FREE_SDS(value);
+        }
+    }
+    raxStop(&iter);
+}
+
+/**
+ * Writes the pending sticker writes.
+ * The stickerdb must be connected and not in idle mode.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool sticker_pending_commit(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->pending == NULL ||
+        stickerdb->pending->numele == 0)
+    {
+        return true;
+    }
+    MYMPD_LOG_INFO(stickerdb->name, "Writing %" PRIu64 " pending stickers", stickerdb->pending->numele);
+    return sticker_pending_resolve(stickerdb) &&
+        sticker_pending_write(stickerdb);
+}
+
+/**
+ * Creates a snapshot of the pending sticker writes
+ * @param stickerdb pointer to the stickerdb state
+ * @param entries initialized list to populate, key is the pending key and user_data a pointer to the entry
+ * @param inc true to add the unresolved increments, false to add the values to set
+ */
+static void sticker_pending_list(struct t_stickerdb_state *stickerdb, struct t_list *entries, bool inc) {
+    raxIterator iter;
+    raxStart(&iter, stickerdb->pending);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker_pending *entry = (struct t_sticker_pending *)iter.data;
+        if (entry->inc == inc) {
+            list_push_len(entries, (char *)iter.key, iter.key_len, 0, NULL, 0, entry);
+        }
+    }
+    raxStop(&iter);
+}
+
+/**
+ * Removes and frees a pending sticker write
+ * @param stickerdb pointer to the stickerdb state
+ * @param node list node from sticker_pending_list
+ */
+static void sticker_pending_remove(struct t_stickerdb_state *stickerdb, struct t_list_node *node) {
+    struct t_sticker_pending *entry = (struct t_sticker_pending *)node->user_data;
+    raxRemove(stickerdb->pending, (unsigned char *)node->key, sdslen(node->key), NULL);
+    FREE_SDS(entry->uri);
+    FREE_SDS(entry->name);
+    FREE_PTR(entry);
+    node->user_data = NULL;
+}
+
+/**
+ * Converts a pending increment to an absolute value
+ * @param entry pending sticker write
+ * @param current current value of the sticker
+ */
+static void sticker_pending_resolve_value(struct t_sticker_pending *entry, int64_t current) {
+    entry->value = current < INT_MAX - entry->value
+        ? current + entry->value
+        : INT_MAX;
+    entry->inc = false;
+}
+
+/**
+ * Resolves the pending increments against the current sticker values.
+ * Values are read from the sticker mirror or with pipelined sticker list commands.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool sticker_pending_resolve(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->mirror != NULL) {
+        raxIterator iter;
+        raxStart(&iter, stickerdb->pending);
+        raxSeek(&iter, "^", NULL, 0);
+        while (raxNext(&iter)) {
+            struct t_sticker_pending *entry = (struct t_sticker_pending *)iter.data;
+            if (entry->inc == true &&
+                entry->type == STICKER_TYPE_SONG &&
+                (sticker_name_parse(entry->name) != STICKER_UNKNOWN || stickerdb->mirror_user_defined == true))
+            {
+                sticker_pending_resolve_value(entry, get_sticker_int64(stickerdb, entry->type, entry->uri, entry->name));
+            }
+        }
+        raxStop(&iter);
+    }
+    struct t_list entries;
+    list_init(&entries);
+    sticker_pending_list(stickerdb, &entries, true);
+    struct t_list_node *current = entries.head;
+    bool rc = true;
+    while (current != NULL) {
+        struct t_list_node *first = current;
+        unsigned count = 0;
+        rc = mpd_command_list_begin(stickerdb->conn, true);
+        while (rc == true &&
+               current != NULL &&
+               count < MPD_COMMANDS_MAX)
+        {
+            struct t_sticker_pending *entry = (struct t_sticker_pending *)current->user_data;
+            rc = mpd_send_sticker_list(stickerdb->conn, mympd_sticker_type_name_lookup(entry->type), entry->uri);
+            current = current->next;
+            count++;
+        }
+        if (rc == false ||
+            mpd_command_list_end(stickerdb->conn) == false)
+        {
+            mpd_response_finish(stickerdb->conn);
+            stickerdb_check_error_and_recover(stickerdb, "mpd_send_sticker_list");
+            rc = false;
+            break;
+        }
+        // demultiplex the responses, a failed command resolves to zero
+        struct t_list_node *node = first;
+        for (unsigned i = 0; i < count; i++) {
+            if (i > 0) {
+                if (mpd_response_next(stickerdb->conn) == false) {
+                    break;
+                }
+                node = node->next;
+            }
+            struct t_sticker_pending *entry = (struct t_sticker_pending *)node->user_data;
+            int64_t value = 0;
+            struct mpd_pair *pair;
+            while ((pair = mpd_recv_sticker(stickerdb->conn)) != NULL) {
+                if (strcmp(pair->name, entry->name) == 0) {
+                    str2int64(&value, pair->value);
+                }
+                mpd_return_sticker(stickerdb->conn, pair);
+            }
+            sticker_pending_resolve_value(entry, value);
+        }
+        mpd_response_finish(stickerdb->conn);
+        if (stickerdb_check_error_and_recover(stickerdb, "mpd_send_sticker_list") == false) {
+            if (stickerdb->conn_state == MPD_FAILURE) {
+                rc = false;
+                break;
+            }
+            // continue after the failed uri
+            current = node->next;
+        }
+        rc = true;
+    }
+    list_clear(&entries);
+    return rc;
+}
+
+/**
+ * Writes the resolved pending sticker values with command lists.
+ * Written entries and entries rejected by MPD are removed.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool sticker_pending_write(struct t_stickerdb_state *stickerdb) {
+    struct t_list entries;
+    list_init(&entries);
+    sticker_pending_list(stickerdb, &entries, false);
+    struct t_list_node *current = entries.head;
+    bool rc = true;
+    while (rc == true &&
+           current != NULL)
+    {
+        struct t_list_node *first = current;
+        unsigned count = 0;
+        rc = mpd_command_list_begin(stickerdb->conn, false);
+        while (rc == true &&
+               current != NULL &&
+               count < MPD_COMMANDS_MAX)
+        {
+            struct t_sticker_pending *entry = (struct t_sticker_pending *)current->user_data;
+            sds value_str = sticker_int64_format(stickerdb, entry->value);
+            rc = mpd_send_sticker_set(stickerdb->conn, mympd_sticker_type_name_lookup(entry->type),
+                entry->uri, entry->name, value_str);
+            FREE_SDS(value_str);
+            current = current->next;
+            count++;
+        }
+        if (rc == true) {
+            rc = mpd_command_list_end(stickerdb->conn);
+        }
+        mpd_response_finish(stickerdb->conn);
+        unsigned applied = count;
+        if (mpd_connection_get_error(stickerdb->conn) == MPD_ERROR_SERVER) {
+            // the commands before the failed command were applied, the failed command is dropped
+            applied = mpd_connection_get_server_error_location(stickerdb->conn);
+            current = first;
+            for (unsigned i = 0; i <= applied && current != NULL; i++) {
+                current = current->next;
+            }
+        }
+        rc = stickerdb_check_error_and_recover(stickerdb, "mpd_send_sticker_set");
+        if (rc == false &&
+            stickerdb->conn_state == MPD_FAILURE)
+        {
+            break;
+        }
+        struct t_list_node *node = first;
+        for (unsigned i = 0; i < count && node != current; i++) {
+            struct t_sticker_pending *entry = (struct t_sticker_pending *)node->user_data;
+            if (i < applied &&
+                stickerdb->mirror != NULL)
+            {
+                sds value_str = sdsfromlonglong((long long)entry->value);
+                stickerdb_mirror_update(stickerdb, entry->type, entry->uri, entry->name, value_str);
+                stickerdb->mirror_own_events = true;
+                FREE_SDS(value_str);
+            }
+            sticker_pending_remove(stickerdb, node);
+            node = node->next;
+        }
+        rc = true;
+    }
+    list_clear(&entries);
+    return rc;
+}
+
 /**
  * Removes a sticker
  * @param stickerdb pointer to the stickerdb state
@@ -929,8 +1945,39 @@ static bool remove_sticker(struct t_stickerdb_state *stickerdb, enum mympd_stick
         return false;
     }
     MYMPD_LOG_INFO(stickerdb->name, "Removing sticker: \"%s\" -> %s", uri, name);
+    stickerdb_pending_discard(stickerdb, type, uri, name);
     mpd_run_sticker_delete(stickerdb->conn, type_name, uri, name);
-    return stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_delete");
+    if (stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_delete") == false) {
+        return false;
+    }
+    if (stickerdb->mirror != NULL) {
+        stickerdb_mirror_update(stickerdb, type, uri, name, NULL);
+        stickerdb->mirror_own_events = true;
+    }
+    return true;
+}
+
+/**
+ * Exits the idle mode and reads the idle events
+ * @param stickerdb pointer to the stickerdb state
+ * @param own_events true if the sticker events are caused by our own writes
+ * @return true on success, else false
+ */
+static bool stickerdb_leave_idle(struct t_stickerdb_state *stickerdb, bool own_events) {
+    MYMPD_LOG_DEBUG("stickerdb", "Exiting idle mode");
+    if (mpd_send_noidle(stickerdb->conn) == false) {
+        MYMPD_LOG_ERROR("stickerdb", "Error exiting idle mode");
+    }
+    enum mpd_idle events = mpd_recv_idle(stickerdb->conn, false);
+    mpd_response_finish(stickerdb->conn);
+    if (own_events == false &&
+        (events & MPD_IDLE_STICKER) == MPD_IDLE_STICKER &&
+        stickerdb->mirror != NULL)
+    {
+        MYMPD_LOG_DEBUG("stickerdb", "Stickers were changed by another client");
+        stickerdb_mirror_clear(stickerdb);
+    }
+    return stickerdb_check_error_and_recover(stickerdb, "mpd_run_noidle");
 }
 
 /**
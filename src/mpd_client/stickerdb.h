@@ -18,6 +18,12 @@ void stickerdb_disconnect(struct t_stickerdb_state *stickerdb);
 bool stickerdb_idle(struct t_stickerdb_state *stickerdb);
 bool stickerdb_enter_idle(struct t_stickerdb_state *stickerdb);
 bool stickerdb_exit_idle(struct t_stickerdb_state *stickerdb);
+void stickerdb_mirror_clear(struct t_stickerdb_state *stickerdb);
+void stickerdb_mirror_update(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
+        const char *uri, const char *name, const char *value);
+bool stickerdb_pending_flush(struct t_stickerdb_state *stickerdb);
+void stickerdb_pending_clear(struct t_stickerdb_state *stickerdb);
+void stickerdb_pending_discard(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
 bool stickerdb_check_error_and_recover(struct t_stickerdb_state *stickerdb, const char *command);
 
 sds stickerdb_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
@@ -27,6 +33,8 @@ struct t_sticker *stickerdb_get_all(struct t_stickerdb_state *stickerdb, enum my
 sds stickerdb_get_batch(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
 int64_t stickerdb_get_int64_batch(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
 struct t_sticker *stickerdb_get_all_batch(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, struct t_sticker *sticker, bool user_defined);
+rax *stickerdb_get_all_multi(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, struct t_list *uris, bool user_defined);
+void stickerdb_free_all_multi(rax *stickers);
 
 rax *stickerdb_find_stickers_by_name(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *name);
 rax *stickerdb_find_stickers_by_name_value(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type,
@@ -390,6 +390,14 @@ sds mpd_client_get_tag_values(const struct mpd_song *song, enum mpd_tag_type tag
     return tag_values;
 }
 
+/**
+ * Callback function for list_clear_user_data to free mpd_song user data
+ * @param current list node
+ */
+void list_free_cb_song_user_data(struct t_list_node *current) {
+    mpd_song_free((struct mpd_song *)current->user_data);
+}
+
 /**
  * Prints the tag values for a mpd song as json string
  * @param buffer already allocated sds string to append the values
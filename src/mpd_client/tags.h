@@ -24,6 +24,7 @@ bool disable_all_mpd_tags(struct t_partition_state *partition_state);
 bool enable_all_mpd_tags(struct t_partition_state *partition_state);
 bool enable_mpd_tags(struct t_partition_state *partition_state, const struct t_mpd_tags *enable_tags);
 enum mpd_tag_type get_sort_tag(enum mpd_tag_type tag, const struct t_mpd_tags *available_tags);
+void list_free_cb_song_user_data(struct t_list_node *current);
 sds print_song_tags(sds buffer, const struct t_mpd_state *mpd_state, const struct t_mpd_tags *tagcols,
         const struct mpd_song *song);
 sds print_album_tags(sds buffer, const struct t_mpd_state *mpd_state, const struct t_mpd_tags *tagcols,
@@ -13,27 +13,62 @@
 
 #include "dist/libmympdclient/include/mpd/client.h"
 #include "dist/libmympdclient/src/isong.h"
+#include "src/lib/album_index.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/convert.h"
 #include "src/lib/datetime.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/msg_queue.h"
+#include "src/lib/mympd_state.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/utility.h"
+#include "src/mpd_client/connection.h"
 #include "src/mpd_client/errorhandler.h"
 #include "src/mpd_client/search.h"
 #include "src/mpd_client/tags.h"
+#include "src/mpd_worker/song_cache.h"
 
 #include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
 
 /**
  * Private definitions
  */
+
+//! Songs to add to the album cache
+#define ALBUMCACHE_EXPRESSION "((Album != '') AND (AlbumArtist !=''))"
+
+/**
+ * Range of songs scanned by an own thread and mpd connection
+ */
+struct t_album_cache_part {
+    struct t_mpd_worker_state *mpd_worker_state;  //!< pointer to the mpd worker state
+    pthread_t thread;                             //!< thread scanning this range
+    rax *album_cache;                             //!< albums of this range
+    unsigned start;                               //!< start of the song range
+    unsigned end;                                 //!< end of the song range
+    int album_count;                              //!< number of albums in this range
+    int skip_count;                               //!< number of skipped songs in this range
+    bool rc;                                      //!< true if the range was scanned successfully
+};
 static bool album_cache_create(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache);
+static bool album_cache_update(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache, time_t since);
 static bool album_cache_create_simple(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache);
+static void album_cache_enable_tags(struct t_mpd_worker_state *mpd_worker_state);
+static bool album_cache_add_songs(struct t_mpd_worker_state *mpd_worker_state, struct t_partition_state *partition_state,
+        rax *album_cache, const char *expression, unsigned start, unsigned end, int *album_count, int *skip_count);
+static bool album_cache_count_songs(struct t_partition_state *partition_state, const char *expression, unsigned *count);
+static void *album_cache_part_run(void *arg);
+static bool album_cache_get_modified(struct t_mpd_worker_state *mpd_worker_state, time_t since, rax *names);
+static bool album_cache_check_counts(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache, rax *names);
+static struct t_album_index *album_index_create_locked(struct t_cache *album_cache);
 
 /**
  * Public functions
@@ -57,6 +92,15 @@ bool mpd_worker_album_cache_create(struct t_mpd_worker_state *mpd_worker_state,
         MYMPD_LOG_DEBUG("default", "Database mtime: %s", fmt_time_db);
         MYMPD_LOG_DEBUG("default", "Album cache mtime: %s", fmt_time_album_cache);
     #endif
+    if (mpd_worker_state->config->song_cache == true) {
+        // the caches are only up-to-date if the song cache is also newer than the database
+        sdsclear(filepath);
+        filepath = sdscatfmt(filepath, "%S/%s/%s", mpd_worker_state->config->workdir, DIR_WORK_TAGS, FILENAME_SONGCACHE);
+        time_t song_cache_mtime = get_mtime(filepath);
+        if (song_cache_mtime < album_cache_mtime) {
+            album_cache_mtime = song_cache_mtime;
+        }
+    }
     FREE_SDS(filepath);
 
     if (force == false &&
@@ -67,6 +111,10 @@ bool mpd_worker_album_cache_create(struct t_mpd_worker_state *mpd_worker_state,
         if (mpd_worker_state->partition_state->mpd_state->feat.tags == true) {
             struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, INTERNAL_API_ALBUMCACHE_SKIPPED, NULL, mpd_worker_state->partition_state->name);
             request->data = jsonrpc_end(request->data);
+            if (mpd_worker_state->album_index_missing == true) {
+                // album cache was read from disk at startup, index it here
+                request->extra = album_index_create_locked(mpd_worker_state->album_cache);
+            }
             mympd_queue_push(mympd_api_queue, request, 0);
         }
         return true;
@@ -74,21 +122,50 @@ bool mpd_worker_album_cache_create(struct t_mpd_worker_state *mpd_worker_state,
     send_jsonrpc_event(JSONRPC_EVENT_UPDATE_CACHE_STARTED, MPD_PARTITION_ALL);
 
     bool rc = true;
+    if (mpd_worker_state->config->song_cache == true &&
+        mpd_worker_state->partition_state->mpd_state->feat.tags == true)
+    {
+        // the song cache is sent before the album cache, the album cache finishes the update.
+        // It is always rebuilt, the interned tag values of removed songs can not be released.
+        mpd_worker_song_cache_create(mpd_worker_state);
+    }
     if (mpd_worker_state->partition_state->mpd_state->feat.tags == true) {
         struct t_cache album_cache;
-        album_cache.cache = raxNew();
-        rc = mpd_worker_state->config->albums.mode == ALBUM_MODE_ADV
-            ? album_cache_create(mpd_worker_state, album_cache.cache)
-            : album_cache_create_simple(mpd_worker_state, album_cache.cache);
+        album_cache.cache = NULL;
+        rc = false;
+        time_t album_cache_db_update = 0;
+        if (force == false &&
+            album_cache_mtime > 0 &&
+            mpd_worker_state->config->albums.mode == ALBUM_MODE_ADV &&
+            mpd_client_tag_exists(&mpd_worker_state->mpd_state->tags_album, MPD_TAG_ALBUM) == true &&
+            album_cache_read(&album_cache, mpd_worker_state->config->workdir, &mpd_worker_state->config->albums, &album_cache_db_update) == true)
+        {
+            // patch the albums that changed since the database update the cache was built from
+            rc = album_cache_db_update > 0 &&
+                album_cache_update(mpd_worker_state, album_cache.cache, album_cache_db_update);
+            if (rc == false) {
+                MYMPD_LOG_INFO("default", "Incremental album cache update not possible, rebuilding it");
+                album_cache_free(&album_cache);
+            }
+        }
+        if (rc == false) {
+            album_cache.cache = raxNew();
+            rc = mpd_worker_state->config->albums.mode == ALBUM_MODE_ADV
+                ? album_cache_create(mpd_worker_state, album_cache.cache)
+                : album_cache_create_simple(mpd_worker_state, album_cache.cache);
+        }
         if (rc == true) {
             struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, INTERNAL_API_ALBUMCACHE_CREATED, NULL, mpd_worker_state->partition_state->name);
             request->data = jsonrpc_end(request->data);
-            request->extra = (void *) album_cache.cache;
+            struct t_album_cache_update *update = malloc_assert(sizeof(struct t_album_cache_update));
+            update->album_cache = album_cache.cache;
+            update->album_index = album_index_new(album_cache.cache);
+            request->extra = (void *) update;
             mympd_queue_push(mympd_api_queue, request, 0);
             send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_INFO, MPD_PARTITION_ALL, "Updated album cache");
             if (mpd_worker_state->config->save_caches == true) {
                 album_cache_write(&album_cache, mpd_worker_state->config->workdir,
-                    &mpd_worker_state->mpd_state->tags_album, &mpd_worker_state->config->albums, false);
+                    &mpd_worker_state->mpd_state->tags_album, &mpd_worker_state->config->albums, db_mtime, false);
             }
         }
         else {
@@ -122,19 +199,189 @@ bool mpd_worker_album_cache_create(struct t_mpd_worker_state *mpd_worker_state,
  */
 static bool album_cache_create(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache) {
     MYMPD_LOG_INFO("default", "Creating album cache");
-    if (mpd_worker_state->config->albums.group_tag != MPD_TAG_UNKNOWN) {
-        MYMPD_LOG_DEBUG("default", "Additional group tag: %s", mpd_tag_name(mpd_worker_state->config->albums.group_tag));
+    album_cache_enable_tags(mpd_worker_state);
+    unsigned song_count;
+    if (album_cache_count_songs(mpd_worker_state->partition_state, ALBUMCACHE_EXPRESSION, &song_count) == false) {
+        return false;
     }
-    else {
-        MYMPD_LOG_DEBUG("default", "Additional group tag: None");
+    // split the songs in ranges of at least MPD_RESULTS_MAX songs, one range per cpu
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned parts_len = song_count / MPD_RESULTS_MAX + 1;
+    if (cpus > 0 &&
+        parts_len > (unsigned)cpus)
+    {
+        parts_len = (unsigned)cpus;
+    }
+    if (parts_len > ALBUMCACHE_THREADS_MAX) {
+        parts_len = ALBUMCACHE_THREADS_MAX;
+    }
+    unsigned range = song_count / parts_len + 1;
+    MYMPD_LOG_DEBUG("default", "Scanning %u songs in %u part(s)", song_count, parts_len);
+
+    //get all songs and set albums
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    struct t_album_cache_part *parts = malloc_assert(sizeof(struct t_album_cache_part) * parts_len);
+    for (unsigned i = 0; i < parts_len; i++) {
+        parts[i].mpd_worker_state = mpd_worker_state;
+        // the first part is added directly to the album cache
+        parts[i].album_cache = i == 0
+            ? album_cache
+            : raxNew();
+        parts[i].start = i * range;
+        // the last part fetches all remaining songs
+        parts[i].end = i == parts_len - 1
+            ? UINT_MAX
+            : (i + 1) * range;
+        parts[i].album_count = 0;
+        parts[i].skip_count = 0;
+        parts[i].rc = false;
+    }
+    // start a thread with an own mpd connection for all parts but the first one
+    unsigned started = 1;
+    for (; started < parts_len; started++) {
+        if (pthread_create(&parts[started].thread, NULL, album_cache_part_run, &parts[started]) != 0) {
+            MYMPD_LOG_ERROR("default", "Can not create album cache thread");
+            break;
+        }
+    }
+    // the first part uses the connection of the worker
+    parts[0].rc = album_cache_add_songs(mpd_worker_state, mpd_worker_state->partition_state, album_cache,
+        ALBUMCACHE_EXPRESSION, parts[0].start, parts[0].end, &parts[0].album_count, &parts[0].skip_count);
+    for (unsigned i = 1; i < started; i++) {
+        pthread_join(parts[i].thread, NULL);
+    }
+    // merge the parts in order, the result is the same as of a serial scan
+    bool rc = started == parts_len;
+    int album_count = 0;
+    int skip_count = 0;
+    for (unsigned i = 0; i < parts_len; i++) {
+        rc = rc && parts[i].rc;
+        skip_count += parts[i].skip_count;
+        if (i == 0) {
+            album_count += parts[i].album_count;
+            continue;
+        }
+        raxIterator iter;
+        raxStart(&iter, parts[i].album_cache);
+        raxSeek(&iter, "^", NULL, 0);
+        while (raxNext(&iter)) {
+            struct mpd_song *part = (struct mpd_song *)iter.data;
+            void *old_data;
+            if (rc == false) {
+                mpd_song_free(part);
+            }
+            else if (raxTryInsert(album_cache, iter.key, iter.key_len, part, &old_data) == 0) {
+                album_cache_merge((struct mpd_song *)old_data, part, &mpd_worker_state->mpd_state->tags_mympd);
+                mpd_song_free(part);
+            }
+            else {
+                album_count++;
+            }
+        }
+        raxStop(&iter);
+        raxFree(parts[i].album_cache);
+    }
+    FREE_PTR(parts);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT("default", "Populate album cache")
+    #endif
+    if (rc == false) {
+        MYMPD_LOG_ERROR("default", "Cache update failed");
+        return false;
     }
 
-    unsigned start = 0;
-    unsigned end = start + MPD_RESULTS_MAX;
-    unsigned i = 0;
+    //finished - print statistics
+    MYMPD_LOG_INFO("default", "Added %d albums to album cache", album_count);
+    if (skip_count > 0) {
+        MYMPD_LOG_WARN("default", "Skipped %d songs for album cache", skip_count);
+    }
+    MYMPD_LOG_INFO("default", "Cache updated successfully");
+    return true;
+}
+
+/**
+ * Updates the album cache read from disc incrementally.
+ * Albums are rebuilt by name, if songs were modified since the database update the cache was built from or
+ * the song count of the album name in the cache differs from the count in the MPD database.
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ * @param album_cache pointer to the album cache to patch
+ * @param since mpd database update time the album cache was built from
+ * @return true on success, false if the cache must be rebuilt from scratch
+ */
+static bool album_cache_update(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache, time_t since) {
+    MYMPD_LOG_INFO("default", "Updating album cache incrementally");
+    album_cache_enable_tags(mpd_worker_state);
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    // album names to rebuild
+    rax *names = raxNew();
+    if (album_cache_get_modified(mpd_worker_state, since, names) == false ||
+        album_cache_check_counts(mpd_worker_state, album_cache, names) == false)
+    {
+        raxFree(names);
+        return false;
+    }
+    album_cache_remove_names(album_cache, names);
+    if (names->numele > ALBUMCACHE_UPDATE_NAMES_MAX) {
+        MYMPD_LOG_INFO("default", "Too many changed albums: %" PRIu64, names->numele);
+        raxFree(names);
+        return false;
+    }
+    MYMPD_LOG_INFO("default", "Rebuilding %" PRIu64 " album(s)", names->numele);
     int album_count = 0;
     int skip_count = 0;
+    bool rc = true;
+    sds expression = sdsempty();
+    raxIterator iter;
+    raxStart(&iter, names);
+    raxSeek(&iter, "^", NULL, 0);
+    while (rc == true &&
+           raxNext(&iter))
+    {
+        sds name = sdsnewlen(iter.key, iter.key_len);
+        sdsclear(expression);
+        expression = sdscatlen(expression, "(", 1);
+        expression = escape_mpd_search_expression(expression, "Album", "==", name);
+        expression = sdscat(expression, " AND (AlbumArtist != ''))");
+        rc = album_cache_add_songs(mpd_worker_state, mpd_worker_state->partition_state, album_cache, expression,
+            0, UINT_MAX, &album_count, &skip_count);
+        FREE_SDS(name);
+    }
+    raxStop(&iter);
+    FREE_SDS(expression);
+    raxFree(names);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT("default", "Update album cache")
+    #endif
+    if (rc == false) {
+        return false;
+    }
+    MYMPD_LOG_INFO("default", "Rebuilt %d albums, album cache has %" PRIu64 " albums", album_count, album_cache->numele);
+    if (skip_count > 0) {
+        MYMPD_LOG_WARN("default", "Skipped %d songs for album cache", skip_count);
+    }
+    MYMPD_LOG_INFO("default", "Cache updated successfully");
+    return true;
+}
 
+/**
+ * Adds the disc and the album group tag to the album tags and enables the album tags
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ */
+static void album_cache_enable_tags(struct t_mpd_worker_state *mpd_worker_state) {
+    if (mpd_worker_state->config->albums.group_tag != MPD_TAG_UNKNOWN) {
+        MYMPD_LOG_DEBUG("default", "Additional group tag: %s", mpd_tag_name(mpd_worker_state->config->albums.group_tag));
+    }
+    else {
+        MYMPD_LOG_DEBUG("default", "Additional group tag: None");
+    }
     //set interesting tags
     if (mpd_client_tag_exists(&mpd_worker_state->mpd_state->tags_mympd, MPD_TAG_DISC) == true) {
         if (mpd_client_tag_exists(&mpd_worker_state->mpd_state->tags_album, MPD_TAG_DISC) == false) {
@@ -155,25 +402,41 @@ static bool album_cache_create(struct t_mpd_worker_state *mpd_worker_state, rax
         }
     }
     enable_mpd_tags(mpd_worker_state->partition_state, &mpd_worker_state->mpd_state->tags_album);
+}
 
-    //get all songs and set albums
-    #ifdef MYMPD_DEBUG
-        MEASURE_INIT
-        MEASURE_START
-    #endif
+/**
+ * Fetches the songs matching the expression and adds them to the album cache
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ * @param partition_state pointer to the partition state with the mpd connection to use
+ * @param album_cache pointer to the album cache
+ * @param expression mpd search expression
+ * @param start start of the song range
+ * @param end end of the song range, UINT_MAX for all remaining songs
+ * @param album_count pointer to the count of new albums
+ * @param skip_count pointer to the count of skipped songs
+ * @return true on success, else false
+ */
+static bool album_cache_add_songs(struct t_mpd_worker_state *mpd_worker_state, struct t_partition_state *partition_state,
+        rax *album_cache, const char *expression, unsigned start, unsigned end, int *album_count, int *skip_count)
+{
+    unsigned i = start;
     sds key = sdsempty();
     do {
-        if (mpd_search_db_songs(mpd_worker_state->partition_state->conn, false) == false ||
-            mpd_search_add_expression(mpd_worker_state->partition_state->conn, "((Album != '') AND (AlbumArtist !=''))") == false ||
-            mpd_search_add_window(mpd_worker_state->partition_state->conn, start, end) == false)
+        unsigned window_end = end - start > MPD_RESULTS_MAX
+            ? start + MPD_RESULTS_MAX
+            : end;
+        if (mpd_search_db_songs(partition_state->conn, false) == false ||
+            mpd_search_add_expression(partition_state->conn, expression) == false ||
+            mpd_search_add_window(partition_state->conn, start, window_end) == false)
         {
             MYMPD_LOG_ERROR("default", "Cache update failed");
-            mpd_search_cancel(mpd_worker_state->partition_state->conn);
+            mpd_search_cancel(partition_state->conn);
+            FREE_SDS(key);
             return false;
         }
-        if (mpd_search_commit(mpd_worker_state->partition_state->conn)) {
+        if (mpd_search_commit(partition_state->conn)) {
             struct mpd_song *song;
-            while ((song = mpd_recv_song(mpd_worker_state->partition_state->conn)) != NULL) {
+            while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
                 // set initial song and disc count to 1
                 album_cache_set_song_count(song, 1);
                 if (mpd_worker_state->tag_disc_empty_is_first == true) {
@@ -183,7 +446,7 @@ static bool album_cache_create(struct t_mpd_worker_state *mpd_worker_state, rax
                 // construct the key
                 key = album_cache_get_key(key, song, &mpd_worker_state->config->albums);
                 if (sdslen(key) > 0) {
-                    if (mpd_worker_state->partition_state->mpd_state->tag_albumartist == MPD_TAG_ALBUM_ARTIST &&
+                    if (partition_state->mpd_state->tag_albumartist == MPD_TAG_ALBUM_ARTIST &&
                         mpd_song_get_tag(song, MPD_TAG_ALBUM_ARTIST, 0) == NULL)
                     {
                         // Copy Artist tag to AlbumArtist tag
@@ -195,7 +458,7 @@ static bool album_cache_create(struct t_mpd_worker_state *mpd_worker_state, rax
                         // existing album: append song data
                         struct mpd_song *album = (struct mpd_song *) old_data;
                         // append tags
-                        album_cache_append_tags(album, song, &mpd_worker_state->partition_state->mpd_state->tags_mympd);
+                        album_cache_append_tags(album, song, &partition_state->mpd_state->tags_mympd);
                         // set album data
                         album_cache_set_last_modified(album, song); // use latest last_modified
                         album_cache_inc_total_time(album, song);    // sum duration
@@ -206,39 +469,174 @@ static bool album_cache_create(struct t_mpd_worker_state *mpd_worker_state, rax
                     }
                     else {
                         // new album: use song data as initial album data
-                        album_count++;
+                        (*album_count)++;
                     }
                 }
                 else {
-                    skip_count++;
+                    (*skip_count)++;
                     mpd_song_free(song);
                 }
                 i++;
             }
         }
-        mpd_response_finish(mpd_worker_state->partition_state->conn);
-        if (mympd_check_error_and_recover(mpd_worker_state->partition_state, NULL, "mpd_search_commit") == false) {
+        mpd_response_finish(partition_state->conn);
+        if (mympd_check_error_and_recover(partition_state, NULL, "mpd_search_commit") == false) {
             MYMPD_LOG_ERROR("default", "Cache update failed");
+            FREE_SDS(key);
             return false;
         }
-        start = end;
-        end = end + MPD_RESULTS_MAX;
-    } while (i >= start);
+        start = window_end;
+    } while (i >= start &&
+             start < end);
     FREE_SDS(key);
-    #ifdef MYMPD_DEBUG
-        MEASURE_END
-        MEASURE_PRINT("default", "Populate album cache")
-    #endif
+    return true;
+}
 
-    //finished - print statistics
-    MYMPD_LOG_INFO("default", "Added %d albums to album cache", album_count);
-    if (skip_count > 0) {
-        MYMPD_LOG_WARN("default", "Skipped %d songs for album cache", skip_count);
+/**
+ * Counts the songs matching the expression
+ * @param partition_state pointer to the partition state
+ * @param expression mpd search expression
+ * @param count pointer to set the song count
+ * @return true on success, else false
+ */
+static bool album_cache_count_songs(struct t_partition_state *partition_state, const char *expression, unsigned *count) {
+    *count = 0;
+    if (mpd_count_db_songs(partition_state->conn) == false ||
+        mpd_search_add_expression(partition_state->conn, expression) == false)
+    {
+        mpd_search_cancel(partition_state->conn);
+        return false;
     }
-    MYMPD_LOG_INFO("default", "Cache updated successfully");
+    if (mpd_search_commit(partition_state->conn)) {
+        struct mpd_pair *pair;
+        while ((pair = mpd_recv_pair(partition_state->conn)) != NULL) {
+            if (strcmp(pair->name, "songs") == 0 &&
+                str2uint(count, pair->value) != STR2INT_SUCCESS)
+            {
+                *count = 0;
+            }
+            mpd_return_pair(partition_state->conn, pair);
+        }
+    }
+    mpd_response_finish(partition_state->conn);
+    return mympd_check_error_and_recover(partition_state, NULL, "mpd_count_db_songs");
+}
+
+/**
+ * Thread function to scan a range of songs with an own mpd connection
+ * @param arg pointer to the t_album_cache_part struct
+ * @return NULL
+ */
+static void *album_cache_part_run(void *arg) {
+    struct t_album_cache_part *part = (struct t_album_cache_part *)arg;
+    struct t_mpd_worker_state *mpd_worker_state = part->mpd_worker_state;
+    thread_logname = sdscatfmt(sdsempty(), "albumcache%u", part->start / MPD_RESULTS_MAX);
+    struct t_partition_state *partition_state = malloc_assert(sizeof(struct t_partition_state));
+    partition_state_default(partition_state, MPD_PARTITION_DEFAULT, mpd_worker_state->mpd_state, mpd_worker_state->config);
+    if (mpd_client_connect(partition_state) == true) {
+        enable_mpd_tags(partition_state, &mpd_worker_state->mpd_state->tags_album);
+        part->rc = album_cache_add_songs(mpd_worker_state, partition_state, part->album_cache, ALBUMCACHE_EXPRESSION,
+            part->start, part->end, &part->album_count, &part->skip_count);
+        mpd_client_disconnect_silent(partition_state);
+    }
+    partition_state_free(partition_state);
+    FREE_SDS(thread_logname);
+    return NULL;
+}
+
+/**
+ * Adds the names of the albums with songs modified since the database update the cache was built from
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ * @param since mpd database update time the album cache was built from
+ * @param names rax to add the album names
+ * @return true on success, else false
+ */
+static bool album_cache_get_modified(struct t_mpd_worker_state *mpd_worker_state, time_t since, rax *names) {
+    sds expression = sdscatfmt(sdsempty(), "((Album != '') AND (modified-since '%I'))", (int64_t)since);
+    if (mpd_search_db_tags(mpd_worker_state->partition_state->conn, MPD_TAG_ALBUM) == false ||
+        mpd_search_add_expression(mpd_worker_state->partition_state->conn, expression) == false)
+    {
+        mpd_search_cancel(mpd_worker_state->partition_state->conn);
+        FREE_SDS(expression);
+        return false;
+    }
+    FREE_SDS(expression);
+    if (mpd_search_commit(mpd_worker_state->partition_state->conn)) {
+        struct mpd_pair *pair;
+        while ((pair = mpd_recv_pair_tag(mpd_worker_state->partition_state->conn, MPD_TAG_ALBUM)) != NULL) {
+            raxInsert(names, (unsigned char *)pair->value, strlen(pair->value), NULL, NULL);
+            mpd_return_pair(mpd_worker_state->partition_state->conn, pair);
+        }
+    }
+    mpd_response_finish(mpd_worker_state->partition_state->conn);
+    if (mympd_check_error_and_recover(mpd_worker_state->partition_state, NULL, "mpd_search_db_tags") == false) {
+        return false;
+    }
+    MYMPD_LOG_DEBUG("default", "%" PRIu64 " album(s) with modified songs", names->numele);
     return true;
 }
 
+/**
+ * Compares the song counts per album name of the album cache with the MPD database
+ * and adds the names with differing counts. This detects removed and moved songs.
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ * @param album_cache pointer to the album cache
+ * @param names rax to add the album names
+ * @return true on success, else false
+ */
+static bool album_cache_check_counts(struct t_mpd_worker_state *mpd_worker_state, rax *album_cache, rax *names) {
+    // song counts per album name of the cache
+    rax *counts = album_cache_count_names(album_cache, names);
+
+    // song counts per album name of the mpd database
+    if (mpd_count_db_songs(mpd_worker_state->partition_state->conn) == false ||
+        mpd_search_add_expression(mpd_worker_state->partition_state->conn, "((Album != '') AND (AlbumArtist !=''))") == false ||
+        mpd_search_add_group_tag(mpd_worker_state->partition_state->conn, MPD_TAG_ALBUM) == false)
+    {
+        mpd_search_cancel(mpd_worker_state->partition_state->conn);
+        raxFree(counts);
+        return false;
+    }
+    if (mpd_search_commit(mpd_worker_state->partition_state->conn)) {
+        struct mpd_pair *pair;
+        sds name = sdsempty();
+        while ((pair = mpd_recv_pair(mpd_worker_state->partition_state->conn)) != NULL) {
+            if (strcmp(pair->name, "Album") == 0) {
+                name = sds_replace(name, pair->value);
+            }
+            else if (strcmp(pair->name, "songs") == 0 &&
+                     sdslen(name) > 0)
+            {
+                unsigned songs;
+                if (str2uint(&songs, pair->value) != STR2INT_SUCCESS) {
+                    songs = 0;
+                }
+                void *data;
+                if (raxRemove(counts, (unsigned char *)name, sdslen(name), &data) == 0 ||
+                    (uintptr_t)data != songs)
+                {
+                    raxInsert(names, (unsigned char *)name, sdslen(name), NULL, NULL);
+                }
+                sdsclear(name);
+            }
+            mpd_return_pair(mpd_worker_state->partition_state->conn, pair);
+        }
+        FREE_SDS(name);
+    }
+    mpd_response_finish(mpd_worker_state->partition_state->conn);
+    bool rc = mympd_check_error_and_recover(mpd_worker_state->partition_state, NULL, "mpd_count_db_songs");
+    // remaining album names are not in the database anymore
+    raxIterator iter;
+    raxStart(&iter, counts);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        raxInsert(names, iter.key, iter.key_len, NULL, NULL);
+    }
+    raxStop(&iter);
+    raxFree(counts);
+    return rc;
+}
+
 /**
  * Initializes the simple album cache.
  * This is faster as the cache_init function, but does not fetch all the album details.
@@ -348,3 +746,19 @@ static bool album_cache_create_simple(struct t_mpd_worker_state *mpd_worker_stat
     MYMPD_LOG_INFO("default", "Cache updated successfully");
     return true;
 }
+
+/**
+ * Creates the index for the current album cache of the mympd_api thread
+ * @param album_cache pointer to the album cache
+ * @return newly allocated album index or NULL if there is no album cache
+ */
+static struct t_album_index *album_index_create_locked(struct t_cache *album_cache) {
+    struct t_album_index *album_index = NULL;
+    if (cache_get_read_lock(album_cache) == true) {
+        if (album_cache->cache != NULL) {
+            album_index = album_index_new(album_cache->cache);
+        }
+        cache_release_lock(album_cache);
+    }
+    return album_index;
+}
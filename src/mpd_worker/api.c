@@ -24,11 +24,36 @@
 #include "src/mpd_worker/song.h"
 #include "src/mpd_worker/webradiodb.h"
 
+/**
+ * Private definitions
+ */
+
+static void mpd_worker_api_request(struct t_mpd_worker_state *mpd_worker_state);
+
+/**
+ * Public functions
+ */
+
 /**
  * Handler for mpd worker api requests
  * @param mpd_worker_state pointer to mpd_worker_state struct
  */
 void mpd_worker_api(struct t_mpd_worker_state *mpd_worker_state) {
+    //parse the request once for all json_get_* calls
+    json_index_create(mpd_worker_state->request->data);
+    mpd_worker_api_request(mpd_worker_state);
+    json_index_free();
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Handles the mpd worker api request, the request is freed
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ */
+static void mpd_worker_api_request(struct t_mpd_worker_state *mpd_worker_state) {
     struct t_work_request *request = mpd_worker_state->request;
     bool rc;
     bool bool_buf1;
@@ -99,6 +124,10 @@ void mpd_worker_api(struct t_mpd_worker_state *mpd_worker_state) {
                 async = true;
             }
             break;
+        case INTERNAL_API_CACHE_DISK_NEGATIVE_CLEAR:
+            cache_disk_negative_clear(mpd_worker_state->config);
+            response->data = jsonrpc_respond_ok(response->data, request->cmd_id, request->id, JSONRPC_FACILITY_GENERAL);
+            break;
         case MYMPD_API_CACHE_DISK_CLEAR:
             cache_disk_clear(mpd_worker_state->config);
             response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
@@ -69,6 +69,7 @@ bool mpd_worker_start(struct t_mympd_state *mympd_state, struct t_partition_stat
     mpd_worker_state->tag_disc_empty_is_first = mympd_state->tag_disc_empty_is_first;
     mpd_tags_clone(&mympd_state->smartpls_generate_tag_types, &mpd_worker_state->smartpls_generate_tag_types);
     mpd_worker_state->album_cache = &mympd_state->album_cache;
+    mpd_worker_state->album_index_missing = mympd_state->album_index == NULL;
 
     if (mpd_worker_state->mympd_only == true) {
         mpd_worker_state->mpd_state = NULL;
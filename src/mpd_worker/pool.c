@@ -0,0 +1,478 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Pool of mpd_worker threads for read-only api requests
+ *
+ * The threads use their own MPD connections. Requests are routed to the pool
+ * by the mympd_api thread after all prior requests were handled, this keeps
+ * the ordering with the mutating commands on the main connection.
+ */
+
+#include "compile_time.h"
+#include "src/mpd_worker/pool.h"
+
+#include "src/lib/fields.h"
+#include "src/lib/jsonrpc.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/thread.h"
+#include "src/lib/validate.h"
+#include "src/mpd_client/connection.h"
+#include "src/mpd_client/playlists.h"
+#include "src/mpd_client/stickerdb.h"
+#include "src/mpd_client/search.h"
+#include "src/mympd_api/browse.h"
+#include "src/mympd_api/filesystem.h"
+#include "src/mympd_api/playlists.h"
+#include "src/mympd_api/search.h"
+
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+static void *mpd_worker_pool_run(void *arg);
+static void mpd_worker_pool_handle(struct t_mpd_worker_pool_thread *worker, struct t_work_request *request);
+static void mpd_worker_pool_api(struct t_mpd_worker_pool_thread *worker, struct t_work_request *request);
+static void mpd_worker_pool_sync(struct t_mpd_worker_pool_thread *worker);
+static bool mpd_worker_pool_connect(struct t_mpd_worker_pool_thread *worker, const char *partition);
+static bool mpd_worker_pool_stickerdb(struct t_mpd_worker_pool_thread *worker);
+static void mpd_worker_pool_thread_clear(struct t_mpd_worker_pool_thread *worker);
+static void mpd_worker_pool_states_clear(struct t_mpd_worker_pool *pool);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates the pool and starts the threads.
+ * The threads are idle until the pool is configured.
+ * @param config pointer to myMPD config
+ * @return pointer to the pool or NULL on error
+ */
+struct t_mpd_worker_pool *mpd_worker_pool_new(struct t_config *config) {
+    struct t_mpd_worker_pool *pool = malloc_assert(sizeof(struct t_mpd_worker_pool));
+    pool->queue = mympd_queue_create("mpd_worker_pool_queue", QUEUE_TYPE_REQUEST, QUEUE_MODE_LIST, false);
+    pool->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    pool->generation = 0;
+    pool->stop = false;
+    pool->config = config;
+    pool->mpd_state = NULL;
+    pool->stickerdb_mpd_state = NULL;
+    pool->booklet_name = sdsempty();
+    pool->info_txt_name = sdsempty();
+    pool->size = 0;
+    for (unsigned i = 0; i < MPD_WORKER_POOL_SIZE; i++) {
+        struct t_mpd_worker_pool_thread *worker = &pool->threads[i];
+        worker->id = i;
+        worker->pool = pool;
+        worker->generation = 0;
+        worker->mpd_state = NULL;
+        worker->partition_state = NULL;
+        worker->stickerdb = NULL;
+        worker->stickers = false;
+        cache_init(&worker->song_cache);
+        if (pthread_create(&worker->thread, NULL, mpd_worker_pool_run, worker) != 0) {
+            MYMPD_LOG_ERROR(NULL, "Can not create mpd_worker pool thread");
+            cache_free(&worker->song_cache);
+            break;
+        }
+        pool->size++;
+    }
+    if (pool->size == 0) {
+        return mpd_worker_pool_free(pool);
+    }
+    MYMPD_LOG_NOTICE(NULL, "Started %u mpd_worker pool threads", pool->size);
+    return pool;
+}
+
+/**
+ * Stops the threads and frees the pool.
+ * Requests that are not handled are discarded.
+ * @param pool pointer to the pool
+ * @return NULL
+ */
+void *mpd_worker_pool_free(struct t_mpd_worker_pool *pool) {
+    pool->stop = true;
+    mympd_queue_wakeup_all(pool->queue);
+    for (unsigned i = 0; i < pool->size; i++) {
+        int rc = pthread_join(pool->threads[i].thread, NULL);
+        if (rc != 0) {
+            MYMPD_LOG_ERROR(NULL, "Error stopping mpd_worker pool thread: %d", rc);
+        }
+        cache_free(&pool->threads[i].song_cache);
+    }
+    mympd_queue_free(pool->queue);
+    mpd_worker_pool_states_clear(pool);
+    FREE_SDS(pool->booklet_name);
+    FREE_SDS(pool->info_txt_name);
+    pthread_mutex_destroy(&pool->mutex);
+    FREE_PTR(pool);
+    return NULL;
+}
+
+/**
+ * Copies the mpd connection settings and features to the pool.
+ * The threads reconnect with the new settings on their next request.
+ * It must be called after each feature detection.
+ * @param mympd_state pointer to mympd state
+ */
+void mpd_worker_pool_configure(struct t_mympd_state *mympd_state) {
+    struct t_mpd_worker_pool *pool = mympd_state->mpd_worker_pool;
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    mpd_worker_pool_states_clear(pool);
+    pool->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+    mpd_state_copy(mympd_state->mpd_state, pool->mpd_state);
+    pool->stickerdb_mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+    mpd_state_copy(mympd_state->stickerdb->mpd_state, pool->stickerdb_mpd_state);
+    pool->booklet_name = sds_replace(pool->booklet_name, mympd_state->booklet_name);
+    pool->info_txt_name = sds_replace(pool->info_txt_name, mympd_state->info_txt_name);
+    pool->generation++;
+    if (pool->generation == 0) {
+        // 0 is reserved for not configured
+        pool->generation++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    MYMPD_LOG_DEBUG(NULL, "Configured mpd_worker pool, generation %u", pool->generation);
+}
+
+/**
+ * Pushes a read-only request to the pool.
+ * @param mympd_state pointer to mympd state
+ * @param request the work request, it is freed by the pool thread
+ * @return true if the request was pushed to the pool,
+ *         false if it must be handled by the caller
+ */
+bool mpd_worker_pool_push(struct t_mympd_state *mympd_state, struct t_work_request *request) {
+    struct t_mpd_worker_pool *pool = mympd_state->mpd_worker_pool;
+    if (pool == NULL ||
+        pool->generation == 0 ||
+        is_mpd_worker_pool_request(request, mympd_state->song_cache.cache != NULL) == false)
+    {
+        return false;
+    }
+    MYMPD_LOG_DEBUG(request->partition, "Push request \"%s\" to the mpd_worker pool", get_cmd_id_method_name(request->cmd_id));
+    return mympd_queue_push(pool->queue, request, 0);
+}
+
+/**
+ * Parses and handles the read-only api requests.
+ * It is shared by the pool threads and the mympd_api handler.
+ * @param partition_state pointer to partition state
+ * @param stickerdb pointer to the stickerdb state
+ * @param song_cache pointer to the song cache
+ * @param booklet_name filename for booklet
+ * @param info_txt_name filename for album info
+ * @param buffer already allocated sds string to append the response
+ * @param request the work request
+ * @param parse_error pointer to t_jsonrpc_parse_error
+ * @return pointer to buffer, it is empty on a parsing error
+ */
+sds mpd_worker_pool_api_request(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        struct t_cache *song_cache, sds booklet_name, sds info_txt_name, sds buffer, struct t_work_request *request,
+        struct t_jsonrpc_parse_error *parse_error)
+{
+    unsigned uint_buf1;
+    unsigned uint_buf2;
+    unsigned uint_buf3;
+    bool bool_buf1;
+    bool rc;
+    sds sds_buf1 = NULL;
+    sds sds_buf2 = NULL;
+    sds sds_buf3 = NULL;
+    struct t_fields tagcols;
+    fields_reset(&tagcols);
+
+    switch(request->cmd_id) {
+        case MYMPD_API_DATABASE_FILESYSTEM_LIST:
+            if (json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, parse_error) == true &&
+                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, parse_error) == true &&
+                json_get_string(request->data, "$.params.searchstr", 0, NAME_LEN_MAX, &sds_buf1, vcb_isname, parse_error) == true &&
+                json_get_string(request->data, "$.params.path", 1, FILEPATH_LEN_MAX, &sds_buf2, vcb_isfilepath, parse_error) == true &&
+                json_get_string(request->data, "$.params.type", 1, 5, &sds_buf3, vcb_isalnum, parse_error) == true &&
+                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, parse_error) == true)
+            {
+                if (strcmp(sds_buf3, "plist") == 0) {
+                    sds expr = sdslen(sds_buf1) > 0
+                        ? escape_mpd_search_expression(sdsempty(), "file", "contains", sds_buf1)
+                        : sdsempty();
+                    buffer = mympd_api_playlist_content_search(partition_state, stickerdb, buffer, request->id,
+                        sds_buf2, uint_buf1, uint_buf2, expr, &tagcols);
+                    FREE_SDS(expr);
+                }
+                else {
+                    buffer = mympd_api_browse_filesystem(partition_state, stickerdb, booklet_name, info_txt_name, buffer, request->id,
+                        sds_buf2, uint_buf1, uint_buf2, sds_buf1, &tagcols);
+                }
+            }
+            break;
+        case MYMPD_API_DATABASE_SEARCH:
+            if (json_get_string(request->data, "$.params.expression", 0, EXPRESSION_LEN_MAX, &sds_buf1, vcb_issearchexpression, parse_error) == true &&
+                json_get_string(request->data, "$.params.sort", 0, NAME_LEN_MAX, &sds_buf2, vcb_ismpdsort, parse_error) == true &&
+                json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, parse_error) == true &&
+                json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, parse_error) == true &&
+                json_get_uint(request->data, "$.params.limit", 0, MPD_RESULTS_MAX, &uint_buf2, parse_error) == true &&
+                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, parse_error) == true)
+            {
+                buffer = mympd_api_search_songs(partition_state, stickerdb, song_cache, buffer, request->id,
+                        sds_buf1, sds_buf2, bool_buf1, uint_buf1, uint_buf2, &tagcols, &rc);
+            }
+            break;
+        case MYMPD_API_DATABASE_TAG_LIST:
+            if (json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, parse_error) == true &&
+                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, parse_error) == true &&
+                json_get_string(request->data, "$.params.searchstr", 0, NAME_LEN_MAX, &sds_buf1, vcb_isname, parse_error) == true &&
+                json_get_string(request->data, "$.params.tag", 1, NAME_LEN_MAX, &sds_buf2, vcb_ismpdtag_or_any, parse_error) == true &&
+                json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, parse_error) == true)
+            {
+                buffer = mympd_api_browse_tag_list(partition_state, song_cache, buffer, request->id,
+                        sds_buf1, sds_buf2, uint_buf1, uint_buf2, bool_buf1);
+            }
+            break;
+        case MYMPD_API_PLAYLIST_LIST:
+            if (json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, parse_error) == true &&
+                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, parse_error) == true &&
+                json_get_string(request->data, "$.params.searchstr", 0, NAME_LEN_MAX, &sds_buf1, vcb_isname, parse_error) == true &&
+                json_get_uint(request->data, "$.params.type", 0, 2, &uint_buf3, parse_error) == true &&
+                json_get_string(request->data, "$.params.sort", 0, NAME_LEN_MAX, &sds_buf2, vcb_ismpdsort, parse_error) == true &&
+                json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, parse_error) == true &&
+                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, parse_error) == true)
+            {
+                enum playlist_sort_types sort = playlist_parse_sort(sds_buf2);
+                buffer = mympd_api_playlist_list(partition_state, stickerdb, buffer, request->cmd_id,
+                    uint_buf1, uint_buf2, sds_buf1, uint_buf3, sort, bool_buf1, &tagcols);
+            }
+            break;
+        case MYMPD_API_PLAYLIST_CONTENT_LIST:
+            if (json_get_string(request->data, "$.params.plist", 1, FILENAME_LEN_MAX, &sds_buf1, vcb_isfilename, parse_error) == true &&
+                json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, parse_error) == true &&
+                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, parse_error) == true &&
+                json_get_string(request->data, "$.params.expression", 0, NAME_LEN_MAX, &sds_buf2, vcb_issearchexpression, parse_error) == true &&
+                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, parse_error) == true)
+            {
+                buffer = mympd_api_playlist_content_search(partition_state, stickerdb, buffer, request->id,
+                    sds_buf1, uint_buf1, uint_buf2, sds_buf2, &tagcols);
+            }
+            break;
+        default:
+            MYMPD_LOG_ERROR(request->partition, "Unsupported method for the mpd_worker pool: %s", get_cmd_id_method_name(request->cmd_id));
+    }
+    FREE_SDS(sds_buf1);
+    FREE_SDS(sds_buf2);
+    FREE_SDS(sds_buf3);
+    return buffer;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * This is the main function of the pool threads.
+ * @param arg void pointer to the t_mpd_worker_pool_thread struct
+ * @return NULL
+ */
+static void *mpd_worker_pool_run(void *arg) {
+    struct t_mpd_worker_pool_thread *worker = (struct t_mpd_worker_pool_thread *)arg;
+    thread_logname = sdscatfmt(sdsempty(), "mpdpool%u", worker->id);
+    set_threadname(thread_logname);
+    while (worker->pool->stop == false) {
+        struct t_work_request *request = mympd_queue_shift(worker->pool->queue, MPD_WORKER_POOL_WAIT_MS, 0);
+        if (request != NULL) {
+            mpd_worker_pool_handle(worker, request);
+        }
+    }
+    mpd_worker_pool_thread_clear(worker);
+    MYMPD_LOG_DEBUG(NULL, "Stopping mpd_worker pool thread");
+    FREE_SDS(thread_logname);
+    return NULL;
+}
+
+/**
+ * Connects to MPD and handles the request
+ * @param worker pointer to the thread state
+ * @param request the work request, it is freed
+ */
+static void mpd_worker_pool_handle(struct t_mpd_worker_pool_thread *worker, struct t_work_request *request) {
+    mpd_worker_pool_sync(worker);
+    if (mpd_worker_pool_connect(worker, request->partition) == false) {
+        struct t_work_response *response = create_response(request);
+        response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+            JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "MPD disconnected");
+        push_response(response);
+        free_request(request);
+        return;
+    }
+    worker->mpd_state->feat.stickers = worker->stickers == true
+        ? mpd_worker_pool_stickerdb(worker)
+        : false;
+    mpd_worker_pool_api(worker, request);
+    if (worker->partition_state->conn_state != MPD_CONNECTED) {
+        // reconnect with the next request
+        mpd_client_disconnect_silent(worker->partition_state);
+    }
+}
+
+/**
+ * Handles the read-only api requests, the request is freed.
+ * @param worker pointer to the thread state
+ * @param request the work request
+ */
+static void mpd_worker_pool_api(struct t_mpd_worker_pool_thread *worker, struct t_work_request *request) {
+    struct t_jsonrpc_parse_error parse_error;
+    jsonrpc_parse_error_init(&parse_error);
+
+    const char *method = get_cmd_id_method_name(request->cmd_id);
+    MYMPD_LOG_DEBUG(request->partition, "MPD WORKER POOL API request (%lu)(%u) %s: %s",
+        request->conn_id, request->id, method, request->data);
+
+    struct t_work_response *response = create_response(request);
+
+    //parse the request once for all json_get_* calls
+    json_index_create(request->data);
+    //the extra media settings are replaced by mpd_worker_pool_configure
+    pthread_mutex_lock(&worker->pool->mutex);
+    sds booklet_name = sdsdup(worker->pool->booklet_name);
+    sds info_txt_name = sdsdup(worker->pool->info_txt_name);
+    pthread_mutex_unlock(&worker->pool->mutex);
+    //large list responses are streamed to the webserver
+    response_stream_begin(request);
+    response->data = mpd_worker_pool_api_request(worker->partition_state, worker->stickerdb, &worker->song_cache,
+        booklet_name, info_txt_name, response->data, request, &parse_error);
+    json_index_free();
+    FREE_SDS(booklet_name);
+    FREE_SDS(info_txt_name);
+
+    if (sdslen(response->data) == 0) {
+        if (parse_error.message != NULL) {
+            // jsonrpc parsing error
+            response->data = jsonrpc_respond_message_phrase(response->data, request->cmd_id, request->id,
+                JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, parse_error.message, 2, "path", parse_error.path);
+        }
+        else {
+            // no response and no error - this should not occur
+            response->data = jsonrpc_respond_message_phrase(response->data, request->cmd_id, request->id,
+                JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "No response for method %{method}", 2, "method", method);
+            MYMPD_LOG_ERROR(request->partition, "No response for method \"%s\"", method);
+        }
+    }
+    //an aborted stream is ended by the final response
+    push_response(response);
+    response_stream_end();
+    free_request(request);
+    jsonrpc_parse_error_clear(&parse_error);
+}
+
+/**
+ * Replaces the states of the thread, if the pool was reconfigured
+ * @param worker pointer to the thread state
+ */
+static void mpd_worker_pool_sync(struct t_mpd_worker_pool_thread *worker) {
+    struct t_mpd_worker_pool *pool = worker->pool;
+    if (worker->generation == pool->generation) {
+        return;
+    }
+    mpd_worker_pool_thread_clear(worker);
+    pthread_mutex_lock(&pool->mutex);
+    worker->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+    mpd_state_copy(pool->mpd_state, worker->mpd_state);
+    worker->partition_state = malloc_assert(sizeof(struct t_partition_state));
+    partition_state_default(worker->partition_state, MPD_PARTITION_DEFAULT, worker->mpd_state, pool->config);
+    worker->stickers = worker->mpd_state->feat.stickers;
+    worker->stickerdb = malloc_assert(sizeof(struct t_stickerdb_state));
+    stickerdb_state_default(worker->stickerdb, pool->config);
+    worker->stickerdb->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+    mpd_state_copy(pool->stickerdb_mpd_state, worker->stickerdb->mpd_state);
+    worker->generation = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/**
+ * Connects to MPD, if not already connected, and switches the partition
+ * @param worker pointer to the thread state
+ * @param partition partition of the request
+ * @return true on success, else false
+ */
+static bool mpd_worker_pool_connect(struct t_mpd_worker_pool_thread *worker, const char *partition) {
+    struct t_partition_state *partition_state = worker->partition_state;
+    if (partition_state->conn_state != MPD_CONNECTED) {
+        mpd_client_disconnect_silent(partition_state);
+        // a new connection starts in the default partition
+        partition_state->name = sds_replace(partition_state->name, MPD_PARTITION_DEFAULT);
+        if (mpd_client_connect(partition_state) == false) {
+            mpd_client_disconnect_silent(partition_state);
+            return false;
+        }
+    }
+    if (strcmp(partition_state->name, partition) != 0) {
+        if (mpd_run_switch_partition(partition_state->conn, partition) == false) {
+            MYMPD_LOG_ERROR(partition_state->name, "Could not switch to partition \"%s\"", partition);
+            mpd_client_disconnect_silent(partition_state);
+            return false;
+        }
+        partition_state->name = sds_replace(partition_state->name, partition);
+    }
+    return true;
+}
+
+/**
+ * Connects the stickerdb, if not already connected.
+ * The connection is left in idle mode, as expected by the sticker functions.
+ * @param worker pointer to the thread state
+ * @return true if the stickerdb is usable, else false
+ */
+static bool mpd_worker_pool_stickerdb(struct t_mpd_worker_pool_thread *worker) {
+    if (worker->stickerdb->conn_state == MPD_CONNECTED) {
+        return true;
+    }
+    stickerdb_disconnect(worker->stickerdb);
+    return stickerdb_connect(worker->stickerdb) &&
+        stickerdb_enter_idle(worker->stickerdb);
+}
+
+/**
+ * Disconnects from MPD and frees the states of the thread
+ * @param worker pointer to the thread state
+ */
+static void mpd_worker_pool_thread_clear(struct t_mpd_worker_pool_thread *worker) {
+    if (worker->partition_state != NULL) {
+        mpd_client_disconnect_silent(worker->partition_state);
+        partition_state_free(worker->partition_state);
+        worker->partition_state = NULL;
+    }
+    if (worker->mpd_state != NULL) {
+        mpd_state_free(worker->mpd_state);
+        worker->mpd_state = NULL;
+    }
+    if (worker->stickerdb != NULL) {
+        stickerdb_disconnect(worker->stickerdb);
+        mpd_state_free(worker->stickerdb->mpd_state);
+        stickerdb_state_free(worker->stickerdb);
+        worker->stickerdb = NULL;
+    }
+    worker->generation = 0;
+}
+
+/**
+ * Frees the state copies of the pool
+ * @param pool pointer to the pool
+ */
+static void mpd_worker_pool_states_clear(struct t_mpd_worker_pool *pool) {
+    if (pool->mpd_state != NULL) {
+        mpd_state_free(pool->mpd_state);
+        pool->mpd_state = NULL;
+    }
+    if (pool->stickerdb_mpd_state != NULL) {
+        mpd_state_free(pool->stickerdb_mpd_state);
+        pool->stickerdb_mpd_state = NULL;
+    }
+}
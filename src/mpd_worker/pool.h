@@ -0,0 +1,64 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Pool of mpd_worker threads for read-only api requests
+ */
+
+#ifndef MYMPD_MPD_WORKER_POOL_H
+#define MYMPD_MPD_WORKER_POOL_H
+
+#include "src/lib/api.h"
+#include "src/lib/cache_rax.h"
+#include "src/lib/jsonrpc.h"
+#include "src/lib/msg_queue.h"
+#include "src/lib/mympd_state.h"
+
+#include <pthread.h>
+
+struct t_mpd_worker_pool;
+
+/**
+ * State of one thread of the pool, owned by the thread itself
+ */
+struct t_mpd_worker_pool_thread {
+    pthread_t thread;                             //!< thread handle
+    unsigned id;                                  //!< thread number
+    struct t_mpd_worker_pool *pool;               //!< pointer to the pool
+    unsigned generation;                          //!< generation of the copied states
+    struct t_mpd_state *mpd_state;                //!< copy of the shared mpd state
+    struct t_partition_state *partition_state;    //!< own mpd connection
+    struct t_stickerdb_state *stickerdb;          //!< own stickerdb connection
+    bool stickers;                                //!< stickers are enabled
+    struct t_cache song_cache;                    //!< empty song cache, searches are run against MPD
+};
+
+/**
+ * Pool of mpd_worker threads
+ */
+struct t_mpd_worker_pool {
+    struct t_mympd_queue *queue;                  //!< requests for the pool
+    pthread_mutex_t mutex;                        //!< protects the state copies
+    _Atomic unsigned generation;                  //!< incremented on each configuration, 0 = not configured
+    _Atomic bool stop;                            //!< stops the threads
+    struct t_config *config;                      //!< pointer to myMPD config
+    struct t_mpd_state *mpd_state;                //!< copy of the shared mpd state
+    struct t_mpd_state *stickerdb_mpd_state;      //!< copy of the mpd state of the stickerdb connection
+    sds booklet_name;                             //!< copy of the booklet filename setting
+    sds info_txt_name;                            //!< copy of the album info filename setting
+    unsigned size;                                //!< number of started threads
+    struct t_mpd_worker_pool_thread threads[MPD_WORKER_POOL_SIZE];  //!< the threads
+};
+
+struct t_mpd_worker_pool *mpd_worker_pool_new(struct t_config *config);
+void *mpd_worker_pool_free(struct t_mpd_worker_pool *pool);
+void mpd_worker_pool_configure(struct t_mympd_state *mympd_state);
+bool mpd_worker_pool_push(struct t_mympd_state *mympd_state, struct t_work_request *request);
+sds mpd_worker_pool_api_request(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        struct t_cache *song_cache, sds booklet_name, sds info_txt_name, sds buffer, struct t_work_request *request,
+        struct t_jsonrpc_parse_error *parse_error);
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Song cache creation
+ */
+
+#include "compile_time.h"
+#include "src/mpd_worker/song_cache.h"
+
+#include "dist/libmympdclient/include/mpd/client.h"
+#include "src/lib/cache_rax_song.h"
+#include "src/lib/jsonrpc.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/msg_queue.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/utility.h"
+#include "src/mpd_client/errorhandler.h"
+#include "src/mpd_client/tags.h"
+
+#include <inttypes.h>
+
+/**
+ * Private definitions
+ */
+static bool song_cache_create(struct t_mpd_worker_state *mpd_worker_state, struct t_cache *song_cache);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates the song cache and returns it to mympd_api thread
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ * @return true on success else false
+ */
+bool mpd_worker_song_cache_create(struct t_mpd_worker_state *mpd_worker_state) {
+    struct t_cache *song_cache = malloc_assert(sizeof(struct t_cache));
+    song_cache_init(song_cache);
+    bool rc = song_cache_create(mpd_worker_state, song_cache);
+    if (rc == false) {
+        song_cache_free(song_cache);
+        FREE_PTR(song_cache);
+        send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_ERROR, MPD_PARTITION_ALL, "Update of song cache failed");
+        return false;
+    }
+    if (mpd_worker_state->config->save_caches == true) {
+        // save before sending, the mympd_api thread owns the cache afterwards
+        song_cache_write(song_cache, mpd_worker_state->config->workdir,
+            &mpd_worker_state->mpd_state->tags_mympd, false);
+    }
+    struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, INTERNAL_API_SONGCACHE_CREATED, NULL, mpd_worker_state->partition_state->name);
+    request->data = jsonrpc_end(request->data);
+    request->extra = (void *) song_cache;
+    mympd_queue_push(mympd_api_queue, request, 0);
+    send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_INFO, MPD_PARTITION_ALL, "Updated song cache");
+    return true;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Populates the song cache with all songs from the mpd database
+ * @param mpd_worker_state pointer to mpd_worker_state struct
+ * @param song_cache pointer to the initialized song cache
+ * @return true on success, else false
+ */
+static bool song_cache_create(struct t_mpd_worker_state *mpd_worker_state, struct t_cache *song_cache) {
+    MYMPD_LOG_INFO("default", "Creating song cache");
+    unsigned start = 0;
+    unsigned end = start + MPD_RESULTS_MAX;
+    unsigned i = 0;
+    const struct t_mpd_tags *tags = &mpd_worker_state->mpd_state->tags_mympd;
+    enable_mpd_tags(mpd_worker_state->partition_state, tags);
+
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    do {
+        if (mpd_search_db_songs(mpd_worker_state->partition_state->conn, false) == false ||
+            mpd_search_add_expression(mpd_worker_state->partition_state->conn, "(modified-since '0')") == false ||
+            mpd_search_add_window(mpd_worker_state->partition_state->conn, start, end) == false)
+        {
+            MYMPD_LOG_ERROR("default", "Song cache update failed");
+            mpd_search_cancel(mpd_worker_state->partition_state->conn);
+            return false;
+        }
+        if (mpd_search_commit(mpd_worker_state->partition_state->conn)) {
+            struct mpd_song *song;
+            while ((song = mpd_recv_song(mpd_worker_state->partition_state->conn)) != NULL) {
+                song_cache_insert(song_cache, song, tags);
+                mpd_song_free(song);
+                i++;
+            }
+        }
+        mpd_response_finish(mpd_worker_state->partition_state->conn);
+        if (mympd_check_error_and_recover(mpd_worker_state->partition_state, NULL, "mpd_search_commit") == false) {
+            MYMPD_LOG_ERROR("default", "Song cache update failed");
+            return false;
+        }
+        start = end;
+        end = end + MPD_RESULTS_MAX;
+    } while (i >= start);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT("default", "Populate song cache")
+    #endif
+    MYMPD_LOG_INFO("default", "Added %" PRIu64 " songs with %" PRIu64 " distinct tag values to song cache",
+        song_cache->cache->numele, song_cache->strings->numele);
+    return true;
+}
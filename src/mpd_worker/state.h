@@ -30,6 +30,7 @@ struct t_mpd_worker_state {
     struct t_stickerdb_state *stickerdb;          //!< pointer to the stickerdb state
     bool mympd_only;                              //!< true = no mpd connection required
     struct t_cache *album_cache;                  //!< the album cache, use it only with a read lock
+    bool album_index_missing;                     //!< true if the album cache has no index
 };
 
 void mpd_worker_state_free(struct t_mpd_worker_state *mpd_worker_state);
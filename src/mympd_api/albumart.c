@@ -198,6 +198,9 @@ sds mympd_api_albumart_getcover_by_uri(struct t_mympd_state *mympd_state, struct
             (void)conn_id;
         #endif
         MYMPD_LOG_INFO(partition_state->name, "No albumart found by mpd for uri \"%s\"", uri);
+        if (partition_state->config->cache_cover_keep_days != CACHE_DISK_DISABLED) {
+            cache_disk_negative_write(partition_state->config->cachedir, DIR_CACHE_COVER, uri, 0);
+        }
         buffer = jsonrpc_respond_message(buffer, INTERNAL_API_ALBUMART_BY_URI, request_id,
                 JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_WARN, "No albumart found by mpd");
     }
@@ -12,7 +12,11 @@
 #include "src/mympd_api/browse.h"
 
 #include "dist/utf8/utf8.h"
+#include "src/lib/album_index.h"
+#include "src/lib/album_results.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/cache_rax_song.h"
+#include "src/lib/casefold.h"
 #include "src/lib/fields.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/jsonrpc.h"
@@ -37,6 +41,13 @@
 
 static bool check_album_sort_tag(enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
         struct t_albums_config *album_config);
+static rax *album_detail_songs_local(struct t_cache *song_cache, const char *expression,
+        const struct t_mpd_tags *any_tag_types);
+static struct mpd_song *album_detail_next_song(raxIterator *iter);
+static rax *album_list_search(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        sds expression, enum sort_by_type sort_by, enum mpd_tag_type sort_tag);
+static void tag_list_add(rax *taglist, sds *key, const char *value, const char *folded, size_t folded_len, sds searchstr);
+static void tag_list_local(struct t_cache *song_cache, enum mpd_tag_type tag, rax *taglist, sds searchstr);
 
 // public functions
 
@@ -70,10 +81,13 @@ sds mympd_api_browse_album_detail(struct t_mympd_state *mympd_state, struct t_pa
     sds expression = get_search_expression_album(sdsempty(), partition_state->mpd_state->tag_albumartist, mpd_album,
         &partition_state->config->albums);
 
-    if (mpd_search_db_songs(partition_state->conn, true) == false ||
-        mpd_search_add_expression(partition_state->conn, expression) == false ||
-        mpd_search_add_sort_tag(partition_state->conn, MPD_TAG_DISC, false) == false ||
-        mpd_search_add_window(partition_state->conn, 0, MPD_RESULTS_MAX) == false)
+    // get the songs from the song cache or from mpd
+    rax *local_songs = album_detail_songs_local(&mympd_state->song_cache, expression, &partition_state->mpd_state->tags_browse);
+    if (local_songs == NULL &&
+        (mpd_search_db_songs(partition_state->conn, true) == false ||
+         mpd_search_add_expression(partition_state->conn, expression) == false ||
+         mpd_search_add_sort_tag(partition_state->conn, MPD_TAG_DISC, false) == false ||
+         mpd_search_add_window(partition_state->conn, 0, MPD_RESULTS_MAX) == false))
     {
         mpd_search_cancel(partition_state->conn);
         FREE_SDS(expression);
@@ -96,12 +110,22 @@ sds mympd_api_browse_album_detail(struct t_mympd_state *mympd_state, struct t_pa
     if (print_stickers == true) {
         stickerdb_exit_idle(mympd_state->stickerdb);
     }
-    if (mpd_search_commit(partition_state->conn)) {
+    raxIterator iter;
+    if (local_songs != NULL) {
+        raxStart(&iter, local_songs);
+        raxSeek(&iter, "^", NULL, 0);
+    }
+    if (local_songs != NULL ||
+        mpd_search_commit(partition_state->conn))
+    {
         buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
         buffer = sdscat(buffer, "\"data\":[");
 
         struct mpd_song *song;
-        while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+        while ((song = local_songs != NULL
+                    ? album_detail_next_song(&iter)
+                    : mpd_recv_song(partition_state->conn)) != NULL)
+        {
             if (entities_returned++) {
                 buffer = sdscatlen(buffer, ",", 1);
             }
@@ -133,14 +157,22 @@ sds mympd_api_browse_album_detail(struct t_mympd_state *mympd_state, struct t_pa
             mpd_song_free(song);
         }
     }
-    mpd_response_finish(partition_state->conn);
     if (print_stickers == true) {
         stickerdb_enter_idle(mympd_state->stickerdb);
     }
-    if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_search_commit") == false) {
-        FREE_SDS(first_song_uri);
-        FREE_SDS(last_played_song_uri);
-        return buffer;
+    if (local_songs != NULL) {
+        raxStop(&iter);
+        raxFree(local_songs);
+    }
+    else {
+        mpd_response_finish(partition_state->conn);
+        if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_search_commit") == false) {
+            FREE_SDS(expression);
+            FREE_SDS(first_song_uri);
+            FREE_SDS(last_played_song_uri);
+            FREE_SDS(last_played_song_title);
+            return buffer;
+        }
     }
 
     buffer = sdscatlen(buffer, "],", 2);
@@ -233,28 +265,14 @@ sds mympd_api_browse_album_list(struct t_mympd_state *mympd_state, struct t_part
         return buffer;
     }
 
-    //parse mpd search expression
-    struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
-    
-    //search and sort albumlist
-    unsigned real_limit = offset + limit;
-    rax *albums = raxNew();
-    raxIterator iter;
-    raxStart(&iter, mympd_state->album_cache.cache);
-    raxSeek(&iter, "^", NULL, 0);
-    sds key = sdsempty();
-    while (raxNext(&iter)) {
-        struct mpd_song *album = (struct mpd_song *)iter.data;
-        if (expr_list->length == 0 ||
-            search_expression_song(album, expr_list, &partition_state->mpd_state->tags_browse) == true)
-        {
-            key = get_sort_key(key, sort_by, sort_tag, album);
-            rax_insert_no_dup(albums, key, iter.data);
-            sdsclear(key);
-        }
+    //get the sorted album list from the lru or create it
+    sds key = album_results_key(sdsempty(), expression, sort_by, sort_tag, &partition_state->mpd_state->tags_browse);
+    const struct t_album_results *results = album_results_get(&mympd_state->album_results, key);
+    if (results == NULL) {
+        rax *albums = album_list_search(mympd_state, partition_state, expression, sort_by, sort_tag);
+        results = album_results_add(&mympd_state->album_results, key, albums);
+        raxFree(albums);
     }
-    raxStop(&iter);
-    free_search_expression_list(expr_list);
     FREE_SDS(key);
 
     //print album list
@@ -262,49 +280,35 @@ sds mympd_api_browse_album_list(struct t_mympd_state *mympd_state, struct t_part
     if (print_stickers == true) {
         stickerdb_exit_idle(mympd_state->stickerdb);
     }
-    unsigned entity_count = 0;
     unsigned entities_returned = 0;
-    raxStart(&iter, albums);
-    int (*iterator)(struct raxIterator *iter);
-    if (sortdesc == false) {
-        raxSeek(&iter, "^", NULL, 0);
-        iterator = &raxNext;
-    }
-    else {
-        raxSeek(&iter, "$", NULL, 0);
-        iterator = &raxPrev;
-    }
+    unsigned real_limit = offset + limit < results->len
+        ? offset + limit
+        : results->len;
     sds album_exp = sdsempty();
-    while (iterator(&iter)) {
-        if (entity_count >= offset) {
-            if (entities_returned++) {
-                buffer = sdscatlen(buffer, ",", 1);
-            }
-            struct mpd_song *album = (struct mpd_song *)iter.data;
-            buffer = sdscat(buffer, "{\"Type\": \"album\",");
-            buffer = print_album_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, album);
+    for (unsigned i = offset; i < real_limit; i++) {
+        if (entities_returned++) {
             buffer = sdscatlen(buffer, ",", 1);
-            buffer = tojson_char(buffer, "FirstSongUri", mpd_song_get_uri(album), false);
-            if (print_stickers == true) {
-                buffer = sdscatlen(buffer, ",", 1);
-                album_exp = get_search_expression_album(album_exp, mympd_state->mpd_state->tag_albumartist, album, &mympd_state->config->albums);
-                buffer = mympd_api_sticker_get_print_batch(buffer, mympd_state->stickerdb, STICKER_TYPE_FILTER, album_exp, &tagcols->stickers);
-                
-            }
-            buffer = sdscatlen(buffer, "}", 1);
         }
-        entity_count++;
-        if (entity_count == real_limit) {
-            break;
+        struct mpd_song *album = sortdesc == false
+            ? results->albums[i]
+            : results->albums[results->len - 1 - i];
+        buffer = sdscat(buffer, "{\"Type\": \"album\",");
+        buffer = print_album_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, album);
+        buffer = sdscatlen(buffer, ",", 1);
+        buffer = tojson_char(buffer, "FirstSongUri", mpd_song_get_uri(album), false);
+        if (print_stickers == true) {
+            buffer = sdscatlen(buffer, ",", 1);
+            album_exp = get_search_expression_album(album_exp, mympd_state->mpd_state->tag_albumartist, album, &mympd_state->config->albums);
+            buffer = mympd_api_sticker_get_print_batch(buffer, mympd_state->stickerdb, STICKER_TYPE_FILTER, album_exp, &tagcols->stickers);
         }
+        buffer = sdscatlen(buffer, "}", 1);
     }
-    raxStop(&iter);
     FREE_SDS(album_exp);
     if (print_stickers == true) {
         stickerdb_enter_idle(mympd_state->stickerdb);
     }
     buffer = sdscatlen(buffer, "],", 2);
-    buffer = tojson_uint64(buffer, "totalEntities", albums->numele, true);
+    buffer = tojson_uint(buffer, "totalEntities", results->len, true);
     buffer = tojson_uint(buffer, "returnedEntities", entities_returned, true);
     buffer = tojson_uint(buffer, "offset", offset, true);
     buffer = tojson_sds(buffer, "expression", expression, true);
@@ -312,13 +316,13 @@ sds mympd_api_browse_album_list(struct t_mympd_state *mympd_state, struct t_part
     buffer = tojson_bool(buffer, "sortdesc", sortdesc, true);
     buffer = tojson_char(buffer, "tag", "Album", false);
     buffer = jsonrpc_end(buffer);
-    raxFree(albums);
     return buffer;
 }
 
 /**
  * Lists tags from the mpd database
  * @param partition_state pointer to partition specific states
+ * @param song_cache pointer to the song cache, the tags are fetched from MPD if it is not ready
  * @param buffer sds string to append response
  * @param request_id jsonrpc request id
  * @param searchstr string to search
@@ -328,50 +332,49 @@ sds mympd_api_browse_album_list(struct t_mympd_state *mympd_state, struct t_part
  * @param sortdesc true to sort descending, false to sort ascending
  * @return pointer to buffer
  */
-sds mympd_api_browse_tag_list(struct t_partition_state *partition_state, sds buffer, unsigned request_id,
-        sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc)
+sds mympd_api_browse_tag_list(struct t_partition_state *partition_state, struct t_cache *song_cache,
+        sds buffer, unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc)
 {
-    size_t searchstr_len = sdslen(searchstr);
     enum mympd_cmd_ids cmd_id = MYMPD_API_DATABASE_TAG_LIST;
-
-    if (mpd_search_db_tags(partition_state->conn, mpd_tag_name_parse(tag)) == false) {
-        mpd_search_cancel(partition_state->conn);
-        return jsonrpc_respond_message(buffer, cmd_id, request_id, JSONRPC_FACILITY_DATABASE,
-            JSONRPC_SEVERITY_ERROR, "Error creating MPD search command");
-    }
-
+    enum mpd_tag_type mpdtag = mpd_tag_name_parse(tag);
     unsigned real_limit = offset + limit;
     rax *taglist = raxNew();
     sds key = sdsempty();
+    //fold the search string once for all tag values
+    sds searchstr_folded = casefold_cat(sdsempty(), searchstr);
 
-    if (mpd_search_commit(partition_state->conn)) {
-        struct mpd_pair *pair;
-        enum mpd_tag_type mpdtag = mpd_tag_name_parse(tag);
-        //filter and sort
-        while ((pair = mpd_recv_pair_tag(partition_state->conn, mpdtag)) != NULL) {
-            if (pair->value[0] == '\0') {
-                MYMPD_LOG_DEBUG(partition_state->name, "Value is empty, skipping");
-            }
-            else if (searchstr_len == 0 ||
-                (searchstr_len <= 2 && utf8ncasecmp(searchstr, pair->value, searchstr_len) == 0) ||
-                (searchstr_len > 2 && utf8casestr(pair->value, searchstr) != NULL))
-            {
-                key = sdscat(key, pair->value);
-                //handle tags case insensitive
-                sds_utf8_tolower(key);
-                sds data = sdsnew(pair->value);
-                rax_insert_no_dup(taglist, key, data);
-                sdsclear(key);
+    if (song_cache->cache != NULL &&
+        mpd_client_tag_exists(&partition_state->mpd_state->tags_mympd, mpdtag) == true)
+    {
+        tag_list_local(song_cache, mpdtag, taglist, searchstr_folded);
+    }
+    else {
+        if (mpd_search_db_tags(partition_state->conn, mpdtag) == false) {
+            mpd_search_cancel(partition_state->conn);
+            FREE_SDS(key);
+            FREE_SDS(searchstr_folded);
+            raxFree(taglist);
+            return jsonrpc_respond_message(buffer, cmd_id, request_id, JSONRPC_FACILITY_DATABASE,
+                JSONRPC_SEVERITY_ERROR, "Error creating MPD search command");
+        }
+        if (mpd_search_commit(partition_state->conn)) {
+            struct mpd_pair *pair;
+            //filter and sort
+            while ((pair = mpd_recv_pair_tag(partition_state->conn, mpdtag)) != NULL) {
+                tag_list_add(taglist, &key, pair->value, NULL, 0, searchstr_folded);
+                mpd_return_pair(partition_state->conn, pair);
             }
-            mpd_return_pair(partition_state->conn, pair);
         }
-    }
-    mpd_response_finish(partition_state->conn);
-    if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_search_commit") == false) {
-        rax_free_sds_data(taglist);
-        return buffer;
+        mpd_response_finish(partition_state->conn);
+        if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_search_commit") == false) {
+            FREE_SDS(key);
+            FREE_SDS(searchstr_folded);
+            rax_free_sds_data(taglist);
+            return buffer;
+        }
     }
     FREE_SDS(key);
+    FREE_SDS(searchstr_folded);
 
     //print list
     buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
@@ -457,3 +460,179 @@ static bool check_album_sort_tag(enum sort_by_type sort_by, enum mpd_tag_type so
     }
     return true;
 }
+
+/**
+ * Filters the album cache and sorts the result.
+ * The album index narrows the candidates and its records provide the
+ * folded tag values for the contains filters.
+ * @param mympd_state pointer to mympd_state
+ * @param partition_state pointer to partition specific states
+ * @param expression mpd search expression
+ * @param sort_by sort type
+ * @param sort_tag tag to sort by
+ * @return newly allocated rax with the sort keys and the albums as data
+ */
+static rax *album_list_search(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        sds expression, enum sort_by_type sort_by, enum mpd_tag_type sort_tag)
+{
+    struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    rax *albums = raxNew();
+    sds key = sdsempty();
+    struct t_album_index *album_index = mympd_state->album_index;
+    if (album_index != NULL) {
+        struct t_album_postings *candidates = expr_list->length > 0
+            ? album_index_lookup(album_index, expr_list, &partition_state->mpd_state->tags_browse)
+            : NULL;
+        //verify only the candidates from the inverted index or all albums
+        unsigned len = candidates != NULL
+            ? candidates->len
+            : album_index->albums_len;
+        for (unsigned i = 0; i < len; i++) {
+            unsigned id = candidates != NULL
+                ? candidates->ids[i]
+                : i;
+            if (expr_list->length == 0 ||
+                search_expression_cached_song(album_index->records[id], expr_list, &partition_state->mpd_state->tags_browse, false) == true)
+            {
+                struct mpd_song *album = album_index->albums[id];
+                key = get_sort_key(key, sort_by, sort_tag, album);
+                rax_insert_no_dup(albums, key, album);
+                sdsclear(key);
+            }
+        }
+        album_postings_free(candidates);
+    }
+    else {
+        raxIterator iter;
+        raxStart(&iter, mympd_state->album_cache.cache);
+        raxSeek(&iter, "^", NULL, 0);
+        while (raxNext(&iter)) {
+            struct mpd_song *album = (struct mpd_song *)iter.data;
+            if (expr_list->length == 0 ||
+                search_expression_song(album, expr_list, &partition_state->mpd_state->tags_browse) == true)
+            {
+                key = get_sort_key(key, sort_by, sort_tag, album);
+                rax_insert_no_dup(albums, key, iter.data);
+                sdsclear(key);
+            }
+        }
+        raxStop(&iter);
+    }
+    free_search_expression_list(expr_list);
+    FREE_SDS(key);
+    return albums;
+}
+
+/**
+ * Searches the song cache for the songs of an album.
+ * Strings are compared case-sensitive as mpd find does.
+ * @param song_cache pointer to the song cache
+ * @param expression mpd search expression for the album
+ * @param any_tag_types tags for special "any" tag in expression
+ * @return songs sorted by disc and uri or NULL if the song cache can not be used
+ */
+static rax *album_detail_songs_local(struct t_cache *song_cache, const char *expression,
+        const struct t_mpd_tags *any_tag_types)
+{
+    if (song_cache->cache == NULL) {
+        return NULL;
+    }
+    struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    if (search_expression_is_complete(expression, expr_list) == false) {
+        free_search_expression_list(expr_list);
+        return NULL;
+    }
+    rax *songs = raxNew();
+    sds key = sdsempty();
+    raxIterator iter;
+    raxStart(&iter, song_cache->cache);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_song_cache_song *song = (struct t_song_cache_song *)iter.data;
+        if (search_expression_cached_song(song, expr_list, any_tag_types, true) == true) {
+            key = song_cache_get_sort_key(key, SORT_BY_TAG, MPD_TAG_DISC, song);
+            rax_insert_no_dup(songs, key, iter.data);
+            sdsclear(key);
+            if (songs->numele == MPD_RESULTS_MAX) {
+                break;
+            }
+        }
+    }
+    raxStop(&iter);
+    FREE_SDS(key);
+    free_search_expression_list(expr_list);
+    return songs;
+}
+
+/**
+ * Returns the next song from the result of album_detail_songs_local
+ * @param iter rax iterator
+ * @return newly allocated mpd_song struct or NULL if iteration is finished
+ */
+static struct mpd_song *album_detail_next_song(raxIterator *iter) {
+    return raxNext(iter)
+        ? song_cache_to_mpd_song((struct t_song_cache_song *)iter->data)
+        : NULL;
+}
+
+/**
+ * Adds a tag value to the tag list if it matches the search string
+ * @param taglist rax tree to add the value
+ * @param key already allocated sds string to use as key buffer
+ * @param value tag value
+ * @param folded tag value folded to lower case, NULL to fold it on the fly
+ * @param folded_len length of folded
+ * @param searchstr string to search, folded to lower case
+ */
+static void tag_list_add(rax *taglist, sds *key, const char *value, const char *folded, size_t folded_len, sds searchstr) {
+    if (value[0] == '\0') {
+        MYMPD_LOG_DEBUG(NULL, "Value is empty, skipping");
+        return;
+    }
+    size_t searchstr_len = sdslen(searchstr);
+    bool match;
+    if (searchstr_len == 0) {
+        match = true;
+    }
+    else if (folded == NULL) {
+        match = searchstr_len <= 2
+            ? utf8ncasecmp(searchstr, value, searchstr_len) == 0
+            : casefold_contains(value, searchstr, searchstr_len);
+    }
+    else {
+        match = searchstr_len <= 2
+            ? folded_len >= searchstr_len && memcmp(folded, searchstr, searchstr_len) == 0
+            : casefold_find(folded, folded_len, searchstr, searchstr_len) != NULL;
+    }
+    if (match == true) {
+        *key = sdscat(*key, value);
+        //handle tags case insensitive
+        sds_utf8_tolower(*key);
+        sds data = sdsnew(value);
+        rax_insert_no_dup(taglist, *key, data);
+        sdsclear(*key);
+    }
+}
+
+/**
+ * Adds all values of a tag from the song cache to the tag list
+ * @param song_cache pointer to the song cache
+ * @param tag tag to list
+ * @param taglist rax tree to add the values
+ * @param searchstr string to search, folded to lower case
+ */
+static void tag_list_local(struct t_cache *song_cache, enum mpd_tag_type tag, rax *taglist, sds searchstr) {
+    uint64_t tag_mask = (uint64_t)1 << tag;
+    sds key = sdsempty();
+    raxIterator iter;
+    raxStart(&iter, song_cache->strings);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_song_cache_string *str = (struct t_song_cache_string *)iter.data;
+        if ((str->tags & tag_mask) != 0) {
+            tag_list_add(taglist, &key, str->value, str->folded, str->folded_len, searchstr);
+        }
+    }
+    raxStop(&iter);
+    FREE_SDS(key);
+}
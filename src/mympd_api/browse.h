@@ -18,6 +18,6 @@ sds mympd_api_browse_album_detail(struct t_mympd_state *mympd_state, struct t_pa
 sds mympd_api_browse_album_list(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
         sds buffer, unsigned request_id, sds expression, sds sort, bool sortdesc, unsigned offset, unsigned limit,
         const struct t_fields *tagcols);
-sds mympd_api_browse_tag_list(struct t_partition_state *partition_state, sds buffer,
-        unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc);
+sds mympd_api_browse_tag_list(struct t_partition_state *partition_state, struct t_cache *song_cache,
+        sds buffer, unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc);
 #endif
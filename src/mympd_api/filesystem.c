@@ -11,7 +11,7 @@
 #include "compile_time.h"
 #include "src/mympd_api/filesystem.h"
 
-#include "dist/utf8/utf8.h"
+#include "src/lib/casefold.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/mem.h"
 #include "src/lib/rax_extras.h"
@@ -49,8 +49,10 @@ static bool search_dir_entry(rax *rt, sds key, sds entity_name, struct mpd_entit
 /**
  * Lists the entry of directory in the mpd music directory as jsonrpc response
  * Custom order: directories, playlists, songs
- * @param mympd_state pointer to mympd state
  * @param partition_state pointer to the partition state
+ * @param stickerdb pointer to the stickerdb state
+ * @param booklet_name filename for booklet
+ * @param info_txt_name filename for album info
  * @param buffer already allocated sds string to append result
  * @param request_id jsonrpc request id
  * @param path path to list
@@ -60,13 +62,15 @@ static bool search_dir_entry(rax *rt, sds key, sds entity_name, struct mpd_entit
  * @param tagcols columns to print
  * @return pointer to buffer
  */
-sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        sds buffer, unsigned request_id, sds path, unsigned offset, unsigned limit, sds searchstr, const struct t_fields *tagcols)
+sds mympd_api_browse_filesystem(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        sds booklet_name, sds info_txt_name, sds buffer, unsigned request_id, sds path, unsigned offset, unsigned limit, sds searchstr, const struct t_fields *tagcols)
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_DATABASE_FILESYSTEM_LIST;
     sds key = sdsempty();
     rax *entity_list = raxNew();
     unsigned real_limit = offset + limit;
+    //fold the search string once for all entries
+    sds searchstr_folded = casefold_cat(sdsempty(), searchstr);
 
     if (mpd_send_list_meta(partition_state->conn, path)) {
         struct mpd_entity *entity;
@@ -76,7 +80,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
                     const struct mpd_song *song = mpd_entity_get_song(entity);
                     sds entity_name =  mpd_client_get_tag_value_string(song, MPD_TAG_TITLE, sdsempty());
                     key = sdscatfmt(key, "2%s", mpd_song_get_uri(song));
-                    search_dir_entry(entity_list, key, entity_name, entity, searchstr);
+                    search_dir_entry(entity_list, key, entity_name, entity, searchstr_folded);
                     break;
                 }
                 case MPD_ENTITY_TYPE_DIRECTORY: {
@@ -84,7 +88,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
                     sds entity_name = sdsnew(mpd_directory_get_path(dir));
                     basename_uri(entity_name);
                     key = sdscatfmt(key, "0%s", mpd_directory_get_path(dir));
-                    search_dir_entry(entity_list, key, entity_name, entity, searchstr);
+                    search_dir_entry(entity_list, key, entity_name, entity, searchstr_folded);
                     break;
                 }
                 case MPD_ENTITY_TYPE_PLAYLIST: {
@@ -106,7 +110,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
                     sds entity_name = sdsnew(pl_path);
                     basename_uri(entity_name);
                     key = sdscatfmt(key, "1%s", pl_path);
-                    search_dir_entry(entity_list, key, entity_name, entity, searchstr);
+                    search_dir_entry(entity_list, key, entity_name, entity, searchstr_folded);
                     break;
                 }
                 default: {
@@ -117,6 +121,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
         }
         FREE_SDS(key);
     }
+    FREE_SDS(searchstr_folded);
     mpd_response_finish(partition_state->conn);
     if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_send_list_meta") == false) {
         //free result
@@ -136,7 +141,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
     raxSeek(&iter, "^", NULL, 0);
     bool print_stickers = check_get_sticker(partition_state->mpd_state->feat.stickers, &tagcols->stickers);
     if (print_stickers == true) {
-        stickerdb_exit_idle(mympd_state->stickerdb);
+        stickerdb_exit_idle(stickerdb);
     }
     while (raxNext(&iter)) {
         struct t_dir_entry *entry_data = (struct t_dir_entry *)iter.data;
@@ -157,7 +162,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
                     buffer = tojson_sds(buffer, "Filename", filename, false);
                     FREE_SDS(filename);
                     if (print_stickers == true) {
-                        buffer = mympd_api_sticker_get_print_batch(buffer, mympd_state->stickerdb, STICKER_TYPE_SONG, mpd_song_get_uri(song), &tagcols->stickers);
+                        buffer = mympd_api_sticker_get_print_batch(buffer, stickerdb, STICKER_TYPE_SONG, mpd_song_get_uri(song), &tagcols->stickers);
                     }
                     buffer = sdscatlen(buffer, "}", 1);
                     break;
@@ -184,6 +189,7 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
                 default:
                     break;
             }
+            buffer = response_stream_flush(buffer);
         }
         mpd_entity_free(entry_data->entity);
         FREE_SDS(entry_data->name);
@@ -192,10 +198,10 @@ sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_part
     }
     raxStop(&iter);
     if (print_stickers == true) {
-        stickerdb_enter_idle(mympd_state->stickerdb);
+        stickerdb_enter_idle(stickerdb);
     }
     buffer = sdscatlen(buffer, "],", 2);
-    buffer = mympd_api_get_extra_media(buffer, partition_state->mpd_state, mympd_state->booklet_name, mympd_state->info_txt_name, path, true);
+    buffer = mympd_api_get_extra_media(buffer, partition_state->mpd_state, booklet_name, info_txt_name, path, true);
     buffer = sdscatlen(buffer, ",", 1);
     buffer = tojson_uint(buffer, "totalEntities", entity_count, true);
     buffer = tojson_uint(buffer, "returnedEntities", entities_returned, true);
@@ -227,12 +233,12 @@ static void free_t_dir_entry(void *data) {
  * @param key key to insert
  * @param entity_name displayname of the entity
  * @param entity pointer to mpd entity
- * @param searchstr string to search in entity_name
+ * @param searchstr string to search in entity_name, folded to lower case
  * @return true on match, else false
  */
 static bool search_dir_entry(rax *rt, sds key, sds entity_name, struct mpd_entity *entity, sds searchstr) {
     if (sdslen(searchstr) == 0 ||
-        utf8casestr(entity_name, searchstr) != NULL)
+        casefold_contains(entity_name, searchstr, sdslen(searchstr)) == true)
     {
         struct t_dir_entry *entry_data = malloc_assert(sizeof(struct t_dir_entry));
         entry_data->name = entity_name;
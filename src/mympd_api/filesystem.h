@@ -13,6 +13,6 @@
 
 #include "src/lib/mympd_state.h"
 
-sds mympd_api_browse_filesystem(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        sds buffer, unsigned request_id, sds path, unsigned offset, unsigned limit, sds searchstr, const struct t_fields *tagcols);
+sds mympd_api_browse_filesystem(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        sds booklet_name, sds info_txt_name, sds buffer, unsigned request_id, sds path, unsigned offset, unsigned limit, sds searchstr, const struct t_fields *tagcols);
 #endif
@@ -132,38 +132,59 @@ sds mympd_api_jukebox_list(struct t_partition_state *partition_state, struct t_s
     if (partition_state->jukebox.mode == JUKEBOX_ADD_SONG ||
         partition_state->jukebox.mode == JUKEBOX_SCRIPT)
     {
+        struct t_list songs;
+        list_init(&songs);
         struct t_list_node *current = partition_state->jukebox.queue->head;
         while (current != NULL) {
             if (mpd_send_list_meta(partition_state->conn, current->key)) {
                 struct mpd_song *song;
                 if ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+                    bool keep = false;
                     if (search_expression_song(song, expr_list, &tagcols->mpd_tags) == true) {
                         if (entities_found >= offset &&
                             entities_found < real_limit)
                         {
-                            if (entities_returned++) {
-                                buffer = sdscatlen(buffer, ",", 1);
-                            }
-                            buffer = sdscat(buffer, "{\"Type\": \"song\",");
-                            buffer = tojson_uint(buffer, "Pos", entity_count, true);
-                            buffer = print_song_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, song);
-                            if (print_stickers == true) {
-                                buffer = mympd_api_sticker_get_print_batch(buffer, stickerdb, STICKER_TYPE_SONG, mpd_song_get_uri(song), &tagcols->stickers);
-                            }
-                            buffer = sdscatlen(buffer, "}", 1);
+                            list_push(&songs, mpd_song_get_uri(song), entity_count, NULL, song);
+                            keep = true;
                         }
                         entities_found++;
                     }
                     entity_count++;
-                    mpd_song_free(song);
+                    if (keep == false) {
+                        mpd_song_free(song);
+                    }
                 }
             }
             mpd_response_finish(partition_state->conn);
             mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_meta");
             current = current->next;
         }
+        // get the stickers for all rows at once
+        rax *stickers = print_stickers == true
+            ? stickerdb_get_all_multi(stickerdb, STICKER_TYPE_SONG, &songs, tagcols->stickers.user_defined)
+            : NULL;
+        current = songs.head;
+        while (current != NULL) {
+            struct mpd_song *song = (struct mpd_song *)current->user_data;
+            if (entities_returned++) {
+                buffer = sdscatlen(buffer, ",", 1);
+            }
+            buffer = sdscat(buffer, "{\"Type\": \"song\",");
+            buffer = tojson_int64(buffer, "Pos", current->value_i, true);
+            buffer = print_song_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, song);
+            if (stickers != NULL) {
+                buffer = mympd_api_sticker_print_multi(buffer, stickers, current->key, &tagcols->stickers);
+            }
+            buffer = sdscatlen(buffer, "}", 1);
+            current = current->next;
+        }
+        stickerdb_free_all_multi(stickers);
+        list_clear_user_data(&songs, list_free_cb_song_user_data);
     }
     else if (partition_state->jukebox.mode == JUKEBOX_ADD_ALBUM) {
+        // albums of the page with the album search expression as key
+        struct t_list albums;
+        list_init(&albums);
         struct t_list_node *current = partition_state->jukebox.queue->head;
         sds album_exp = sdsempty();
         while (current != NULL) {
@@ -172,18 +193,8 @@ sds mympd_api_jukebox_list(struct t_partition_state *partition_state, struct t_s
                 if (entities_found >= offset &&
                     entities_found < real_limit)
                 {
-                    if (entities_returned++) {
-                        buffer = sdscatlen(buffer, ",", 1);
-                    }
-                    buffer = sdscat(buffer, "{\"Type\": \"album\",");
-                    buffer = tojson_uint(buffer, "Pos", entity_count, true);
-                    buffer = print_album_tags(buffer, partition_state->mpd_state, &partition_state->mpd_state->tags_album, album);
-                    if (print_stickers == true) {
-                        buffer = sdscatlen(buffer, ",", 1);
-                        album_exp = get_search_expression_album(album_exp, partition_state->mpd_state->tag_albumartist, album, &partition_state->config->albums);
-                        buffer = mympd_api_sticker_get_print_batch(buffer, stickerdb, STICKER_TYPE_FILTER, album_exp, &tagcols->stickers);
-                    }
-                    buffer = sdscatlen(buffer, "}", 1);
+                    album_exp = get_search_expression_album(album_exp, partition_state->mpd_state->tag_albumartist, album, &partition_state->config->albums);
+                    list_push(&albums, album_exp, entity_count, NULL, album);
                 }
                 entities_found++;
             }
@@ -191,6 +202,28 @@ sds mympd_api_jukebox_list(struct t_partition_state *partition_state, struct t_s
             current = current->next;
         }
         FREE_SDS(album_exp);
+        // get the stickers for all rows at once
+        rax *stickers = print_stickers == true
+            ? stickerdb_get_all_multi(stickerdb, STICKER_TYPE_FILTER, &albums, tagcols->stickers.user_defined)
+            : NULL;
+        current = albums.head;
+        while (current != NULL) {
+            if (entities_returned++) {
+                buffer = sdscatlen(buffer, ",", 1);
+            }
+            buffer = sdscat(buffer, "{\"Type\": \"album\",");
+            buffer = tojson_int64(buffer, "Pos", current->value_i, true);
+            buffer = print_album_tags(buffer, partition_state->mpd_state, &partition_state->mpd_state->tags_album, (struct mpd_song *)current->user_data);
+            if (stickers != NULL) {
+                buffer = sdscatlen(buffer, ",", 1);
+                buffer = mympd_api_sticker_print_multi(buffer, stickers, current->key, &tagcols->stickers);
+            }
+            buffer = sdscatlen(buffer, "}", 1);
+            current = current->next;
+        }
+        stickerdb_free_all_multi(stickers);
+        // the albums are owned by the jukebox queue
+        list_clear(&albums);
     }
     if (print_stickers == true) {
         stickerdb_enter_idle(stickerdb);
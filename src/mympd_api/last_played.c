@@ -12,7 +12,10 @@
 #include "src/mympd_api/last_played.h"
 
 #include "dist/sds/sds.h"
+#include "src/lib/cache_rax_song.h"
 #include "src/lib/jsonrpc.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/search.h"
 #include "src/lib/utility.h"
@@ -27,9 +30,21 @@
  * Private definitions
  */
 
-static sds get_last_played_obj(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
-        sds buffer, unsigned entity_count, int64_t last_played, const char *uri, struct t_list *expr_list,
-        const struct t_fields *tagcols, bool print_stickers);
+/**
+ * A row of the last played page
+ */
+struct t_last_played_row {
+    unsigned pos;           //!< position in the last played list
+    int64_t last_played;    //!< last played time as unix timestamp
+    struct mpd_song *song;  //!< the song
+};
+
+static unsigned filter_last_played_cache(struct t_partition_state *partition_state, struct t_cache *song_cache,
+        struct t_list *expr_list, const struct t_fields *tagcols, unsigned offset, unsigned real_limit, struct t_list *rows);
+static unsigned filter_last_played_mpd(struct t_partition_state *partition_state, struct t_list *expr_list,
+        const struct t_fields *tagcols, unsigned offset, unsigned real_limit, struct t_list *rows);
+static void add_last_played_row(struct t_list *rows, struct mpd_song *song, unsigned pos, int64_t last_played);
+static void free_last_played_row(struct t_list_node *current);
 
 /**
  * Public functions
@@ -61,6 +76,7 @@ bool mympd_api_last_played_add_song(struct t_partition_state *partition_state, u
  * Prints a jsonrpc response with the last played songs
  * @param partition_state pointer to partition state
  * @param stickerdb pointer to stickerdb state
+ * @param song_cache pointer to the song cache, the songs are fetched from MPD if it is not ready
  * @param buffer already allocated sds string to append the response
  * @param request_id jsonrpc request id
  * @param offset offset
@@ -70,51 +86,60 @@ bool mympd_api_last_played_add_song(struct t_partition_state *partition_state, u
  * @return pointer to buffer
  */
 sds mympd_api_last_played_list(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
-        sds buffer, unsigned request_id, unsigned offset, unsigned limit, sds expression, const struct t_fields *tagcols)
+        struct t_cache *song_cache, sds buffer, unsigned request_id, unsigned offset, unsigned limit,
+        sds expression, const struct t_fields *tagcols)
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_LAST_PLAYED_LIST;
-    unsigned entity_count = 0;
     unsigned entities_returned = 0;
-    unsigned entities_found = 0;
 
     buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
     buffer = sdscat(buffer, "\"data\":[");
-    sds obj = sdsempty();
 
     unsigned real_limit = offset + limit;
     struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    struct t_list rows;
+    list_init(&rows);
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    unsigned entities_found = song_cache->cache != NULL &&
+            search_expression_is_complete(expression, expr_list) == true
+        ? filter_last_played_cache(partition_state, song_cache, expr_list, tagcols, offset, real_limit, &rows)
+        : filter_last_played_mpd(partition_state, expr_list, tagcols, offset, real_limit, &rows);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(partition_state->name, "Last played filter");
+    #endif
+    free_search_expression_list(expr_list);
+
     bool print_stickers = check_get_sticker(partition_state->mpd_state->feat.stickers, &tagcols->stickers);
+    rax *stickers = NULL;
     if (print_stickers == true) {
         stickerdb_exit_idle(stickerdb);
+        stickers = stickerdb_get_all_multi(stickerdb, STICKER_TYPE_SONG, &rows, tagcols->stickers.user_defined);
+        stickerdb_enter_idle(stickerdb);
     }
-
-    struct t_list_node *current = partition_state->last_played.head;
+    struct t_list_node *current = rows.head;
     while (current != NULL) {
-        obj = get_last_played_obj(partition_state, stickerdb, obj, entity_count, current->value_i,
-            current->key, expr_list, tagcols, print_stickers);
-        if (sdslen(obj) > 0) {
-            if (entities_found >= offset) {
-                if (entities_returned++) {
-                    buffer = sdscatlen(buffer, ",", 1);
-                }
-                buffer = sdscatsds(buffer, obj);
-            }
-            sdsclear(obj);
-            entities_found++;
-            if (entities_returned == real_limit) {
-                break;
-            }
+        const struct t_last_played_row *row = (struct t_last_played_row *)current->user_data;
+        if (entities_returned++) {
+            buffer = sdscatlen(buffer, ",", 1);
         }
-        entity_count++;
+        buffer = sdscat(buffer, "{\"Type\": \"song\",");
+        buffer = tojson_uint(buffer, "Pos", row->pos, true);
+        buffer = tojson_int64(buffer, "LastPlayed", row->last_played, true);
+        buffer = print_song_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, row->song);
+        if (stickers != NULL) {
+            buffer = mympd_api_sticker_print_multi(buffer, stickers, current->key, &tagcols->stickers);
+        }
+        buffer = sdscatlen(buffer, "}", 1);
         current = current->next;
     }
-    FREE_SDS(obj);
-    if (print_stickers == true) {
-        stickerdb_enter_idle(stickerdb);
-    }
-    free_search_expression_list(expr_list);
+    stickerdb_free_all_multi(stickers);
+    list_clear_user_data(&rows, free_last_played_row);
     buffer = sdscatlen(buffer, "],", 2);
-    buffer = tojson_int(buffer, "totalEntities", -1, true);
+    buffer = tojson_uint(buffer, "totalEntities", entities_found, true);
     buffer = tojson_uint(buffer, "offset", offset, true);
     buffer = tojson_uint(buffer, "returnedEntities", entities_returned, false);
     buffer = jsonrpc_end(buffer);
@@ -127,39 +152,141 @@ sds mympd_api_last_played_list(struct t_partition_state *partition_state, struct
  */
 
 /**
- * Gets the song and searches for searchstr and prints it as json object
+ * Filters the last played list with the song cache
  * @param partition_state pointer to partition state
- * @param stickerdb pointer to stickerdb state
- * @param buffer already allocated buffer to append the result
- * @param entity_count position in the list
- * @param last_played songs last played time as unix timestamp
- * @param uri uri of the song
+ * @param song_cache pointer to the song cache
  * @param expr_list list of search expressions
  * @param tagcols columns to print
- * @param print_stickers Print stickers?
- * @return pointer to buffer
+ * @param offset offset
+ * @param real_limit offset + limit
+ * @param rows list to append the rows of the requested window
+ * @return number of matching entries
  */
-static sds get_last_played_obj(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
-        sds buffer, unsigned entity_count, int64_t last_played, const char *uri, struct t_list *expr_list,
-        const struct t_fields *tagcols, bool print_stickers)
+static unsigned filter_last_played_cache(struct t_partition_state *partition_state, struct t_cache *song_cache,
+        struct t_list *expr_list, const struct t_fields *tagcols, unsigned offset, unsigned real_limit, struct t_list *rows)
 {
-    if (mpd_send_list_meta(partition_state->conn, uri)) {
-        struct mpd_song *song;
-        if ((song = mpd_recv_song(partition_state->conn)) != NULL) {
-            if (search_expression_song(song, expr_list, &tagcols->mpd_tags) == true) {
-                buffer = sdscat(buffer, "{\"Type\": \"song\",");
-                buffer = tojson_uint(buffer, "Pos", entity_count, true);
-                buffer = tojson_int64(buffer, "LastPlayed", last_played, true);
-                buffer = print_song_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, song);
-                if (print_stickers == true) {
-                    buffer = mympd_api_sticker_get_print_batch(buffer, stickerdb, STICKER_TYPE_SONG, mpd_song_get_uri(song), &tagcols->stickers);
+    unsigned entity_count = 0;
+    unsigned entities_found = 0;
+    struct t_list_node *current = partition_state->last_played.head;
+    while (current != NULL) {
+        const struct t_song_cache_song *song = song_cache_get_song(song_cache, current->key);
+        if (song != NULL &&
+            (expr_list->length == 0 ||
+             search_expression_cached_song(song, expr_list, &tagcols->mpd_tags, false) == true))
+        {
+            if (entities_found >= offset &&
+                entities_found < real_limit)
+            {
+                add_last_played_row(rows, song_cache_to_mpd_song(song), entity_count, current->value_i);
+            }
+            entities_found++;
+        }
+        entity_count++;
+        current = current->next;
+    }
+    return entities_found;
+}
+
+/**
+ * Filters the last played list with songs fetched from MPD.
+ * The songs are fetched in command lists of MPD_COMMANDS_MAX commands.
+ * @param partition_state pointer to partition state
+ * @param expr_list list of search expressions
+ * @param tagcols columns to print
+ * @param offset offset
+ * @param real_limit offset + limit
+ * @param rows list to append the rows of the requested window
+ * @return number of matching entries
+ */
+static unsigned filter_last_played_mpd(struct t_partition_state *partition_state, struct t_list *expr_list,
+        const struct t_fields *tagcols, unsigned offset, unsigned real_limit, struct t_list *rows)
+{
+    unsigned entity_count = 0;
+    unsigned entities_found = 0;
+    struct t_list_node *current = partition_state->last_played.head;
+    while (current != NULL) {
+        struct t_list_node *first = current;
+        unsigned count = 0;
+        bool rc = mpd_command_list_begin(partition_state->conn, true);
+        while (rc == true &&
+               current != NULL &&
+               count < MPD_COMMANDS_MAX)
+        {
+            rc = mpd_send_list_meta(partition_state->conn, current->key);
+            current = current->next;
+            count++;
+        }
+        if (rc == false ||
+            mpd_command_list_end(partition_state->conn) == false)
+        {
+            mpd_response_finish(partition_state->conn);
+            mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_meta");
+            return entities_found;
+        }
+        // demultiplex the responses
+        struct t_list_node *node = first;
+        unsigned i = 0;
+        for (; i < count; i++) {
+            if (i > 0) {
+                if (mpd_response_next(partition_state->conn) == false) {
+                    break;
                 }
-                buffer = sdscatlen(buffer, "}", 1);
+                node = node->next;
             }
-            mpd_song_free(song);
+            struct mpd_song *song;
+            if ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+                bool keep = false;
+                if (search_expression_song(song, expr_list, &tagcols->mpd_tags) == true) {
+                    if (entities_found >= offset &&
+                        entities_found < real_limit)
+                    {
+                        add_last_played_row(rows, song, entity_count + i, node->value_i);
+                        keep = true;
+                    }
+                    entities_found++;
+                }
+                if (keep == false) {
+                    mpd_song_free(song);
+                }
+            }
+        }
+        mpd_response_finish(partition_state->conn);
+        if (mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_meta") == false) {
+            if (partition_state->conn_state == MPD_FAILURE) {
+                return entities_found;
+            }
+            // song not found, continue after the failed uri
+            current = node->next;
+            entity_count += i;
+        }
+        else {
+            entity_count += count;
         }
     }
-    mpd_response_finish(partition_state->conn);
-    mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_meta");
-    return buffer;
+    return entities_found;
+}
+
+/**
+ * Appends a row to the last played page
+ * @param rows list of rows
+ * @param song the song, ownership is transferred to the row
+ * @param pos position in the last played list
+ * @param last_played last played time as unix timestamp
+ */
+static void add_last_played_row(struct t_list *rows, struct mpd_song *song, unsigned pos, int64_t last_played) {
+    struct t_last_played_row *row = malloc_assert(sizeof(struct t_last_played_row));
+    row->pos = pos;
+    row->last_played = last_played;
+    row->song = song;
+    list_push(rows, mpd_song_get_uri(song), 0, NULL, row);
+}
+
+/**
+ * Callback function for list_clear_user_data to free a last played row
+ * @param current list node
+ */
+static void free_last_played_row(struct t_list_node *current) {
+    struct t_last_played_row *row = (struct t_last_played_row *)current->user_data;
+    mpd_song_free(row->song);
+    FREE_PTR(row);
 }
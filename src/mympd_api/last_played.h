@@ -15,5 +15,6 @@
 
 bool mympd_api_last_played_add_song(struct t_partition_state *partition_state, unsigned last_played_count);
 sds mympd_api_last_played_list(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
-        sds buffer, unsigned request_id, unsigned offset, unsigned limit, sds expression, const struct t_fields *tagcols);
+        struct t_cache *song_cache, sds buffer, unsigned request_id, unsigned offset, unsigned limit,
+        sds expression, const struct t_fields *tagcols);
 #endif
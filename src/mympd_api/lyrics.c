@@ -11,6 +11,7 @@
 #include "compile_time.h"
 #include "src/mympd_api/lyrics.h"
 
+#include "src/lib/cache_disk.h"
 #include "src/lib/cache_disk_lyrics.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/jsonrpc.h"
@@ -77,18 +78,34 @@ sds mympd_api_lyrics_get(struct t_mympd_state *mympd_state, sds buffer,
     FREE_SDS(content);
 
     // get lyrics only for local uri and if we have access to the mpd music directory
+    bool negative_cache = mympd_state->config->cache_lyrics_keep_days != CACHE_DISK_DISABLED &&
+        is_streamuri(uri) == false;
+    bool negative_found = false;
     if (is_streamuri(uri) == false &&
         sdslen(mympd_state->mpd_state->music_directory_value) > 0)
     {
         sds mediafile = sdscatfmt(sdsempty(), "%S/%S", mympd_state->mpd_state->music_directory_value, uri);
-        const char *mime_type_mediafile = get_mime_type_by_ext(mediafile);
-        lyrics_get(&mympd_state->lyrics, &extracted, mediafile, mime_type_mediafile);
+        if (extracted.length == 0 &&
+            negative_cache == true)
+        {
+            negative_found = cache_disk_negative_check(mympd_state->config->cachedir, DIR_CACHE_LYRICS, uri, 0, mediafile);
+        }
+        if (negative_found == false) {
+            const char *mime_type_mediafile = get_mime_type_by_ext(mediafile);
+            lyrics_get(&mympd_state->lyrics, &extracted, mediafile, mime_type_mediafile);
+        }
         FREE_SDS(mediafile);
     }
+    else if (extracted.length == 0 &&
+        negative_cache == true)
+    {
+        negative_found = cache_disk_negative_check(mympd_state->config->cachedir, DIR_CACHE_LYRICS, uri, 0, NULL);
+    }
 
     if (extracted.length == 0) {
         #ifdef MYMPD_ENABLE_LUA
             // no lyrics found, check if there is a trigger to fetch lyrics
+            // the negative cache covers only the local lookup
             struct t_list arguments;
             list_init(&arguments);
             list_push(&arguments, "uri", 0, uri, NULL);
@@ -106,6 +123,11 @@ sds mympd_api_lyrics_get(struct t_mympd_state *mympd_state, sds buffer,
             (void)conn_id;
         #endif
         // no trigger
+        if (negative_cache == true &&
+            negative_found == false)
+        {
+            cache_disk_negative_write(mympd_state->config->cachedir, DIR_CACHE_LYRICS, uri, 0);
+        }
         buffer = jsonrpc_respond_message(buffer, cmd_id, request_id,
             JSONRPC_FACILITY_LYRICS, JSONRPC_SEVERITY_INFO, "No lyrics found");
     }
@@ -12,14 +12,15 @@
 #include "src/mympd_api/mympd_api.h"
 
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/cache_rax_song.h"
 #include "src/lib/event.h"
-#include "src/lib/filehandler.h"
 #include "src/lib/last_played.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
 #include "src/lib/msg_queue.h"
 #include "src/lib/mympd_state.h"
 #include "src/lib/sds_extras.h"
+#include "src/lib/state_store.h"
 #include "src/lib/thread.h"
 #include "src/lib/timer.h"
 #include "src/lib/webradio.h"
@@ -28,6 +29,7 @@
 #include "src/mpd_client/idle.h"
 #include "src/mpd_client/partitions.h"
 #include "src/mpd_client/stickerdb.h"
+#include "src/mpd_worker/pool.h"
 #include "src/mympd_api/home.h"
 #include "src/mympd_api/settings.h"
 #include "src/mympd_api/timer.h"
@@ -39,8 +41,10 @@
 // private definitions
 
 static void populate_pfds(struct t_mympd_state *mympd_state);
-static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, struct t_work_request **request);
-static void handle_socket_error(struct t_mympd_state *mympd_state, nfds_t i);
+static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, struct t_list *requests);
+static void handle_socket_error(struct t_mympd_state *mympd_state, nfds_t i, struct t_list *requests);
+static void handle_timers(struct t_mympd_state *mympd_state);
+static void shift_requests(struct t_mympd_state *mympd_state, struct t_list *requests);
 
 // public functions
 
@@ -57,12 +61,12 @@ void *mympd_api_loop(void *arg_config) {
     struct t_mympd_state *mympd_state = malloc_assert(sizeof(struct t_mympd_state));
     mympd_state_default(mympd_state, (struct t_config *)arg_config);
 
+    // load the global states
+    state_store_load(&mympd_state->state_store, mympd_state->config->workdir, DIR_WORK_STATE);
     // start auto configuration, if mpd_host does not exist
-    sds filepath = sdscatfmt(sdsempty(), "%S/%s/mpd_host", mympd_state->config->workdir, DIR_WORK_STATE);
-    if (testfile_read(filepath) == false) {
+    if (state_store_exists(&mympd_state->state_store, "mpd_host") == false) {
         mpd_client_autoconf(mympd_state);
     }
-    FREE_SDS(filepath);
 
     // read global states
     mympd_api_settings_statefiles_global_read(mympd_state);
@@ -79,7 +83,12 @@ void *mympd_api_loop(void *arg_config) {
     // caches
     if (mympd_state->config->save_caches == true) {
         // album cache
-        album_cache_read(&mympd_state->album_cache, mympd_state->config->workdir, &mympd_state->config->albums);
+        // the album index is built by the mpd_worker thread on the first cache update
+        album_cache_read(&mympd_state->album_cache, mympd_state->config->workdir, &mympd_state->config->albums, NULL);
+        // song cache
+        if (mympd_state->config->song_cache == true) {
+            song_cache_read(&mympd_state->song_cache, mympd_state->config->workdir);
+        }
     }
     //webradiodb
     if (mympd_state->config->webradiodb == true) {
@@ -112,8 +121,15 @@ void *mympd_api_loop(void *arg_config) {
         MYMPD_LOG_NOTICE("stickerdb", "Stickers are disabled by config");
     }
 
+    // start the mpd_worker pool, it is configured after the feature detection
+    mympd_state->mpd_worker_pool = mpd_worker_pool_new(mympd_state->config);
+
     // connect to default mpd partition
-    mympd_timer_set(mympd_state->partition_state->timer_fd_mpd_connect, 0, 5);
+    mympd_timer_entry_set(&mympd_state->partition_state->timer_mpd_connect, 0, 5);
+
+    // requests shifted from the mympd_api_queue in one loop iteration
+    struct t_list requests;
+    list_init(&requests);
 
     // thread loop
     while (s_signal_received == 0) {
@@ -125,25 +141,30 @@ void *mympd_api_loop(void *arg_config) {
             MYMPD_LOG_ERRNO(NULL, errno);
             continue;
         }
-        struct t_work_request *request = NULL;
         for (nfds_t i = 0; i < mympd_state->pfds.len; i++) {
             if (mympd_state->pfds.fds[i].revents & POLLIN) {
-                handle_socket_pollin(mympd_state, i, &request);
+                handle_socket_pollin(mympd_state, i, &requests);
             }
             else if (mympd_state->pfds.fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) {
-                handle_socket_error(mympd_state, i);
+                handle_socket_error(mympd_state, i, &requests);
             }
         }
-        // Iterate through mpd partitions and handle the events
-        mpd_client_idle(mympd_state, request);
+        // Iterate through mpd partitions and handle the events and requests
+        mpd_client_idle(mympd_state, &requests);
     }
     MYMPD_LOG_DEBUG(NULL, "Stopping mympd_api thread");
 
     // stop trigger
     mympd_api_trigger_execute(&mympd_state->trigger_list, TRIGGER_MYMPD_STOP, MPD_PARTITION_ALL, NULL);
 
+    // stop the mpd_worker pool
+    if (mympd_state->mpd_worker_pool != NULL) {
+        mympd_state->mpd_worker_pool = mpd_worker_pool_free(mympd_state->mpd_worker_pool);
+    }
+
     // disconnect from mpd
     mpd_client_disconnect_all(mympd_state);
+    stickerdb_pending_flush(mympd_state->stickerdb);
     if (mympd_state->stickerdb->conn != NULL) {
         stickerdb_disconnect(mympd_state->stickerdb);
     }
@@ -157,19 +178,47 @@ void *mympd_api_loop(void *arg_config) {
 
 // private functions
 
+/**
+ * Shifts up to MYMPD_API_QUEUE_BATCH_MAX requests from the mympd_api_queue
+ * @param mympd_state pointer to mympd state
+ * @param requests list to append the requests
+ */
+static void shift_requests(struct t_mympd_state *mympd_state, struct t_list *requests) {
+    unsigned count = 0;
+    struct t_work_request *request;
+    while (count < MYMPD_API_QUEUE_BATCH_MAX &&
+        (request = mympd_queue_shift(mympd_api_queue, -1, 0)) != NULL)
+    {
+        list_push(requests, "", 0, NULL, request);
+        count++;
+    }
+    if (count == MYMPD_API_QUEUE_BATCH_MAX) {
+        // the eventfd counter is already consumed, wakeup again for the remaining requests
+        event_eventfd_write(mympd_api_queue->event_fd);
+        mympd_state->loop_stats.capped++;
+    }
+    mympd_state->loop_stats.wakeups++;
+    mympd_state->loop_stats.requests += count;
+    mympd_state->loop_stats.last_batch = count;
+    if (count > mympd_state->loop_stats.max_batch) {
+        mympd_state->loop_stats.max_batch = count;
+    }
+    MYMPD_LOG_DEBUG(NULL, "Shifted %u requests from the queue", count);
+}
+
 /**
  * Handles socket read event
  * @param mympd_state pointer to mympd state
  * @param i fd number from pfds array
- * @param request pointer to work request struct to populate
+ * @param requests list to append requests from the mympd_api_queue
  */
-static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, struct t_work_request **request) {
+static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, struct t_list *requests) {
     switch (mympd_state->pfds.fd_types[i]) {
         case PFD_TYPE_TIMER:
-            // generic myMPD timer
+            // timer heap
             MYMPD_LOG_DEBUG(NULL, "Timer event");
             if (mympd_timer_read(mympd_state->pfds.fds[i].fd) == true) {
-                mympd_api_timer_check(mympd_state->pfds.fds[i].fd, &mympd_state->timer_list);
+                handle_timers(mympd_state);
             }
             break;
         case PFD_TYPE_STICKERDB:
@@ -180,17 +229,7 @@ static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, st
             // check the mympd_api_queue
             MYMPD_LOG_DEBUG(NULL, "Queue event");
             if (event_eventfd_read(mympd_state->pfds.fds[i].fd) == true) {
-                *request = mympd_queue_shift(mympd_api_queue, -1, 0);
-                if (*request == NULL) {
-                    break;
-                }
-                struct t_partition_state *partition_state = partitions_get_by_name(mympd_state, (*request)->partition);
-                if (partition_state == NULL) {
-                    MYMPD_LOG_ERROR(NULL, "Unable to find partition for queue fd: %d", mympd_state->pfds.fds[i].fd);
-                    break;
-                }
-                MYMPD_LOG_DEBUG(partition_state->name, "Queue event");
-                partition_state->waiting_events |= PFD_TYPE_QUEUE;
+                shift_requests(mympd_state, requests);
             }
             break;
         case PFD_TYPE_PARTITION:
@@ -198,27 +237,54 @@ static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, st
             MYMPD_LOG_DEBUG(mympd_state->pfds.partition_states[i]->name, "Partition event");
             mympd_state->pfds.partition_states[i]->waiting_events |= PFD_TYPE_PARTITION;
             break;
-        case PFD_TYPE_TIMER_JUKEBOX:
-            // jukebox should add a song
-            MYMPD_LOG_DEBUG(mympd_state->pfds.partition_states[i]->name, "Jukebox event");
-            if (mympd_timer_read(mympd_state->pfds.fds[i].fd) == true) {
-                mympd_state->pfds.partition_states[i]->waiting_events |= PFD_TYPE_TIMER_JUKEBOX;
-            }
-            break;
-        case PFD_TYPE_TIMER_SCROBBLE:
-            // scrobble event
-            MYMPD_LOG_DEBUG(mympd_state->pfds.partition_states[i]->name, "Scrobble event");
-            if (mympd_timer_read(mympd_state->pfds.fds[i].fd) == true) {
-                mpd_client_scrobble(mympd_state, mympd_state->pfds.partition_states[i]);
-            }
-            break;
-        case PFD_TYPE_TIMER_MPD_CONNECT:
-            // connect to mpd
-            MYMPD_LOG_DEBUG(mympd_state->pfds.partition_states[i]->name, "Connect event");
-            if (mympd_timer_read(mympd_state->pfds.fds[i].fd) == true) {
-                partitions_connect(mympd_state, mympd_state->pfds.partition_states[i]);
-            }
-            break;
+        default:
+            MYMPD_LOG_WARN(NULL, "Unexpected poll fd type %s", lookup_pfd_type(mympd_state->pfds.fd_types[i]));
+    }
+}
+
+/**
+ * Executes all expired timers of the timer heap
+ * @param mympd_state pointer to mympd state
+ */
+static void handle_timers(struct t_mympd_state *mympd_state) {
+    int64_t now = mympd_timer_now();
+    struct t_timer_entry *timer;
+    // the timer can be freed by its handler, do not access it afterwards
+    while ((timer = mympd_timer_heap_next_expired(&mympd_state->timer_heap, now)) != NULL) {
+        if ((timer->type == PFD_TYPE_TIMER_JUKEBOX || timer->type == PFD_TYPE_TIMER_SCROBBLE) &&
+            timer->partition_state->conn == NULL)
+        {
+            MYMPD_LOG_DEBUG(timer->partition_state->name, "Skipping %s event, not connected", lookup_pfd_type(timer->type));
+            continue;
+        }
+        switch (timer->type) {
+            case PFD_TYPE_TIMER:
+                // myMPD timer from the timer list
+                mympd_api_timer_check((struct t_timer_node *)timer->data, &mympd_state->timer_list);
+                break;
+            case PFD_TYPE_TIMER_STICKERDB:
+                // write the coalesced sticker writes
+                MYMPD_LOG_DEBUG("stickerdb", "Stickerdb timer event");
+                stickerdb_pending_flush(mympd_state->stickerdb);
+                break;
+            case PFD_TYPE_TIMER_JUKEBOX:
+                // jukebox should add a song
+                MYMPD_LOG_DEBUG(timer->partition_state->name, "Jukebox event");
+                timer->partition_state->waiting_events |= PFD_TYPE_TIMER_JUKEBOX;
+                break;
+            case PFD_TYPE_TIMER_SCROBBLE:
+                // scrobble event
+                MYMPD_LOG_DEBUG(timer->partition_state->name, "Scrobble event");
+                mpd_client_scrobble(mympd_state, timer->partition_state);
+                break;
+            case PFD_TYPE_TIMER_MPD_CONNECT:
+                // connect to mpd
+                MYMPD_LOG_DEBUG(timer->partition_state->name, "Connect event");
+                partitions_connect(mympd_state, timer->partition_state);
+                break;
+            default:
+                MYMPD_LOG_WARN(NULL, "Unexpected timer type %s", lookup_pfd_type(timer->type));
+        }
     }
 }
 
@@ -226,8 +292,9 @@ static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, st
  * Handles socket errors
  * @param mympd_state pointer to mympd state
  * @param i fd number from pfds array
+ * @param requests list to append requests from the mympd_api_queue
  */
-static void handle_socket_error(struct t_mympd_state *mympd_state, nfds_t i) {
+static void handle_socket_error(struct t_mympd_state *mympd_state, nfds_t i, struct t_list *requests) {
     MYMPD_LOG_ERROR(NULL, "Socket error %s for %d of type %s", lookup_pfd_revents(mympd_state->pfds.fds[i].revents),
         mympd_state->pfds.fds[i].fd, lookup_pfd_type(mympd_state->pfds.fd_types[i]));
     switch (mympd_state->pfds.fd_types[i]) {
@@ -240,6 +307,14 @@ static void handle_socket_error(struct t_mympd_state *mympd_state, nfds_t i) {
         case PFD_TYPE_QUEUE:
             event_fd_close(mympd_state->pfds.fds[i].fd);
             mympd_api_queue->event_fd = event_eventfd_create();
+            // do not lose requests signaled through the closed eventfd
+            shift_requests(mympd_state, requests);
+            break;
+        case PFD_TYPE_TIMER:
+            event_fd_close(mympd_state->pfds.fds[i].fd);
+            mympd_state->timer_heap.fd = mympd_timer_create(CLOCK_MONOTONIC, 0, 0);
+            // the new timerfd must be armed
+            mympd_state->timer_heap.armed = -1;
             break;
         default:
             MYMPD_LOG_DEBUG(NULL, "Closing socket");
@@ -259,10 +334,7 @@ static void populate_pfds(struct t_mympd_state *mympd_state) {
     while (partition_state != NULL) {
         if (partition_state->conn != NULL) {
             event_pfd_add_fd(&mympd_state->pfds, mpd_connection_get_fd(partition_state->conn), PFD_TYPE_PARTITION, partition_state);
-            event_pfd_add_fd(&mympd_state->pfds, partition_state->timer_fd_scrobble, PFD_TYPE_TIMER_SCROBBLE, partition_state);
-            event_pfd_add_fd(&mympd_state->pfds, partition_state->timer_fd_jukebox, PFD_TYPE_TIMER_JUKEBOX, partition_state);
         }
-        event_pfd_add_fd(&mympd_state->pfds, partition_state->timer_fd_mpd_connect, PFD_TYPE_TIMER_MPD_CONNECT, partition_state);
         partition_state = partition_state->next;
     }
     // StickerDB MPD connection
@@ -273,13 +345,9 @@ static void populate_pfds(struct t_mympd_state *mympd_state) {
     }
     // mympd_api_queue
     event_pfd_add_fd(&mympd_state->pfds, mympd_api_queue->event_fd, PFD_TYPE_QUEUE, NULL);
-    // Timer
-    struct t_list_node *current = mympd_state->timer_list.list.head;
-    while (current != NULL) {
-        struct t_timer_node *current_timer = (struct t_timer_node *)current->user_data;
-        event_pfd_add_fd(&mympd_state->pfds, current_timer->fd, PFD_TYPE_TIMER, NULL);
-        current = current->next;
-    }
+    // Timer heap with the myMPD, partition and stickerdb timers
+    mympd_timer_heap_arm(&mympd_state->timer_heap);
+    event_pfd_add_fd(&mympd_state->pfds, mympd_state->timer_heap.fd, PFD_TYPE_TIMER, NULL);
     #ifdef MYMPD_DEBUG
         MYMPD_LOG_DEBUG(NULL, "Polling %lu fds", mympd_state->pfds.len);
     #endif
@@ -11,8 +11,11 @@
 #include "compile_time.h"
 #include "src/mympd_api/mympd_api_handler.h"
 
+#include "src/lib/album_index.h"
+#include "src/lib/album_results.h"
 #include "src/lib/api.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/cache_rax_song.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/list.h"
 #include "src/lib/log.h"
@@ -20,6 +23,7 @@
 #include "src/lib/mympd_state.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/smartpls.h"
+#include "src/lib/state_store.h"
 #include "src/lib/timer.h"
 #include "src/lib/utility.h"
 #include "src/lib/validate.h"
@@ -35,11 +39,11 @@
 #include "src/mpd_client/search.h"
 #include "src/mpd_client/stickerdb.h"
 #include "src/mpd_worker/mpd_worker.h"
+#include "src/mpd_worker/pool.h"
 #include "src/mympd_api/albumart.h"
 #include "src/mympd_api/browse.h"
 #include "src/mympd_api/channel.h"
 #include "src/mympd_api/database.h"
-#include "src/mympd_api/filesystem.h"
 #include "src/mympd_api/home.h"
 #include "src/mympd_api/jukebox.h"
 #include "src/mympd_api/last_played.h"
@@ -73,6 +77,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Private definitions
+ */
+
+static void mympd_api_handler_request(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, struct t_work_request *request);
+
+/**
+ * Public functions
+ */
+
 /**
  * Central myMPD api handler function
  * @param mympd_state pointer to mympd state
@@ -80,6 +94,30 @@
  * @param request pointer to the jsonrpc request struct
  */
 void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, struct t_work_request *request) {
+    //read-only requests are handled by the mpd_worker pool
+    if (mpd_worker_pool_push(mympd_state, request) == true) {
+        return;
+    }
+    //parse the request once for all json_get_* calls
+    json_index_create(request->data);
+    //large list responses are streamed to the webserver
+    response_stream_begin(request);
+    mympd_api_handler_request(mympd_state, partition_state, request);
+    response_stream_end();
+    json_index_free();
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Handles the request, the request is freed or pushed to the mpd_worker thread
+ * @param mympd_state pointer to mympd state
+ * @param partition_state pointer to partition state
+ * @param request pointer to the jsonrpc request struct
+ */
+static void mympd_api_handler_request(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, struct t_work_request *request) {
     //some buffer variables
     unsigned uint_buf1;
     unsigned uint_buf2;
@@ -119,6 +157,7 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
 
     switch(request->cmd_id) {
     // methods that are delegated to a new worker thread
+        case INTERNAL_API_CACHE_DISK_NEGATIVE_CLEAR:
         case INTERNAL_API_JUKEBOX_REFILL:
         case INTERNAL_API_JUKEBOX_REFILL_ADD:
         case MYMPD_API_CACHE_DISK_CROP:
@@ -171,30 +210,71 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             break;
     // Album cache
         case INTERNAL_API_ALBUMCACHE_SKIPPED:
+            mympd_state->album_cache.building = false;
+            if (request->extra != NULL) {
+                // index for the album cache read at startup
+                if (mympd_state->album_index == NULL) {
+                    mympd_state->album_index = (struct t_album_index *) request->extra;
+                }
+                else {
+                    album_index_free(request->extra);
+                }
+            }
+            break;
         case INTERNAL_API_ALBUMCACHE_ERROR:
             mympd_state->album_cache.building = false;
             break;
         case INTERNAL_API_ALBUMCACHE_CREATED:
             mympd_state->album_cache.building = false;
             if (request->extra != NULL) {
+                struct t_album_cache_update *update = (struct t_album_cache_update *) request->extra;
                 //first clear the jukebox queues - it has references to the album cache
                 MYMPD_LOG_INFO(partition_state->name, "Clearing jukebox queues");
                 jukebox_clear_all(mympd_state);
                 //free the old album cache and replace it with the freshly generated one
                 if (cache_get_write_lock(&mympd_state->album_cache) == false) {
-                    album_cache_free_rt(request->extra);
+                    album_index_free(update->album_index);
+                    album_cache_free_rt(update->album_cache);
+                    FREE_PTR(update);
                     send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_ERROR, MPD_PARTITION_ALL, "Album cache could not be replaced");
                     break;
                 }
+                album_results_clear(&mympd_state->album_results);
+                mympd_state->album_index = album_index_free(mympd_state->album_index);
                 album_cache_free(&mympd_state->album_cache);
-                mympd_state->album_cache.cache = (rax *) request->extra;
+                mympd_state->album_cache.cache = update->album_cache;
                 cache_release_lock(&mympd_state->album_cache);
+                //the index was built by the mpd_worker thread
+                mympd_state->album_index = update->album_index;
+                FREE_PTR(update);
                 MYMPD_LOG_INFO(partition_state->name, "Album cache was replaced");
             }
             else {
                 MYMPD_LOG_ERROR(partition_state->name, "Album cache is NULL");
             }
             break;
+    // Song cache
+        case INTERNAL_API_SONGCACHE_CREATED:
+            if (request->extra != NULL) {
+                //free the old song cache and replace it with the freshly generated one
+                struct t_cache *new_song_cache = (struct t_cache *) request->extra;
+                if (cache_get_write_lock(&mympd_state->song_cache) == false) {
+                    song_cache_free(new_song_cache);
+                    FREE_PTR(new_song_cache);
+                    send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_ERROR, MPD_PARTITION_ALL, "Song cache could not be replaced");
+                    break;
+                }
+                song_cache_free(&mympd_state->song_cache);
+                mympd_state->song_cache.cache = new_song_cache->cache;
+                mympd_state->song_cache.strings = new_song_cache->strings;
+                cache_release_lock(&mympd_state->song_cache);
+                FREE_PTR(new_song_cache);
+                MYMPD_LOG_INFO(partition_state->name, "Song cache was replaced");
+            }
+            else {
+                MYMPD_LOG_ERROR(partition_state->name, "Song cache is NULL");
+            }
+            break;
     // Misc
         case MYMPD_API_LOGLEVEL:
             if (json_get_int(request->data, "$.params.loglevel", 0, 7, &int_buf1, &parse_error) == true) {
@@ -236,7 +316,7 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             response->data = mympd_api_channel_messages_read(partition_state, response->data, request->id);
             break;
         case MYMPD_API_STATS:
-            response->data = mympd_api_stats_get(partition_state, response->data, request->id);
+            response->data = mympd_api_stats_get(partition_state, &mympd_state->loop_stats, response->data, request->id);
             break;
     // Tagart
         case INTERNAL_API_TAGART:
@@ -391,10 +471,18 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             break;
         }
         case MYMPD_API_SETTINGS_SET: {
-            if (json_iterate_object(request->data, "$.params", mympd_api_settings_set, mympd_state, NULL, NULL, 1000, &parse_error) == true) {
+            rc = json_iterate_object(request->data, "$.params", mympd_api_settings_set, mympd_state, NULL, NULL, 1000, &parse_error);
+            // write all changed settings at once
+            if (state_store_save(&mympd_state->state_store) == false) {
+                response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+                    JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Could not save settings");
+                break;
+            }
+            if (rc == true) {
                 if (partition_state->conn_state == MPD_CONNECTED) {
                     //feature detection
                     mpd_client_mpd_features(mympd_state, partition_state);
+                    mpd_worker_pool_configure(mympd_state);
                 }
                 else {
                     settings_to_webserver(mympd_state);
@@ -413,7 +501,14 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                     JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Can't set playback options: MPD not connected");
                 break;
             }
-            if (json_iterate_object(request->data, "$.params", mympd_api_settings_mpd_options_set, partition_state, NULL, NULL, 100, &parse_error) == true) {
+            rc = json_iterate_object(request->data, "$.params", mympd_api_settings_mpd_options_set, partition_state, NULL, NULL, 100, &parse_error);
+            // write all changed settings at once
+            if (state_store_save(&partition_state->state_store) == false) {
+                response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+                    JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Could not save settings");
+                break;
+            }
+            if (rc == true) {
                 sdsclear(partition_state->jukebox.last_error);
                 if (partition_state->jukebox.mode != JUKEBOX_OFF &&
                     partition_state->queue_length == 0)
@@ -457,7 +552,13 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
         case MYMPD_API_CONNECTION_SAVE: {
             sds old_mpd_settings = sdscatfmt(sdsempty(), "%S%i%S", mympd_state->mpd_state->mpd_host, mympd_state->mpd_state->mpd_port, mympd_state->mpd_state->mpd_pass);
             sds old_stickerdb_settings = sdscatfmt(sdsempty(), "%S%i%S", mympd_state->stickerdb->mpd_state->mpd_host, mympd_state->stickerdb->mpd_state->mpd_port, mympd_state->stickerdb->mpd_state->mpd_pass);
-            if (json_iterate_object(request->data, "$.params", mympd_api_settings_connection_save, mympd_state, NULL, NULL, 100, &parse_error) == true) {
+            rc = json_iterate_object(request->data, "$.params", mympd_api_settings_connection_save, mympd_state, NULL, NULL, 100, &parse_error);
+            // write all changed settings at once
+            if (state_store_save(&mympd_state->state_store) == false) {
+                response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+                    JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Could not save settings");
+            }
+            else if (rc == true) {
                 // primary mpd connection
                 sds new_mpd_settings = sdscatfmt(sdsempty(), "%S%i%S", mympd_state->mpd_state->mpd_host, mympd_state->mpd_state->mpd_port, mympd_state->mpd_state->mpd_pass);
                 if (strcmp(old_mpd_settings, new_mpd_settings) != 0) {
@@ -468,11 +569,13 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                     partitions_list_clear(mympd_state);
                     //remove caches
                     album_cache_remove(config->workdir);
-                    mympd_timer_set(mympd_state->partition_state->timer_fd_mpd_connect, 0, 5);
+                    song_cache_remove(config->workdir);
+                    mympd_timer_entry_set(&mympd_state->partition_state->timer_mpd_connect, 0, 5);
                 }
                 else if (partition_state->conn_state == MPD_CONNECTED) {
                     //feature detection
                     mpd_client_mpd_features(mympd_state, partition_state);
+                    mpd_worker_pool_configure(mympd_state);
                 }
                 FREE_SDS(new_mpd_settings);
 
@@ -1316,7 +1419,7 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                 json_get_string(request->data, "$.params.expression", 0, NAME_LEN_MAX, &sds_buf1, vcb_issearchexpression, &parse_error) == true &&
                 json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, &parse_error) == true)
             {
-                response->data = mympd_api_last_played_list(partition_state, mympd_state->stickerdb, response->data, request->id, uint_buf1, uint_buf2, sds_buf1, &tagcols);
+                response->data = mympd_api_last_played_list(partition_state, mympd_state->stickerdb, &mympd_state->song_cache, response->data, request->id, uint_buf1, uint_buf2, sds_buf1, &tagcols);
             }
             break;
         }
@@ -1356,37 +1459,15 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                 response->data = mympd_api_playlist_delete_all(partition_state, response->data, request->id, criteria);
             }
             break;
-        case MYMPD_API_PLAYLIST_LIST: {
-            struct t_fields tagcols;
-            fields_reset(&tagcols);
-            if (json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, &parse_error) == true &&
-                json_get_string(request->data, "$.params.searchstr", 0, NAME_LEN_MAX, &sds_buf1, vcb_isname, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.type", 0, 2, &uint_buf3, &parse_error) == true &&
-                json_get_string(request->data, "$.params.sort", 0, NAME_LEN_MAX, &sds_buf2, vcb_ismpdsort, &parse_error) == true &&
-                json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, &parse_error) == true &&
-                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, &parse_error) == true)
-            {
-                enum playlist_sort_types sort = playlist_parse_sort(sds_buf2);
-                response->data = mympd_api_playlist_list(partition_state, mympd_state->stickerdb, response->data, request->cmd_id,
-                    uint_buf1, uint_buf2, sds_buf1, uint_buf3, sort, bool_buf1, &tagcols);
-            }
-            break;
-        }
-        case MYMPD_API_PLAYLIST_CONTENT_LIST: {
-            struct t_fields tagcols;
-            fields_reset(&tagcols);
-            if (json_get_string(request->data, "$.params.plist", 1, FILENAME_LEN_MAX, &sds_buf1, vcb_isfilename, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, &parse_error) == true &&
-                json_get_string(request->data, "$.params.expression", 0, NAME_LEN_MAX, &sds_buf2, vcb_issearchexpression, &parse_error) == true &&
-                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, &parse_error) == true)
-            {
-                response->data = mympd_api_playlist_content_search(partition_state, mympd_state->stickerdb, response->data, request->id,
-                    sds_buf1, uint_buf1, uint_buf2, sds_buf2, &tagcols);
-            }
+        case MYMPD_API_DATABASE_FILESYSTEM_LIST:
+        case MYMPD_API_DATABASE_SEARCH:
+        case MYMPD_API_DATABASE_TAG_LIST:
+        case MYMPD_API_PLAYLIST_LIST:
+        case MYMPD_API_PLAYLIST_CONTENT_LIST:
+            //read-only requests that are not routed to the mpd_worker pool
+            response->data = mpd_worker_pool_api_request(partition_state, mympd_state->stickerdb, &mympd_state->song_cache,
+                mympd_state->booklet_name, mympd_state->info_txt_name, response->data, request, &parse_error);
             break;
-        }
         case MYMPD_API_PLAYLIST_CONTENT_APPEND_URIS: {
             struct t_list uris;
             list_init(&uris);
@@ -1661,57 +1742,6 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                 response->data = mympd_api_database_update(partition_state, response->data, request->cmd_id, request->id, sds_buf1);
             }
             break;
-        case MYMPD_API_DATABASE_FILESYSTEM_LIST: {
-            struct t_fields tagcols;
-            fields_reset(&tagcols);
-            if (json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, &parse_error) == true &&
-                json_get_string(request->data, "$.params.searchstr", 0, NAME_LEN_MAX, &sds_buf1, vcb_isname, &parse_error) == true &&
-                json_get_string(request->data, "$.params.path", 1, FILEPATH_LEN_MAX, &sds_buf2, vcb_isfilepath, &parse_error) == true &&
-                json_get_string(request->data, "$.params.type", 1, 5, &sds_buf3, vcb_isalnum, &parse_error) == true &&
-                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, &parse_error) == true)
-            {
-                if (strcmp(sds_buf3, "plist") == 0) {
-                    sds expr = sdslen(sds_buf1) > 0
-                        ? escape_mpd_search_expression(sdsempty(), "file", "contains", sds_buf1)
-                        : sdsempty();
-                    response->data = mympd_api_playlist_content_search(partition_state, mympd_state->stickerdb, response->data, request->id,
-                        sds_buf2, uint_buf1, uint_buf2, expr, &tagcols);
-                    FREE_SDS(expr);
-                }
-                else {
-                    response->data = mympd_api_browse_filesystem(mympd_state, partition_state, response->data, request->id, sds_buf2,
-                        uint_buf1, uint_buf2, sds_buf1, &tagcols);
-                }
-            }
-            break;
-        }
-        case MYMPD_API_DATABASE_SEARCH: {
-            struct t_fields tagcols;
-            fields_reset(&tagcols);
-            if (json_get_string(request->data, "$.params.expression", 0, EXPRESSION_LEN_MAX, &sds_buf1, vcb_issearchexpression, &parse_error) == true &&
-                json_get_string(request->data, "$.params.sort", 0, NAME_LEN_MAX, &sds_buf2, vcb_ismpdsort, &parse_error) == true &&
-                json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.limit", 0, MPD_RESULTS_MAX, &uint_buf2, &parse_error) == true &&
-                json_get_fields(request->data, "$.params.fields", &tagcols, FIELDS_MAX, &parse_error) == true)
-            {
-                response->data = mympd_api_search_songs(partition_state, mympd_state->stickerdb, response->data, request->id,
-                        sds_buf1, sds_buf2, bool_buf1, uint_buf1, uint_buf2, &tagcols, &rc);
-            }
-            break;
-        }
-        case MYMPD_API_DATABASE_TAG_LIST:
-            if (json_get_uint(request->data, "$.params.offset", 0, MPD_PLAYLIST_LENGTH_MAX, &uint_buf1, &parse_error) == true &&
-                json_get_uint(request->data, "$.params.limit", MPD_RESULTS_MIN, MPD_RESULTS_MAX, &uint_buf2, &parse_error) == true &&
-                json_get_string(request->data, "$.params.searchstr", 0, NAME_LEN_MAX, &sds_buf1, vcb_isname, &parse_error) == true &&
-                json_get_string(request->data, "$.params.tag", 1, NAME_LEN_MAX, &sds_buf2, vcb_ismpdtag_or_any, &parse_error) == true &&
-                json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, &parse_error) == true)
-            {
-                response->data = mympd_api_browse_tag_list(partition_state, response->data, request->id,
-                        sds_buf1, sds_buf2, uint_buf1, uint_buf2, bool_buf1);
-            }
-            break;
         case MYMPD_API_DATABASE_ALBUM_LIST: {
             struct t_fields tagcols;
             fields_reset(&tagcols);
@@ -1750,6 +1780,12 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             break;
         case MYMPD_API_PARTITION_SAVE:
             rc = json_iterate_object(request->data, "$.params", mympd_api_settings_partition_set, partition_state, NULL, NULL, 1000, &parse_error);
+            // write all changed settings at once
+            if (state_store_save(&partition_state->state_store) == false) {
+                response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+                    JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Could not save settings");
+                break;
+            }
             if (rc == true) {
                 settings_to_webserver(mympd_state);
                 response->data = jsonrpc_respond_ok(response->data, request->cmd_id, request->id, JSONRPC_FACILITY_MPD);
@@ -11,9 +11,9 @@
 #include "compile_time.h"
 #include "src/mympd_api/playlists.h"
 
-#include "dist/utf8/utf8.h"
 #include "src/lib/api.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/casefold.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/list.h"
@@ -562,7 +562,9 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_PLAYLIST_LIST;
     rax *entity_list = raxNew();
-    size_t search_len = sdslen(searchstr);
+    //fold the search string once for all playlist names
+    sds searchstr_folded = casefold_cat(sdsempty(), searchstr);
+    size_t search_len = sdslen(searchstr_folded);
     unsigned real_limit = offset + limit;
     sds key = sdsempty();
 
@@ -577,7 +579,7 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
         while ((pl = mpd_recv_playlist(partition_state->conn)) != NULL) {
             const char *plpath = mpd_playlist_get_path(pl);
             bool smartpls = is_smartpls(partition_state->config->workdir, plpath);
-            if ((search_len == 0 || utf8casestr(plpath, searchstr) != NULL) &&
+            if ((search_len == 0 || casefold_contains(plpath, searchstr_folded, search_len) == true) &&
                 (type == PLTYPE_ALL || (type == PLTYPE_STATIC && smartpls == false) || (type == PLTYPE_SMART && smartpls == true)))
             {
                 struct t_pl_data *data = malloc_assert(sizeof(struct t_pl_data));
@@ -602,6 +604,7 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
         //free result
         rax_free_data(entity_list, free_t_pl_data);
         FREE_SDS(key);
+        FREE_SDS(searchstr_folded);
         //return error message
         return buffer;
     }
@@ -615,7 +618,7 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
             struct dirent *next_file;
             while ((next_file = readdir(smartpls_dir)) != NULL ) {
                 if (next_file->d_type == DT_REG &&
-                    (search_len == 0 || utf8casestr(next_file->d_name, searchstr) != NULL)
+                    (search_len == 0 || casefold_contains(next_file->d_name, searchstr_folded, search_len) == true)
                 ) {
                     struct t_pl_data *data = malloc_assert(sizeof(struct t_pl_data));
                     data->last_modified = smartpls_get_mtime(partition_state->config->workdir, next_file->d_name);
@@ -643,6 +646,7 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
         FREE_SDS(smartpls_path);
     }
     FREE_SDS(key);
+    FREE_SDS(searchstr_folded);
     buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
     buffer = sdscat(buffer,"\"data\":[");
 
@@ -712,9 +716,8 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
  * @param buffer already allocated sds string to append the response
  * @param song mpd song to print
  * @param pos position in playlist
- * @param stickers print stickers?
+ * @param stickers stickers of the rows from stickerdb_get_all_multi or NULL to not print stickers
  * @param partition_state pointer to partition state
- * @param stickerdb pointer to stickerdb state
  * @param tagcols columns to print
  * @param last_played_max played time from last played song
  * @param last_played_song_uri last played song uri
@@ -722,9 +725,8 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
  * @param last_played_song_title last played song title tag
  * @return pointer to buffer
  */
-static sds print_plist_entry(sds buffer, struct mpd_song *song, unsigned pos, bool stickers,
-        struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
-        const struct t_fields *tagcols, time_t *last_played_max, sds *last_played_song_uri,
+static sds print_plist_entry(sds buffer, struct mpd_song *song, unsigned pos, rax *stickers,
+        struct t_partition_state *partition_state, const struct t_fields *tagcols, time_t *last_played_max, sds *last_played_song_uri,
         unsigned *last_played_pos, sds *last_played_song_title)
 {
     const char *uri = mpd_song_get_uri(song);
@@ -734,18 +736,22 @@ static sds print_plist_entry(sds buffer, struct mpd_song *song, unsigned pos, bo
         : tojson_char(buffer, "Type", "song", true);
     buffer = tojson_uint(buffer, "Pos", pos, true);
     buffer = print_song_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, song);
-    if (stickers == true) {
+    if (stickers != NULL) {
         buffer = sdscatlen(buffer, ",", 1);
-        struct t_sticker sticker;
-        stickerdb_get_all_batch(stickerdb, STICKER_TYPE_SONG, uri, &sticker, false);
-        buffer = mympd_api_sticker_print(buffer, &sticker, &tagcols->stickers);
-        if (sticker.mympd[STICKER_LAST_PLAYED] > *last_played_max) {
-            *last_played_max = (time_t)sticker.mympd[STICKER_LAST_PLAYED];
+        struct t_sticker empty;
+        sticker_struct_init(&empty);
+        struct t_sticker *sticker = &empty;
+        void *data;
+        if (raxFind(stickers, (unsigned char *)uri, strlen(uri), &data) == 1) {
+            sticker = (struct t_sticker *)data;
+        }
+        buffer = mympd_api_sticker_print(buffer, sticker, &tagcols->stickers);
+        if (sticker->mympd[STICKER_LAST_PLAYED] > *last_played_max) {
+            *last_played_max = (time_t)sticker->mympd[STICKER_LAST_PLAYED];
             *last_played_pos = pos;
             *last_played_song_uri = sds_replace(*last_played_song_uri, uri);
             *last_played_song_title = sds_replace(*last_played_song_title, mpd_song_get_tag(song, MPD_TAG_TITLE, 0));
         }
-        sticker_struct_clear(&sticker);
     }
     buffer = sdscatlen(buffer, "}", 1);
     return buffer;
@@ -782,6 +788,8 @@ sds mympd_api_playlist_content_search(struct t_partition_state *partition_state,
     if (print_stickers == true) {
         stickerdb_exit_idle(stickerdb);
     }
+    struct t_list songs;
+    list_init(&songs);
     buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
     buffer = sdscat(buffer,"\"data\":[");
     if (partition_state->mpd_state->feat.listplaylist_range == true) {
@@ -792,12 +800,8 @@ sds mympd_api_playlist_content_search(struct t_partition_state *partition_state,
                 
                 while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
                     total_time += mpd_song_get_duration(song);
-                    if (entities_returned++) {
-                        buffer= sdscatlen(buffer, ",", 1);
-                    }
-                    buffer = print_plist_entry(buffer, song, entity_count, print_stickers, partition_state, stickerdb, tagcols,
-                        &last_played_max, &last_played_song_uri, &last_played_pos, &last_played_song_title);
-                    mpd_song_free(song);
+                    entities_returned++;
+                    list_push(&songs, mpd_song_get_uri(song), entity_count, NULL, song);
                     entity_count++;
                 }
             }
@@ -816,11 +820,8 @@ sds mympd_api_playlist_content_search(struct t_partition_state *partition_state,
             if (mpd_search_commit(partition_state->conn) == true) {
                 while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
                     total_time += mpd_song_get_duration(song);
-                    if (entities_returned++) {
-                        buffer= sdscatlen(buffer, ",", 1);
-                    }
-                    buffer = print_plist_entry(buffer, song, mpd_song_get_pos(song), print_stickers, partition_state, stickerdb, tagcols,
-                        &last_played_max, &last_played_song_uri, &last_played_pos, &last_played_song_title);
+                    entities_returned++;
+                    list_push(&songs, mpd_song_get_uri(song), mpd_song_get_pos(song), NULL, song);
                 }
             }
             entities_found = entities_returned;
@@ -830,28 +831,47 @@ sds mympd_api_playlist_content_search(struct t_partition_state *partition_state,
         if (mpd_send_list_playlist_meta(partition_state->conn, plist)) {
             struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
             while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+                bool keep = false;
                 if (search_expression_song(song, expr_list, &tagcols->mpd_tags) == true) {
                     total_time += mpd_song_get_duration(song);
                     if (entities_found >= offset) {
-                        if (entities_returned++) {
-                            buffer= sdscatlen(buffer, ",", 1);
-                        }
-                        buffer = print_plist_entry(buffer, song, entity_count, print_stickers, partition_state, stickerdb, tagcols,
-                            &last_played_max, &last_played_song_uri, &last_played_pos, &last_played_song_title);
+                        entities_returned++;
+                        list_push(&songs, mpd_song_get_uri(song), entity_count, NULL, song);
+                        keep = true;
                     }
                     entities_found++;
                     if (entities_found == real_limit) {
-                        mpd_song_free(song);
+                        if (keep == false) {
+                            mpd_song_free(song);
+                        }
                         break;
                     }
                 }
                 entity_count++;
-                mpd_song_free(song);
+                if (keep == false) {
+                    mpd_song_free(song);
+                }
             }
             free_search_expression_list(expr_list);
         }
     }
     mpd_response_finish(partition_state->conn);
+    // get the stickers for all rows at once
+    rax *stickers = print_stickers == true
+        ? stickerdb_get_all_multi(stickerdb, STICKER_TYPE_SONG, &songs, false)
+        : NULL;
+    struct t_list_node *current = songs.head;
+    while (current != NULL) {
+        buffer = print_plist_entry(buffer, (struct mpd_song *)current->user_data, (unsigned)current->value_i, stickers,
+            partition_state, tagcols, &last_played_max, &last_played_song_uri, &last_played_pos, &last_played_song_title);
+        buffer = response_stream_flush(buffer);
+        current = current->next;
+        if (current != NULL) {
+            buffer = sdscatlen(buffer, ",", 1);
+        }
+    }
+    stickerdb_free_all_multi(stickers);
+    list_clear_user_data(&songs, list_free_cb_song_user_data);
     if (print_stickers == true) {
         stickerdb_enter_idle(stickerdb);
     }
@@ -34,7 +34,7 @@
 static bool add_queue_search_adv_params(struct t_partition_state *partition_state,
         sds sort, bool sortdesc, unsigned offset, unsigned limit);
 sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        sds buffer, const struct t_fields *tagcols, bool print_stickers, struct mpd_song *song);
+        sds buffer, const struct t_fields *tagcols, rax *stickers, struct mpd_song *song);
 
 /**
  * Public functions
@@ -839,14 +839,28 @@ sds mympd_api_queue_list(struct t_mympd_state *mympd_state, struct t_partition_s
         unsigned total_time = 0;
         unsigned entities_returned = 0;
         struct mpd_song *song;
+        struct t_list songs;
+        list_init(&songs);
         while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+            list_push(&songs, mpd_song_get_uri(song), 0, NULL, song);
+        }
+        // get the stickers for all rows at once
+        rax *stickers = print_stickers == true
+            ? stickerdb_get_all_multi(mympd_state->stickerdb, STICKER_TYPE_SONG, &songs, tagcols->stickers.user_defined)
+            : NULL;
+        struct t_list_node *current = songs.head;
+        while (current != NULL) {
+            song = (struct mpd_song *)current->user_data;
             if (entities_returned++) {
                 buffer = sdscatlen(buffer, ",", 1);
             }
-            buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, print_stickers, song);
+            buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, stickers, song);
+            buffer = response_stream_flush(buffer);
             total_time += mpd_song_get_duration(song);
-            mpd_song_free(song);
+            current = current->next;
         }
+        stickerdb_free_all_multi(stickers);
+        list_clear_user_data(&songs, list_free_cb_song_user_data);
 
         buffer = sdscatlen(buffer, "],", 2);
         buffer = tojson_uint(buffer, "totalTime", total_time, true);
@@ -911,17 +925,17 @@ sds mympd_api_queue_search(struct t_mympd_state *mympd_state, struct t_partition
         const unsigned real_limit = offset + limit;
         unsigned entities_returned = 0;
         unsigned entity_count = 0;
+        struct t_list songs;
+        list_init(&songs);
         while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
             if (partition_state->mpd_state->feat.advqueue == true ||
                 entity_count >= offset)
             {
-                if (entities_returned++) {
-                    buffer= sdscatlen(buffer, ",", 1);
-                }
-                buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, print_stickers, song);
-                total_time += mpd_song_get_duration(song);
+                list_push(&songs, mpd_song_get_uri(song), 0, NULL, song);
+            }
+            else {
+                mpd_song_free(song);
             }
-            mpd_song_free(song);
             if (partition_state->mpd_state->feat.advqueue == false) {
                 entity_count++;
                 if (entity_count == real_limit) {
@@ -929,6 +943,23 @@ sds mympd_api_queue_search(struct t_mympd_state *mympd_state, struct t_partition
                 }
             }
         }
+        // get the stickers for all rows at once
+        rax *stickers = print_stickers == true
+            ? stickerdb_get_all_multi(mympd_state->stickerdb, STICKER_TYPE_SONG, &songs, tagcols->stickers.user_defined)
+            : NULL;
+        struct t_list_node *current = songs.head;
+        while (current != NULL) {
+            song = (struct mpd_song *)current->user_data;
+            if (entities_returned++) {
+                buffer= sdscatlen(buffer, ",", 1);
+            }
+            buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, stickers, song);
+            buffer = response_stream_flush(buffer);
+            total_time += mpd_song_get_duration(song);
+            current = current->next;
+        }
+        stickerdb_free_all_multi(stickers);
+        list_clear_user_data(&songs, list_free_cb_song_user_data);
         buffer = sdscatlen(buffer, "],", 2);
         buffer = tojson_uint(buffer, "totalTime", total_time, true);
         if (sdslen(expression) == 0) {
@@ -1019,12 +1050,12 @@ static bool add_queue_search_adv_params(struct t_partition_state *partition_stat
  * @param partition_state pointer to partition state
  * @param buffer already allocated sds string to append the response
  * @param tagcols columns to print
- * @param print_stickers Print stickers?
+ * @param stickers stickers of the rows from stickerdb_get_all_multi or NULL to not print stickers
  * @param song pointer to mpd song struct
  * @return pointer to buffer
  */
 sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        sds buffer, const struct t_fields *tagcols, bool print_stickers, struct mpd_song *song)
+        sds buffer, const struct t_fields *tagcols, rax *stickers, struct mpd_song *song)
 {
     buffer = sdscatlen(buffer, "{", 1);
     buffer = tojson_uint(buffer, "id", mpd_song_get_id(song), true);
@@ -1052,8 +1083,8 @@ sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partition_stat
     else {
         buffer = tojson_char(buffer, "Type", "song", false);
     }
-    if (print_stickers == true) {
-        buffer = mympd_api_sticker_get_print_batch(buffer, mympd_state->stickerdb, STICKER_TYPE_SONG, uri, &tagcols->stickers);
+    if (stickers != NULL) {
+        buffer = mympd_api_sticker_print_multi(buffer, stickers, uri, &tagcols->stickers);
     }
     buffer = sdscatlen(buffer, "}", 1);
     return buffer;
@@ -11,18 +11,41 @@
 #include "compile_time.h"
 #include "src/mympd_api/search.h"
 
+#include "dist/rax/rax.h"
 #include "src/lib/api.h"
+#include "src/lib/cache_rax_song.h"
 #include "src/lib/jsonrpc.h"
+#include "src/lib/log.h"
+#include "src/lib/rax_extras.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/search.h"
+#include "src/lib/utility.h"
 #include "src/mpd_client/errorhandler.h"
 #include "src/mpd_client/search.h"
 #include "src/mpd_client/stickerdb.h"
 #include "src/mpd_client/tags.h"
 #include "src/mympd_api/sticker.h"
 
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+static sds search_songs_local(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        struct t_cache *song_cache, sds buffer, const struct t_list *expr_list, const char *sort, bool sortdesc,
+        unsigned offset, unsigned limit, const struct t_fields *tagcols, unsigned *total_entities,
+        unsigned *entities_returned);
+
+/**
+ * Public functions
+ */
+
 /**
  * Searches the mpd database for songs by expression and returns an jsonrpc result
  * @param partition_state pointer to partition specific states
  * @param stickerdb pointer to stickerdb state
+ * @param song_cache pointer to the song cache, the search runs against MPD if it is not ready
  * @param buffer already allocated sds string to append the result
  * @param request_id jsonrpc request id
  * @param expression mpd search expression
@@ -34,14 +57,37 @@
  * @param result pointer to bool to set returncode
  * @return pointer to buffer
  */
-sds mympd_api_search_songs(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb, 
-        sds buffer, unsigned request_id, const char *expression, const char *sort, bool sortdesc,
+sds mympd_api_search_songs(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        struct t_cache *song_cache, sds buffer, unsigned request_id, const char *expression, const char *sort, bool sortdesc,
         unsigned offset, unsigned limit, const struct t_fields *tagcols, bool *result)
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_DATABASE_SEARCH;
     buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
     buffer = sdscat(buffer, "\"data\":[");
 
+    if (song_cache->cache != NULL) {
+        struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+        if (search_expression_is_complete(expression, expr_list) == true) {
+            unsigned total_entities = 0;
+            unsigned entities_returned = 0;
+            buffer = search_songs_local(partition_state, stickerdb, song_cache, buffer, expr_list,
+                sort, sortdesc, offset, limit, tagcols, &total_entities, &entities_returned);
+            free_search_expression_list(expr_list);
+            *result = true;
+            buffer = sdscatlen(buffer, "],", 2);
+            buffer = tojson_uint(buffer, "totalEntities", total_entities, true);
+            buffer = tojson_uint(buffer, "offset", offset, true);
+            buffer = tojson_uint(buffer, "returnedEntities", entities_returned, true);
+            buffer = tojson_char(buffer, "expression", expression, true);
+            buffer = tojson_char(buffer, "sort", sort, true);
+            buffer = tojson_bool(buffer, "sortdesc", sortdesc, false);
+            buffer = jsonrpc_end(buffer);
+            return buffer;
+        }
+        MYMPD_LOG_DEBUG(partition_state->name, "Expression not supported by the song cache, searching in MPD");
+        free_search_expression_list(expr_list);
+    }
+
     unsigned real_limit = limit == 0 ? offset + MPD_PLAYLIST_LENGTH_MAX : offset + limit;
     if (mpd_search_db_songs(partition_state->conn, false) == false ||
         mpd_search_add_expression(partition_state->conn, expression) == false ||
@@ -97,3 +143,124 @@ sds mympd_api_search_songs(struct t_partition_state *partition_state, struct t_s
     buffer = jsonrpc_end(buffer);
     return buffer;
 }
+
+/**
+ * Private functions
+ */
+
+/**
+ * Searches the song cache for songs by expression and prints the matching window
+ * @param partition_state pointer to partition specific states
+ * @param stickerdb pointer to stickerdb state
+ * @param song_cache pointer to the song cache
+ * @param buffer already allocated sds string to append the songs
+ * @param expr_list parsed search expression
+ * @param sort tag to sort
+ * @param sortdesc false = ascending, true = descending
+ * @param offset result offset
+ * @param limit max number of results to return
+ * @param tagcols tags to return
+ * @param total_entities pointer to set the number of all matching songs
+ * @param entities_returned pointer to set the number of printed songs
+ * @return pointer to buffer
+ */
+static sds search_songs_local(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        struct t_cache *song_cache, sds buffer, const struct t_list *expr_list, const char *sort, bool sortdesc,
+        unsigned offset, unsigned limit, const struct t_fields *tagcols, unsigned *total_entities,
+        unsigned *entities_returned)
+{
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    // parse sort tag, no sort tag sorts by uri
+    enum mpd_tag_type sort_tag = MPD_TAG_UNKNOWN;
+    enum sort_by_type sort_by = SORT_BY_TAG;
+    if (sort[0] != '\0') {
+        sort_tag = mpd_tag_name_parse(sort);
+        if (sort_tag != MPD_TAG_UNKNOWN) {
+            sort_tag = get_sort_tag(sort_tag, &partition_state->mpd_state->tags_mympd);
+        }
+        else if (strcmp(sort, "Added") == 0 ||
+                 strcmp(sort, "Last-Modified") == 0)
+        {
+            sort_by = sort[0] == 'A'
+                ? SORT_BY_ADDED
+                : SORT_BY_LAST_MODIFIED;
+            //swap order
+            sortdesc = sortdesc == false
+                ? true
+                : false;
+        }
+        else {
+            MYMPD_LOG_WARN(partition_state->name, "Unknown sort tag: %s", sort);
+        }
+    }
+
+    // filter and sort
+    rax *songs = raxNew();
+    raxIterator iter;
+    raxStart(&iter, song_cache->cache);
+    raxSeek(&iter, "^", NULL, 0);
+    sds key = sdsempty();
+    while (raxNext(&iter)) {
+        const struct t_song_cache_song *song = (struct t_song_cache_song *)iter.data;
+        if (expr_list->length == 0 ||
+            search_expression_cached_song(song, expr_list, &partition_state->mpd_state->tags_search, false) == true)
+        {
+            key = song_cache_get_sort_key(key, sort_by, sort_tag, song);
+            rax_insert_no_dup(songs, key, iter.data);
+            sdsclear(key);
+        }
+    }
+    raxStop(&iter);
+    FREE_SDS(key);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(partition_state->name, "Song cache search");
+    #endif
+
+    // print the requested window
+    unsigned real_limit = limit == 0 ? offset + MPD_PLAYLIST_LENGTH_MAX : offset + limit;
+    bool print_stickers = check_get_sticker(partition_state->mpd_state->feat.stickers, &tagcols->stickers);
+    if (print_stickers == true) {
+        stickerdb_exit_idle(stickerdb);
+    }
+    unsigned entity_count = 0;
+    raxStart(&iter, songs);
+    int (*iterator)(struct raxIterator *iter);
+    if (sortdesc == false) {
+        raxSeek(&iter, "^", NULL, 0);
+        iterator = &raxNext;
+    }
+    else {
+        raxSeek(&iter, "$", NULL, 0);
+        iterator = &raxPrev;
+    }
+    while (iterator(&iter)) {
+        if (entity_count >= offset) {
+            if ((*entities_returned)++) {
+                buffer = sdscatlen(buffer, ",", 1);
+            }
+            struct mpd_song *song = song_cache_to_mpd_song((struct t_song_cache_song *)iter.data);
+            buffer = sdscat(buffer, "{\"Type\": \"song\",");
+            buffer = print_song_tags(buffer, partition_state->mpd_state, &tagcols->mpd_tags, song);
+            if (print_stickers == true) {
+                buffer = mympd_api_sticker_get_print_batch(buffer, stickerdb, STICKER_TYPE_SONG, mpd_song_get_uri(song), &tagcols->stickers);
+            }
+            buffer = sdscatlen(buffer, "}", 1);
+            mpd_song_free(song);
+        }
+        entity_count++;
+        if (entity_count == real_limit) {
+            break;
+        }
+    }
+    raxStop(&iter);
+    if (print_stickers == true) {
+        stickerdb_enter_idle(stickerdb);
+    }
+    *total_entities = (unsigned)songs->numele;
+    raxFree(songs);
+    return buffer;
+}
@@ -13,8 +13,8 @@
 
 #include "src/lib/mympd_state.h"
 
-sds mympd_api_search_songs(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb, 
-        sds buffer, unsigned request_id, const char *expression, const char *sort, bool sortdesc,
+sds mympd_api_search_songs(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
+        struct t_cache *song_cache, sds buffer, unsigned request_id, const char *expression, const char *sort, bool sortdesc,
         unsigned offset, unsigned limit, const struct t_fields *tagcols, bool *result);
 
 #endif
@@ -22,6 +22,7 @@
 #include "src/lib/msg_queue.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/state_files.h"
+#include "src/lib/state_store.h"
 #include "src/lib/utility.h"
 #include "src/lib/validate.h"
 #include "src/mpd_client/errorhandler.h"
@@ -223,10 +224,10 @@ bool mympd_api_settings_connection_save(const char *path, sds key, sds value, in
     }
 
     sds state_filename = camel_to_snake(key);
-    bool rc = state_file_write(mympd_state->config->workdir, DIR_WORK_STATE, state_filename, value);
+    state_store_set(&mympd_state->state_store, state_filename, value);
     FREE_SDS(state_filename);
 
-    return rc;
+    return true;
 }
 
 /**
@@ -302,7 +303,8 @@ bool mympd_api_settings_view_save(struct t_mympd_state *mympd_state, sds view, s
         return false;
     }
     sds view_name = camel_to_snake(view);
-    bool rc = state_file_write(mympd_state->config->workdir, DIR_WORK_STATE, view_name, def);
+    state_store_set(&mympd_state->state_store, view_name, def);
+    bool rc = state_store_save(&mympd_state->state_store);
     FREE_SDS(view_name);
     FREE_SDS(def);
     return rc;
@@ -521,9 +523,9 @@ bool mympd_api_settings_set(const char *path, sds key, sds value, int vtype, val
         return false;
     }
     sds state_filename = camel_to_snake(key);
-    bool rc = state_file_write(mympd_state->config->workdir, DIR_WORK_STATE, state_filename, value);
+    state_store_set(&mympd_state->state_store, state_filename, value);
     FREE_SDS(state_filename);
-    return rc;
+    return true;
 }
 
 /**
@@ -580,9 +582,9 @@ bool mympd_api_settings_partition_set(const char *path, sds key, sds value, int
         return false;
     }
     sds state_filename = camel_to_snake(key);
-    bool rc = state_file_write(partition_state->config->workdir, partition_state->state_dir, state_filename, value);
+    state_store_set(&partition_state->state_store, state_filename, value);
     FREE_SDS(state_filename);
-    return rc;
+    return true;
 }
 
 /**
@@ -823,105 +825,112 @@ bool mympd_api_settings_mpd_options_set(const char *path, sds key, sds value, in
     }
     if (write_state_file == true) {
         sds state_filename = camel_to_snake(key);
-        rc = state_file_write(partition_state->config->workdir, partition_state->state_dir, state_filename, value);
+        state_store_set(&partition_state->state_store, state_filename, value);
         FREE_SDS(state_filename);
+        rc = true;
     }
     return rc;
 }
 
 /**
- * Reads the settings from the state files.
- * If the state file does not exist, it is populated with the default value and created.
+ * Reads the settings from the global state store, it must be already loaded.
+ * If a state does not exist, it is populated with the default value.
+ * Changed states are saved at once.
  * @param mympd_state pointer to the t_mympd_state struct
  */
 void mympd_api_settings_statefiles_global_read(struct t_mympd_state *mympd_state) {
     MYMPD_LOG_NOTICE(NULL, "Reading global states");
-    sds workdir = mympd_state->config->workdir;
+    struct t_state_store *store = &mympd_state->state_store;
     // mpd connection
-    mympd_state->mpd_state->mpd_host = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "mpd_host", mympd_state->mpd_state->mpd_host, vcb_isname, true);
-    mympd_state->mpd_state->mpd_port = state_file_rw_uint(workdir, DIR_WORK_STATE, "mpd_port", mympd_state->mpd_state->mpd_port, MPD_PORT_MIN, MPD_PORT_MAX, true);
-    mympd_state->mpd_state->mpd_pass = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "mpd_pass", mympd_state->mpd_state->mpd_pass, vcb_isname, true);
-    mympd_state->mpd_state->mpd_binarylimit = state_file_rw_uint(workdir, DIR_WORK_STATE, "mpd_binarylimit", mympd_state->mpd_state->mpd_binarylimit, MPD_BINARY_CHUNK_SIZE_MIN, MPD_BINARY_CHUNK_SIZE_MAX, true);
-    mympd_state->mpd_state->mpd_timeout = state_file_rw_uint(workdir, DIR_WORK_STATE, "mpd_timeout", mympd_state->mpd_state->mpd_timeout, MPD_TIMEOUT_MIN, MPD_TIMEOUT_MAX, true);
-    mympd_state->mpd_state->mpd_keepalive = state_file_rw_bool(workdir, DIR_WORK_STATE, "mpd_keepalive", mympd_state->mpd_state->mpd_keepalive, true);
+    mympd_state->mpd_state->mpd_host = state_store_rw_string_sds(store, "mpd_host", mympd_state->mpd_state->mpd_host, vcb_isname, true);
+    mympd_state->mpd_state->mpd_port = state_store_rw_uint(store, "mpd_port", mympd_state->mpd_state->mpd_port, MPD_PORT_MIN, MPD_PORT_MAX, true);
+    mympd_state->mpd_state->mpd_pass = state_store_rw_string_sds(store, "mpd_pass", mympd_state->mpd_state->mpd_pass, vcb_isname, true);
+    mympd_state->mpd_state->mpd_binarylimit = state_store_rw_uint(store, "mpd_binarylimit", mympd_state->mpd_state->mpd_binarylimit, MPD_BINARY_CHUNK_SIZE_MIN, MPD_BINARY_CHUNK_SIZE_MAX, true);
+    mympd_state->mpd_state->mpd_timeout = state_store_rw_uint(store, "mpd_timeout", mympd_state->mpd_state->mpd_timeout, MPD_TIMEOUT_MIN, MPD_TIMEOUT_MAX, true);
+    mympd_state->mpd_state->mpd_keepalive = state_store_rw_bool(store, "mpd_keepalive", mympd_state->mpd_state->mpd_keepalive, true);
     // stickerdb connection, use mpd connection settings as default
     mympd_state->stickerdb->mpd_state->mpd_host = sds_replace(mympd_state->stickerdb->mpd_state->mpd_host, mympd_state->mpd_state->mpd_host);
     mympd_state->stickerdb->mpd_state->mpd_pass = sds_replace(mympd_state->stickerdb->mpd_state->mpd_pass, mympd_state->mpd_state->mpd_pass);
 
-    mympd_state->stickerdb->mpd_state->mpd_host = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "stickerdb_mpd_host", mympd_state->stickerdb->mpd_state->mpd_host, vcb_isname, true);
-    mympd_state->stickerdb->mpd_state->mpd_port = state_file_rw_uint(workdir, DIR_WORK_STATE, "stickerdb_mpd_port", mympd_state->mpd_state->mpd_port, MPD_PORT_MIN, MPD_PORT_MAX, true);
-    mympd_state->stickerdb->mpd_state->mpd_pass = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "stickerdb_mpd_pass", mympd_state->stickerdb->mpd_state->mpd_pass, vcb_isname, true);
-    mympd_state->stickerdb->mpd_state->mpd_timeout = state_file_rw_uint(workdir, DIR_WORK_STATE, "stickerdb_mpd_timeout", mympd_state->mpd_state->mpd_timeout, MPD_TIMEOUT_MIN, MPD_TIMEOUT_MAX, true);
-    mympd_state->stickerdb->mpd_state->mpd_keepalive = state_file_rw_bool(workdir, DIR_WORK_STATE, "stickerdb_mpd_keepalive", mympd_state->mpd_state->mpd_keepalive, true);
+    mympd_state->stickerdb->mpd_state->mpd_host = state_store_rw_string_sds(store, "stickerdb_mpd_host", mympd_state->stickerdb->mpd_state->mpd_host, vcb_isname, true);
+    mympd_state->stickerdb->mpd_state->mpd_port = state_store_rw_uint(store, "stickerdb_mpd_port", mympd_state->mpd_state->mpd_port, MPD_PORT_MIN, MPD_PORT_MAX, true);
+    mympd_state->stickerdb->mpd_state->mpd_pass = state_store_rw_string_sds(store, "stickerdb_mpd_pass", mympd_state->stickerdb->mpd_state->mpd_pass, vcb_isname, true);
+    mympd_state->stickerdb->mpd_state->mpd_timeout = state_store_rw_uint(store, "stickerdb_mpd_timeout", mympd_state->mpd_state->mpd_timeout, MPD_TIMEOUT_MIN, MPD_TIMEOUT_MAX, true);
+    mympd_state->stickerdb->mpd_state->mpd_keepalive = state_store_rw_bool(store, "stickerdb_mpd_keepalive", mympd_state->mpd_state->mpd_keepalive, true);
     // other settings
-    mympd_state->mpd_state->tag_list = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "tag_list", mympd_state->mpd_state->tag_list, vcb_istaglist, true);
-    mympd_state->last_played_count = state_file_rw_uint(workdir, DIR_WORK_STATE, "last_played_count", mympd_state->last_played_count, 0, MPD_PLAYLIST_LENGTH_MAX, true);
-    mympd_state->booklet_name = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "booklet_name", mympd_state->booklet_name, vcb_isfilename, true);
-    mympd_state->info_txt_name = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "info_txt_name", mympd_state->info_txt_name, vcb_isfilename, true);
-    mympd_state->tag_list_search = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "tag_list_search", mympd_state->tag_list_search, vcb_istaglist, true);
-    mympd_state->tag_list_browse = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "tag_list_browse", mympd_state->tag_list_browse, vcb_istaglist, true);
-    mympd_state->smartpls = state_file_rw_bool(workdir, DIR_WORK_STATE, "smartpls", mympd_state->smartpls, true);
-    mympd_state->smartpls_sort = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "smartpls_sort", mympd_state->smartpls_sort, vcb_ismpdsort, true);
-    mympd_state->smartpls_prefix = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "smartpls_prefix", mympd_state->smartpls_prefix, vcb_isname, true);
-    mympd_state->smartpls_interval = state_file_rw_int(workdir, DIR_WORK_STATE, "smartpls_interval", mympd_state->smartpls_interval, TIMER_INTERVAL_MIN, TIMER_INTERVAL_MAX, true);
-    mympd_state->smartpls_generate_tag_list = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "smartpls_generate_tag_list", mympd_state->smartpls_generate_tag_list, vcb_istaglist, true);
-    mympd_state->view_queue_current = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_queue_current", mympd_state->view_queue_current, vcb_isname, true);
-    mympd_state->view_search = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_search", mympd_state->view_search, vcb_isname, true);
-    mympd_state->view_browse_database_album_detail_info = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_database_album_detail_info", mympd_state->view_browse_database_album_detail_info, vcb_isname, true);
-    mympd_state->view_browse_database_album_detail = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_database_album_detail", mympd_state->view_browse_database_album_detail, vcb_isname, true);
-    mympd_state->view_browse_database_album_list = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_database_album_list", mympd_state->view_browse_database_album_list, vcb_isname, true);
-    mympd_state->view_browse_database_tag_list = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_database_tag_list", mympd_state->view_browse_database_tag_list, vcb_isname, true);
-    mympd_state->view_browse_playlist_list = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_playlist_list", mympd_state->view_browse_playlist_list, vcb_isname, true);
-    mympd_state->view_browse_playlist_detail = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_playlist_detail", mympd_state->view_browse_playlist_detail, vcb_isname, true);
-    mympd_state->view_browse_filesystem = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_filesystem", mympd_state->view_browse_filesystem, vcb_isname, true);
-    mympd_state->view_playback = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_playback", mympd_state->view_playback, vcb_isname, true);
-    mympd_state->view_queue_last_played = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_queue_last_played", mympd_state->view_queue_last_played, vcb_isname, true);
-    mympd_state->view_queue_jukebox_song = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_queue_jukebox_song", mympd_state->view_queue_jukebox_song, vcb_isname, true);
-    mympd_state->view_queue_jukebox_album = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_queue_jukebox_album", mympd_state->view_queue_jukebox_album, vcb_isname, true);
-    mympd_state->view_browse_radio_webradiodb = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_radio_webradiodb", mympd_state->view_browse_radio_webradiodb, vcb_isname, true);
-    mympd_state->view_browse_radio_favorites = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "view_browse_radio_favorites", mympd_state->view_browse_radio_favorites, vcb_isname, true);
-    mympd_state->coverimage_names = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "coverimage_names", mympd_state->coverimage_names, vcb_isfilename, true);
-    mympd_state->thumbnail_names = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "thumbnail_names", mympd_state->thumbnail_names, vcb_isfilename, true);
-    mympd_state->music_directory = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "music_directory", mympd_state->music_directory, vcb_isfilepath, true);
-    mympd_state->playlist_directory = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "playlist_directory", mympd_state->playlist_directory, vcb_isfilepath, true);
-    mympd_state->volume_min = state_file_rw_uint(workdir, DIR_WORK_STATE, "volume_min", mympd_state->volume_min, VOLUME_MIN, VOLUME_MAX, true);
-    mympd_state->volume_max = state_file_rw_uint(workdir, DIR_WORK_STATE, "volume_max", mympd_state->volume_max, VOLUME_MIN, VOLUME_MAX, true);
-    mympd_state->volume_step = state_file_rw_uint(workdir, DIR_WORK_STATE, "volume_step", mympd_state->volume_step, VOLUME_STEP_MIN, VOLUME_STEP_MAX, true);
-    mympd_state->webui_settings = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "webui_settings", mympd_state->webui_settings, validate_json_object, true);
-    mympd_state->lyrics.uslt_ext = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "lyrics_uslt_ext", mympd_state->lyrics.uslt_ext, vcb_isalnum, true);
-    mympd_state->lyrics.sylt_ext = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "lyrics_sylt_ext", mympd_state->lyrics.sylt_ext, vcb_isalnum, true);
-    mympd_state->lyrics.vorbis_uslt = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "lyrics_vorbis_uslt", mympd_state->lyrics.vorbis_uslt, vcb_isalnum, true);
-    mympd_state->lyrics.vorbis_sylt = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "lyrics_vorbis_sylt", mympd_state->lyrics.vorbis_sylt, vcb_isalnum, true);
-    mympd_state->navbar_icons = state_file_rw_string_sds(workdir, DIR_WORK_STATE, "navbar_icons", mympd_state->navbar_icons, validate_json_array, true);
-    mympd_state->tag_disc_empty_is_first = state_file_rw_bool(workdir, DIR_WORK_STATE, "tag_disc_empty_is_first", mympd_state->tag_disc_empty_is_first, true);
+    mympd_state->mpd_state->tag_list = state_store_rw_string_sds(store, "tag_list", mympd_state->mpd_state->tag_list, vcb_istaglist, true);
+    mympd_state->last_played_count = state_store_rw_uint(store, "last_played_count", mympd_state->last_played_count, 0, MPD_PLAYLIST_LENGTH_MAX, true);
+    mympd_state->booklet_name = state_store_rw_string_sds(store, "booklet_name", mympd_state->booklet_name, vcb_isfilename, true);
+    mympd_state->info_txt_name = state_store_rw_string_sds(store, "info_txt_name", mympd_state->info_txt_name, vcb_isfilename, true);
+    mympd_state->tag_list_search = state_store_rw_string_sds(store, "tag_list_search", mympd_state->tag_list_search, vcb_istaglist, true);
+    mympd_state->tag_list_browse = state_store_rw_string_sds(store, "tag_list_browse", mympd_state->tag_list_browse, vcb_istaglist, true);
+    mympd_state->smartpls = state_store_rw_bool(store, "smartpls", mympd_state->smartpls, true);
+    mympd_state->smartpls_sort = state_store_rw_string_sds(store, "smartpls_sort", mympd_state->smartpls_sort, vcb_ismpdsort, true);
+    mympd_state->smartpls_prefix = state_store_rw_string_sds(store, "smartpls_prefix", mympd_state->smartpls_prefix, vcb_isname, true);
+    mympd_state->smartpls_interval = state_store_rw_int(store, "smartpls_interval", mympd_state->smartpls_interval, TIMER_INTERVAL_MIN, TIMER_INTERVAL_MAX, true);
+    mympd_state->smartpls_generate_tag_list = state_store_rw_string_sds(store, "smartpls_generate_tag_list", mympd_state->smartpls_generate_tag_list, vcb_istaglist, true);
+    mympd_state->view_queue_current = state_store_rw_string_sds(store, "view_queue_current", mympd_state->view_queue_current, vcb_isname, true);
+    mympd_state->view_search = state_store_rw_string_sds(store, "view_search", mympd_state->view_search, vcb_isname, true);
+    mympd_state->view_browse_database_album_detail_info = state_store_rw_string_sds(store, "view_browse_database_album_detail_info", mympd_state->view_browse_database_album_detail_info, vcb_isname, true);
+    mympd_state->view_browse_database_album_detail = state_store_rw_string_sds(store, "view_browse_database_album_detail", mympd_state->view_browse_database_album_detail, vcb_isname, true);
+    mympd_state->view_browse_database_album_list = state_store_rw_string_sds(store, "view_browse_database_album_list", mympd_state->view_browse_database_album_list, vcb_isname, true);
+    mympd_state->view_browse_database_tag_list = state_store_rw_string_sds(store, "view_browse_database_tag_list", mympd_state->view_browse_database_tag_list, vcb_isname, true);
+    mympd_state->view_browse_playlist_list = state_store_rw_string_sds(store, "view_browse_playlist_list", mympd_state->view_browse_playlist_list, vcb_isname, true);
+    mympd_state->view_browse_playlist_detail = state_store_rw_string_sds(store, "view_browse_playlist_detail", mympd_state->view_browse_playlist_detail, vcb_isname, true);
+    mympd_state->view_browse_filesystem = state_store_rw_string_sds(store, "view_browse_filesystem", mympd_state->view_browse_filesystem, vcb_isname, true);
+    mympd_state->view_playback = state_store_rw_string_sds(store, "view_playback", mympd_state->view_playback, vcb_isname, true);
+    mympd_state->view_queue_last_played = state_store_rw_string_sds(store, "view_queue_last_played", mympd_state->view_queue_last_played, vcb_isname, true);
+    mympd_state->view_queue_jukebox_song = state_store_rw_string_sds(store, "view_queue_jukebox_song", mympd_state->view_queue_jukebox_song, vcb_isname, true);
+    mympd_state->view_queue_jukebox_album = state_store_rw_string_sds(store, "view_queue_jukebox_album", mympd_state->view_queue_jukebox_album, vcb_isname, true);
+    mympd_state->view_browse_radio_webradiodb = state_store_rw_string_sds(store, "view_browse_radio_webradiodb", mympd_state->view_browse_radio_webradiodb, vcb_isname, true);
+    mympd_state->view_browse_radio_favorites = state_store_rw_string_sds(store, "view_browse_radio_favorites", mympd_state->view_browse_radio_favorites, vcb_isname, true);
+    mympd_state->coverimage_names = state_store_rw_string_sds(store, "coverimage_names", mympd_state->coverimage_names, vcb_isfilename, true);
+    mympd_state->thumbnail_names = state_store_rw_string_sds(store, "thumbnail_names", mympd_state->thumbnail_names, vcb_isfilename, true);
+    mympd_state->music_directory = state_store_rw_string_sds(store, "music_directory", mympd_state->music_directory, vcb_isfilepath, true);
+    mympd_state->playlist_directory = state_store_rw_string_sds(store, "playlist_directory", mympd_state->playlist_directory, vcb_isfilepath, true);
+    mympd_state->volume_min = state_store_rw_uint(store, "volume_min", mympd_state->volume_min, VOLUME_MIN, VOLUME_MAX, true);
+    mympd_state->volume_max = state_store_rw_uint(store, "volume_max", mympd_state->volume_max, VOLUME_MIN, VOLUME_MAX, true);
+    mympd_state->volume_step = state_store_rw_uint(store, "volume_step", mympd_state->volume_step, VOLUME_STEP_MIN, VOLUME_STEP_MAX, true);
+    mympd_state->webui_settings = state_store_rw_string_sds(store, "webui_settings", mympd_state->webui_settings, validate_json_object, true);
+    mympd_state->lyrics.uslt_ext = state_store_rw_string_sds(store, "lyrics_uslt_ext", mympd_state->lyrics.uslt_ext, vcb_isalnum, true);
+    mympd_state->lyrics.sylt_ext = state_store_rw_string_sds(store, "lyrics_sylt_ext", mympd_state->lyrics.sylt_ext, vcb_isalnum, true);
+    mympd_state->lyrics.vorbis_uslt = state_store_rw_string_sds(store, "lyrics_vorbis_uslt", mympd_state->lyrics.vorbis_uslt, vcb_isalnum, true);
+    mympd_state->lyrics.vorbis_sylt = state_store_rw_string_sds(store, "lyrics_vorbis_sylt", mympd_state->lyrics.vorbis_sylt, vcb_isalnum, true);
+    mympd_state->navbar_icons = state_store_rw_string_sds(store, "navbar_icons", mympd_state->navbar_icons, validate_json_array, true);
+    mympd_state->tag_disc_empty_is_first = state_store_rw_bool(store, "tag_disc_empty_is_first", mympd_state->tag_disc_empty_is_first, true);
 
     strip_slash(mympd_state->music_directory);
     strip_slash(mympd_state->playlist_directory);
+    state_store_save(store);
 }
 
 /**
- * Reads the partition specific settings from the state files.
- * If the state file does not exist, it is populated with the default value and created.
+ * Loads the partition state store and reads the partition specific settings.
+ * If a state does not exist, it is populated with the default value.
+ * Changed states are saved at once.
  * @param partition_state pointer to the t_partition_state struct
  */
 void mympd_api_settings_statefiles_partition_read(struct t_partition_state *partition_state) {
     sds workdir = partition_state->config->workdir;
     MYMPD_LOG_NOTICE(partition_state->name, "Reading partition states from directory \"%s/%s\"", workdir, partition_state->state_dir);
-    partition_state->auto_play = state_file_rw_bool(workdir, partition_state->state_dir, "auto_play", partition_state->auto_play, true);
-    partition_state->jukebox.mode = state_file_rw_uint(workdir, partition_state->state_dir, "jukebox_mode", partition_state->jukebox.mode, JUKEBOX_MODE_MIN, JUKEBOX_MODE_MAX, true);
-    partition_state->jukebox.playlist = state_file_rw_string_sds(workdir, partition_state->state_dir, "jukebox_playlist", partition_state->jukebox.playlist, vcb_isfilename, true);
-    partition_state->jukebox.queue_length = state_file_rw_uint(workdir, partition_state->state_dir, "jukebox_queue_length", partition_state->jukebox.queue_length, JUKEBOX_QUEUE_MIN, JUKEBOX_QUEUE_MAX, true);
-    partition_state->jukebox.last_played = state_file_rw_uint(workdir, partition_state->state_dir, "jukebox_last_played", partition_state->jukebox.last_played, JUKEBOX_LAST_PLAYED_MIN, JUKEBOX_LAST_PLAYED_MAX, true);
-    partition_state->jukebox.uniq_tag.tags[0] = state_file_rw_tag(workdir, partition_state->state_dir, "jukebox_uniq_tag", partition_state->jukebox.uniq_tag.tags[0], true);
-    partition_state->jukebox.ignore_hated = state_file_rw_bool(workdir, partition_state->state_dir, "jukebox_ignore_hated", MYMPD_JUKEBOX_IGNORE_HATED, true);
-    partition_state->jukebox.filter_include = state_file_rw_string_sds(workdir, partition_state->state_dir, "jukebox_filter_include", partition_state->jukebox.filter_include, vcb_issearchexpression, true);
-    partition_state->jukebox.filter_exclude = state_file_rw_string_sds(workdir, partition_state->state_dir, "jukebox_filter_exclude", partition_state->jukebox.filter_exclude, vcb_issearchexpression, true);
-    partition_state->jukebox.min_song_duration= state_file_rw_uint(workdir, partition_state->state_dir, "jukebox_min_song_duration", partition_state->jukebox.min_song_duration, 0, JUKEBOX_MIN_SONG_DURATION_MAX, true);
-    partition_state->jukebox.max_song_duration= state_file_rw_uint(workdir, partition_state->state_dir, "jukebox_max_song_duration", partition_state->jukebox.max_song_duration, 0, JUKEBOX_MAX_SONG_DURATION_MAX, true);
-    partition_state->highlight_color = state_file_rw_string_sds(workdir, partition_state->state_dir, "highlight_color", partition_state->highlight_color, vcb_ishexcolor, true);
-    partition_state->highlight_color_contrast = state_file_rw_string_sds(workdir, partition_state->state_dir, "highlight_color_contrast", partition_state->highlight_color_contrast, vcb_ishexcolor, true);
-    partition_state->mpd_stream_port = state_file_rw_uint(workdir, partition_state->state_dir, "mpd_stream_port", partition_state->mpd_stream_port, MPD_PORT_MIN, MPD_PORT_MAX, true);
-    partition_state->stream_uri = state_file_rw_string_sds(workdir, partition_state->state_dir, "stream_uri", partition_state->stream_uri, vcb_isuri, true);
+    struct t_state_store *store = &partition_state->state_store;
+    state_store_load(store, workdir, partition_state->state_dir);
+    partition_state->auto_play = state_store_rw_bool(store, "auto_play", partition_state->auto_play, true);
+    partition_state->jukebox.mode = state_store_rw_uint(store, "jukebox_mode", partition_state->jukebox.mode, JUKEBOX_MODE_MIN, JUKEBOX_MODE_MAX, true);
+    partition_state->jukebox.playlist = state_store_rw_string_sds(store, "jukebox_playlist", partition_state->jukebox.playlist, vcb_isfilename, true);
+    partition_state->jukebox.queue_length = state_store_rw_uint(store, "jukebox_queue_length", partition_state->jukebox.queue_length, JUKEBOX_QUEUE_MIN, JUKEBOX_QUEUE_MAX, true);
+    partition_state->jukebox.last_played = state_store_rw_uint(store, "jukebox_last_played", partition_state->jukebox.last_played, JUKEBOX_LAST_PLAYED_MIN, JUKEBOX_LAST_PLAYED_MAX, true);
+    partition_state->jukebox.uniq_tag.tags[0] = state_store_rw_tag(store, "jukebox_uniq_tag", partition_state->jukebox.uniq_tag.tags[0], true);
+    partition_state->jukebox.ignore_hated = state_store_rw_bool(store, "jukebox_ignore_hated", MYMPD_JUKEBOX_IGNORE_HATED, true);
+    partition_state->jukebox.filter_include = state_store_rw_string_sds(store, "jukebox_filter_include", partition_state->jukebox.filter_include, vcb_issearchexpression, true);
+    partition_state->jukebox.filter_exclude = state_store_rw_string_sds(store, "jukebox_filter_exclude", partition_state->jukebox.filter_exclude, vcb_issearchexpression, true);
+    partition_state->jukebox.min_song_duration= state_store_rw_uint(store, "jukebox_min_song_duration", partition_state->jukebox.min_song_duration, 0, JUKEBOX_MIN_SONG_DURATION_MAX, true);
+    partition_state->jukebox.max_song_duration= state_store_rw_uint(store, "jukebox_max_song_duration", partition_state->jukebox.max_song_duration, 0, JUKEBOX_MAX_SONG_DURATION_MAX, true);
+    partition_state->highlight_color = state_store_rw_string_sds(store, "highlight_color", partition_state->highlight_color, vcb_ishexcolor, true);
+    partition_state->highlight_color_contrast = state_store_rw_string_sds(store, "highlight_color_contrast", partition_state->highlight_color_contrast, vcb_ishexcolor, true);
+    partition_state->mpd_stream_port = state_store_rw_uint(store, "mpd_stream_port", partition_state->mpd_stream_port, MPD_PORT_MIN, MPD_PORT_MAX, true);
+    partition_state->stream_uri = state_store_rw_string_sds(store, "stream_uri", partition_state->stream_uri, vcb_isuri, true);
+    state_store_save(store);
 }
 
 /**
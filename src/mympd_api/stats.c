@@ -19,11 +19,14 @@
 /**
  * Get mpd statistics
  * @param partition_state pointer to partition state
+ * @param loop_stats pointer to the counters of the mympd_api event loop
  * @param buffer already allocated sds string to append the response
  * @param request_id jsonrpc request id
  * @return pointer to buffer
  */
-sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, unsigned request_id) {
+sds mympd_api_stats_get(struct t_partition_state *partition_state, const struct t_mympd_api_loop_stats *loop_stats,
+        sds buffer, unsigned request_id)
+{
     enum mympd_cmd_ids cmd_id = MYMPD_API_STATS;
     struct mpd_stats *stats = mpd_run_stats(partition_state->conn);
     if (stats != NULL) {
@@ -43,7 +46,14 @@ sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, u
         buffer = tojson_uint64(buffer, "dbPlaytime", mpd_stats_get_db_play_time(stats), true);
         buffer = tojson_char(buffer, "mympdVersion", MYMPD_VERSION, true);
         buffer = tojson_char(buffer, "mpdProtocolVersion", mpd_protocol_version, true);
-        buffer = tojson_char(buffer, "myMPDuri", mympd_uri,false);
+        buffer = tojson_char(buffer, "myMPDuri", mympd_uri, true);
+        buffer = sdscat(buffer, "\"apiQueue\":{");
+        buffer = tojson_uint64(buffer, "wakeups", loop_stats->wakeups, true);
+        buffer = tojson_uint64(buffer, "requests", loop_stats->requests, true);
+        buffer = tojson_uint(buffer, "lastBatch", loop_stats->last_batch, true);
+        buffer = tojson_uint(buffer, "maxBatch", loop_stats->max_batch, true);
+        buffer = tojson_uint(buffer, "capped", loop_stats->capped, false);
+        buffer = sdscatlen(buffer, "}", 1);
         buffer = jsonrpc_end(buffer);
 
         FREE_SDS(mympd_uri);
@@ -13,5 +13,6 @@
 
 #include "src/lib/mympd_state.h"
 
-sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, unsigned request_id);
+sds mympd_api_stats_get(struct t_partition_state *partition_state, const struct t_mympd_api_loop_stats *loop_stats,
+        sds buffer, unsigned request_id);
 #endif
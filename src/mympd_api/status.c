@@ -189,16 +189,16 @@ sds mympd_api_status_get(struct t_partition_state *partition_state, struct t_cac
                 : (partition_state->song_duration / 2) - elapsed_time;
             if (scrobble_offset > 0) {
                 MYMPD_LOG_DEBUG(partition_state->name, "Setting scrobble timer");
-                mympd_timer_set(partition_state->timer_fd_scrobble, (int)scrobble_offset, 0);
+                mympd_timer_entry_set(&partition_state->timer_scrobble, (int)scrobble_offset, 0);
             }
             else {
                 MYMPD_LOG_DEBUG(partition_state->name, "Disabling scrobble timer");
-                mympd_timer_set(partition_state->timer_fd_scrobble, 0, 0);
+                mympd_timer_entry_set(&partition_state->timer_scrobble, 0, 0);
             }
         }
         else {
             MYMPD_LOG_DEBUG(partition_state->name, "Disabling scrobble timer");
-            mympd_timer_set(partition_state->timer_fd_scrobble, 0, 0);
+            mympd_timer_entry_set(&partition_state->timer_scrobble, 0, 0);
         }
 
         if (partition_state->jukebox.mode == JUKEBOX_OFF ||
@@ -211,7 +211,7 @@ sds mympd_api_status_get(struct t_partition_state *partition_state, struct t_cac
             time_t add_offset = partition_state->song_duration - (elapsed_time + partition_state->crossfade + JUKEBOX_ADD_SONG_OFFSET);
             if (add_offset > 0) {
                 MYMPD_LOG_DEBUG(partition_state->name, "Setting jukebox timer");
-                mympd_timer_set(partition_state->timer_fd_jukebox, (int)add_offset, 0);
+                mympd_timer_entry_set(&partition_state->timer_jukebox, (int)add_offset, 0);
             }
             else {
                 jukebox_disable(partition_state);
@@ -11,14 +11,16 @@
 #include "compile_time.h"
 #include "src/mympd_api/sticker.h"
 
-#include "dist/utf8/utf8.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/casefold.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/sds_extras.h"
 #include "src/mpd_client/search.h"
 #include "src/mpd_client/stickerdb.h"
 #include "src/mympd_api/trigger.h"
 
+#include <string.h>
+
 /**
  * Gets a sticker value
  * @param stickerdb pointer to stickerdb
@@ -154,6 +156,22 @@ sds mympd_api_sticker_get_print_batch(sds buffer, struct t_stickerdb_state *stic
     return buffer;
 }
 
+/**
+ * Prints the stickers of an uri from the result of stickerdb_get_all_multi
+ * @param buffer already allocated sds string to append the list
+ * @param sticker_map stickers by uri
+ * @param uri sticker uri
+ * @param stickers array of stickers to print
+ * @return pointer to the modified buffer
+ */
+sds mympd_api_sticker_print_multi(sds buffer, rax *sticker_map, const char *uri, const struct t_stickers *stickers) {
+    void *data;
+    if (raxFind(sticker_map, (unsigned char *)uri, strlen(uri), &data) == 1) {
+        buffer = mympd_api_sticker_print(buffer, (struct t_sticker *)data, stickers);
+    }
+    return buffer;
+}
+
 /**
  * Print the sticker struct as json list
  * @param buffer already allocated sds string to append the list
@@ -224,14 +242,17 @@ sds mympd_api_sticker_names(struct t_stickerdb_state *stickerdb, sds buffer, uns
         return jsonrpc_respond_message(buffer, MYMPD_API_STICKER_NAMES, request_id,
                 JSONRPC_FACILITY_STICKER, JSONRPC_SEVERITY_ERROR, "Failure listing stickernames");
     }
+    //fold the search string once for all names
+    sds searchstr_folded = casefold_cat(sdsempty(), searchstr);
+    size_t searchstr_len = sdslen(searchstr_folded);
     buffer = jsonrpc_respond_start(buffer, MYMPD_API_STICKER_NAMES, request_id);
     buffer = sdscat(buffer,"\"data\":[");
     struct t_list_node *current = sticker_names.head;
     unsigned entities_returned = 0;
     while (current != NULL) {
         if (sticker_name_parse(current->key) == STICKER_UNKNOWN &&
-            (sdslen(searchstr) == 0 ||
-             utf8casestr(current->key, searchstr) != NULL))
+            (searchstr_len == 0 ||
+             casefold_contains(current->key, searchstr_folded, searchstr_len) == true))
         {
             if (entities_returned++) {
                 buffer= sdscatlen(buffer, ",", 1);
@@ -245,6 +266,7 @@ sds mympd_api_sticker_names(struct t_stickerdb_state *stickerdb, sds buffer, uns
     buffer = tojson_uint(buffer, "totalEntities", entities_returned, false);
     buffer = jsonrpc_end(buffer);
     list_clear(&sticker_names);
+    FREE_SDS(searchstr_folded);
     return buffer;
 }
 
@@ -24,6 +24,7 @@ sds mympd_api_sticker_get_print(sds buffer, struct t_stickerdb_state *stickerdb,
 sds mympd_api_sticker_get_print_batch(sds buffer, struct t_stickerdb_state *stickerdb,
         enum mympd_sticker_type type, const char *uri, const struct t_stickers *stickers);
 sds mympd_api_sticker_print(sds buffer, struct t_sticker *sticker, const struct t_stickers *stickers);
+sds mympd_api_sticker_print_multi(sds buffer, rax *sticker_map, const char *uri, const struct t_stickers *stickers);
 
 sds mympd_api_sticker_print_types(struct t_stickerdb_state *stickerdb, sds buffer);
 sds mympd_api_sticker_names(struct t_stickerdb_state *stickerdb, sds buffer, unsigned request_id,
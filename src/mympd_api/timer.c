@@ -31,7 +31,6 @@
  */
 
 static void mympd_api_timer_free_node(struct t_list_node *node);
-static struct t_list_node *get_timer_from_fd(struct t_timer_list *l, int fd);
 static sds print_timer_node(sds buffer, unsigned timer_id, struct t_timer_node *current);
 
 /**
@@ -41,30 +40,26 @@ static sds print_timer_node(sds buffer, unsigned timer_id, struct t_timer_node *
 /**
  * Inits the timer list
  * @param l pointer to already allocated timer list
+ * @param heap timer heap to schedule the timers
  */
-void mympd_api_timer_timerlist_init(struct t_timer_list *l) {
+void mympd_api_timer_timerlist_init(struct t_timer_list *l, struct t_timer_heap *heap) {
     l->active = 0;
     l->last_id = USER_TIMER_ID_START;
+    l->heap = heap;
     list_init(&l->list);
 }
 
 /**
- * Checks the timer event and executes the callback function
- * @param fd fd with POLLIN event
+ * Checks the expired timer and executes the callback function
+ * @param current_timer expired timer from the timer heap
  * @param timer_list timer list
  * @return true on success, else false
  */
-bool mympd_api_timer_check(int fd, struct t_timer_list *timer_list) {
-    struct t_list_node *current = get_timer_from_fd(timer_list, fd);
-    if (current == NULL) {
-        MYMPD_LOG_ERROR(NULL, "Could not get timer from fd");
-        return false;
-    }
-    struct t_timer_node *current_timer = (struct t_timer_node *)current->user_data;
+bool mympd_api_timer_check(struct t_timer_node *current_timer, struct t_timer_list *timer_list) {
     if (current_timer->definition != NULL) {
         //user defined timers
         if (current_timer->definition->enabled == false) {
-            MYMPD_LOG_DEBUG(NULL, "Skipping timer with id %" PRId64 ", not enabled", current->value_i);
+            MYMPD_LOG_DEBUG(NULL, "Skipping timer with id %u, not enabled", current_timer->timer_id);
             return false;
         }
         time_t t = time(NULL);
@@ -76,27 +71,27 @@ bool mympd_api_timer_check(int fd, struct t_timer_list *timer_list) {
         int wday = now.tm_wday;
         wday = wday > 0 ? wday - 1 : 6;
         if (current_timer->definition->weekdays[wday] == false) {
-            MYMPD_LOG_DEBUG(NULL, "Skipping timer with id %" PRId64 ", not enabled on this weekday", current->value_i);
+            MYMPD_LOG_DEBUG(NULL, "Skipping timer with id %u, not enabled on this weekday", current_timer->timer_id);
             return false;
         }
     }
     //execute callback function
-    MYMPD_LOG_DEBUG(NULL, "Timer with id %" PRId64 " triggered", current->value_i);
+    MYMPD_LOG_DEBUG(NULL, "Timer with id %u triggered", current_timer->timer_id);
     if (current_timer->callback) {
-        current_timer->callback((unsigned)current->value_i, current_timer->definition);
+        current_timer->callback(current_timer->timer_id, current_timer->definition);
     }
     //handle one shot timers
     if (current_timer->interval == TIMER_ONE_SHOT_DISABLE &&
         current_timer->definition != NULL)
     {
         //user defined "one shot and disable" timers
-        MYMPD_LOG_DEBUG(NULL, "One shot timer disabled: %" PRId64, current->value_i);
+        MYMPD_LOG_DEBUG(NULL, "One shot timer disabled: %u", current_timer->timer_id);
         current_timer->definition->enabled = false;
     }
     else if (current_timer->interval <= TIMER_ONE_SHOT_REMOVE) {
         //"one shot and remove" timers
-        MYMPD_LOG_DEBUG(NULL, "One shot timer removed: %" PRId64, current->value_i);
-        mympd_api_timer_remove(timer_list, (unsigned)current->value_i);
+        MYMPD_LOG_DEBUG(NULL, "One shot timer removed: %u", current_timer->timer_id);
+        mympd_api_timer_remove(timer_list, current_timer->timer_id);
     }
     return true;
 }
@@ -185,6 +180,8 @@ bool mympd_api_timer_add(struct t_timer_list *l, int timeout, int interval, time
         unsigned timer_id, struct t_timer_definition *definition)
 {
     struct t_timer_node *new_node = malloc_assert(sizeof(struct t_timer_node));
+    new_node->timer_id = timer_id;
+    mympd_timer_entry_init(&new_node->timer, l->heap, PFD_TYPE_TIMER, NULL, new_node);
     new_node->callback = handler;
     new_node->definition = definition;
     new_node->timeout = timeout;
@@ -196,15 +193,11 @@ bool mympd_api_timer_add(struct t_timer_list *l, int timeout, int interval, time
         // Interval:
         //  0 = oneshot and deactivate
         // -1 = oneshot and remove
-        new_node->fd = mympd_timer_create(CLOCK_REALTIME, timeout, (interval > 0 ? interval : 0));
-        if (new_node->fd == -1) {
+        if (mympd_timer_entry_set(&new_node->timer, timeout, (interval > 0 ? interval : 0)) == false) {
             FREE_PTR(new_node);
             return false;
         }
     }
-    else {
-        new_node->fd = -1;
-    }
     list_push(&l->list, "", timer_id, NULL, new_node);
     if (definition == NULL ||
         definition->enabled == true)
@@ -280,7 +273,7 @@ bool mympd_api_timer_toggle(struct t_timer_list *l, unsigned timer_id, sds *erro
  */
 void mympd_api_timer_timerlist_clear(struct t_timer_list *l) {
     list_clear_user_data(&l->list, mympd_api_timer_free_node);
-    mympd_api_timer_timerlist_init(l);
+    mympd_api_timer_timerlist_init(l, l->heap);
 }
 
 /**
@@ -562,31 +555,13 @@ bool mympd_api_timer_file_save(struct t_timer_list *timer_list, sds workdir) {
  */
 static void mympd_api_timer_free_node(struct t_list_node *node) {
     struct t_timer_node *timer = (struct t_timer_node *)node->user_data;
-    mympd_timer_close(timer->fd);
+    mympd_timer_entry_cancel(&timer->timer);
     if (timer->definition != NULL) {
         mympd_api_timer_free_definition(timer->definition);
     }
     FREE_PTR(timer);
 }
 
-/**
- * Gets the timer associated with the fd
- * @param l timer list
- * @param fd timer fd
- * @return timer for the fd
- */
-static struct t_list_node *get_timer_from_fd(struct t_timer_list *l, int fd) {
-    struct t_list_node *current = l->list.head;
-    while (current != NULL) {
-        struct t_timer_node *current_timer = (struct t_timer_node *)current->user_data;
-        if (current_timer->fd == fd) {
-            return current;
-        }
-        current = current->next;
-    }
-    return NULL;
-}
-
 /**
  * Prints a timer node as a json object string
  * @param buffer already allocated sds string to append the response
@@ -32,16 +32,17 @@ typedef void (*timer_handler)(unsigned timer_id, struct t_timer_definition *defi
  * Timer node
  */
 struct t_timer_node {
-    int fd;                                 //!< holds the timerfd
+    unsigned timer_id;                      //!< id of the timer
+    struct t_timer_entry timer;             //!< schedules the timer in the timer heap
     timer_handler callback;                 //!< timer callback function
     struct t_timer_definition *definition;  //!< optional pointer to timer definition (GUI)
     int timeout;                            //!< seconds when timer will run
     int interval;                           //!< reschedule timer interval
 };
 
-void mympd_api_timer_timerlist_init(struct t_timer_list *l);
+void mympd_api_timer_timerlist_init(struct t_timer_list *l, struct t_timer_heap *heap);
 void mympd_api_timer_timerlist_clear(struct t_timer_list *l);
-bool mympd_api_timer_check(int fd, struct t_timer_list *timer_list);
+bool mympd_api_timer_check(struct t_timer_node *current_timer, struct t_timer_list *timer_list);
 bool mympd_api_timer_save(struct t_partition_state *partition_state, struct t_timer_list *timer_list, int interval, unsigned timerid,
         struct t_timer_definition *timer_def, sds *error);
 bool mympd_api_timer_add(struct t_timer_list *l, int timeout, int interval,
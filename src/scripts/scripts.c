@@ -20,6 +20,7 @@
 #include "src/scripts/api_handler.h"
 #include "src/scripts/api_scripts.h"
 #include "src/scripts/api_vars.h"
+#include "src/scripts/scripts_worker.h"
 #include "src/scripts/util.h"
 
 /**
@@ -36,6 +37,7 @@ void *scripts_loop(void *arg_config) {
     scripts_state_default(scripts_state, (struct t_config *)arg_config);
     scripts_vars_file_read(&scripts_state->var_list, scripts_state->config->workdir);
     scripts_file_read(scripts_state);
+    scripts_state->worker_pool = script_worker_pool_new();
 
     // thread loop
     while (s_signal_received == 0) {
@@ -46,6 +48,10 @@ void *scripts_loop(void *arg_config) {
     }
     MYMPD_LOG_DEBUG(NULL, "Stopping scripts thread");
 
+    // stop the script worker threads
+    script_worker_pool_free(scripts_state->worker_pool);
+    scripts_state->worker_pool = NULL;
+
     // save and free states
     scripts_state_save(scripts_state, true);
     FREE_SDS(thread_logname);
@@ -37,19 +37,43 @@
 
 // Private definitions
 
-static bool create_lua_vm(struct t_script_thread_arg *script_arg);
-static bool script_load(struct t_script_thread_arg *script_arg, const char *script);
-static bool script_load_bytecode(struct t_script_thread_arg *script_arg, sds bytecode);
-static int save_bytecode(lua_State *lua_vm, struct t_script_list_data *data);
-static void populate_lua_global_vars(struct t_scripts_state *scripts_state,
-        struct t_script_thread_arg *script_arg, struct t_list *arguments);
+/**
+ * Registry key for the snapshot of the global variables of a fresh lua vm
+ */
+#define LUA_GLOBALS_SNAPSHOT "mympd_globals"
+
+/**
+ * Registry key for the snapshot of the loaded modules of a fresh lua vm
+ */
+#define LUA_LOADED_SNAPSHOT "mympd_loaded"
+
+/**
+ * Registry key for the read-only base of the script environments
+ */
+#define LUA_ENV_BASE "mympd_env_base"
+
+#ifndef LUA_LOADED_TABLE
+    //! Registry key of the loaded modules, not defined in older lua 5.3 versions
+    #define LUA_LOADED_TABLE "_LOADED"
+#endif
+
+static bool script_compile(const char *script, sds *bytecode, sds *error);
+static int dump_cb(lua_State *lua_vm, const void* p, size_t sz, void* ud);
+static void script_vm_snapshot_globals(lua_State *lua_vm);
+static void script_vm_create_env_base(lua_State *lua_vm);
+static void script_vm_push_readonly(lua_State *lua_vm, int idx);
+static int script_vm_readonly_newindex(lua_State *lua_vm);
+static int script_vm_readonly_next(lua_State *lua_vm);
+static int script_vm_readonly_pairs(lua_State *lua_vm);
+static int script_vm_readonly_len(lua_State *lua_vm);
+static void table_remove_missing(lua_State *lua_vm, int idx, int snapshot_idx);
 static void register_lua_functions(lua_State *lua_vm);
 static int mympd_luaopen(lua_State *lua_vm, const char *lualib);
 
 // Public functions
 
 /**
- * Executes the script in a new thread.
+ * Queues the script for execution in the script worker pool.
  * @param scripts_state Pointer to script_state
  * @param scriptname Script name to execute
  * @param arguments Script arguments
@@ -65,104 +89,79 @@ bool script_start(struct t_scripts_state *scripts_state, sds scriptname, struct
         const char *partition, bool localscript, enum script_start_events start_event,
         unsigned request_id, unsigned long conn_id, sds *error)
 {
-    if (script_worker_threads > MAX_SCRIPT_WORKER_THREADS) {
-        if (start_event == SCRIPT_START_HTTP) {
-            send_script_raw_error(conn_id, partition, "Too many script worker threads already running.");
-        }
-        else {
-            *error = sdscat(*error, "Too many script worker threads already running.");
-        }
-        return false;
-    }
-
-    struct t_script_thread_arg *script_arg = malloc_assert(sizeof(struct t_script_thread_arg));
-    script_arg->partition = sdsnew(partition);
-    script_arg->start_event = start_event;
-    script_arg->conn_id = start_event == SCRIPT_START_HTTP ? conn_id : 0;
-    script_arg->request_id = request_id;
-    script_arg->config = scripts_state->config;
-    script_arg->lua_vm = NULL;
+    sds bytecode = NULL;
+    sds compile_error = NULL;
     bool rc;
 
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
     if (localscript == true) {
-        script_arg->script_name = sdsdup(scriptname);
         // Load script from list
         struct t_list_node *script = list_get_node(&scripts_state->script_list, scriptname);
         if (script != NULL) {
-            #ifdef MYMPD_DEBUG
-                MEASURE_INIT
-                MEASURE_START
-            #endif
             struct t_script_list_data *data = (struct t_script_list_data *)script->user_data;
             if (data->bytecode == NULL) {
                 MYMPD_LOG_DEBUG(partition, "Compiling lua script");
-                rc = script_load(script_arg, data->script);
+                rc = script_compile(data->script, &data->bytecode, &compile_error);
                 if (rc == true) {
-                    if (save_bytecode(script_arg->lua_vm, data) == 0) {
-                        MYMPD_LOG_DEBUG(partition, "Lua byte code cached successfully");
-                    }
-                    else {
-                        MYMPD_LOG_ERROR(partition, "Error caching lua bytecode");
-                    }
+                    MYMPD_LOG_DEBUG(partition, "Lua byte code cached successfully");
                 }
             }
             else {
-                MYMPD_LOG_DEBUG(partition, "Loading cached lua bytecode");
-                rc = script_load_bytecode(script_arg, data->bytecode);
+                MYMPD_LOG_DEBUG(partition, "Using cached lua bytecode");
+                rc = true;
+            }
+            if (rc == true) {
+                bytecode = sdsdup(data->bytecode);
             }
-            #ifdef MYMPD_DEBUG
-                MEASURE_END
-                MEASURE_PRINT(partition, "SCRIPT_START")
-            #endif
         }
         else {
+            compile_error = sdsnew("Error creating Lua instance.");
             rc = false;
         }
     }
     else {
-        script_arg->script_name = sdsnew("user_defined");
-        rc = script_load(script_arg, scriptname);
+        rc = script_compile(scriptname, &bytecode, &compile_error);
     }
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(partition, "SCRIPT_START")
+    #endif
 
-    if (script_arg->lua_vm == NULL) {
-        if (start_event == SCRIPT_START_HTTP) {
-            send_script_raw_error(conn_id, partition, "Error creating Lua instance.");
-        }
-        else {
-            *error = sdscat(*error, "Error creating Lua instance.");
-        }
-        free_t_script_thread_arg(script_arg);
-        return false;
-    }
     if (rc == false) {
-        sds result = script_get_result(script_arg->lua_vm, rc);
         if (start_event == SCRIPT_START_HTTP) {
-            send_script_raw_error(conn_id, partition, result);
+            send_script_raw_error(conn_id, partition, compile_error);
         }
         else {
-            *error = sdscat(*error, result);
+            *error = sdscatsds(*error, compile_error);
         }
-        MYMPD_LOG_ERROR(script_arg->partition, "Error executing script %s: %s", script_arg->script_name, result);
-        FREE_SDS(result);
-        free_t_script_thread_arg(script_arg);
+        MYMPD_LOG_ERROR(partition, "Error executing script %s: %s", scriptname, compile_error);
+        FREE_SDS(compile_error);
+        FREE_SDS(bytecode);
         return false;
     }
 
-    populate_lua_global_vars(scripts_state, script_arg, arguments);
+    struct t_script_thread_arg *script_arg = malloc_assert(sizeof(struct t_script_thread_arg));
+    script_arg->bytecode = bytecode;
+    script_arg->arguments = list_dup(arguments);
+    script_arg->vars = list_dup(&scripts_state->var_list);
+    script_arg->script_name = localscript == true
+        ? sdsdup(scriptname)
+        : sdsnew("user_defined");
+    script_arg->partition = sdsnew(partition);
+    script_arg->start_event = start_event;
+    script_arg->conn_id = start_event == SCRIPT_START_HTTP ? conn_id : 0;
+    script_arg->request_id = request_id;
+    script_arg->config = scripts_state->config;
 
-    //execute script
-    pthread_t scripts_worker_thread;
-    pthread_attr_t attr;
-    if (pthread_attr_init(&attr) != 0 ||
-        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0 ||
-        pthread_create(&scripts_worker_thread, &attr, script_run, script_arg) != 0)
-    {
-        MYMPD_LOG_ERROR(NULL, "Can not create script worker thread");
+    if (script_worker_pool_push(scripts_state->worker_pool, script_arg) == false) {
         if (start_event == SCRIPT_START_HTTP) {
-            send_script_raw_error(conn_id, partition, "Can not create script worker thread");
+            send_script_raw_error(conn_id, partition, "Too many scripts are waiting for execution.");
         }
         else {
-            *error = sdscat(*error, "Can not create script worker thread");
+            *error = sdscat(*error, "Too many scripts are waiting for execution.");
         }
         free_t_script_thread_arg(script_arg);
         return false;
@@ -180,158 +179,361 @@ bool script_start(struct t_scripts_state *scripts_state, sds scriptname, struct
  * @return true on success, else false
  */
 bool script_validate(struct t_config *config, sds scriptname, sds script, sds *error) {
-    struct t_script_thread_arg script_arg;
-    script_arg.script_name = scriptname;
-    script_arg.partition = NULL;
-    script_arg.config = config;
-    script_arg.request_id = 0;
-
-    bool rc = script_load(&script_arg, script);
-    if (script_arg.lua_vm == NULL) {
-        *error = sdscat(*error, "Error creating Lua instance.");
-        return false;
-    }
-    sds result = script_get_result(script_arg.lua_vm, rc);
-    lua_close(script_arg.lua_vm);
+    (void)config;
+    sds bytecode = NULL;
+    sds compile_error = NULL;
+    bool rc = script_compile(script, &bytecode, &compile_error);
+    FREE_SDS(bytecode);
     if (rc == true) {
-        FREE_SDS(result);
         return true;
     }
     //compilation error
-    MYMPD_LOG_ERROR(NULL, "Error validating script %s: %s", script_arg.script_name, result);
-    *error = sdscatsds(*error, result);
-    FREE_SDS(result);
+    MYMPD_LOG_ERROR(NULL, "Error validating script %s: %s", scriptname, compile_error);
+    *error = sdscatsds(*error, compile_error);
+    FREE_SDS(compile_error);
     return false;
 }
 
-// Private functions
-
 /**
- * Creates the lua instance and opens the standard and myMPD libraries
- * @param script_arg 
- * @return true on success, else false
+ * Creates the lua instance and opens the standard and myMPD libraries.
+ * The instance is reused for many script executions, see script_vm_set_env
+ * and script_vm_reset.
+ * @return the lua instance or NULL on error
  */
-static bool create_lua_vm(struct t_script_thread_arg *script_arg) {
-    script_arg->lua_vm = luaL_newstate();
-    if (script_arg->lua_vm == NULL) {
-        MYMPD_LOG_ERROR(script_arg->partition, "Memory allocation error in luaL_newstate");
-        return false;
+lua_State *script_vm_new(void) {
+    lua_State *lua_vm = luaL_newstate();
+    if (lua_vm == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Memory allocation error in luaL_newstate");
+        return NULL;
     }
-    luaL_openlibs(script_arg->lua_vm);
-    if (mympd_luaopen(script_arg->lua_vm, "json") == 1 ||
-        mympd_luaopen(script_arg->lua_vm, "mympd") == 1)
+    luaL_openlibs(lua_vm);
+    if (mympd_luaopen(lua_vm, "json") == 1 ||
+        mympd_luaopen(lua_vm, "mympd") == 1)
     {
-        lua_close(script_arg->lua_vm);
-        script_arg->lua_vm = NULL;
-        return false;
+        lua_close(lua_vm);
+        return NULL;
     }
-    register_lua_functions(script_arg->lua_vm);
-    return true;
-}
-
-/**
- * Loads the script from a string
- * @param script_arg pointer to t_script_thread_arg struct
- * @param script script to load
- * @return 0 on success, else 1
- */
-static bool script_load(struct t_script_thread_arg *script_arg, const char *script) {
-    return create_lua_vm(script_arg) &&
-        luaL_loadstring(script_arg->lua_vm, script) == 0;
-}
-
-/**
- * Loads the cached bytecode
- * This should be faster than compiling the script on each execution.
- * @param script_arg pointer to t_script_thread_arg struct
- * @param bytecode compiled lua script
- * @return 0 on success, else 1
- */
-static bool script_load_bytecode(struct t_script_thread_arg *script_arg, sds bytecode) {
-    return create_lua_vm(script_arg) &&
-        luaL_loadbuffer(script_arg->lua_vm, bytecode, sdslen(bytecode), script_arg->script_name) == 0;
+    register_lua_functions(lua_vm);
+    script_vm_snapshot_globals(lua_vm);
+    script_vm_create_env_base(lua_vm);
+    return lua_vm;
 }
 
 /**
- * Callback function for lua_dump to save the lua script bytecode
- * @param lua_vm lua state
- * @param p chunk to write
- * @param sz chunk size
- * @param ud user data
- * @return 0 on success
+ * Sets a fresh environment for the loaded script chunk on top of the stack.
+ * Globals of the script are set in this environment, unknown globals are
+ * looked up in the read-only base. The tables of the libraries can not be
+ * modified through the base.
+ * @param lua_vm lua instance
  */
-static int dump_cb(lua_State *lua_vm, const void* p, size_t sz, void* ud) {
-    (void)lua_vm;
-    struct t_script_list_data *data = (struct t_script_list_data *)ud;
-    data->bytecode = sdscatlen(data->bytecode, p, sz);
-    return 0;
+void script_vm_set_env(lua_State *lua_vm) {
+    lua_newtable(lua_vm);
+    lua_newtable(lua_vm);
+    lua_getfield(lua_vm, LUA_REGISTRYINDEX, LUA_ENV_BASE);
+    lua_setfield(lua_vm, -2, "__index");
+    lua_setmetatable(lua_vm, -2);
+    // _G points to the environment of the script
+    lua_pushvalue(lua_vm, -1);
+    lua_setfield(lua_vm, -2, "_G");
+    // the first upvalue of a main chunk is _ENV
+    if (lua_setupvalue(lua_vm, -2, 1) == NULL) {
+        lua_pop(lua_vm, 1);
+    }
 }
 
 /**
- * Saves the lua bytecode
- * @param lua_vm lua state
- * @param data pointer to script_list data
- * @return 0 on success
+ * Resets the lua instance to the snapshot taken after its creation.
+ * The script globals are dropped with its environment. This function resets
+ * the real globals, that are set by myMPD, by the libraries, by load and
+ * by required modules, and removes the modules required by the last script.
+ * The read-only base is recreated, rawset bypasses its metamethods.
+ * @param lua_vm lua instance
  */
-static int save_bytecode(lua_State *lua_vm, struct t_script_list_data *data) {
-    FREE_SDS(data->bytecode);
-    data->bytecode = sdsempty();
-    return lua_dump(lua_vm, dump_cb, data, false);
+void script_vm_reset(lua_State *lua_vm) {
+    lua_settop(lua_vm, 0);
+    lua_getfield(lua_vm, LUA_REGISTRYINDEX, LUA_GLOBALS_SNAPSHOT);
+    lua_pushglobaltable(lua_vm);
+    // remove globals that are not in the snapshot
+    table_remove_missing(lua_vm, 2, 1);
+    // restore the globals from the snapshot
+    lua_pushnil(lua_vm);
+    while (lua_next(lua_vm, 1) != 0) {
+        lua_pushvalue(lua_vm, -2);
+        lua_insert(lua_vm, -2);
+        lua_rawset(lua_vm, 2);
+    }
+    lua_settop(lua_vm, 0);
+    // remove the modules that are not in the snapshot
+    lua_getfield(lua_vm, LUA_REGISTRYINDEX, LUA_LOADED_SNAPSHOT);
+    luaL_getsubtable(lua_vm, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+    table_remove_missing(lua_vm, 2, 1);
+    lua_settop(lua_vm, 0);
+    script_vm_create_env_base(lua_vm);
+    lua_gc(lua_vm, LUA_GCCOLLECT, 0);
 }
 
 /**
  * Populate the global vars for script execution
- * @param scripts_state pointer to scripts_state
+ * @param lua_vm lua instance
  * @param script_arg pointer to t_script_thread_arg struct
- * @param arguments list of arguments
  */
-static void populate_lua_global_vars(struct t_scripts_state *scripts_state,
-        struct t_script_thread_arg *script_arg, struct t_list *arguments)
-{
+void script_vm_populate_globals(lua_State *lua_vm, struct t_script_thread_arg *script_arg) {
     // Set myMPD config as a global
-    lua_pushlightuserdata(script_arg->lua_vm, script_arg->config);
-    lua_setglobal(script_arg->lua_vm, "mympd_config");
+    lua_pushlightuserdata(lua_vm, script_arg->config);
+    lua_setglobal(lua_vm, "mympd_config");
     // Set global mympd_env lua table
-    lua_newtable(script_arg->lua_vm);
-    populate_lua_table_field_p(script_arg->lua_vm, "partition", script_arg->partition);
-    populate_lua_table_field_i(script_arg->lua_vm, "requestid", script_arg->request_id);
-    populate_lua_table_field_p(script_arg->lua_vm, "scriptevent", script_start_event_name(script_arg->start_event));
-    populate_lua_table_field_p(script_arg->lua_vm, "scriptname", script_arg->script_name);
+    lua_newtable(lua_vm);
+    populate_lua_table_field_p(lua_vm, "partition", script_arg->partition);
+    populate_lua_table_field_i(lua_vm, "requestid", script_arg->request_id);
+    populate_lua_table_field_p(lua_vm, "scriptevent", script_start_event_name(script_arg->start_event));
+    populate_lua_table_field_p(lua_vm, "scriptname", script_arg->script_name);
     sds cachedir = sdscatfmt(sdsempty(), "%s/%s", script_arg->config->cachedir,  DIR_CACHE_COVER);
-    populate_lua_table_field_p(script_arg->lua_vm, "cachedir_cover", cachedir);
+    populate_lua_table_field_p(lua_vm, "cachedir_cover", cachedir);
     sdsclear(cachedir);
     cachedir = sdscatfmt(cachedir, "%s/%s", script_arg->config->cachedir,  DIR_CACHE_LYRICS);
-    populate_lua_table_field_p(script_arg->lua_vm, "cachedir_lyrics", cachedir);
+    populate_lua_table_field_p(lua_vm, "cachedir_lyrics", cachedir);
     sdsclear(cachedir);
     cachedir = sdscatfmt(cachedir, "%s/%s", script_arg->config->cachedir,  DIR_CACHE_MISC);
-    populate_lua_table_field_p(script_arg->lua_vm, "cachedir_misc", cachedir);
+    populate_lua_table_field_p(lua_vm, "cachedir_misc", cachedir);
     sdsclear(cachedir);
     cachedir = sdscatfmt(cachedir, "%s/%s", script_arg->config->cachedir,  DIR_CACHE_THUMBS);
-    populate_lua_table_field_p(script_arg->lua_vm, "cachedir_thumbs", cachedir);
+    populate_lua_table_field_p(lua_vm, "cachedir_thumbs", cachedir);
     FREE_SDS(cachedir);
-    populate_lua_table_field_p(script_arg->lua_vm, "workdir", script_arg->config->workdir);
+    populate_lua_table_field_p(lua_vm, "workdir", script_arg->config->workdir);
     // User defined variables
-    lua_pushstring(script_arg->lua_vm, "var");
-    lua_newtable(script_arg->lua_vm);
-    struct t_list_node *current = scripts_state->var_list.head;
+    lua_pushstring(lua_vm, "var");
+    lua_newtable(lua_vm);
+    struct t_list_node *current = script_arg->vars->head;
     while (current != NULL) {
-        populate_lua_table_field_p(script_arg->lua_vm, current->key, current->value_p);
+        populate_lua_table_field_p(lua_vm, current->key, current->value_p);
         current = current->next;
     }
-    lua_settable(script_arg->lua_vm, -3);
+    lua_settable(lua_vm, -3);
     // Set the global variable
-    lua_setglobal(script_arg->lua_vm, "mympd_env");
+    lua_setglobal(lua_vm, "mympd_env");
 
     // Set global arguments lua table
-    lua_newtable(script_arg->lua_vm);
-    if (arguments->length > 0) {
-        current = arguments->head;
-        while (current != NULL) {
-            populate_lua_table_field_p(script_arg->lua_vm, current->key, current->value_p);
-            current = current->next;
+    lua_newtable(lua_vm);
+    current = script_arg->arguments->head;
+    while (current != NULL) {
+        populate_lua_table_field_p(lua_vm, current->key, current->value_p);
+        current = current->next;
+    }
+    lua_setglobal(lua_vm, "mympd_arguments");
+}
+
+// Private functions
+
+/**
+ * Compiles a lua script to bytecode.
+ * Compiling needs no libraries, a bare lua instance is used.
+ * @param script the script to compile
+ * @param bytecode pointer to sds string to set with the bytecode
+ * @param error pointer to sds string to set with the error message
+ * @return true on success, else false
+ */
+static bool script_compile(const char *script, sds *bytecode, sds *error) {
+    lua_State *lua_vm = luaL_newstate();
+    if (lua_vm == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Memory allocation error in luaL_newstate");
+        *error = sdsnew("Error creating Lua instance.");
+        return false;
+    }
+    int rc = luaL_loadstring(lua_vm, script);
+    if (rc == 0) {
+        FREE_SDS(*bytecode);
+        *bytecode = sdsempty();
+        rc = lua_dump(lua_vm, dump_cb, bytecode, false);
+        if (rc != 0) {
+            MYMPD_LOG_ERROR(NULL, "Error dumping lua bytecode");
+            FREE_SDS(*bytecode);
+            *error = sdsnew("Error creating Lua instance.");
+        }
+    }
+    else {
+        *error = script_get_result(lua_vm, rc);
+    }
+    lua_close(lua_vm);
+    return rc == 0;
+}
+
+/**
+ * Saves the globals and the loaded modules of a fresh lua instance in the registry
+ * @param lua_vm lua instance
+ */
+static void script_vm_snapshot_globals(lua_State *lua_vm) {
+    lua_newtable(lua_vm);
+    lua_pushglobaltable(lua_vm);
+    lua_pushnil(lua_vm);
+    while (lua_next(lua_vm, -2) != 0) {
+        lua_pushvalue(lua_vm, -2);
+        lua_insert(lua_vm, -2);
+        lua_rawset(lua_vm, -5);
+    }
+    lua_pop(lua_vm, 1);
+    lua_setfield(lua_vm, LUA_REGISTRYINDEX, LUA_GLOBALS_SNAPSHOT);
+
+    lua_newtable(lua_vm);
+    luaL_getsubtable(lua_vm, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+    lua_pushnil(lua_vm);
+    while (lua_next(lua_vm, -2) != 0) {
+        lua_pushvalue(lua_vm, -2);
+        lua_insert(lua_vm, -2);
+        lua_rawset(lua_vm, -5);
+    }
+    lua_pop(lua_vm, 1);
+    lua_setfield(lua_vm, LUA_REGISTRYINDEX, LUA_LOADED_SNAPSHOT);
+}
+
+/**
+ * Creates the read-only base for the script environments and saves it in the registry.
+ * The base contains read-only views of the library tables and falls back to the
+ * real globals, e.g. for the mympd_env and mympd_state tables populated by myMPD.
+ * @param lua_vm lua instance
+ */
+static void script_vm_create_env_base(lua_State *lua_vm) {
+    lua_newtable(lua_vm);
+    lua_pushglobaltable(lua_vm);
+    lua_pushnil(lua_vm);
+    while (lua_next(lua_vm, -2) != 0) {
+        if (lua_type(lua_vm, -2) == LUA_TSTRING &&
+            lua_istable(lua_vm, -1) &&
+            strcmp(lua_tostring(lua_vm, -2), "_G") != 0)
+        {
+            script_vm_push_readonly(lua_vm, -1);
+            lua_pushvalue(lua_vm, -3);
+            lua_insert(lua_vm, -2);
+            lua_rawset(lua_vm, -6);
+        }
+        lua_pop(lua_vm, 1);
+    }
+    // metatable of the base, the real globals are on top of the stack
+    lua_newtable(lua_vm);
+    lua_insert(lua_vm, -2);
+    lua_setfield(lua_vm, -2, "__index");
+    lua_pushcfunction(lua_vm, script_vm_readonly_newindex);
+    lua_setfield(lua_vm, -2, "__newindex");
+    lua_pushboolean(lua_vm, 0);
+    lua_setfield(lua_vm, -2, "__metatable");
+    lua_setmetatable(lua_vm, -2);
+    lua_setfield(lua_vm, LUA_REGISTRYINDEX, LUA_ENV_BASE);
+    // string methods are looked up in the real string table, lock its metatable
+    lua_pushstring(lua_vm, "");
+    if (lua_getmetatable(lua_vm, -1) != 0) {
+        lua_pushboolean(lua_vm, 0);
+        lua_setfield(lua_vm, -2, "__metatable");
+        lua_pop(lua_vm, 1);
+    }
+    lua_pop(lua_vm, 1);
+}
+
+/**
+ * Pushes a read-only view of a table.
+ * Reading, iterating with pairs and the length operator are forwarded to the table.
+ * @param lua_vm lua instance
+ * @param idx stack index of the table
+ */
+static void script_vm_push_readonly(lua_State *lua_vm, int idx) {
+    idx = lua_absindex(lua_vm, idx);
+    lua_newtable(lua_vm);
+    lua_newtable(lua_vm);
+    lua_pushvalue(lua_vm, idx);
+    lua_setfield(lua_vm, -2, "__index");
+    lua_pushcfunction(lua_vm, script_vm_readonly_newindex);
+    lua_setfield(lua_vm, -2, "__newindex");
+    lua_pushvalue(lua_vm, idx);
+    lua_pushcclosure(lua_vm, script_vm_readonly_pairs, 1);
+    lua_setfield(lua_vm, -2, "__pairs");
+    lua_pushvalue(lua_vm, idx);
+    lua_pushcclosure(lua_vm, script_vm_readonly_len, 1);
+    lua_setfield(lua_vm, -2, "__len");
+    lua_pushboolean(lua_vm, 0);
+    lua_setfield(lua_vm, -2, "__metatable");
+    lua_setmetatable(lua_vm, -2);
+}
+
+/**
+ * The __newindex metamethod of read-only tables
+ * @param lua_vm lua instance
+ * @return raises an error
+ */
+static int script_vm_readonly_newindex(lua_State *lua_vm) {
+    return luaL_error(lua_vm, "Attempt to modify a read-only table");
+}
+
+/**
+ * Iterator function for the __pairs metamethod of read-only tables
+ * @param lua_vm lua instance
+ * @return number of return values
+ */
+static int script_vm_readonly_next(lua_State *lua_vm) {
+    luaL_checktype(lua_vm, 1, LUA_TTABLE);
+    lua_settop(lua_vm, 2);
+    if (lua_next(lua_vm, 1) != 0) {
+        return 2;
+    }
+    lua_pushnil(lua_vm);
+    return 1;
+}
+
+/**
+ * The __pairs metamethod of read-only tables, iterates the upvalue table
+ * @param lua_vm lua instance
+ * @return number of return values
+ */
+static int script_vm_readonly_pairs(lua_State *lua_vm) {
+    lua_pushcfunction(lua_vm, script_vm_readonly_next);
+    lua_pushvalue(lua_vm, lua_upvalueindex(1));
+    lua_pushnil(lua_vm);
+    return 3;
+}
+
+/**
+ * The __len metamethod of read-only tables, returns the length of the upvalue table
+ * @param lua_vm lua instance
+ * @return number of return values
+ */
+static int script_vm_readonly_len(lua_State *lua_vm) {
+    lua_pushinteger(lua_vm, (lua_Integer)lua_rawlen(lua_vm, lua_upvalueindex(1)));
+    return 1;
+}
+
+/**
+ * Removes all keys from a table that are not in the snapshot table
+ * @param lua_vm lua instance
+ * @param idx stack index of the table to clean up
+ * @param snapshot_idx stack index of the snapshot table
+ */
+static void table_remove_missing(lua_State *lua_vm, int idx, int snapshot_idx) {
+    idx = lua_absindex(lua_vm, idx);
+    snapshot_idx = lua_absindex(lua_vm, snapshot_idx);
+    lua_pushnil(lua_vm);
+    while (lua_next(lua_vm, idx) != 0) {
+        lua_pop(lua_vm, 1);
+        lua_pushvalue(lua_vm, -1);
+        if (lua_rawget(lua_vm, snapshot_idx) == LUA_TNIL) {
+            // assigning nil to an existing field is allowed during traversal
+            lua_pushvalue(lua_vm, -2);
+            lua_pushnil(lua_vm);
+            lua_rawset(lua_vm, idx);
         }
+        lua_pop(lua_vm, 1);
     }
-    lua_setglobal(script_arg->lua_vm, "mympd_arguments");
+}
+
+/**
+ * Callback function for lua_dump to save the lua script bytecode
+ * @param lua_vm lua state
+ * @param p chunk to write
+ * @param sz chunk size
+ * @param ud pointer to the sds string for the bytecode
+ * @return 0 on success
+ */
+static int dump_cb(lua_State *lua_vm, const void* p, size_t sz, void* ud) {
+    (void)lua_vm;
+    sds *bytecode = (sds *)ud;
+    *bytecode = sdscatlen(*bytecode, p, sz);
+    return 0;
 }
 
 /**
@@ -21,5 +21,9 @@ bool script_start(struct t_scripts_state *scripts_state, sds scriptname, struct
         const char *partition, bool localscript, enum script_start_events start_event,
         unsigned request_id, unsigned long conn_id, sds *error);
 bool script_validate(struct t_config *config, sds scriptname, sds script, sds *error);
+lua_State *script_vm_new(void);
+void script_vm_set_env(lua_State *lua_vm);
+void script_vm_reset(lua_State *lua_vm);
+void script_vm_populate_globals(lua_State *lua_vm, struct t_script_thread_arg *script_arg);
 
 #endif
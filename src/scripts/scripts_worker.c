@@ -14,26 +14,226 @@
 #include "src/lib/api.h"
 #include "src/lib/jsonrpc.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/thread.h"
-#include "src/scripts/util.h"
+#include "src/scripts/scripts_lua.h"
+
+#include <errno.h>
+#include <time.h>
+
+// Private definitions
+
+static bool script_worker_start(struct t_script_worker_pool *pool);
+static void *script_worker_loop(void *arg_pool);
+static void script_run(lua_State *lua_vm, struct t_script_thread_arg *script_arg);
+static void free_job_data(struct t_list_node *current);
+
+// Public functions
+
+/**
+ * Creates the script worker pool and starts the threads
+ * @return the pool or NULL if no thread could be started
+ */
+struct t_script_worker_pool *script_worker_pool_new(void) {
+    struct t_script_worker_pool *pool = malloc_assert(sizeof(struct t_script_worker_pool));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wakeup, NULL);
+    pthread_cond_init(&pool->stopped, NULL);
+    list_init(&pool->jobs);
+    pool->stop = false;
+    pool->threads = 0;
+    pool->busy = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (unsigned i = 0; i < SCRIPT_WORKER_POOL_SIZE; i++) {
+        if (script_worker_start(pool) == false) {
+            break;
+        }
+    }
+    unsigned threads = pool->threads;
+    pthread_mutex_unlock(&pool->mutex);
+    if (threads == 0) {
+        script_worker_pool_free(pool);
+        return NULL;
+    }
+    MYMPD_LOG_INFO(NULL, "Started %u script worker threads", threads);
+    return pool;
+}
+
+/**
+ * Stops the threads and frees the pool.
+ * Waits for running scripts up to SCRIPT_WORKER_POOL_STOP_WAIT_S seconds.
+ * @param pool the pool to free
+ */
+void script_worker_pool_free(struct t_script_worker_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    struct timespec max_wait;
+    if (clock_gettime(CLOCK_REALTIME, &max_wait) == -1) {
+        MYMPD_LOG_ERROR(NULL, "Error getting realtime");
+    }
+    max_wait.tv_sec += SCRIPT_WORKER_POOL_STOP_WAIT_S;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wakeup);
+    while (pool->threads > 0) {
+        int rc = pthread_cond_timedwait(&pool->stopped, &pool->mutex, &max_wait);
+        if (rc == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (pool->threads > 0) {
+        // threads are still executing scripts, the pool can not be freed
+        MYMPD_LOG_WARN(NULL, "%u script worker threads are still running", pool->threads);
+        pthread_mutex_unlock(&pool->mutex);
+        return;
+    }
+    list_clear_user_data(&pool->jobs, free_job_data);
+    pthread_mutex_unlock(&pool->mutex);
+    pthread_cond_destroy(&pool->stopped);
+    pthread_cond_destroy(&pool->wakeup);
+    pthread_mutex_destroy(&pool->mutex);
+    FREE_PTR(pool);
+}
+
+/**
+ * Queues a script for execution.
+ * Starts an additional thread up to MAX_SCRIPT_WORKER_THREADS if all threads
+ * are busy, scripts can block a thread for a long time, e.g. in mympd.api calls.
+ * @param pool the pool
+ * @param script_arg script to execute, the pool takes ownership on success
+ * @return true on success, false if the pool is not running or the queue is full
+ */
+bool script_worker_pool_push(struct t_script_worker_pool *pool, struct t_script_thread_arg *script_arg) {
+    if (pool == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->stop == true ||
+        pool->jobs.length >= SCRIPT_WORKER_QUEUE_MAX)
+    {
+        pthread_mutex_unlock(&pool->mutex);
+        return false;
+    }
+    list_push(&pool->jobs, "", 0, NULL, script_arg);
+    if (pool->jobs.length > pool->threads - pool->busy &&
+        pool->threads < MAX_SCRIPT_WORKER_THREADS)
+    {
+        // the script is queued if the thread can not be started
+        script_worker_start(pool);
+    }
+    pthread_cond_signal(&pool->wakeup);
+    pthread_mutex_unlock(&pool->mutex);
+    return true;
+}
+
+// Private functions
+
+/**
+ * Starts a detached script worker thread, the caller must hold the pool mutex
+ * @param pool the pool
+ * @return true on success, else false
+ */
+static bool script_worker_start(struct t_script_worker_pool *pool) {
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0 ||
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
+    {
+        MYMPD_LOG_ERROR(NULL, "Can not set script worker thread attributes");
+        return false;
+    }
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, script_worker_loop, pool);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Can not create script worker thread");
+        return false;
+    }
+    pool->threads++;
+    MYMPD_LOG_DEBUG(NULL, "Started script worker thread %u", pool->threads);
+    return true;
+}
 
 /**
- * Main function for the scripts_worker thread.
- * @param script_thread_arg pointer to t_script_thread_arg struct
+ * Main function for the script worker threads.
+ * Creates the lua instance once and executes the queued scripts.
+ * Threads above SCRIPT_WORKER_POOL_SIZE exit if no script is queued.
+ * @param arg_pool pointer to the t_script_worker_pool struct
  * @return NULL
  */
-void *script_run(void *script_thread_arg) {
-    script_worker_threads++;
+static void *script_worker_loop(void *arg_pool) {
+    struct t_script_worker_pool *pool = (struct t_script_worker_pool *)arg_pool;
     thread_logname = sds_replace(thread_logname, "scripts_worker");
     set_threadname(thread_logname);
-    struct t_script_thread_arg *script_arg = (struct t_script_thread_arg *) script_thread_arg;
 
+    lua_State *lua_vm = script_vm_new();
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->stop == false) {
+        if (pool->jobs.head == NULL) {
+            pthread_cond_wait(&pool->wakeup, &pool->mutex);
+            continue;
+        }
+        struct t_list_node *job = list_shift_first(&pool->jobs);
+        pool->busy++;
+        pthread_mutex_unlock(&pool->mutex);
+        struct t_script_thread_arg *script_arg = (struct t_script_thread_arg *)job->user_data;
+        list_node_free(job);
+
+        if (lua_vm == NULL) {
+            // try again to create the lua instance
+            lua_vm = script_vm_new();
+        }
+        if (lua_vm != NULL) {
+            script_run(lua_vm, script_arg);
+            script_vm_reset(lua_vm);
+        }
+        else if (script_arg->start_event == SCRIPT_START_HTTP) {
+            send_script_raw_error(script_arg->conn_id, script_arg->partition, "Error creating Lua instance.");
+        }
+        else {
+            send_jsonrpc_notify(JSONRPC_FACILITY_SCRIPT, JSONRPC_SEVERITY_ERROR, script_arg->partition, "Error creating Lua instance.");
+        }
+        free_t_script_thread_arg(script_arg);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->busy--;
+        if (pool->jobs.head == NULL &&
+            pool->threads > SCRIPT_WORKER_POOL_SIZE)
+        {
+            // stop the additional thread
+            break;
+        }
+    }
+    pool->threads--;
+    pthread_cond_signal(&pool->stopped);
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (lua_vm != NULL) {
+        lua_close(lua_vm);
+    }
+    FREE_SDS(thread_logname);
+    return NULL;
+}
+
+/**
+ * Executes the script and sends the result
+ * @param lua_vm preloaded lua instance
+ * @param script_arg pointer to t_script_thread_arg struct
+ */
+static void script_run(lua_State *lua_vm, struct t_script_thread_arg *script_arg) {
     MYMPD_LOG_DEBUG(NULL, "Start script");
-    bool rc = lua_pcall(script_arg->lua_vm, 0, 1, 0);
+    int rc = luaL_loadbuffer(lua_vm, script_arg->bytecode, sdslen(script_arg->bytecode), script_arg->script_name);
+    if (rc == 0) {
+        script_vm_set_env(lua_vm);
+        script_vm_populate_globals(lua_vm, script_arg);
+        rc = lua_pcall(lua_vm, 0, 1, 0);
+    }
     MYMPD_LOG_DEBUG(NULL, "End script");
 
-    sds result = script_get_result(script_arg->lua_vm, rc);
+    sds result = script_get_result(lua_vm, rc);
     if (rc == 0) {
         if (script_arg->start_event == SCRIPT_START_HTTP) {
             if (sdslen(result) == 0) {
@@ -77,8 +277,12 @@ void *script_run(void *script_thread_arg) {
         MYMPD_LOG_ERROR(script_arg->partition, "Error executing script %s: %s", script_arg->script_name, result);
     }
     FREE_SDS(result);
-    free_t_script_thread_arg(script_arg);
-    script_worker_threads--;
-    FREE_SDS(thread_logname);
-    return NULL;
+}
+
+/**
+ * Frees a queued script
+ * @param current list node
+ */
+static void free_job_data(struct t_list_node *current) {
+    free_t_script_thread_arg((struct t_script_thread_arg *)current->user_data);
 }
@@ -11,10 +11,27 @@
 #ifndef MYMPD_SCRIPTS_WORKER_H
 #define MYMPD_SCRIPTS_WORKER_H
 
-#include <lauxlib.h>
-#include <lua.h>
-#include <lualib.h>
+#include "src/lib/list.h"
+#include "src/scripts/util.h"
 
-void *script_run(void *script_thread_arg);
+#include <pthread.h>
+#include <stdbool.h>
+
+/**
+ * Pool of script worker threads, each thread owns a preloaded lua instance
+ */
+struct t_script_worker_pool {
+    pthread_mutex_t mutex;   //!< protects the pool
+    pthread_cond_t wakeup;   //!< signals new jobs and the stop request
+    pthread_cond_t stopped;  //!< signals the exit of a thread
+    struct t_list jobs;      //!< queued t_script_thread_arg structs
+    bool stop;               //!< stops the threads
+    unsigned threads;        //!< number of running threads
+    unsigned busy;           //!< number of threads executing a script
+};
+
+struct t_script_worker_pool *script_worker_pool_new(void);
+void script_worker_pool_free(struct t_script_worker_pool *pool);
+bool script_worker_pool_push(struct t_script_worker_pool *pool, struct t_script_thread_arg *script_arg);
 
 #endif
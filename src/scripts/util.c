@@ -45,6 +45,7 @@ void scripts_state_default(struct t_scripts_state *scripts_state, struct t_confi
     scripts_state->config = config;
     list_init(&scripts_state->var_list);
     list_init(&scripts_state->script_list);
+    scripts_state->worker_pool = NULL;
 }
 
 /**
@@ -76,8 +77,12 @@ void scripts_state_free(struct t_scripts_state *scripts_state) {
 void free_t_script_thread_arg(struct t_script_thread_arg *script_thread_arg) {
     FREE_SDS(script_thread_arg->script_name);
     FREE_SDS(script_thread_arg->partition);
-    if (script_thread_arg->lua_vm != NULL) {
-        lua_close(script_thread_arg->lua_vm);
+    FREE_SDS(script_thread_arg->bytecode);
+    if (script_thread_arg->arguments != NULL) {
+        list_free(script_thread_arg->arguments);
+    }
+    if (script_thread_arg->vars != NULL) {
+        list_free(script_thread_arg->vars);
     }
     FREE_PTR(script_thread_arg);
 }
@@ -19,13 +19,16 @@
 #include <lua.h>
 #include <lualib.h>
 
+struct t_script_worker_pool;
+
 /**
  * Holds central scripts state and configuration values.
  */
 struct t_scripts_state {
-    struct t_config *config;     //!< pointer to static config
-    struct t_list var_list;      //!< list of variables for scripts
-    struct t_list script_list;   //!< list of scripts
+    struct t_config *config;                    //!< pointer to static config
+    struct t_list var_list;                     //!< list of variables for scripts
+    struct t_list script_list;                  //!< list of scripts
+    struct t_script_worker_pool *worker_pool;   //!< pool of script worker threads
 };
 
 /**
@@ -40,7 +43,9 @@ struct t_script_list_data {
  * Struct for passing values to the script execute function
  */
 struct t_script_thread_arg {
-    lua_State *lua_vm;                     //!< new lua vm
+    sds bytecode;                          //!< compiled lua script
+    struct t_list *arguments;              //!< script arguments
+    struct t_list *vars;                   //!< user defined variables
     sds script_name;                       //!< name of the script
     sds partition;                         //!< execute the script in this partition
     enum script_start_events start_event;  //!< script start event
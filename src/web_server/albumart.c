@@ -22,25 +22,12 @@
 #include "src/lib/sds_extras.h"
 #include "src/lib/utility.h"
 #include "src/lib/validate.h"
+#include "src/web_server/albumart_worker.h"
 #include "src/web_server/placeholder.h"
 #include "src/web_server/webradio.h"
 
 #include <libgen.h>
 
-//optional includes
-#ifdef MYMPD_ENABLE_LIBID3TAG
-    #include "src/web_server/albumart_id3.h"
-#endif
-
-#ifdef MYMPD_ENABLE_FLAC
-    #include "src/web_server/albumart_flac.h"
-#endif
-
-/**
- * Privat definitions
- */
-static bool handle_coverextract(struct mg_connection *nc, sds cachedir, const char *uri, const char *media_file, bool covercache, int offset);
-
 /**
  * Public functions
  */
@@ -71,7 +58,7 @@ void webserver_send_albumart_redirect(struct mg_connection *nc, sds data) {
 }
 
 /**
- * Sends the albumart response from mpd to the client
+ * Sends the albumart response from mpd or the albumart worker pool to the client
  * @param nc mongoose connection
  * @param data jsonrpc response
  * @param binary the image
@@ -79,13 +66,30 @@ void webserver_send_albumart_redirect(struct mg_connection *nc, sds data) {
 void webserver_send_albumart(struct mg_connection *nc, sds data, sds binary) {
     size_t len = sdslen(binary);
     sds mime_type = NULL;
-    if (len > 0 &&
+    sds etag = NULL;
+    bool not_modified = false;
+    if (json_get_string(data, "$.result.etag", 1, NAME_LEN_MAX, &etag, vcb_isprint, NULL) == true &&
+        json_get_bool(data, "$.result.notModified", &not_modified, NULL) == true &&
+        not_modified == true)
+    {
+        MYMPD_LOG_DEBUG(NULL, "Sending 304 Not Modified for albumart to %lu", nc->id);
+        mg_printf(nc, "HTTP/1.1 304 Not Modified\r\n"
+            EXTRA_HEADERS_IMAGE
+            "ETag: %s\r\n"
+            "Content-Length: 0\r\n\r\n",
+            etag);
+        webserver_handle_connection_close(nc);
+    }
+    else if (len > 0 &&
         json_get_string(data, "$.result.mime_type", 1, 200, &mime_type, vcb_isname, NULL) == true &&
         strncmp(mime_type, "image/", 6) == 0)
     {
         MYMPD_LOG_DEBUG(NULL, "Serving albumart from memory (%s - %lu bytes) (%lu)", mime_type, (unsigned long)len, nc->id);
         sds headers = sdscatfmt(sdsempty(), "Content-Type: %S\r\n", mime_type);
         headers = sdscat(headers, EXTRA_HEADERS_IMAGE);
+        if (etag != NULL) {
+            headers = sdscatfmt(headers, "ETag: %S\r\n", etag);
+        }
         webserver_send_data(nc, binary, len, headers);
         FREE_SDS(headers);
     }
@@ -93,6 +97,7 @@ void webserver_send_albumart(struct mg_connection *nc, sds data, sds binary) {
         webserver_redirect_placeholder_image(nc, PLACEHOLDER_NA);
     }
     FREE_SDS(mime_type);
+    FREE_SDS(etag);
 }
 
 /**
@@ -122,7 +127,7 @@ void request_handler_albumart_by_album_id(struct mg_http_message *hm, unsigned l
  * @param conn_id connection id
  * @param size albumart size
  * @return true: an image was served,
- *         false: request was sent to the mympd_api thread to get the image by MPD
+ *         false: request was sent to the albumart worker pool or to the mympd_api thread
  */
 bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_message *hm,
         struct t_mg_user_data *mg_user_data, unsigned long conn_id, enum albumart_sizes size)
@@ -149,8 +154,15 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
 
     MYMPD_LOG_DEBUG(NULL, "Handle albumart for uri \"%s\", offset %d", uri, offset);
 
+    //check the negative covercache entry, it is validated against the media file by the albumart worker
+    bool negative = config->cache_cover_keep_days != CACHE_DISK_DISABLED &&
+        is_streamuri(uri) == false &&
+        cache_disk_negative_check(config->cachedir, DIR_CACHE_COVER, uri, offset, NULL) == true;
+
     //check covercache and serve image from it if found
-    if (check_imagescache(nc, hm, mg_user_data, DIR_CACHE_COVER, uri, offset) == true) {
+    if (negative == false &&
+        check_imagescache(nc, hm, mg_user_data, DIR_CACHE_COVER, uri, offset) == true)
+    {
         FREE_SDS(uri);
         return true;
     }
@@ -194,55 +206,25 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
         return true;
     }
 
-    if (sdslen(mg_user_data->music_directory) > 0) {
-        //create absolute file
-        sds mediafile = sdscatfmt(sdsempty(), "%S/%S", mg_user_data->music_directory, uri);
-        MYMPD_LOG_DEBUG(NULL, "Absolut media_file: %s", mediafile);
-        //try image in folder under music_directory
-        if (mg_user_data->coverimage_names_len > 0 &&
-            offset == 0)
-        {
-            sds path = sdsdup(uri);
-            path = sds_dirname(path);
-            if (is_virtual_cuedir(mg_user_data->music_directory, path) == true) {
-                //fix virtual cue sheet directories
-                path = sds_dirname(path);
-            }
-            bool found = false;
-            sds coverfile = sdsempty();
-            if (size == ALBUMART_THUMBNAIL) {
-                found = find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->thumbnail_names, mg_user_data->thumbnail_names_len);
-            }
-            if (found == false) {
-                found = find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->coverimage_names, mg_user_data->coverimage_names_len);
-            }
-            if (found == true) {
-                webserver_serve_file(nc, hm, mg_user_data->browse_directory, coverfile);
-                FREE_SDS(uri);
-                FREE_SDS(coverfile);
-                FREE_SDS(mediafile);
-                FREE_SDS(path);
-                return true;
-            }
-
-            FREE_SDS(coverfile);
-            MYMPD_LOG_DEBUG(NULL, "No cover file found in music directory");
-            FREE_SDS(path);
-        }
+    struct mg_str *if_none_match = mg_http_get_header(hm, "If-None-Match");
+    sds etag = if_none_match != NULL && if_none_match->len <= NAME_LEN_MAX
+        ? sdsnewlen(if_none_match->buf, if_none_match->len)
+        : sdsempty();
+    if (sdslen(mg_user_data->music_directory) > 0 &&
+        albumart_workers_push(mg_user_data, conn_id, uri, offset, size, negative, etag) == true)
+    {
+        FREE_SDS(etag);
+        // the albumart worker pool responds asynchronously
+        FREE_SDS(uri);
+        return false;
+    }
+    FREE_SDS(etag);
 
-        if (testfile_read(mediafile) == true) {
-            //try to extract albumart from media file
-            bool covercache = mg_user_data->config->cache_cover_keep_days != CACHE_DISK_DISABLED
-                ? true
-                : false;
-            bool rc = handle_coverextract(nc, config->cachedir, uri, mediafile, covercache, offset);
-            if (rc == true) {
-                FREE_SDS(uri);
-                FREE_SDS(mediafile);
-                return true;
-            }
-        }
-        FREE_SDS(mediafile);
+    if (negative == true) {
+        MYMPD_LOG_DEBUG(NULL, "No coverimage found for \"%s\" (cached)", uri);
+        FREE_SDS(uri);
+        webserver_redirect_placeholder_image(nc, PLACEHOLDER_NA);
+        return true;
     }
 
     //ask mpd - mpd can read only first image
@@ -263,55 +245,3 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
     webserver_redirect_placeholder_image(nc, PLACEHOLDER_NA);
     return true;
 }
-
-/**
- * Extracts albumart from media files
- * @param nc mongoose connection
- * @param cachedir covercache directory
- * @param uri song uri
- * @param media_file full path to the song
- * @param covercache true = covercache is enabled
- * @param offset number of embedded image to extract
- * @return true on success, else false
- */
-static bool handle_coverextract(struct mg_connection *nc, sds cachedir,
-        const char *uri, const char *media_file, bool covercache, int offset)
-{
-    #if !defined MYMPD_ENABLE_LIBID3TAG && !defined MYMPD_ENABLE_FLAC
-        (void) covercache;
-        (void) cachedir;
-        (void) offset;
-        return false;
-    #endif
-
-    bool rc = false;
-    const char *mime_type_media_file = get_mime_type_by_ext(media_file);
-    MYMPD_LOG_DEBUG(NULL, "Handle coverextract for uri \"%s\"", uri);
-    MYMPD_LOG_DEBUG(NULL, "Mimetype of %s is %s", media_file, mime_type_media_file);
-    sds binary = sdsempty();
-    if (strcmp(mime_type_media_file, "audio/mpeg") == 0) {
-        #ifdef MYMPD_ENABLE_LIBID3TAG
-            rc = handle_coverextract_id3(cachedir, uri, media_file, &binary, covercache, offset);
-        #endif
-    }
-    else if (strcmp(mime_type_media_file, "audio/ogg") == 0) {
-        #ifdef MYMPD_ENABLE_FLAC
-            rc = handle_coverextract_flac(cachedir, uri, media_file, &binary, true, covercache, offset);
-        #endif
-    }
-    else if (strcmp(mime_type_media_file, "audio/flac") == 0) {
-        #ifdef MYMPD_ENABLE_FLAC
-            rc = handle_coverextract_flac(cachedir, uri, media_file, &binary, false, covercache, offset);
-        #endif
-    }
-    if (rc == true) {
-        const char *mime_type = get_mime_type_by_magic_stream(binary);
-        MYMPD_LOG_DEBUG(NULL, "Serving coverimage for \"%s\" (%s)", media_file, mime_type);
-        sds headers = sdscatfmt(sdsempty(), "Content-Type: %s\r\n", mime_type);
-        headers = sdscat(headers, EXTRA_HEADERS_IMAGE);
-        webserver_send_data(nc, binary,  sdslen(binary), headers);
-        FREE_SDS(headers);
-    }
-    FREE_SDS(binary);
-    return rc;
-}
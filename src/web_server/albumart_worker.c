@@ -0,0 +1,489 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Albumart worker pool
+ */
+
+#include "compile_time.h"
+#include "src/web_server/albumart_worker.h"
+
+#include "dist/rax/rax.h"
+#include "src/lib/api.h"
+#include "src/lib/cache_disk.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/jsonrpc.h"
+#include "src/lib/list.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/mimetype.h"
+#include "src/lib/msg_queue.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/thread.h"
+#include "src/lib/utility.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+
+//optional includes
+#ifdef MYMPD_ENABLE_LIBID3TAG
+    #include "src/web_server/albumart_id3.h"
+#endif
+
+#ifdef MYMPD_ENABLE_FLAC
+    #include "src/web_server/albumart_flac.h"
+#endif
+
+/**
+ * The albumart worker pool looks up the albumart for song uris that are not
+ * found in the covercache. Probing the music directory and extracting
+ * embedded images can be slow, the webserver thread only queues the job.
+ * Concurrent requests for the same image are coalesced into one job.
+ * The workers send the response through the web_server_queue.
+ * Responses carry an ETag derived from the modification time of the image
+ * source and the image size, matching If-None-Match headers are answered
+ * without the image.
+ */
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Albumart lookup job
+ */
+struct t_albumart_job {
+    sds key;                    //!< key of the job in the pending map
+    sds uri;                    //!< song uri
+    int offset;                 //!< number of the embedded image
+    enum albumart_sizes size;   //!< albumart size
+    sds music_directory;        //!< mpd music directory
+    sds *coverimage_names;      //!< sds array of coverimage names
+    int coverimage_names_len;   //!< length of coverimage_names array
+    sds *thumbnail_names;       //!< sds array of coverimage thumbnail names
+    int thumbnail_names_len;    //!< length of thumbnail_names array
+    bool feat_albumart;         //!< feature flag for the mpd albumart command
+    bool negative;              //!< true if a negative covercache entry exists
+    struct t_list waiters;      //!< connections waiting for this job, key is the If-None-Match header, value_i the connection id
+};
+
+/**
+ * State of the albumart worker pool
+ */
+struct t_albumart_workers {
+    pthread_t threads[ALBUMART_WORKERS];  //!< worker threads
+    unsigned threads_len;                 //!< number of started threads
+    pthread_mutex_t mutex;                //!< protects the jobs list, the pending map and stop
+    pthread_cond_t wakeup;                //!< signals new jobs and the stop request
+    struct t_list jobs;                   //!< queued jobs, user_data is a struct t_albumart_job
+    rax *pending;                         //!< queued and running jobs by key
+    bool stop;                            //!< true if the workers should stop
+    struct t_config *config;              //!< pointer to myMPD config
+};
+
+static struct t_albumart_workers albumart_workers = {
+    .threads_len = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wakeup = PTHREAD_COND_INITIALIZER,
+    .pending = NULL,
+    .stop = false,
+    .config = NULL
+};
+
+static void *albumart_worker_run(void *arg);
+static void albumart_job_run(struct t_albumart_job *job);
+static bool albumart_job_find_image(struct t_albumart_job *job, const char *media_file, sds *binary, const char **mime_type, sds *etag);
+static bool albumart_job_coverextract(struct t_albumart_job *job, const char *media_file, sds *binary);
+static void albumart_job_respond(struct t_albumart_job *job, sds binary, const char *mime_type, const char *etag);
+static sds albumart_etag(sds etag, const char *path, size_t size);
+static void albumart_job_free(struct t_albumart_job *job);
+static bool albumart_thumbnail_is_full(struct t_mg_user_data *mg_user_data, int offset);
+static sds *names_dup(sds *names, int names_len);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Starts the albumart worker threads
+ * @param config pointer to myMPD config
+ * @return true on success, else false
+ */
+bool albumart_workers_start(struct t_config *config) {
+    albumart_workers.config = config;
+    albumart_workers.stop = false;
+    albumart_workers.pending = raxNew();
+    list_init(&albumart_workers.jobs);
+    for (unsigned i = 0; i < ALBUMART_WORKERS; i++) {
+        if (pthread_create(&albumart_workers.threads[i], NULL, albumart_worker_run, NULL) != 0) {
+            MYMPD_LOG_ERROR(NULL, "Can not create albumart worker thread");
+            break;
+        }
+        albumart_workers.threads_len++;
+    }
+    MYMPD_LOG_DEBUG(NULL, "Started %u albumart worker threads", albumart_workers.threads_len);
+    return albumart_workers.threads_len > 0;
+}
+
+/**
+ * Stops the albumart worker threads and frees the queued jobs
+ */
+void albumart_workers_stop(void) {
+    pthread_mutex_lock(&albumart_workers.mutex);
+    albumart_workers.stop = true;
+    pthread_cond_broadcast(&albumart_workers.wakeup);
+    pthread_mutex_unlock(&albumart_workers.mutex);
+    for (unsigned i = 0; i < albumart_workers.threads_len; i++) {
+        pthread_join(albumart_workers.threads[i], NULL);
+    }
+    albumart_workers.threads_len = 0;
+    struct t_list_node *current;
+    while ((current = list_shift_first(&albumart_workers.jobs)) != NULL) {
+        albumart_job_free((struct t_albumart_job *)current->user_data);
+        list_node_free(current);
+    }
+    if (albumart_workers.pending != NULL) {
+        raxFree(albumart_workers.pending);
+        albumart_workers.pending = NULL;
+    }
+}
+
+/**
+ * Queues an albumart lookup for a song uri.
+ * Joins an already queued or running job for the same image.
+ * @param mg_user_data pointer to mongoose configuration
+ * @param conn_id connection id
+ * @param uri song uri
+ * @param offset number of the embedded image
+ * @param size albumart size
+ * @param negative true if a negative covercache entry exists
+ * @param if_none_match value of the If-None-Match header or empty string
+ * @return true if the job was queued, else false
+ */
+bool albumart_workers_push(struct t_mg_user_data *mg_user_data, unsigned long conn_id,
+        const char *uri, int offset, enum albumart_sizes size, bool negative, const char *if_none_match)
+{
+    if (albumart_workers.threads_len == 0) {
+        return false;
+    }
+    if (size == ALBUMART_THUMBNAIL &&
+        albumart_thumbnail_is_full(mg_user_data, offset) == true)
+    {
+        // the lookup result is the same, share the job with full size requests
+        size = ALBUMART_FULL;
+    }
+    sds key = sdscatfmt(sdsempty(), "%i:%i:%s", (int)size, offset, uri);
+    pthread_mutex_lock(&albumart_workers.mutex);
+    void *data;
+    if (raxFind(albumart_workers.pending, (unsigned char *)key, sdslen(key), &data) == 1) {
+        struct t_albumart_job *job = (struct t_albumart_job *)data;
+        list_push(&job->waiters, if_none_match, (int64_t)conn_id, NULL, NULL);
+        pthread_mutex_unlock(&albumart_workers.mutex);
+        MYMPD_LOG_DEBUG(NULL, "Joined pending albumart job \"%s\" for connection %lu", key, conn_id);
+        FREE_SDS(key);
+        return true;
+    }
+    struct t_albumart_job *job = malloc_assert(sizeof(struct t_albumart_job));
+    job->key = key;
+    job->uri = sdsnew(uri);
+    job->offset = offset;
+    job->size = size;
+    job->music_directory = sdsdup(mg_user_data->music_directory);
+    job->coverimage_names = names_dup(mg_user_data->coverimage_names, mg_user_data->coverimage_names_len);
+    job->coverimage_names_len = mg_user_data->coverimage_names_len;
+    job->thumbnail_names = names_dup(mg_user_data->thumbnail_names, mg_user_data->thumbnail_names_len);
+    job->thumbnail_names_len = mg_user_data->thumbnail_names_len;
+    job->feat_albumart = mg_user_data->feat_albumart;
+    job->negative = negative;
+    list_init(&job->waiters);
+    list_push(&job->waiters, if_none_match, (int64_t)conn_id, NULL, NULL);
+    raxInsert(albumart_workers.pending, (unsigned char *)job->key, sdslen(job->key), job, NULL);
+    list_push(&albumart_workers.jobs, "", 0, NULL, job);
+    pthread_cond_signal(&albumart_workers.wakeup);
+    pthread_mutex_unlock(&albumart_workers.mutex);
+    return true;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Main function of an albumart worker thread
+ * @param arg unused
+ * @return NULL
+ */
+static void *albumart_worker_run(void *arg) {
+    (void)arg;
+    thread_logname = sdsnew("albumart");
+    set_threadname(thread_logname);
+    pthread_mutex_lock(&albumart_workers.mutex);
+    while (albumart_workers.stop == false) {
+        struct t_list_node *current = list_shift_first(&albumart_workers.jobs);
+        if (current == NULL) {
+            pthread_cond_wait(&albumart_workers.wakeup, &albumart_workers.mutex);
+            continue;
+        }
+        struct t_albumart_job *job = (struct t_albumart_job *)current->user_data;
+        list_node_free(current);
+        pthread_mutex_unlock(&albumart_workers.mutex);
+        albumart_job_run(job);
+        pthread_mutex_lock(&albumart_workers.mutex);
+    }
+    pthread_mutex_unlock(&albumart_workers.mutex);
+    FREE_SDS(thread_logname);
+    return NULL;
+}
+
+/**
+ * Looks up the albumart and responds to all waiting connections
+ * @param job the job, it is freed by this function
+ */
+static void albumart_job_run(struct t_albumart_job *job) {
+    MYMPD_LOG_DEBUG(NULL, "Handle albumart for uri \"%s\", offset %d", job->uri, job->offset);
+    struct t_config *config = albumart_workers.config;
+    bool covercache = config->cache_cover_keep_days != CACHE_DISK_DISABLED
+        ? true
+        : false;
+    sds mediafile = sdscatfmt(sdsempty(), "%S/%S", job->music_directory, job->uri);
+    MYMPD_LOG_DEBUG(NULL, "Absolut media_file: %s", mediafile);
+    sds binary = sdsempty();
+    const char *mime_type = NULL;
+    sds etag = sdsempty();
+    bool negative = job->negative == true &&
+        cache_disk_negative_check(config->cachedir, DIR_CACHE_COVER, job->uri, job->offset, mediafile) == true;
+    bool found = negative == false &&
+        albumart_job_find_image(job, mediafile, &binary, &mime_type, &etag) == true;
+    FREE_SDS(mediafile);
+    // no more connections can join this job
+    pthread_mutex_lock(&albumart_workers.mutex);
+    raxRemove(albumart_workers.pending, (unsigned char *)job->key, sdslen(job->key), NULL);
+    pthread_mutex_unlock(&albumart_workers.mutex);
+
+    if (found == true) {
+        albumart_job_respond(job, binary, mime_type, etag);
+    }
+    else if (negative == false &&
+        job->feat_albumart == true &&
+        job->offset == 0)
+    {
+        //ask mpd - mpd can read only first image
+        struct t_list_node *current = job->waiters.head;
+        while (current != NULL) {
+            MYMPD_LOG_DEBUG(NULL, "Sending INTERNAL_API_ALBUMART_BY_URI to mympdapi_queue");
+            struct t_work_request *request = create_request(REQUEST_TYPE_DEFAULT, (unsigned long)current->value_i, 0,
+                INTERNAL_API_ALBUMART_BY_URI, NULL, MPD_PARTITION_DEFAULT);
+            request->data = tojson_sds(request->data, "uri", job->uri, false);
+            request->data = jsonrpc_end(request->data);
+            mympd_queue_push(mympd_api_queue, request, 0);
+            current = current->next;
+        }
+    }
+    else {
+        MYMPD_LOG_INFO(NULL, "No coverimage found for \"%s\"", job->uri);
+        if (negative == false &&
+            covercache == true)
+        {
+            cache_disk_negative_write(config->cachedir, DIR_CACHE_COVER, job->uri, job->offset);
+        }
+        // an empty response is answered with the placeholder image
+        albumart_job_respond(job, binary, NULL, NULL);
+    }
+    FREE_SDS(binary);
+    FREE_SDS(etag);
+    albumart_job_free(job);
+}
+
+/**
+ * Searches the albumart in the music directory and in the media file
+ * @param job the job
+ * @param media_file full path to the song
+ * @param binary already allocated sds string to set the image
+ * @param mime_type pointer to set the mime type of the image
+ * @param etag already allocated sds string to set the etag of the image
+ * @return true if an image was found, else false
+ */
+static bool albumart_job_find_image(struct t_albumart_job *job, const char *media_file, sds *binary, const char **mime_type, sds *etag) {
+    //try image in folder under music_directory
+    if (job->coverimage_names_len > 0 &&
+        job->offset == 0)
+    {
+        sds path = sdsdup(job->uri);
+        path = sds_dirname(path);
+        if (is_virtual_cuedir(job->music_directory, path) == true) {
+            //fix virtual cue sheet directories
+            path = sds_dirname(path);
+        }
+        bool found = false;
+        sds coverfile = sdsempty();
+        if (job->size == ALBUMART_THUMBNAIL) {
+            found = find_image_in_folder(&coverfile, job->music_directory, path, job->thumbnail_names, job->thumbnail_names_len);
+        }
+        if (found == false) {
+            found = find_image_in_folder(&coverfile, job->music_directory, path, job->coverimage_names, job->coverimage_names_len);
+        }
+        FREE_SDS(path);
+        if (found == true) {
+            int nread = 0;
+            *binary = sds_getfile_binary(*binary, coverfile, ALBUMART_FILE_SIZE_MAX, &nread);
+            if (nread > 0) {
+                *mime_type = get_mime_type_by_ext(coverfile);
+                *etag = albumart_etag(*etag, coverfile, sdslen(*binary));
+                MYMPD_LOG_DEBUG(NULL, "Serving file %s (%s)", coverfile, *mime_type);
+                FREE_SDS(coverfile);
+                return true;
+            }
+            sdsclear(*binary);
+        }
+        FREE_SDS(coverfile);
+        MYMPD_LOG_DEBUG(NULL, "No cover file found in music directory");
+    }
+
+    //try to extract albumart from media file
+    bool rc = false;
+    if (testfile_read(media_file) == true) {
+        rc = albumart_job_coverextract(job, media_file, binary);
+        if (rc == true) {
+            *mime_type = get_mime_type_by_magic_stream(*binary);
+            *etag = albumart_etag(*etag, media_file, sdslen(*binary));
+            MYMPD_LOG_DEBUG(NULL, "Serving coverimage for \"%s\" (%s)", media_file, *mime_type);
+        }
+    }
+    return rc;
+}
+
+/**
+ * Extracts albumart from media files
+ * @param job the job
+ * @param media_file full path to the song
+ * @param binary already allocated sds string to set the image
+ * @return true on success, else false
+ */
+static bool albumart_job_coverextract(struct t_albumart_job *job, const char *media_file, sds *binary) {
+    #if !defined MYMPD_ENABLE_LIBID3TAG && !defined MYMPD_ENABLE_FLAC
+        (void)job;
+        (void)media_file;
+        (void)binary;
+        return false;
+    #else
+        bool rc = false;
+        bool covercache = albumart_workers.config->cache_cover_keep_days != CACHE_DISK_DISABLED
+            ? true
+            : false;
+        sds cachedir = albumart_workers.config->cachedir;
+        const char *mime_type_media_file = get_mime_type_by_ext(media_file);
+        MYMPD_LOG_DEBUG(NULL, "Handle coverextract for uri \"%s\"", job->uri);
+        MYMPD_LOG_DEBUG(NULL, "Mimetype of %s is %s", media_file, mime_type_media_file);
+        if (strcmp(mime_type_media_file, "audio/mpeg") == 0) {
+            #ifdef MYMPD_ENABLE_LIBID3TAG
+                rc = handle_coverextract_id3(cachedir, job->uri, media_file, binary, covercache, job->offset);
+            #endif
+        }
+        else if (strcmp(mime_type_media_file, "audio/ogg") == 0) {
+            #ifdef MYMPD_ENABLE_FLAC
+                rc = handle_coverextract_flac(cachedir, job->uri, media_file, binary, true, covercache, job->offset);
+            #endif
+        }
+        else if (strcmp(mime_type_media_file, "audio/flac") == 0) {
+            #ifdef MYMPD_ENABLE_FLAC
+                rc = handle_coverextract_flac(cachedir, job->uri, media_file, binary, false, covercache, job->offset);
+            #endif
+        }
+        return rc;
+    #endif
+}
+
+/**
+ * Sends the albumart to all waiting connections
+ * @param job the job
+ * @param binary the image
+ * @param mime_type mime type of the image, NULL if no image was found
+ * @param etag etag of the image, NULL if no image was found
+ */
+static void albumart_job_respond(struct t_albumart_job *job, sds binary, const char *mime_type, const char *etag) {
+    struct t_list_node *current = job->waiters.head;
+    while (current != NULL) {
+        struct t_work_response *response = create_response_new(RESPONSE_TYPE_DEFAULT, (unsigned long)current->value_i,
+            0, INTERNAL_API_ALBUMART_BY_URI, MPD_PARTITION_DEFAULT);
+        bool not_modified = etag != NULL &&
+            etag[0] != '\0' &&
+            strcmp(current->key, etag) == 0;
+        response->data = jsonrpc_respond_start(response->data, INTERNAL_API_ALBUMART_BY_URI, 0);
+        response->data = tojson_char(response->data, "mime_type", (mime_type != NULL ? mime_type : ""), true);
+        response->data = tojson_char(response->data, "etag", (etag != NULL ? etag : ""), true);
+        response->data = tojson_bool(response->data, "notModified", not_modified, false);
+        response->data = jsonrpc_end(response->data);
+        if (mime_type != NULL &&
+            not_modified == false)
+        {
+            response->binary = sdscatsds(response->binary, binary);
+        }
+        push_response(response);
+        current = current->next;
+    }
+}
+
+/**
+ * Creates an etag from the modification time of the image source and the image size.
+ * Uses the same format as the mongoose static file handler.
+ * @param etag already allocated sds string to set the etag
+ * @param path image source
+ * @param size size of the image
+ * @return pointer to etag
+ */
+static sds albumart_etag(sds etag, const char *path, size_t size) {
+    sdsclear(etag);
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return etag;
+    }
+    return sdscatprintf(etag, "\"%lld.%lld\"", (long long)st.st_mtime, (long long)size);
+}
+
+/**
+ * Checks if a thumbnail lookup is the same as the full size lookup.
+ * Thumbnail names are only probed for the first image and only if cover names are configured.
+ * @param mg_user_data pointer to mongoose configuration
+ * @param offset number of the embedded image
+ * @return true if no thumbnail can be found, else false
+ */
+static bool albumart_thumbnail_is_full(struct t_mg_user_data *mg_user_data, int offset) {
+    return mg_user_data->thumbnail_names_len == 0 ||
+        mg_user_data->coverimage_names_len == 0 ||
+        offset != 0;
+}
+
+/**
+ * Frees an albumart job
+ * @param job the job to free
+ */
+static void albumart_job_free(struct t_albumart_job *job) {
+    FREE_SDS(job->key);
+    FREE_SDS(job->uri);
+    FREE_SDS(job->music_directory);
+    sdsfreesplitres(job->coverimage_names, job->coverimage_names_len);
+    sdsfreesplitres(job->thumbnail_names, job->thumbnail_names_len);
+    list_clear(&job->waiters);
+    FREE_PTR(job);
+}
+
+/**
+ * Duplicates an sds array
+ * @param names sds array
+ * @param names_len length of the sds array
+ * @return newly allocated sds array
+ */
+static sds *names_dup(sds *names, int names_len) {
+    if (names_len <= 0) {
+        return NULL;
+    }
+    sds *dup = malloc_assert(sizeof(sds) * (size_t)names_len);
+    for (int i = 0; i < names_len; i++) {
+        dup[i] = sdsdup(names[i]);
+    }
+    return dup;
+}
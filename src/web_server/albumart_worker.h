@@ -0,0 +1,25 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Albumart worker pool
+ */
+
+#ifndef MYMPD_WEB_SERVER_ALBUMART_WORKER_H
+#define MYMPD_WEB_SERVER_ALBUMART_WORKER_H
+
+#include "dist/sds/sds.h"
+#include "src/web_server/albumart.h"
+#include "src/web_server/utility.h"
+
+#include <stdbool.h>
+
+bool albumart_workers_start(struct t_config *config);
+void albumart_workers_stop(void);
+bool albumart_workers_push(struct t_mg_user_data *mg_user_data, unsigned long conn_id,
+        const char *uri, int offset, enum albumart_sizes size, bool negative, const char *if_none_match);
+
+#endif
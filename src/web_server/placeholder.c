@@ -62,7 +62,7 @@ void webserver_serve_placeholder_image(struct mg_connection *nc, struct mg_http_
     if (uri[1] == 'a') {
         // Default placeholders
         #ifdef MYMPD_EMBEDDED_ASSETS
-            webserver_serve_embedded_files(nc, uri);
+            webserver_serve_embedded_files(nc, hm, uri);
         #else
             sds abs_uri = sdscatfmt(sdsempty(), "%s%S", MYMPD_DOC_ROOT, uri);
             webserver_serve_file(nc, hm, MYMPD_DOC_ROOT, abs_uri);
@@ -16,6 +16,7 @@
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
+#include "src/lib/mg_str_utils.h"
 #include "src/lib/mimetype.h"
 #include "src/lib/sds_extras.h"
 #include "src/lib/utility.h"
@@ -112,6 +113,9 @@ void *mg_user_data_free(struct t_mg_user_data *mg_user_data) {
     FREE_SDS(mg_user_data->placeholder_folder);
     FREE_SDS(mg_user_data->cert_content);
     FREE_SDS(mg_user_data->key_content);
+    raxFree(mg_user_data->conns);
+    raxFree(mg_user_data->ws_conns);
+    raxFree(mg_user_data->ws_clients);
     FREE_PTR(mg_user_data);
     return NULL;
 }
@@ -255,6 +259,43 @@ void webserver_send_data(struct mg_connection *nc, const char *data, size_t len,
     webserver_handle_connection_close(nc);
 }
 
+/**
+ * Sends a part of a chunked reply, the first chunk sends the http header
+ * @param nc mongoose connection
+ * @param data data to send
+ * @param len length of the data to send
+ * @param headers extra headers to add
+ */
+void webserver_send_chunk(struct mg_connection *nc, const char *data, size_t len, const char *headers) {
+    MYMPD_LOG_DEBUG(NULL, "Sending chunk with %lu bytes to %lu", (unsigned long)len, nc->id);
+    if (nc->data[3] != 'S') {
+        mg_printf(nc, "HTTP/1.1 200 OK\r\n"
+            "%s"
+            "Transfer-Encoding: chunked\r\n\r\n",
+            headers);
+        nc->data[3] = 'S';
+    }
+    if (len > 0) {
+        mg_http_write_chunk(nc, data, len);
+    }
+}
+
+/**
+ * Sends the last part of a chunked reply and the terminating empty chunk
+ * @param nc mongoose connection
+ * @param data data to send
+ * @param len length of the data to send
+ */
+void webserver_send_chunk_end(struct mg_connection *nc, const char *data, size_t len) {
+    MYMPD_LOG_DEBUG(NULL, "Sending last chunk with %lu bytes to %lu", (unsigned long)len, nc->id);
+    if (len > 0) {
+        mg_http_write_chunk(nc, data, len);
+    }
+    mg_http_write_chunk(nc, "", 0);
+    nc->data[3] = '-';
+    webserver_handle_connection_close(nc);
+}
+
 /**
  * Sends a raw reply
  * @param nc mongoose connection
@@ -363,83 +404,100 @@ struct embedded_file {
     bool cache;
     const unsigned char *data;
     const unsigned size;
+    const char *etag;
+    const unsigned char *data_br;
+    const unsigned size_br;
+    const char *etag_br;
 };
 
 /**
- * Serves the embedded files
+ * Brotli compressed variant of an embedded file
+ */
+#ifdef MYMPD_EMBEDDED_BROTLI
+    #define EMBEDDED_BROTLI(NAME, ETAG) NAME##_br_data, NAME##_br_size, ETAG
+#else
+    #define EMBEDDED_BROTLI(NAME, ETAG) NULL, 0, NULL
+#endif
+#define EMBEDDED_NO_BROTLI NULL, 0, NULL
+
+/**
+ * Serves the embedded files.
+ * Selects the brotli compressed variant if the client accepts it
+ * and answers conditional requests with 304 Not Modified.
  * @param nc mongoose connection
+ * @param hm http message
  * @param uri uri to server
  * @return true on success, else false
  */
-bool webserver_serve_embedded_files(struct mg_connection *nc, sds uri) {
+bool webserver_serve_embedded_files(struct mg_connection *nc, struct mg_http_message *hm, sds uri) {
     const struct embedded_file embedded_files[] = {
-        {"/", "text/html; charset=utf-8", true, false, index_html_data, index_html_size},
-        {"/css/combined.css", "text/css; charset=utf-8", true, false, combined_css_data, combined_css_size},
-        {"/js/combined.js", "application/javascript; charset=utf-8", true, false, combined_js_data, combined_js_size},
-        {"/sw.js", "application/javascript; charset=utf-8", true, false, sw_js_data, sw_js_size},
-        {"/mympd.webmanifest", "application/manifest+json", true, false, mympd_webmanifest_data, mympd_webmanifest_size},
-        {"/assets/coverimage-notavailable.svg", "image/svg+xml", true, true, coverimage_notavailable_svg_data, coverimage_notavailable_svg_size},
-        {"/assets/MaterialIcons-Regular.woff2", "font/woff2", false, true, MaterialIcons_Regular_woff2_data, MaterialIcons_Regular_woff2_size},
-        {"/assets/coverimage-stream.svg", "image/svg+xml", true, true, coverimage_stream_svg_data, coverimage_stream_svg_size},
-        {"/assets/coverimage-booklet.svg", "image/svg+xml", true, true, coverimage_booklet_svg_data, coverimage_booklet_svg_size},
-        {"/assets/coverimage-mympd.svg", "image/svg+xml", true, true, coverimage_mympd_svg_data, coverimage_mympd_svg_size},
-        {"/assets/coverimage-playlist.svg", "image/svg+xml", true, true, coverimage_playlist_svg_data, coverimage_playlist_svg_size},
-        {"/assets/coverimage-smartpls.svg", "image/svg+xml", true, true, coverimage_smartpls_svg_data, coverimage_smartpls_svg_size},
-        {"/assets/coverimage-folder.svg", "image/svg+xml", true, true, coverimage_folder_svg_data, coverimage_folder_svg_size},
-        {"/assets/mympd-background-dark.svg", "image/svg+xml", true, true, mympd_background_dark_svg_data, mympd_background_dark_svg_size},
-        {"/assets/mympd-background-light.svg", "image/svg+xml", true, true, mympd_background_light_svg_data, mympd_background_light_svg_size},
-        {"/assets/appicon-192.png", "image/png", false, true, appicon_192_png_data, appicon_192_png_size},
-        {"/assets/appicon-512.png", "image/png", false, true, appicon_512_png_data, appicon_512_png_size},
-        {"/assets/ligatures.json", "application/json", true, true, ligatures_json_data, ligatures_json_size},
+        {"/", "text/html; charset=utf-8", true, false, index_html_data, index_html_size, ETAG_index_html_gz, EMBEDDED_BROTLI(index_html, ETAG_index_html_br)},
+        {"/css/combined.css", "text/css; charset=utf-8", true, false, combined_css_data, combined_css_size, ETAG_css_combined_css_gz, EMBEDDED_BROTLI(combined_css, ETAG_css_combined_css_br)},
+        {"/js/combined.js", "application/javascript; charset=utf-8", true, false, combined_js_data, combined_js_size, ETAG_js_combined_js_gz, EMBEDDED_BROTLI(combined_js, ETAG_js_combined_js_br)},
+        {"/sw.js", "application/javascript; charset=utf-8", true, false, sw_js_data, sw_js_size, ETAG_sw_js_gz, EMBEDDED_NO_BROTLI},
+        {"/mympd.webmanifest", "application/manifest+json", true, false, mympd_webmanifest_data, mympd_webmanifest_size, ETAG_mympd_webmanifest_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-notavailable.svg", "image/svg+xml", true, true, coverimage_notavailable_svg_data, coverimage_notavailable_svg_size, ETAG_assets_coverimage_notavailable_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/MaterialIcons-Regular.woff2", "font/woff2", false, true, MaterialIcons_Regular_woff2_data, MaterialIcons_Regular_woff2_size, ETAG_assets_MaterialIcons_Regular_woff2, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-stream.svg", "image/svg+xml", true, true, coverimage_stream_svg_data, coverimage_stream_svg_size, ETAG_assets_coverimage_stream_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-booklet.svg", "image/svg+xml", true, true, coverimage_booklet_svg_data, coverimage_booklet_svg_size, ETAG_assets_coverimage_booklet_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-mympd.svg", "image/svg+xml", true, true, coverimage_mympd_svg_data, coverimage_mympd_svg_size, ETAG_assets_coverimage_mympd_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-playlist.svg", "image/svg+xml", true, true, coverimage_playlist_svg_data, coverimage_playlist_svg_size, ETAG_assets_coverimage_playlist_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-smartpls.svg", "image/svg+xml", true, true, coverimage_smartpls_svg_data, coverimage_smartpls_svg_size, ETAG_assets_coverimage_smartpls_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/coverimage-folder.svg", "image/svg+xml", true, true, coverimage_folder_svg_data, coverimage_folder_svg_size, ETAG_assets_coverimage_folder_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/mympd-background-dark.svg", "image/svg+xml", true, true, mympd_background_dark_svg_data, mympd_background_dark_svg_size, ETAG_assets_mympd_background_dark_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/mympd-background-light.svg", "image/svg+xml", true, true, mympd_background_light_svg_data, mympd_background_light_svg_size, ETAG_assets_mympd_background_light_svg_gz, EMBEDDED_NO_BROTLI},
+        {"/assets/appicon-192.png", "image/png", false, true, appicon_192_png_data, appicon_192_png_size, ETAG_assets_appicon_192_png, EMBEDDED_NO_BROTLI},
+        {"/assets/appicon-512.png", "image/png", false, true, appicon_512_png_data, appicon_512_png_size, ETAG_assets_appicon_512_png, EMBEDDED_NO_BROTLI},
+        {"/assets/ligatures.json", "application/json", true, true, ligatures_json_data, ligatures_json_size, ETAG_assets_ligatures_json_gz, EMBEDDED_NO_BROTLI},
         #ifdef I18N_bg_BG
-            {"/assets/i18n/bg-BG.json", "application/json", true, true, i18n_bg_BG_json_data, i18n_bg_BG_json_size},
+            {"/assets/i18n/bg-BG.json", "application/json", true, true, i18n_bg_BG_json_data, i18n_bg_BG_json_size, ETAG_assets_i18n_bg_BG_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_de_DE
-            {"/assets/i18n/de-DE.json", "application/json", true, true, i18n_de_DE_json_data, i18n_de_DE_json_size},
+            {"/assets/i18n/de-DE.json", "application/json", true, true, i18n_de_DE_json_data, i18n_de_DE_json_size, ETAG_assets_i18n_de_DE_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_en_US
-        {"/assets/i18n/en-US.json", "application/json", true, true, i18n_en_US_json_data, i18n_en_US_json_size},
+        {"/assets/i18n/en-US.json", "application/json", true, true, i18n_en_US_json_data, i18n_en_US_json_size, ETAG_assets_i18n_en_US_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_es_AR
-        {"/assets/i18n/es-AR.json", "application/json", true, true, i18n_es_AR_json_data, i18n_es_AR_json_size},
+        {"/assets/i18n/es-AR.json", "application/json", true, true, i18n_es_AR_json_data, i18n_es_AR_json_size, ETAG_assets_i18n_es_AR_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_es_ES
-        {"/assets/i18n/es-ES.json", "application/json", true, true, i18n_es_ES_json_data, i18n_es_ES_json_size},
+        {"/assets/i18n/es-ES.json", "application/json", true, true, i18n_es_ES_json_data, i18n_es_ES_json_size, ETAG_assets_i18n_es_ES_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_es_VE
-        {"/assets/i18n/es-VE.json", "application/json", true, true, i18n_es_VE_json_data, i18n_es_VE_json_size},
+        {"/assets/i18n/es-VE.json", "application/json", true, true, i18n_es_VE_json_data, i18n_es_VE_json_size, ETAG_assets_i18n_es_VE_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_fi_FI
-        {"/assets/i18n/fi-FI.json", "application/json", true, true, i18n_fi_FI_json_data, i18n_fi_FI_json_size},
+        {"/assets/i18n/fi-FI.json", "application/json", true, true, i18n_fi_FI_json_data, i18n_fi_FI_json_size, ETAG_assets_i18n_fi_FI_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_fr_FR
-        {"/assets/i18n/fr-FR.json", "application/json", true, true, i18n_fr_FR_json_data, i18n_fr_FR_json_size},
+        {"/assets/i18n/fr-FR.json", "application/json", true, true, i18n_fr_FR_json_data, i18n_fr_FR_json_size, ETAG_assets_i18n_fr_FR_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_it_IT
-        {"/assets/i18n/it-IT.json", "application/json", true, true, i18n_it_IT_json_data, i18n_it_IT_json_size},
+        {"/assets/i18n/it-IT.json", "application/json", true, true, i18n_it_IT_json_data, i18n_it_IT_json_size, ETAG_assets_i18n_it_IT_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_ja_JP
-        {"/assets/i18n/ja-JP.json", "application/json", true, true, i18n_ja_JP_json_data, i18n_ja_JP_json_size},
+        {"/assets/i18n/ja-JP.json", "application/json", true, true, i18n_ja_JP_json_data, i18n_ja_JP_json_size, ETAG_assets_i18n_ja_JP_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_ko_KR
-        {"/assets/i18n/ko-KR.json", "application/json", true, true, i18n_ko_KR_json_data, i18n_ko_KR_json_size},
+        {"/assets/i18n/ko-KR.json", "application/json", true, true, i18n_ko_KR_json_data, i18n_ko_KR_json_size, ETAG_assets_i18n_ko_KR_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_nl_NL
-        {"/assets/i18n/nl-NL.json", "application/json", true, true, i18n_nl_NL_json_data, i18n_nl_NL_json_size},
+        {"/assets/i18n/nl-NL.json", "application/json", true, true, i18n_nl_NL_json_data, i18n_nl_NL_json_size, ETAG_assets_i18n_nl_NL_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_pl_PL
-        {"/assets/i18n/pl-PL.json", "application/json", true, true, i18n_pl_PL_json_data, i18n_pl_PL_json_size},
+        {"/assets/i18n/pl-PL.json", "application/json", true, true, i18n_pl_PL_json_data, i18n_pl_PL_json_size, ETAG_assets_i18n_pl_PL_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_ru_RU
-        {"/assets/i18n/ru-RU.json", "application/json", true, true, i18n_ru_RU_json_data, i18n_ru_RU_json_size},
+        {"/assets/i18n/ru-RU.json", "application/json", true, true, i18n_ru_RU_json_data, i18n_ru_RU_json_size, ETAG_assets_i18n_ru_RU_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_zh_Hans
-        {"/assets/i18n/zh-Hans.json", "application/json", true, true, i18n_zh_Hans_json_data, i18n_zh_Hans_json_size},
+        {"/assets/i18n/zh-Hans.json", "application/json", true, true, i18n_zh_Hans_json_data, i18n_zh_Hans_json_size, ETAG_assets_i18n_zh_Hans_json_gz, EMBEDDED_NO_BROTLI},
         #endif
         #ifdef I18N_zh_Hant
-        {"/assets/i18n/zh-Hant.json", "application/json", true, true, i18n_zh_Hant_json_data, i18n_zh_Hant_json_size},
+        {"/assets/i18n/zh-Hant.json", "application/json", true, true, i18n_zh_Hant_json_data, i18n_zh_Hant_json_size, ETAG_assets_i18n_zh_Hant_json_gz, EMBEDDED_NO_BROTLI},
         #endif
-        {NULL, NULL, false, false, NULL, 0}
+        {NULL, NULL, false, false, NULL, 0, NULL, EMBEDDED_NO_BROTLI}
     };
     //decode uri
     sds uri_decoded = sds_urldecode(sdsempty(), uri, sdslen(uri), false);
@@ -457,20 +515,61 @@ bool webserver_serve_embedded_files(struct mg_connection *nc, sds uri) {
     }
 
     if (p->uri != NULL) {
+        //select the variant
+        const unsigned char *data = p->data;
+        unsigned size = p->size;
+        const char *etag = p->etag;
+        const char *encoding = p->compressed == true
+            ? EXTRA_HEADER_CONTENT_ENCODING
+            : "";
+        if (p->data_br != NULL) {
+            struct mg_str *accept_encoding = mg_http_get_header(hm, "Accept-Encoding");
+            if (accept_encoding != NULL &&
+                mg_str_accepts_encoding(accept_encoding, "br") == true)
+            {
+                data = p->data_br;
+                size = p->size_br;
+                etag = p->etag_br;
+                encoding = EXTRA_HEADER_CONTENT_ENCODING_BR;
+            }
+        }
+        //conditional request
+        struct mg_str *if_none_match = mg_http_get_header(hm, "If-None-Match");
+        if (if_none_match != NULL &&
+            mg_strcmp(*if_none_match, mg_str(etag)) == 0)
+        {
+            MYMPD_LOG_DEBUG(NULL, "Sending 304 Not Modified for \"%s\" to %lu", p->uri, nc->id);
+            mg_printf(nc, "HTTP/1.1 304 Not Modified\r\n"
+                "%s"
+                "ETag: %s\r\n"
+                "%s"
+                "Content-Length: 0\r\n\r\n",
+                (p->cache == true ? EXTRA_HEADERS_CACHE : ""),
+                etag,
+                (p->data_br != NULL ? "Vary: Accept-Encoding\r\n" : "")
+            );
+            webserver_handle_connection_close(nc);
+            FREE_SDS(uri_decoded);
+            return true;
+        }
         //send header
         mg_printf(nc, "HTTP/1.1 200 OK\r\n"
             EXTRA_HEADERS_SAFE
             "%s"
-            "Content-Length: %d\r\n"
+            "ETag: %s\r\n"
+            "%s"
+            "Content-Length: %u\r\n"
             "Content-Type: %s\r\n"
             "%s\r\n",
             (p->cache == true ? EXTRA_HEADERS_CACHE : ""),
-            p->size,
+            etag,
+            (p->data_br != NULL ? "Vary: Accept-Encoding\r\n" : ""),
+            size,
             p->mimetype,
-            (p->compressed == true ? EXTRA_HEADER_CONTENT_ENCODING : "")
+            encoding
         );
         //send data
-        mg_send(nc, p->data, p->size);
+        mg_send(nc, data, size);
         webserver_handle_connection_close(nc);
         FREE_SDS(uri_decoded);
         return true;
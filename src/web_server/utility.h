@@ -12,6 +12,7 @@
 #define MYMPD_WEB_SERVER_UTILITY_H
 
 #include "dist/mongoose/mongoose.h"
+#include "dist/rax/rax.h"
 #include "dist/sds/sds.h"
 #include "src/lib/config_def.h"
 #include "src/lib/list.h"
@@ -49,6 +50,9 @@ struct t_mg_user_data {
     struct mg_str key;                       //!< pointer to ssl key_content
     struct t_webradios *webradiodb;          //!< Pointer to WebradioDB in mympd_api thread
     struct t_webradios *webradio_favorites;  //!< Pointer to webradio favorits in mympd_api thread
+    rax *conns;                              //!< connection id to frontend connection
+    rax *ws_conns;                           //!< partition and connection id to websocket connection
+    rax *ws_clients;                         //!< jsonrpc client id to websocket connection
 };
 
 /**
@@ -63,7 +67,7 @@ struct t_frontend_nc_data {
 };
 
 #ifdef MYMPD_EMBEDDED_ASSETS
-bool webserver_serve_embedded_files(struct mg_connection *nc, sds uri);
+bool webserver_serve_embedded_files(struct mg_connection *nc, struct mg_http_message *hm, sds uri);
 #endif
 sds get_uri_param(struct mg_str *query, const char *name);
 sds print_ip(sds s, struct mg_addr *addr);
@@ -79,6 +83,8 @@ void webserver_send_header_redirect(struct mg_connection *nc, const char *locati
 void webserver_send_header_found(struct mg_connection *nc, const char *location, const char *headers);
 void webserver_send_cors_reply(struct mg_connection *nc);
 void webserver_send_data(struct mg_connection *nc, const char *data, size_t len, const char *headers);
+void webserver_send_chunk(struct mg_connection *nc, const char *data, size_t len, const char *headers);
+void webserver_send_chunk_end(struct mg_connection *nc, const char *data, size_t len);
 void webserver_send_raw(struct mg_connection *nc, const char *data, size_t len);
 void webserver_handle_connection_close(struct mg_connection *nc);
 void *mg_user_data_free(struct t_mg_user_data *mg_user_data);
@@ -23,6 +23,7 @@
 #include "src/lib/sds_extras.h"
 #include "src/lib/thread.h"
 #include "src/web_server/albumart.h"
+#include "src/web_server/albumart_worker.h"
 #include "src/web_server/folderart.h"
 #include "src/web_server/placeholder.h"
 #include "src/web_server/playlistart.h"
@@ -48,9 +49,14 @@ static void ev_handler_redirect(struct mg_connection *nc_http, int ev, void *ev_
 static void send_ws_notify(struct mg_mgr *mgr, struct t_work_response *response);
 static void send_ws_notify_client(struct mg_mgr *mgr, struct t_work_response *response);
 static struct mg_connection *get_nc_by_id(struct mg_mgr *mgr, unsigned long id);
+static sds get_ws_conn_key(sds key, const char *partition, unsigned long id);
+static void ws_client_set(struct t_mg_user_data *mg_user_data, struct mg_connection *nc, unsigned id);
+static void conn_map_remove(struct t_mg_user_data *mg_user_data, struct mg_connection *nc);
 static void send_raw_response(struct mg_mgr *mgr, struct t_work_response *response);
 static void send_redirect(struct mg_mgr *mgr, struct t_work_response *response);
 static void send_api_response(struct mg_mgr *mgr, struct t_work_response *response);
+static void send_api_response_chunk(struct mg_mgr *mgr, struct t_work_response *response);
+static void send_api_response_abort(struct mg_mgr *mgr, struct t_work_response *response);
 static bool enforce_acl(struct mg_connection *nc, sds acl);
 static bool enforce_conn_limit(struct mg_connection *nc, int connection_count);
 static void mongoose_log(char ch, void *param);
@@ -97,6 +103,9 @@ bool web_server_init(struct mg_mgr *mgr, struct t_config *config, struct t_mg_us
     mg_user_data->key = mg_str("");
     mg_user_data->webradiodb = NULL;
     mg_user_data->webradio_favorites = NULL;
+    mg_user_data->conns = raxNew();
+    mg_user_data->ws_conns = raxNew();
+    mg_user_data->ws_clients = raxNew();
 
     //init monogoose mgr
     mg_mgr_init(mgr);
@@ -206,6 +215,7 @@ void *web_server_loop(void *arg_mgr) {
     mg_log_set_fn(mongoose_log, NULL);
     // Initialise wakeup socket pair
     mg_wakeup_init(mgr);
+    albumart_workers_start(mg_user_data->config);
     if (mg_user_data->config->ssl == true) {
         MYMPD_LOG_DEBUG(NULL, "Using certificate: %s", mg_user_data->config->ssl_cert);
         MYMPD_LOG_DEBUG(NULL, "Using private key: %s", mg_user_data->config->ssl_key);
@@ -215,6 +225,7 @@ void *web_server_loop(void *arg_mgr) {
         mg_mgr_poll(mgr, -1);
     }
     MYMPD_LOG_DEBUG(NULL, "Stopping web_server thread");
+    albumart_workers_stop();
     FREE_SDS(thread_logname);
     return NULL;
 }
@@ -259,6 +270,16 @@ static void read_queue(struct mg_mgr *mgr) {
                 MYMPD_LOG_DEBUG(response->partition, "Got API response for id \"%lu\"", response->conn_id);
                 send_api_response(mgr, response);
                 break;
+            case RESPONSE_TYPE_CHUNK:
+                //part of a streamed api response
+                MYMPD_LOG_DEBUG(response->partition, "Got API response chunk for id \"%lu\" with %lu bytes", response->conn_id, (unsigned long)sdslen(response->data));
+                send_api_response_chunk(mgr, response);
+                break;
+            case RESPONSE_TYPE_ABORT:
+                //streamed api response can not be finished
+                MYMPD_LOG_DEBUG(response->partition, "Got API response abort for id \"%lu\"", response->conn_id);
+                send_api_response_abort(mgr, response);
+                break;
             case RESPONSE_TYPE_RAW:
                 MYMPD_LOG_DEBUG(response->partition, "Got raw response for id \"%lu\" with %lu bytes", response->conn_id, (unsigned long)sdslen(response->data));
                 send_raw_response(mgr, response);
@@ -373,37 +394,41 @@ static bool parse_internal_message(struct t_work_response *response, struct t_mg
  * @param response jsonrpc notification
  */
 static void send_ws_notify(struct mg_mgr *mgr, struct t_work_response *response) {
-    struct mg_connection *nc = mgr->conns;
+    struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *) mgr->userdata;
     int send_count = 0;
-    int conn_count = 0;
     time_t last_ping = time(NULL) - WS_PING_TIMEOUT;
-    while (nc != NULL) {
-        if (nc->is_websocket == 1U) {
-            struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
-            if (frontend_nc_data->last_ws_ping < last_ping) {
-                MYMPD_LOG_INFO(NULL, "Closing stale websocket connection \"%lu\"", nc->id);
-                nc->is_closing = 1;
-            }
-            else if (strcmp(response->partition, frontend_nc_data->partition) == 0 ||
-                strcmp(response->partition, MPD_PARTITION_ALL) == 0)
-            {
-                MYMPD_LOG_DEBUG(response->partition, "Sending notify to conn_id \"%lu\": %s", nc->id, response->data);
-                mg_ws_send(nc, response->data, sdslen(response->data), WEBSOCKET_OP_TEXT);
-                send_count++;
-            }
+    //the websocket connections are grouped by partition
+    bool all_partitions = strcmp(response->partition, MPD_PARTITION_ALL) == 0;
+    sds prefix = all_partitions == true
+        ? sdsempty()
+        : sdscatlen(sdsnew(response->partition), "\0", 1);
+    raxIterator iter;
+    raxStart(&iter, mg_user_data->ws_conns);
+    raxSeek(&iter, ">=", (unsigned char *)prefix, sdslen(prefix));
+    while (raxNext(&iter)) {
+        if (iter.key_len < sdslen(prefix) ||
+            memcmp(iter.key, prefix, sdslen(prefix)) != 0)
+        {
+            break;
+        }
+        struct mg_connection *nc = (struct mg_connection *)iter.data;
+        struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
+        if (frontend_nc_data->last_ws_ping < last_ping) {
+            MYMPD_LOG_INFO(NULL, "Closing stale websocket connection \"%lu\"", nc->id);
+            nc->is_closing = 1;
+        }
+        else {
+            MYMPD_LOG_DEBUG(response->partition, "Sending notify to conn_id \"%lu\": %s", nc->id, response->data);
+            mg_ws_send(nc, response->data, sdslen(response->data), WEBSOCKET_OP_TEXT);
+            send_count++;
         }
-        nc = nc->next;
-        conn_count++;
     }
+    raxStop(&iter);
+    FREE_SDS(prefix);
     if (send_count == 0) {
         MYMPD_LOG_DEBUG(NULL, "No websocket client connected, discarding message: %s", response->data);
     }
     free_response(response);
-    struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *) mgr->userdata;
-    if (conn_count != mg_user_data->connection_count) {
-        MYMPD_LOG_DEBUG(NULL, "Correcting connection count from %d to %d", mg_user_data->connection_count, conn_count);
-        mg_user_data->connection_count = conn_count;
-    }
 }
 
 /**
@@ -413,23 +438,16 @@ static void send_ws_notify(struct mg_mgr *mgr, struct t_work_response *response)
  * @param response jsonrpc notification
  */
 static void send_ws_notify_client(struct mg_mgr *mgr, struct t_work_response *response) {
-    struct mg_connection *nc = mgr->conns;
-    int send_count = 0;
+    struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *) mgr->userdata;
     const unsigned client_id = response->id / 1000;
     //const unsigned request_id = response->id % 1000;
-    while (nc != NULL) {
-        if (nc->is_websocket == 1U) {
-            struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
-            if (client_id == frontend_nc_data->id) {
-                MYMPD_LOG_DEBUG(response->partition, "Sending notify to conn_id \"%lu\", jsonrpc client id %u: %s", nc->id, client_id, response->data);
-                mg_ws_send(nc, response->data, sdslen(response->data), WEBSOCKET_OP_TEXT);
-                send_count++;
-                break;
-            }
-        }
-        nc = nc->next;
+    void *data;
+    if (raxFind(mg_user_data->ws_clients, (unsigned char *)&client_id, sizeof(client_id), &data) == 1) {
+        struct mg_connection *nc = (struct mg_connection *)data;
+        MYMPD_LOG_DEBUG(response->partition, "Sending notify to conn_id \"%lu\", jsonrpc client id %u: %s", nc->id, client_id, response->data);
+        mg_ws_send(nc, response->data, sdslen(response->data), WEBSOCKET_OP_TEXT);
     }
-    if (send_count == 0) {
+    else {
         MYMPD_LOG_DEBUG(NULL, "No websocket client with id %u connected, discarding message: %s", client_id, response->data);
     }
     free_response(response);
@@ -442,16 +460,66 @@ static void send_ws_notify_client(struct mg_mgr *mgr, struct t_work_response *re
  * @return struct mg_connection* or NULL if not found
  */
 static struct mg_connection *get_nc_by_id(struct mg_mgr *mgr, unsigned long id) {
-    struct mg_connection *nc = mgr->conns;
-    while (nc != NULL) {
-        if (nc->id == id) {
-            return nc;
-        }
-        nc = nc->next;
+    struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *) mgr->userdata;
+    void *data;
+    if (raxFind(mg_user_data->conns, (unsigned char *)&id, sizeof(id), &data) == 1) {
+        return (struct mg_connection *)data;
     }
     return NULL;
 }
 
+/**
+ * Creates the key for the websocket connections map
+ * @param key already allocated sds string to append the key
+ * @param partition partition of the websocket connection
+ * @param id connection id
+ * @return pointer to key
+ */
+static sds get_ws_conn_key(sds key, const char *partition, unsigned long id) {
+    key = sdscatlen(key, partition, strlen(partition) + 1);
+    key = sdscatlen(key, &id, sizeof(id));
+    return key;
+}
+
+/**
+ * Sets the jsonrpc client id of a websocket connection
+ * @param mg_user_data pointer to mongoose user data
+ * @param nc mongoose websocket connection
+ * @param id new jsonrpc client id
+ */
+static void ws_client_set(struct t_mg_user_data *mg_user_data, struct mg_connection *nc, unsigned id) {
+    struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
+    void *data;
+    if (frontend_nc_data->id != 0 &&
+        raxFind(mg_user_data->ws_clients, (unsigned char *)&frontend_nc_data->id, sizeof(frontend_nc_data->id), &data) == 1 &&
+        data == nc)
+    {
+        raxRemove(mg_user_data->ws_clients, (unsigned char *)&frontend_nc_data->id, sizeof(frontend_nc_data->id), NULL);
+    }
+    frontend_nc_data->id = id;
+    if (id != 0) {
+        raxInsert(mg_user_data->ws_clients, (unsigned char *)&id, sizeof(id), nc, NULL);
+    }
+}
+
+/**
+ * Removes a frontend connection from the connection maps
+ * @param mg_user_data pointer to mongoose user data
+ * @param nc mongoose connection
+ */
+static void conn_map_remove(struct t_mg_user_data *mg_user_data, struct mg_connection *nc) {
+    struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
+    raxRemove(mg_user_data->conns, (unsigned char *)&nc->id, sizeof(nc->id), NULL);
+    if (nc->is_websocket == 1U &&
+        frontend_nc_data->partition != NULL)
+    {
+        sds key = get_ws_conn_key(sdsempty(), frontend_nc_data->partition, nc->id);
+        raxRemove(mg_user_data->ws_conns, (unsigned char *)key, sdslen(key), NULL);
+        FREE_SDS(key);
+        ws_client_set(mg_user_data, nc, 0);
+    }
+}
+
 /**
  * Sends a raw http response message
  * @param mgr mongoose mgr
@@ -501,7 +569,13 @@ static void send_api_response(struct mg_mgr *mgr, struct t_work_response *respon
                 break;
             default:
                 MYMPD_LOG_DEBUG(response->partition, "Sending response to conn_id \"%lu\" (length: %lu): %s", nc->id, (unsigned long)sdslen(response->data), response->data);
-                webserver_send_data(nc, response->data, sdslen(response->data), EXTRA_HEADERS_JSON_CONTENT);
+                if (nc->data[3] == 'S') {
+                    //finish the streamed response
+                    webserver_send_chunk_end(nc, response->data, sdslen(response->data));
+                }
+                else {
+                    webserver_send_data(nc, response->data, sdslen(response->data), EXTRA_HEADERS_JSON_CONTENT);
+                }
         }
     }
     else {
@@ -510,6 +584,42 @@ static void send_api_response(struct mg_mgr *mgr, struct t_work_response *respon
     free_response(response);
 }
 
+/**
+ * Sends a chunk of a streamed api response,
+ * the response is finished by send_api_response
+ * @param mgr mongoose mgr
+ * @param response part of the jsonrpc response
+ */
+static void send_api_response_chunk(struct mg_mgr *mgr, struct t_work_response *response) {
+    struct mg_connection *nc = get_nc_by_id(mgr, response->conn_id);
+    if (nc != NULL) {
+        webserver_send_chunk(nc, response->data, sdslen(response->data), EXTRA_HEADERS_JSON_CONTENT);
+    }
+    else {
+        MYMPD_LOG_ERROR(NULL, "Connection for id \"%lu\" not found", response->conn_id);
+    }
+    free_response(response);
+}
+
+/**
+ * Closes the connection of a streamed api response without the terminating chunk,
+ * the client detects the incomplete response
+ * @param mgr mongoose mgr
+ * @param response the final response, it is discarded
+ */
+static void send_api_response_abort(struct mg_mgr *mgr, struct t_work_response *response) {
+    struct mg_connection *nc = get_nc_by_id(mgr, response->conn_id);
+    if (nc != NULL) {
+        MYMPD_LOG_WARN(response->partition, "Closing connection %lu with incomplete response", nc->id);
+        nc->data[3] = '-';
+        nc->is_draining = 1;
+    }
+    else {
+        MYMPD_LOG_ERROR(NULL, "Connection for id \"%lu\" not found", response->conn_id);
+    }
+    free_response(response);
+}
+
 /**
  * Matches the acl against the client ip and
  * sends an error response / drains the connection if acl is not matched
@@ -594,10 +704,12 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 frontend_nc_data->last_ws_ping = time(NULL);  // websocket ping timestamp
                 frontend_nc_data->backend_nc = NULL;          // used for reverse proxy function
                 nc->fn_data = frontend_nc_data;
+                raxInsert(mg_user_data->conns, (unsigned char *)&nc->id, sizeof(nc->id), nc, NULL);
                 //set labels
                 nc->data[0] = 'F'; // connection type
                 nc->data[1] = '-'; // http method
                 nc->data[2] = 'C'; // connection header
+                nc->data[3] = '-'; // chunked response
             }
             break;
         }
@@ -654,7 +766,7 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 sent = mg_ws_send(nc, "pong", 4, WEBSOCKET_OP_TEXT);
             }
             else if (mg_match(wm->data, mg_str("id:*"), matches)) {
-                frontend_nc_data->id = mg_str_to_uint(&matches[0]);
+                ws_client_set(mg_user_data, nc, mg_str_to_uint(&matches[0]));
                 MYMPD_LOG_INFO(frontend_nc_data->partition, "Setting websocket (%lu) id to \"%u\"", nc->id, frontend_nc_data->id);
                 sent = mg_ws_send(nc, "ok", 2, WEBSOCKET_OP_TEXT);
             }
@@ -800,6 +912,9 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                     break;
                 }
                 mg_ws_upgrade(nc, hm, NULL);
+                sds key = get_ws_conn_key(sdsempty(), frontend_nc_data->partition, nc->id);
+                raxInsert(mg_user_data->ws_conns, (unsigned char *)key, sdslen(key), nc, NULL);
+                FREE_SDS(key);
                 MYMPD_LOG_INFO(frontend_nc_data->partition, "New Websocket connection established (%lu)", nc->id);
                 sds response = jsonrpc_event(sdsempty(), JSONRPC_EVENT_WELCOME);
                 mg_ws_send(nc, response, sdslen(response), WEBSOCKET_OP_TEXT);
@@ -909,7 +1024,7 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 #else
                     //serve embedded files
                     sds uri = sdsnewlen(hm->uri.buf, hm->uri.len);
-                    webserver_serve_embedded_files(nc, uri);
+                    webserver_serve_embedded_files(nc, hm, uri);
                     FREE_SDS(uri);
                 #endif
             }
@@ -924,6 +1039,7 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 }
                 break;
             }
+            conn_map_remove(mg_user_data, nc);
             if (frontend_nc_data->backend_nc != NULL) {
                 MYMPD_LOG_INFO(NULL, "Closing backend connection \"%lu\"", frontend_nc_data->backend_nc->id);
                 //remove pointer to frontend connection
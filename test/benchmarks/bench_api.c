@@ -0,0 +1,47 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/api.h"
+#include "src/lib/log.h"
+#include "src/lib/utility.h"
+
+#include <inttypes.h>
+#include <time.h>
+
+UTEST(benchmark, api_get_cmd_id) {
+    unsigned found = 0;
+    MEASURE_INIT
+    MEASURE_START
+    for (unsigned i = 0; i < 1000000; i++) {
+        if (get_cmd_id(get_cmd_id_method_name(i % TOTAL_API_COUNT)) != GENERAL_API_UNKNOWN) {
+            found++;
+        }
+    }
+    MEASURE_END
+    MEASURE_PRINT(NULL, "1000000 API method lookups");
+    ASSERT_TRUE(found > 0);
+}
+
+UTEST(benchmark, api_method_checks) {
+    unsigned found = 0;
+    MEASURE_INIT
+    MEASURE_START
+    for (unsigned i = 0; i < 1000000; i++) {
+        enum mympd_cmd_ids cmd_id = (enum mympd_cmd_ids)(i % TOTAL_API_COUNT);
+        if (is_public_api_method(cmd_id) == true &&
+            is_protected_api_method(cmd_id) == false &&
+            is_script_api_method(cmd_id) == true)
+        {
+            found++;
+        }
+    }
+    MEASURE_END
+    MEASURE_PRINT(NULL, "1000000 API method checks");
+    ASSERT_TRUE(found > 0);
+}
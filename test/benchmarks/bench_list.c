@@ -0,0 +1,50 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/list.h"
+
+#include <time.h>
+
+static bool sort_benchmark(unsigned count) {
+    struct t_list test_list;
+    list_init(&test_list);
+    //deterministic pseudo random values
+    unsigned seed = 1;
+    for (unsigned i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        list_push(&test_list, "", (int64_t)(seed >> 8), NULL, NULL);
+    }
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    list_sort_by_value_i(&test_list, LIST_SORT_ASC);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    printf("Sorting %u nodes: %ld ms\n", count, ms);
+
+    bool sorted = test_list.length == count;
+    struct t_list_node *current = test_list.head;
+    while (current != NULL &&
+           current->next != NULL)
+    {
+        if (current->value_i > current->next->value_i) {
+            sorted = false;
+            break;
+        }
+        current = current->next;
+    }
+    list_clear(&test_list);
+    return sorted;
+}
+
+UTEST(benchmark, list_sort) {
+    ASSERT_TRUE(sort_benchmark(10000));
+    ASSERT_TRUE(sort_benchmark(100000));
+    ASSERT_TRUE(sort_benchmark(1000000));
+}
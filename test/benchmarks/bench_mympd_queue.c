@@ -0,0 +1,68 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/log.h"
+#include "src/lib/msg_queue.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Number of messages per producer thread
+ */
+#define BENCH_MESSAGES 250000
+/**
+ * Number of producer threads
+ */
+#define BENCH_PRODUCERS 4
+
+static void *bench_producer(void *arg) {
+    struct t_mympd_queue *queue = arg;
+    for (uintptr_t i = 1; i <= BENCH_MESSAGES; i++) {
+        mympd_queue_push(queue, (void *)i, 0);
+    }
+    return NULL;
+}
+
+static long queue_benchmark(enum mympd_queue_modes mode) {
+    struct t_mympd_queue *queue = mympd_queue_create("bench", QUEUE_TYPE_REQUEST, mode, false);
+    pthread_t producers[BENCH_PRODUCERS];
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_PRODUCERS; i++) {
+        pthread_create(&producers[i], NULL, bench_producer, queue);
+    }
+    long received = 0;
+    while (received < BENCH_PRODUCERS * BENCH_MESSAGES) {
+        if (mympd_queue_shift(queue, -1, 0) != NULL) {
+            received++;
+        }
+    }
+    for (int i = 0; i < BENCH_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    printf("Queue mode %d: %ld messages in %ld ms\n", mode, received, ms);
+    mympd_queue_free(queue);
+    return received;
+}
+
+UTEST(benchmark, mympd_queue) {
+    //debug logging would dominate the benchmark
+    int saved_loglevel = loglevel;
+    set_loglevel(LOG_ERR);
+    long list_received = queue_benchmark(QUEUE_MODE_LIST);
+    long ring_received = queue_benchmark(QUEUE_MODE_RING);
+    set_loglevel(saved_loglevel);
+    ASSERT_EQ((long)BENCH_PRODUCERS * BENCH_MESSAGES, list_received);
+    ASSERT_EQ((long)BENCH_PRODUCERS * BENCH_MESSAGES, ring_received);
+}
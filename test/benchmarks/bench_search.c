@@ -0,0 +1,88 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+
+#include "dist/utest/utest.h"
+#include "dist/utf8/utf8.h"
+#include "src/lib/casefold.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds_extras.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static const char *haystacks[] = {
+    "The Beatles",
+    "Motörhead",
+    "Sigur Rós",
+    "ΣΙΓΜΑ σίγμα",
+    "Пётр Ильич Чайковский",
+    "Ärzte",
+    "Die Toten Hosen",
+    "Einstürzende Neubauten"
+};
+
+/**
+ * Compares the search time of utf8casestr with pre-folded values
+ */
+UTEST(benchmark, search_contains) {
+    const unsigned count = 20000;
+    sds *values = malloc_assert(sizeof(sds) * count);
+    sds *folded = malloc_assert(sizeof(sds) * count);
+    for (unsigned i = 0; i < count; i++) {
+        values[i] = sdscatprintf(sdsempty(), "Artist Number %u - %s", i, haystacks[i % 8]);
+        folded[i] = casefold_cat(sdsempty(), values[i]);
+    }
+    const char *needle = "NUMBER 1999";
+    sds needle_folded = casefold_cat(sdsempty(), needle);
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned matches_utf8 = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (utf8casestr(values[i], needle) != NULL) {
+            matches_utf8++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long utf8_us = (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned matches_folded = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (casefold_find(folded[i], sdslen(folded[i]), needle_folded, sdslen(needle_folded)) != NULL) {
+            matches_folded++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long folded_us = (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned matches_fold_on_the_fly = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (casefold_contains(values[i], needle_folded, sdslen(needle_folded)) == true) {
+            matches_fold_on_the_fly++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long fold_on_the_fly_us = (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000;
+
+    printf("%u values, utf8casestr: %lld us, casefold_find: %lld us, casefold_contains: %lld us\n",
+        count, utf8_us, folded_us, fold_on_the_fly_us);
+    ASSERT_EQ(matches_utf8, matches_folded);
+    ASSERT_EQ(matches_utf8, matches_fold_on_the_fly);
+    ASSERT_EQ(11U, matches_folded);
+
+    for (unsigned i = 0; i < count; i++) {
+        sdsfree(values[i]);
+        sdsfree(folded[i]);
+    }
+    free(values);
+    free(folded);
+    sdsfree(needle_folded);
+}
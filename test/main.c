@@ -13,6 +13,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+//signal handler
+sig_atomic_t s_signal_received;
 //message queues
 struct t_mympd_queue *web_server_queue;
 struct t_mympd_queue *mympd_api_queue;
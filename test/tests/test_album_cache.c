@@ -10,10 +10,15 @@
 
 #include "dist/utest/utest.h"
 #include "dist/libmympdclient/src/isong.h"
+#include "src/lib/album_index.h"
+#include "src/lib/album_results.h"
 #include "src/lib/cache_rax_album.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/search.h"
 #include "src/mpd_client/tags.h"
 
 #include <mpd/client.h>
+#include <sys/stat.h>
 
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
@@ -129,3 +134,246 @@ UTEST(album_cache, test_album_cache_inc_song_count) {
 
     mpd_song_free(album);
 }
+
+UTEST(album_cache, test_album_cache_merge) {
+    struct mpd_song *album = new_song();
+    album_cache_set_song_count(album, 2);
+    album_cache_set_disc_count(album, 1);
+    struct mpd_song *part = new_song();
+    album_cache_set_song_count(part, 3);
+    album_cache_set_disc_count(part, 2);
+    part->last_modified = 1699304602;
+    mympd_mpd_song_add_tag_dedup(part, MPD_TAG_ARTIST, "FM Einheit");
+
+    struct t_mpd_tags tags;
+    tags.len = 1;
+    tags.tags[0] = MPD_TAG_ARTIST;
+    ASSERT_TRUE(album_cache_merge(album, part, &tags));
+    ASSERT_EQ(5U, album_get_song_count(album));
+    ASSERT_EQ(2U, album_get_discs(album));
+    ASSERT_EQ(20U, album_get_total_time(album));
+    ASSERT_EQ(1699304602, mpd_song_get_last_modified(album));
+    // the added timestamp of the first part is kept
+    ASSERT_EQ(1699304451, mpd_song_get_added(album));
+    ASSERT_STREQ("Blixa Bargeld", mpd_song_get_tag(album, MPD_TAG_ARTIST, 1));
+    ASSERT_STREQ("FM Einheit", mpd_song_get_tag(album, MPD_TAG_ARTIST, 2));
+    ASSERT_TRUE(mpd_song_get_tag(album, MPD_TAG_ARTIST, 3) == NULL);
+
+    mpd_song_free(album);
+    mpd_song_free(part);
+}
+
+UTEST(album_cache, test_album_cache_write_read) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/"DIR_WORK_TAGS, 0770);
+    struct t_albums_config album_config = {
+        .group_tag = MPD_TAG_UNKNOWN,
+        .mode = ALBUM_MODE_ADV
+    };
+    struct t_mpd_tags tags;
+    tags.len = 2;
+    tags.tags[0] = MPD_TAG_ALBUM;
+    tags.tags[1] = MPD_TAG_ARTIST;
+    struct t_cache album_cache;
+    album_cache.cache = raxNew();
+    struct mpd_song *album = new_song();
+    album_cache_set_song_count(album, 3);
+    raxInsert(album_cache.cache, (unsigned char *)"a1", 2, album, NULL);
+
+    bool rc = album_cache_write(&album_cache, workdir, &tags, &album_config, 1699304602, true);
+    ASSERT_TRUE(rc);
+    ASSERT_TRUE(album_cache.cache == NULL);
+    time_t db_update = 0;
+    rc = album_cache_read(&album_cache, workdir, &album_config, &db_update);
+    ASSERT_TRUE(rc);
+    // the database update time is used as modified-since for the incremental update
+    ASSERT_EQ(1699304602, db_update);
+    ASSERT_EQ(1U, (unsigned)album_cache.cache->numele);
+    void *data;
+    ASSERT_EQ(1, raxFind(album_cache.cache, (unsigned char *)"a1", 2, &data));
+    ASSERT_EQ(3U, album_get_song_count((struct mpd_song *)data));
+
+    album_cache_free(&album_cache);
+    ASSERT_TRUE(album_cache_remove(workdir));
+    clean_testenv();
+}
+
+UTEST(album_cache, test_album_cache_count_names) {
+    rax *album_cache = raxNew();
+    struct mpd_song *album1 = new_song();
+    album_cache_set_song_count(album1, 3);
+    raxInsert(album_cache, (unsigned char *)"a1", 2, album1, NULL);
+    struct mpd_song *album2 = new_song();
+    album_cache_set_song_count(album2, 2);
+    raxInsert(album_cache, (unsigned char *)"a2", 2, album2, NULL);
+    struct mpd_song *album3 = new_song();
+    album_cache_set_song_count(album3, 4);
+    mympd_mpd_song_add_tag_dedup(album3, MPD_TAG_ALBUM, "Halber Mensch");
+    raxInsert(album_cache, (unsigned char *)"a3", 2, album3, NULL);
+
+    rax *names = raxNew();
+    rax *counts = album_cache_count_names(album_cache, names);
+    // albums with the same name are summed up
+    ASSERT_EQ(1U, (unsigned)counts->numele);
+    void *data;
+    ASSERT_EQ(1, raxFind(counts, (unsigned char *)"Tabula Rasa", 11, &data));
+    ASSERT_EQ(5U, (unsigned)(uintptr_t)data);
+    // the count of an album with multiple names is not assigned, the names are rebuilt
+    ASSERT_EQ(2U, (unsigned)names->numele);
+    ASSERT_EQ(1, raxFind(names, (unsigned char *)"Halber Mensch", 13, NULL));
+
+    raxFree(counts);
+    raxFree(names);
+    album_cache_free_rt(album_cache);
+}
+
+UTEST(album_cache, test_album_cache_remove_names) {
+    rax *album_cache = raxNew();
+    struct mpd_song *album1 = new_song();
+    raxInsert(album_cache, (unsigned char *)"a1", 2, album1, NULL);
+    struct mpd_song *album2 = new_song();
+    free(album2->tags[MPD_TAG_ALBUM].value);
+    album2->tags[MPD_TAG_ALBUM].value = strdup("Halber Mensch");
+    mympd_mpd_song_add_tag_dedup(album2, MPD_TAG_ALBUM, "Kollaps");
+    raxInsert(album_cache, (unsigned char *)"a2", 2, album2, NULL);
+    struct mpd_song *album3 = new_song();
+    free(album3->tags[MPD_TAG_ALBUM].value);
+    album3->tags[MPD_TAG_ALBUM].value = strdup("Kollaps");
+    raxInsert(album_cache, (unsigned char *)"a3", 2, album3, NULL);
+
+    rax *names = raxNew();
+    raxInsert(names, (unsigned char *)"Halber Mensch", 13, NULL, NULL);
+    album_cache_remove_names(album_cache, names);
+    // the other name of a removed album removes the albums with this name
+    ASSERT_EQ(1U, (unsigned)album_cache->numele);
+    ASSERT_EQ(1, raxFind(album_cache, (unsigned char *)"a1", 2, NULL));
+    ASSERT_EQ(2U, (unsigned)names->numele);
+    ASSERT_EQ(1, raxFind(names, (unsigned char *)"Kollaps", 7, NULL));
+
+    raxFree(names);
+    album_cache_free_rt(album_cache);
+}
+
+UTEST(album_cache, test_album_index_lookup) {
+    rax *album_cache = raxNew();
+    struct mpd_song *album1 = new_song();
+    raxInsert(album_cache, (unsigned char *)"a1", 2, album1, NULL);
+    struct mpd_song *album2 = new_song();
+    free(album2->tags[MPD_TAG_ALBUM].value);
+    album2->tags[MPD_TAG_ALBUM].value = strdup("Halber Mensch");
+    raxInsert(album_cache, (unsigned char *)"a2", 2, album2, NULL);
+    struct t_album_index *album_index = album_index_new(album_cache);
+    ASSERT_EQ(2U, album_index->albums_len);
+
+    struct t_mpd_tags any_tags;
+    any_tags.len = 2;
+    any_tags.tags[0] = MPD_TAG_ALBUM;
+    any_tags.tags[1] = MPD_TAG_ARTIST;
+
+    struct t_input_result testcases[] = {
+        {"((Album == 'tabula rasa'))", "a1"},
+        {"((Album starts_with 'Hal'))", "a2"},
+        {"((Album contains 'BER MEN'))", "a2"},
+        {"((Album contains 'xyz'))", ""},
+        {"((any contains 'blixa'))", "a1a2"},
+        {"((Artist == 'Blixa Bargeld') AND (Album contains 'rasa'))", "a1"},
+        {NULL, NULL}
+    };
+    struct t_input_result *p = testcases;
+    sds result = sdsempty();
+    while (p->input != NULL) {
+        struct t_list *expr_list = parse_search_expression_to_list(p->input, SEARCH_TYPE_SONG);
+        struct t_album_postings *candidates = album_index_lookup(album_index, expr_list, &any_tags);
+        ASSERT_TRUE(candidates != NULL);
+        for (unsigned i = 0; i < candidates->len; i++) {
+            result = sdscat(result, album_index->albums[candidates->ids[i]] == album1 ? "a1" : "a2");
+        }
+        ASSERT_STREQ(p->result, result);
+        sdsclear(result);
+        album_postings_free(candidates);
+        free_search_expression_list(expr_list);
+        p++;
+    }
+    sdsfree(result);
+
+    // regex can not be answered by the index
+    struct t_list *expr_list = parse_search_expression_to_list("((Album =~ 'tab'))", SEARCH_TYPE_SONG);
+    ASSERT_TRUE(album_index_lookup(album_index, expr_list, &any_tags) == NULL);
+    free_search_expression_list(expr_list);
+
+    album_index_free(album_index);
+    album_cache_free_rt(album_cache);
+}
+
+UTEST(album_cache, test_album_index_casefold) {
+    rax *album_cache = raxNew();
+    struct mpd_song *album = new_song();
+    free(album->tags[MPD_TAG_ALBUM].value);
+    // U+0130 has no lower case mapping, U+00C4 is folded to U+00E4,
+    // the truncated sequence \xC4 must not swallow the following ascii char
+    album->tags[MPD_TAG_ALBUM].value = strdup("\xC4\xB0stanbul \xC3\x84rzte \xC4" "ABC");
+    raxInsert(album_cache, (unsigned char *)"a1", 2, album, NULL);
+    struct t_album_index *album_index = album_index_new(album_cache);
+
+    struct t_mpd_tags any_tags;
+    any_tags.len = 1;
+    any_tags.tags[0] = MPD_TAG_ALBUM;
+
+    // the index must return the album for every expression the matcher accepts
+    struct t_input_result testcases[] = {
+        {"((Album contains '\xC4\xB0STAN'))", "1"},
+        {"((Album contains 'istan'))", "0"},
+        {"((Album contains '\xC3\xA4RZTE'))", "1"},
+        {"((Album starts_with '\xC4\xB0sTA'))", "1"},
+        {"((Album contains 'abc'))", "1"},
+        {"((Album starts_with '\xC4\xB0STANBUL \xC3\x84RZTE'))", "1"},
+        {NULL, NULL}
+    };
+    for (struct t_input_result *p = testcases; p->input != NULL; p++) {
+        struct t_list *expr_list = parse_search_expression_to_list(p->input, SEARCH_TYPE_SONG);
+        bool match = search_expression_song(album, expr_list, &any_tags);
+        ASSERT_EQ(p->result[0] == '1', match);
+        ASSERT_EQ(match, search_expression_cached_song(album_index->records[0], expr_list, &any_tags, false));
+        struct t_album_postings *candidates = album_index_lookup(album_index, expr_list, &any_tags);
+        ASSERT_TRUE(candidates != NULL);
+        ASSERT_EQ(match ? 1U : 0U, candidates->len);
+        album_postings_free(candidates);
+        free_search_expression_list(expr_list);
+    }
+
+    album_index_free(album_index);
+    album_cache_free_rt(album_cache);
+}
+
+UTEST(album_cache, test_album_results) {
+    struct t_list lru;
+    list_init(&lru);
+    int data[2];
+    rax *albums = raxNew();
+    raxInsert(albums, (unsigned char *)"b", 1, &data[1], NULL);
+    raxInsert(albums, (unsigned char *)"a", 1, &data[0], NULL);
+    struct t_mpd_tags any_tags;
+    any_tags.len = 1;
+    any_tags.tags[0] = MPD_TAG_ARTIST;
+    sds key = album_results_key(sdsempty(), "(Album == 'x')", SORT_BY_TAG, MPD_TAG_ALBUM, &any_tags);
+    ASSERT_TRUE(album_results_get(&lru, key) == NULL);
+    const struct t_album_results *results = album_results_add(&lru, key, albums);
+    ASSERT_EQ(2U, results->len);
+    ASSERT_TRUE((void *)results->albums[0] == (void *)&data[0]);
+    ASSERT_TRUE((void *)results->albums[1] == (void *)&data[1]);
+    ASSERT_TRUE(album_results_get(&lru, key) == results);
+    //evict the least recently used result
+    sds key2 = sdsempty();
+    for (unsigned i = 0; i < ALBUM_RESULTS_CACHE_MAX; i++) {
+        key2 = album_results_key(key2, "", SORT_BY_TAG, (enum mpd_tag_type)i, &any_tags);
+        album_results_add(&lru, key2, albums);
+        sdsclear(key2);
+    }
+    ASSERT_EQ((unsigned)ALBUM_RESULTS_CACHE_MAX, lru.length);
+    ASSERT_TRUE(album_results_get(&lru, key) == NULL);
+    album_results_clear(&lru);
+    ASSERT_EQ(0U, lru.length);
+    raxFree(albums);
+    FREE_SDS(key);
+    FREE_SDS(key2);
+}
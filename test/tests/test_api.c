@@ -9,6 +9,7 @@
 
 #include "dist/utest/utest.h"
 #include "src/lib/api.h"
+#include "src/lib/msg_queue.h"
 
 UTEST(api, test_get_cmd_id) {
     enum mympd_cmd_ids cmd_id = get_cmd_id("MYMPD_API_VIEW_SAVE");
@@ -16,6 +17,14 @@ UTEST(api, test_get_cmd_id) {
     ASSERT_TRUE(rc);
 }
 
+UTEST(api, test_get_cmd_id_all) {
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        ASSERT_EQ(i, (unsigned)get_cmd_id(get_cmd_id_method_name(i)));
+    }
+    ASSERT_EQ((unsigned)GENERAL_API_UNKNOWN, (unsigned)get_cmd_id("MYMPD_API_INVALID"));
+    ASSERT_EQ((unsigned)GENERAL_API_UNKNOWN, (unsigned)get_cmd_id(""));
+}
+
 UTEST(api, test_get_cmd_id_method_name) {
     const char *name = get_cmd_id_method_name(MYMPD_API_VIEW_SAVE);
     ASSERT_STREQ(name, "MYMPD_API_VIEW_SAVE");
@@ -37,6 +46,13 @@ UTEST(api, test_is_public_api_method) {
     ASSERT_FALSE(rc);
 }
 
+UTEST(api, test_is_script_api_method) {
+    ASSERT_TRUE(is_script_api_method(MYMPD_API_SETTINGS_SET));
+    ASSERT_TRUE(is_script_api_method(INTERNAL_API_SCRIPT_INIT));
+    ASSERT_FALSE(is_script_api_method(INTERNAL_API_STATE_SAVE));
+    ASSERT_FALSE(is_script_api_method(TOTAL_API_COUNT));
+}
+
 UTEST(api, test_is_mpd_disconnected_api_method) {
     bool rc = is_mpd_disconnected_api_method(MYMPD_API_CONNECTION_SAVE);
     ASSERT_TRUE(rc);
@@ -45,6 +61,32 @@ UTEST(api, test_is_mpd_disconnected_api_method) {
     ASSERT_FALSE(rc);
 }
 
+UTEST(api, test_is_mpd_worker_pool_request) {
+    struct t_work_request *request = create_request(REQUEST_TYPE_DEFAULT, 1, 1, MYMPD_API_PLAYLIST_LIST, "test", MPD_PARTITION_DEFAULT);
+    ASSERT_TRUE(is_mpd_worker_pool_request(request, false));
+    ASSERT_TRUE(is_mpd_worker_pool_request(request, true));
+    //requests from scripts stay on the main connection
+    request->type = REQUEST_TYPE_SCRIPT;
+    ASSERT_FALSE(is_mpd_worker_pool_request(request, false));
+    //search stays on the mympd_api thread while the song cache is loaded
+    request->type = REQUEST_TYPE_DEFAULT;
+    request->cmd_id = MYMPD_API_DATABASE_SEARCH;
+    ASSERT_TRUE(is_mpd_worker_pool_request(request, false));
+    ASSERT_FALSE(is_mpd_worker_pool_request(request, true));
+    request->cmd_id = MYMPD_API_DATABASE_TAG_LIST;
+    ASSERT_TRUE(is_mpd_worker_pool_request(request, false));
+    ASSERT_FALSE(is_mpd_worker_pool_request(request, true));
+    request->cmd_id = MYMPD_API_DATABASE_FILESYSTEM_LIST;
+    ASSERT_TRUE(is_mpd_worker_pool_request(request, true));
+    //album views use the album cache of the mympd_api thread
+    request->cmd_id = MYMPD_API_DATABASE_ALBUM_LIST;
+    ASSERT_FALSE(is_mpd_worker_pool_request(request, false));
+    //mutating requests are never routed
+    request->cmd_id = MYMPD_API_PLAYLIST_CONTENT_CLEAR;
+    ASSERT_FALSE(is_mpd_worker_pool_request(request, false));
+    free_request(request);
+}
+
 UTEST(api, test_request_result) {
     struct t_work_request *request = create_request(REQUEST_TYPE_DEFAULT, 1, 1, MYMPD_API_SETTINGS_SET, "test", MPD_PARTITION_DEFAULT);
     bool rc = request == NULL ? false : true;
@@ -59,3 +101,67 @@ UTEST(api, test_request_result) {
     free_request(request);
     free_response(response);
 }
+
+UTEST(api, test_response_stream) {
+    web_server_queue = mympd_queue_create("test_web_server_queue", QUEUE_TYPE_RESPONSE, QUEUE_MODE_LIST, false);
+    struct t_work_request *request = create_request(REQUEST_TYPE_DEFAULT, 1, 1, MYMPD_API_QUEUE_SEARCH, "test", MPD_PARTITION_DEFAULT);
+    response_stream_begin(request);
+    //small buffers are not flushed
+    sds buffer = sdsnew("[");
+    buffer = response_stream_flush(buffer);
+    ASSERT_EQ(1U, (unsigned)sdslen(buffer));
+    //full buffers are pushed as a chunk
+    buffer = sdsgrowzero(buffer, HTTP_CHUNK_SIZE);
+    buffer = response_stream_flush(buffer);
+    ASSERT_EQ(0U, (unsigned)sdslen(buffer));
+    struct t_work_response *response = mympd_queue_shift(web_server_queue, 50, 0);
+    ASSERT_TRUE(response != NULL);
+    ASSERT_EQ((unsigned)RESPONSE_TYPE_CHUNK, (unsigned)response->type);
+    ASSERT_EQ(1UL, response->conn_id);
+    ASSERT_EQ((unsigned)HTTP_CHUNK_SIZE, (unsigned)sdslen(response->data));
+    free_response(response);
+    response_stream_end();
+    //no streaming outside of the handler
+    buffer = sdsgrowzero(buffer, HTTP_CHUNK_SIZE);
+    buffer = response_stream_flush(buffer);
+    ASSERT_EQ((unsigned)HTTP_CHUNK_SIZE, (unsigned)sdslen(buffer));
+    sdsfree(buffer);
+    free_request(request);
+    mympd_queue_free(web_server_queue);
+    web_server_queue = NULL;
+}
+
+UTEST(api, test_response_stream_abort) {
+    web_server_queue = mympd_queue_create("test_web_server_queue", QUEUE_TYPE_RESPONSE, QUEUE_MODE_LIST, false);
+    struct t_work_request *request = create_request(REQUEST_TYPE_DEFAULT, 1, 1, MYMPD_API_QUEUE_SEARCH, "test", MPD_PARTITION_DEFAULT);
+    response_stream_begin(request);
+    //nothing streamed, the error response replaces the response
+    ASSERT_FALSE(response_stream_abort());
+    struct t_work_response *response = create_response(request);
+    push_response(response);
+    response = mympd_queue_shift(web_server_queue, 50, 0);
+    ASSERT_EQ((unsigned)RESPONSE_TYPE_DEFAULT, (unsigned)response->type);
+    free_response(response);
+    //a chunk was sent, the final response closes the connection
+    sds buffer = sdsgrowzero(sdsempty(), HTTP_CHUNK_SIZE);
+    buffer = response_stream_flush(buffer);
+    response = mympd_queue_shift(web_server_queue, 50, 0);
+    free_response(response);
+    ASSERT_TRUE(response_stream_abort());
+    response = create_response(request);
+    push_response(response);
+    response = mympd_queue_shift(web_server_queue, 50, 0);
+    ASSERT_EQ((unsigned)RESPONSE_TYPE_ABORT, (unsigned)response->type);
+    free_response(response);
+    response_stream_end();
+    //the next response is not affected
+    response = create_response(request);
+    push_response(response);
+    response = mympd_queue_shift(web_server_queue, 50, 0);
+    ASSERT_EQ((unsigned)RESPONSE_TYPE_DEFAULT, (unsigned)response->type);
+    free_response(response);
+    sdsfree(buffer);
+    free_request(request);
+    mympd_queue_free(web_server_queue);
+    web_server_queue = NULL;
+}
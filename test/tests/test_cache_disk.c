@@ -0,0 +1,76 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/cache_disk.h"
+#include "src/lib/filehandler.h"
+
+#include <sys/stat.h>
+#include <utime.h>
+
+UTEST(cache_disk, test_negative) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/cover", 0770);
+    mkdir("/tmp/mympd-test/music", 0770);
+    const char *cachedir = "/tmp/mympd-test";
+    const char *media_file = "/tmp/mympd-test/music/song.mp3";
+    ASSERT_TRUE(write_data_to_file(media_file, "", 0));
+
+    bool rc = cache_disk_negative_check(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0, media_file);
+    ASSERT_FALSE(rc);
+
+    rc = cache_disk_negative_write(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0);
+    ASSERT_TRUE(rc);
+    rc = cache_disk_negative_check(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0, media_file);
+    ASSERT_TRUE(rc);
+    rc = cache_disk_negative_check(cachedir, DIR_CACHE_COVER, "music/song.mp3", 1, NULL);
+    ASSERT_FALSE(rc);
+
+    // entry is stale if the media file was modified after it was written
+    struct utimbuf times = {
+        .actime = time(NULL) + 60,
+        .modtime = time(NULL) + 60
+    };
+    ASSERT_EQ(0, utime(media_file, &times));
+    rc = cache_disk_negative_check(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0, media_file);
+    ASSERT_FALSE(rc);
+    // stale entry was removed
+    rc = cache_disk_negative_check(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0, NULL);
+    ASSERT_FALSE(rc);
+
+    rc = cache_disk_negative_write(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0);
+    ASSERT_TRUE(rc);
+    cache_disk_negative_remove(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0);
+    rc = cache_disk_negative_check(cachedir, DIR_CACHE_COVER, "music/song.mp3", 0, NULL);
+    ASSERT_FALSE(rc);
+
+    clean_testenv();
+}
+
+UTEST(cache_disk, test_negative_clear) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/cover", 0770);
+    struct t_config config;
+    config.cachedir = sdsnew("/tmp/mympd-test");
+    config.cache_cover_keep_days = 31;
+    config.cache_lyrics_keep_days = CACHE_DISK_DISABLED;
+    const char *cover_file = "/tmp/mympd-test/cover/song.jpg";
+    ASSERT_TRUE(write_data_to_file(cover_file, "", 0));
+    ASSERT_TRUE(cache_disk_negative_write(config.cachedir, DIR_CACHE_COVER, "music/song1.mp3", 0));
+    ASSERT_TRUE(cache_disk_negative_write(config.cachedir, DIR_CACHE_COVER, "music/song2.mp3", 0));
+
+    cache_disk_negative_clear(&config);
+    ASSERT_FALSE(cache_disk_negative_check(config.cachedir, DIR_CACHE_COVER, "music/song1.mp3", 0, NULL));
+    ASSERT_FALSE(cache_disk_negative_check(config.cachedir, DIR_CACHE_COVER, "music/song2.mp3", 0, NULL));
+    // other cache files are kept
+    ASSERT_TRUE(get_mtime(cover_file) > 0);
+
+    sdsfree(config.cachedir);
+    clean_testenv();
+}
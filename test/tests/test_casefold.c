@@ -0,0 +1,101 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/sds/sds.h"
+#include "dist/utest/utest.h"
+#include "dist/utf8/utf8.h"
+#include "src/lib/casefold.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *haystacks[] = {
+    "The Beatles",
+    "Abbey Road (Remastered 2019)",
+    "Motörhead",
+    "MOTÖRHEAD",
+    "Sigur Rós",
+    "ΣΙΓΜΑ σίγμα",
+    "Пётр Ильич Чайковский",
+    "A very long album title that is longer than sixteen bytes, to use the vector loop",
+    "",
+    NULL
+};
+
+static const char *needles[] = {
+    "beatles",
+    "BEATLES",
+    "road (rem",
+    "2019)",
+    "motö",
+    "MOTÖ",
+    "RÓS",
+    "σίγμα",
+    "ЧАЙКОВ",
+    "vector LOOP",
+    "x",
+    "the beatles!",
+    NULL
+};
+
+UTEST(casefold, test_casefold) {
+    char buf[64];
+    ASSERT_EQ(11U, casefold("The Beatles", buf, sizeof(buf)));
+    ASSERT_STREQ("the beatles", buf);
+    ASSERT_EQ(10U, casefold("MOTÖRHEAD", buf, sizeof(buf)));
+    ASSERT_STREQ("motörhead", buf);
+    ASSERT_EQ(CASEFOLD_OVERFLOW, casefold("The Beatles", buf, 5));
+    // truncated utf8 sequence is copied
+    ASSERT_EQ(2U, casefold("A\xc3", buf, sizeof(buf)));
+    ASSERT_STREQ("a\xc3", buf);
+
+    sds s = casefold_cat(sdsempty(), "Sigur RÓS");
+    ASSERT_STREQ("sigur rós", s);
+    sdsfree(s);
+}
+
+UTEST(casefold, test_casefold_find) {
+    const char *haystack = "abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+    size_t haystack_len = strlen(haystack);
+    const char *tests[] = {"a", "xyz", "z0", "789a", "yz", "abcdefghijklmnopqrstuvwxyz0", "zz", "9b", NULL};
+    for (int i = 0; tests[i] != NULL; i++) {
+        size_t needle_len = strlen(tests[i]);
+        const char *expected = strstr(haystack, tests[i]);
+        ASSERT_TRUE(expected == casefold_find(haystack, haystack_len, tests[i], needle_len));
+        ASSERT_TRUE(expected == casefold_find_scalar(haystack, haystack_len, tests[i], needle_len));
+    }
+    // needle longer than haystack
+    ASSERT_TRUE(NULL == casefold_find("abc", 3, "abcd", 4));
+    // empty needle
+    ASSERT_TRUE(haystack == casefold_find(haystack, haystack_len, "", 0));
+}
+
+UTEST(casefold, test_casefold_contains) {
+    for (int i = 0; haystacks[i] != NULL; i++) {
+        for (int j = 0; needles[j] != NULL; j++) {
+            sds needle = casefold_cat(sdsempty(), needles[j]);
+            bool expected = utf8casestr(haystacks[i], needles[j]) != NULL;
+            bool rc = casefold_contains(haystacks[i], needle, sdslen(needle));
+            if (expected != rc) {
+                printf("Mismatch: \"%s\" contains \"%s\"\n", haystacks[i], needles[j]);
+            }
+            ASSERT_EQ(expected, rc);
+            sdsfree(needle);
+        }
+    }
+    // haystack that does not fit in the stack buffer
+    sds haystack = sdsempty();
+    for (int i = 0; i < 200; i++) {
+        haystack = sdscat(haystack, "Motörhead ");
+    }
+    haystack = sdscat(haystack, "The Beatles");
+    ASSERT_TRUE(casefold_contains(haystack, "the beatles", 11));
+    ASSERT_FALSE(casefold_contains(haystack, "sigur", 5));
+    sdsfree(haystack);
+}
@@ -117,6 +117,35 @@ UTEST(filehandler, test_sds_getfile) {
     clean_testenv();
 }
 
+UTEST(filehandler, test_sds_getfile_binary) {
+    init_testenv();
+
+    const char data[] = "\n\t\0\xff\xd8 image \r\n";
+    size_t data_len = sizeof(data) - 1;
+    bool rc = write_data_to_file("/tmp/mympd-test/state/test.bin", data, data_len);
+    ASSERT_TRUE(rc);
+
+    int nread = 0;
+    sds binary = sds_getfile_binary(sdsempty(), "/tmp/mympd-test/state/test.bin", 1000, &nread);
+    ASSERT_EQ(nread, (int)data_len);
+    ASSERT_EQ(sdslen(binary), data_len);
+    ASSERT_EQ(memcmp(binary, data, data_len), 0);
+
+    // too big
+    nread = 0;
+    binary = sds_getfile_binary(binary, "/tmp/mympd-test/state/test.bin", 5, &nread);
+    ASSERT_EQ(nread, -2);
+    ASSERT_EQ(sdslen(binary), 0U);
+
+    // not existing
+    nread = 0;
+    binary = sds_getfile_binary(binary, "/tmp/mympd-test/state/test-notexist", 1000, &nread);
+    ASSERT_EQ(nread, -1);
+    sdsfree(binary);
+
+    clean_testenv();
+}
+
 UTEST(filehandler, test_sds_getline) {
     init_testenv();
 
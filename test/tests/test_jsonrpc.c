@@ -257,3 +257,31 @@ UTEST(jsonrpc, test_json_get_fields_as_string) {
     FREE_SDS(cols);
     FREE_SDS(data);
 }
+
+UTEST(jsonrpc, test_json_index) {
+    sds data = sdsnew("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"MYMPD_API_TEST\",\"params\":{\"uri\":\"song.mp3\",\"play\":true,"
+        "\"pos\":10,\"sub\":{\"key1\":\"val1\"},\"fields\":[\"Artist\",\"Title\"],\"uri\":\"duplicate\"}}");
+    json_index_create(data);
+    sds result = NULL;
+    ASSERT_TRUE(json_get_string(data, "$.params.uri", 1, 20, &result, vcb_isfilepath, NULL));
+    ASSERT_STREQ("song.mp3", result);
+    FREE_SDS(result);
+    ASSERT_TRUE(json_get_string(data, "$.params.sub.key1", 1, 20, &result, vcb_isname, NULL));
+    ASSERT_STREQ("val1", result);
+    FREE_SDS(result);
+    bool bool_result;
+    ASSERT_TRUE(json_get_bool(data, "$.params.play", &bool_result, NULL));
+    ASSERT_TRUE(bool_result);
+    unsigned uint_result;
+    ASSERT_TRUE(json_get_uint(data, "$.params.pos", 0, 20, &uint_result, NULL));
+    ASSERT_EQ(10U, uint_result);
+    ASSERT_FALSE(json_get_uint(data, "$.params.missing", 0, 20, &uint_result, NULL));
+    struct t_list l;
+    list_init(&l);
+    ASSERT_TRUE(json_get_array_string(data, "$.params.fields", &l, vcb_isname, 10, NULL));
+    ASSERT_EQ(2U, l.length);
+    list_clear(&l);
+    ASSERT_TRUE(json_find_key(data, "$.params.fields[1]"));
+    json_index_free();
+    FREE_SDS(data);
+}
@@ -425,6 +425,108 @@ UTEST(list, test_list_sort_by_key) {
     list_clear(&test_list);
 }
 
+UTEST(list, test_list_sort_stable) {
+    struct t_list test_list;
+    list_init(&test_list);
+    list_push(&test_list, "a", 2, NULL, NULL);
+    list_push(&test_list, "b", 1, NULL, NULL);
+    list_push(&test_list, "c", 2, NULL, NULL);
+    list_push(&test_list, "d", 1, NULL, NULL);
+    list_push(&test_list, "e", 0, NULL, NULL);
+
+    list_sort_by_value_i(&test_list, LIST_SORT_ASC);
+    sds order = sdsempty();
+    struct t_list_node *current = test_list.head;
+    while (current != NULL) {
+        order = sdscat(order, current->key);
+        current = current->next;
+    }
+    ASSERT_STREQ("ebdac", order);
+    ASSERT_STREQ("c", test_list.tail->key);
+    ASSERT_TRUE(test_list.tail->next == NULL);
+
+    sdsfree(order);
+    list_clear(&test_list);
+}
+
+static bool sort_random(unsigned count) {
+    struct t_list test_list;
+    list_init(&test_list);
+    //deterministic pseudo random values
+    uint32_t seed = 1;
+    for (unsigned i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        list_push(&test_list, "", (int64_t)(seed >> 8), NULL, NULL);
+    }
+    list_sort_by_value_i(&test_list, LIST_SORT_ASC);
+
+    bool sorted = true;
+    unsigned len = 0;
+    struct t_list_node *current = test_list.head;
+    while (current != NULL) {
+        if (current->next != NULL &&
+            current->value_i > current->next->value_i)
+        {
+            sorted = false;
+        }
+        if (current->next == NULL &&
+            current != test_list.tail)
+        {
+            sorted = false;
+        }
+        len++;
+        current = current->next;
+    }
+    list_clear(&test_list);
+    return sorted == true && len == count;
+}
+
+UTEST(list, test_list_sort_random) {
+    ASSERT_TRUE(sort_random(10000));
+    ASSERT_TRUE(sort_random(100000));
+}
+
+UTEST(list, test_list_index) {
+    struct t_list test_list;
+    populate_list(&test_list);
+    list_index_enable(&test_list);
+    ASSERT_TRUE(list_has_key(&test_list, "key0"));
+    ASSERT_TRUE(list_has_value(&test_list, "value5"));
+    ASSERT_FALSE(list_has_key(&test_list, "key6"));
+
+    list_push(&test_list, "key6", 6, "value6", NULL);
+    ASSERT_TRUE(list_has_key(&test_list, "key6"));
+    ASSERT_EQ(7U, list_get_node_idx(&test_list, "key6") + 1);
+
+    list_replace(&test_list, 0, "key7", 7, "value7", NULL);
+    ASSERT_FALSE(list_has_key(&test_list, "key0"));
+    ASSERT_FALSE(list_has_value(&test_list, "value0"));
+    ASSERT_TRUE(list_has_key(&test_list, "key7"));
+
+    //duplicate keys are counted
+    list_insert(&test_list, "key1", 1, "value1", NULL);
+    list_remove_node_by_key(&test_list, "key1");
+    ASSERT_TRUE(list_has_key(&test_list, "key1"));
+    list_remove_node_by_key(&test_list, "key1");
+    ASSERT_FALSE(list_has_key(&test_list, "key1"));
+    ASSERT_TRUE(list_get_node(&test_list, "key1") == NULL);
+
+    //moved nodes stay in the index
+    ASSERT_TRUE(list_move_item_pos(&test_list, 0, 3));
+    ASSERT_TRUE(list_has_key(&test_list, "key7"));
+    ASSERT_TRUE(list_has_value(&test_list, "value7"));
+    ASSERT_TRUE(list_get_node(&test_list, "key7") != NULL);
+    ASSERT_TRUE(list_move_item_pos(&test_list, 3, 0));
+    ASSERT_TRUE(list_get_node(&test_list, "key7") != NULL);
+
+    list_crop(&test_list, 2, NULL);
+    ASSERT_TRUE(list_has_key(&test_list, "key2"));
+    ASSERT_FALSE(list_has_key(&test_list, "key3"));
+
+    list_clear(&test_list);
+    ASSERT_TRUE(test_list.index == NULL);
+}
+
 static unsigned count_list(struct t_list *l) {
     long i = 0;
     struct t_list_node *current = l->head;
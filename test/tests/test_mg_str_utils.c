@@ -0,0 +1,40 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/mg_str_utils.h"
+
+static bool accepts(const char *header, const char *coding) {
+    struct mg_str accept_encoding = mg_str(header);
+    return mg_str_accepts_encoding(&accept_encoding, coding);
+}
+
+UTEST(mg_str_utils, test_mg_str_accepts_encoding) {
+    ASSERT_TRUE(accepts("gzip, deflate, br", "br"));
+    ASSERT_TRUE(accepts("gzip,br", "br"));
+    ASSERT_TRUE(accepts("BR", "br"));
+    ASSERT_TRUE(accepts("br;q=1.0, gzip;q=0.8", "br"));
+    ASSERT_TRUE(accepts("gzip, br ; q=0.001", "br"));
+    ASSERT_TRUE(accepts("*", "br"));
+    ASSERT_TRUE(accepts("gzip, *;q=0.1", "br"));
+    // q=0 means not acceptable
+    ASSERT_FALSE(accepts("gzip, br;q=0", "br"));
+    ASSERT_FALSE(accepts("br;q=0.000, gzip", "br"));
+    ASSERT_FALSE(accepts("br;Q=0.0", "br"));
+    ASSERT_FALSE(accepts("*;q=0", "br"));
+    ASSERT_FALSE(accepts("br;q=0, *", "br"));
+    // no substring matches
+    ASSERT_FALSE(accepts("gzip, brotli", "br"));
+    ASSERT_FALSE(accepts("gzip", "br"));
+    ASSERT_FALSE(accepts("", "br"));
+    // invalid qvalues
+    ASSERT_FALSE(accepts("br;q=2", "br"));
+    ASSERT_FALSE(accepts("br;q=1.5", "br"));
+    ASSERT_FALSE(accepts("br;q=abc", "br"));
+}
@@ -14,7 +14,7 @@
 #include "src/lib/sds_extras.h"
 
 UTEST(mympd_queue, push_shift) {
-    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, false);
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, QUEUE_MODE_LIST, false);
     sds test_data_in0 = sdsnew("test0");
     sds test_data_in1 = sdsnew("test0");
     sds test_data_in2 = sdsnew("test0");
@@ -46,7 +46,7 @@ UTEST(mympd_queue, push_shift) {
 }
 
 UTEST(mympd_queue, push_shift_id) {
-    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, false);
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, QUEUE_MODE_LIST, false);
     sds test_data_in0 = sdsnew("test0");
     sds test_data_in1 = sdsnew("test0");
     sds test_data_in2 = sdsnew("test0");
@@ -80,7 +80,7 @@ UTEST(mympd_queue, push_shift_id) {
 }
 
 UTEST(mympd_queue, expire) {
-    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, false);
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, QUEUE_MODE_LIST, false);
     for (int i = 0; i < 50; i++) {
         struct t_work_request *request = create_request(REQUEST_TYPE_DEFAULT, 0, 0, MYMPD_API_VIEW_SAVE, "test", MPD_PARTITION_DEFAULT);
         request->extra = malloc(10);
@@ -122,10 +122,66 @@ UTEST(mympd_queue, expire) {
 }
 
 UTEST(mympd_queue, event) {
-    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, true);
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, QUEUE_MODE_LIST, true);
     bool rc = event_eventfd_write(test_queue->event_fd);
     ASSERT_TRUE(rc);
     rc = event_eventfd_read(test_queue->event_fd);
     ASSERT_TRUE(rc);
     mympd_queue_free(test_queue);
 }
+
+UTEST(mympd_queue, ring_push_shift) {
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, QUEUE_MODE_RING, false);
+    //fill the ring and the overflow list
+    for (uintptr_t i = 1; i <= MSG_QUEUE_RING_SIZE + 10; i++) {
+        ASSERT_TRUE(mympd_queue_push(test_queue, (void *)i, 0));
+    }
+    ASSERT_EQ(10U, test_queue->length);
+    for (uintptr_t i = 1; i <= MSG_QUEUE_RING_SIZE + 10; i++) {
+        ASSERT_EQ(i, (uintptr_t)mympd_queue_shift(test_queue, -1, 0));
+    }
+    ASSERT_TRUE(mympd_queue_shift(test_queue, -1, 0) == NULL);
+    ASSERT_EQ(0U, test_queue->length);
+    mympd_queue_free(test_queue);
+}
+
+UTEST(mympd_queue, ring_unsupported) {
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, QUEUE_MODE_RING, false);
+    ASSERT_TRUE(mympd_queue_push(test_queue, (void *)1, 0));
+    //waiting, shifting by id and expiring is rejected
+    ASSERT_TRUE(mympd_queue_shift(test_queue, 50, 0) == NULL);
+    ASSERT_TRUE(mympd_queue_shift(test_queue, -1, 10) == NULL);
+    ASSERT_EQ(0, mympd_queue_expire_age(test_queue, 0));
+    ASSERT_EQ(1U, (uintptr_t)mympd_queue_shift(test_queue, -1, 0));
+    mympd_queue_free(test_queue);
+}
+
+UTEST(mympd_queue, mailbox_push_shift_id) {
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_RESPONSE, QUEUE_MODE_MAILBOX, false);
+    sds test_data_in0 = sdsnew("test0");
+    sds test_data_in1 = sdsnew("test1");
+    sds test_data_in2 = sdsnew("test2");
+
+    mympd_queue_push(test_queue, test_data_in0, 10);
+    mympd_queue_push(test_queue, test_data_in1, 20);
+    mympd_queue_push(test_queue, test_data_in2, 10);
+    ASSERT_EQ(3U, test_queue->length);
+
+    ASSERT_TRUE(mympd_queue_shift(test_queue, 50, 30) == NULL);
+    ASSERT_STREQ(test_data_in1, mympd_queue_shift(test_queue, 50, 20));
+    ASSERT_STREQ(test_data_in0, mympd_queue_shift(test_queue, 50, 10));
+    ASSERT_STREQ(test_data_in2, mympd_queue_shift(test_queue, -1, 10));
+    ASSERT_EQ(0U, test_queue->length);
+
+    for (int i = 0; i < 10; i++) {
+        struct t_work_response *response = create_response_new(RESPONSE_TYPE_DISCARD, 0, 0, MYMPD_API_VIEW_SAVE, MPD_PARTITION_DEFAULT);
+        mympd_queue_push(test_queue, response, (unsigned)(i % 3) + 1);
+    }
+    ASSERT_EQ(10, mympd_queue_expire_age(test_queue, 0));
+    ASSERT_EQ(0U, test_queue->length);
+
+    mympd_queue_free(test_queue);
+    sdsfree(test_data_in0);
+    sdsfree(test_data_in1);
+    sdsfree(test_data_in2);
+}
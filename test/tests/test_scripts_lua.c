@@ -0,0 +1,65 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/scripts/scripts_lua.h"
+
+/**
+ * Runs a script like a script worker thread and returns the result
+ */
+static sds run_script(lua_State *lua_vm, const char *script) {
+    sds result;
+    int rc = luaL_loadstring(lua_vm, script);
+    if (rc == 0) {
+        script_vm_set_env(lua_vm);
+        rc = lua_pcall(lua_vm, 0, 1, 0);
+    }
+    result = rc == 0 && lua_gettop(lua_vm) == 1 && lua_type(lua_vm, 1) == LUA_TSTRING
+        ? sdsnew(lua_tostring(lua_vm, 1))
+        : sdsnew("error");
+    script_vm_reset(lua_vm);
+    return result;
+}
+
+UTEST(scripts_lua, test_vm_isolation) {
+    lua_State *lua_vm = script_vm_new();
+    ASSERT_TRUE(lua_vm != NULL);
+
+    // first script sets globals and tries to modify the libraries
+    sds result = run_script(lua_vm,
+        "local tostring = tostring\n"
+        "leaked_global = true\n"
+        "package.loaded.leaked_module = true\n"
+        "local ok_string = pcall(function() string.leaked = true end)\n"
+        "local ok_mympd = pcall(function() mympd.leaked = true end)\n"
+        "rawset(table, 'leaked', true)\n"
+        "rawset(getmetatable(_G).__index, 'leaked_base', true)\n"
+        "setmetatable(_G, {__index = function() return 'meta' end})\n"
+        "return tostring(ok_string) .. tostring(ok_mympd)");
+    ASSERT_STREQ("falsefalse", result);
+    sdsfree(result);
+
+    // second script on the same instance sees nothing of the first one
+    result = run_script(lua_vm,
+        "return tostring(leaked_global) .. tostring(unknown_global) .. "
+        "tostring(string.leaked) .. tostring(mympd.leaked) .. tostring(table.leaked) .. "
+        "tostring(leaked_base) .. tostring(package.loaded.leaked_module)");
+    ASSERT_STREQ("nilnilnilnilnilnilnil", result);
+    sdsfree(result);
+
+    // the libraries are still usable
+    result = run_script(lua_vm,
+        "local t = {}\n"
+        "table.insert(t, string.upper('a'))\n"
+        "return t[1] .. type(mympd)");
+    ASSERT_STREQ("Atable", result);
+    sdsfree(result);
+
+    lua_close(lua_vm);
+}
@@ -10,6 +10,8 @@
 
 #include "dist/utest/utest.h"
 #include "dist/libmympdclient/src/isong.h"
+#include "dist/utf8/utf8.h"
+#include "src/lib/mem.h"
 #include "src/lib/search.h"
 #include "src/mpd_client/tags.h"
 
@@ -69,6 +71,48 @@ UTEST(search_local, test_search_mpd_song_expression) {
     ASSERT_FALSE(search_by_expression("((added-since '2023-11-17'))"));
 }
 
+/**
+ * Compares contains searches over many songs with utf8casestr
+ */
+UTEST(search_local, test_search_contains_many) {
+    const char *values[] = {"Motörhead", "Sigur Rós", "ΣΙΓΜΑ σίγμα", "Пётр Ильич Чайковский"};
+    const char *needles[] = {"NUMBER 1999", "MOTÖ", "rós", "σίγμα", "ЧАЙКОВ", NULL};
+    const unsigned count = 20000;
+    struct t_mpd_tags tags;
+    mpd_tags_reset(&tags);
+    struct mpd_song **songs = malloc_assert(sizeof(struct mpd_song *) * count);
+    for (unsigned i = 0; i < count; i++) {
+        songs[i] = new_song();
+        sds value = sdscatprintf(sdsempty(), "Artist Number %u - %s", i, values[i % 4]);
+        mympd_mpd_song_add_tag_dedup(songs[i], MPD_TAG_GENRE, value);
+        sdsfree(value);
+    }
+    for (unsigned j = 0; needles[j] != NULL; j++) {
+        sds expression = sdscatprintf(sdsempty(), "((Genre contains '%s'))", needles[j]);
+        struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+        unsigned matches = 0;
+        unsigned expected = 0;
+        for (unsigned i = 0; i < count; i++) {
+            if (search_expression_song(songs[i], expr_list, &tags) == true) {
+                matches++;
+            }
+            if (utf8casestr(mpd_song_get_tag(songs[i], MPD_TAG_GENRE, 0), needles[j]) != NULL) {
+                expected++;
+            }
+        }
+        ASSERT_EQ(expected, matches);
+        if (j == 0) {
+            ASSERT_EQ(11U, matches);
+        }
+        free_search_expression_list(expr_list);
+        sdsfree(expression);
+    }
+    for (unsigned i = 0; i < count; i++) {
+        mpd_song_free(songs[i]);
+    }
+    FREE_PTR(songs);
+}
+
 long try_parse(const char *expr) {
     sds expression = sdsnew(expr);
     struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
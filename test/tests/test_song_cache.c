@@ -0,0 +1,149 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "dist/libmympdclient/src/isong.h"
+#include "src/lib/cache_rax_song.h"
+#include "src/lib/search.h"
+#include "src/mpd_client/tags.h"
+
+#include <mpd/client.h>
+#include <sys/stat.h>
+
+static void set_tags(struct t_mpd_tags *tags) {
+    mpd_tags_reset(tags);
+    tags->tags[tags->len++] = MPD_TAG_ARTIST;
+    tags->tags[tags->len++] = MPD_TAG_ALBUM;
+    tags->tags[tags->len++] = MPD_TAG_TITLE;
+    tags->tags[tags->len++] = MPD_TAG_DISC;
+}
+
+static void populate_cache(struct t_cache *song_cache, const struct t_mpd_tags *tags) {
+    cache_init(song_cache);
+    song_cache_init(song_cache);
+    struct mpd_song *song = new_song();
+    song_cache_insert(song_cache, song, tags);
+    free(song->uri);
+    song->uri = strdup("/music/test2.mp3");
+    free(song->tags[MPD_TAG_TITLE].value);
+    song->tags[MPD_TAG_TITLE].value = strdup("Wüste");
+    song_cache_insert(song_cache, song, tags);
+    mpd_song_free(song);
+}
+
+UTEST(song_cache, test_song_cache_insert) {
+    struct t_mpd_tags tags;
+    set_tags(&tags);
+    struct t_cache song_cache;
+    populate_cache(&song_cache, &tags);
+
+    ASSERT_EQ(2U, (unsigned)song_cache.cache->numele);
+    // artists, album and disc are shared, titles are distinct
+    ASSERT_EQ(5U, (unsigned)song_cache.strings->numele);
+
+    // duplicate uri
+    struct mpd_song *song = new_song();
+    ASSERT_FALSE(song_cache_insert(&song_cache, song, &tags));
+    mpd_song_free(song);
+
+    struct t_song_cache_song *s1 = song_cache_get_song(&song_cache, "/music/test.mp3");
+    struct t_song_cache_song *s2 = song_cache_get_song(&song_cache, "/music/test2.mp3");
+    ASSERT_TRUE(s1 != NULL);
+    ASSERT_TRUE(s2 != NULL);
+    ASSERT_TRUE(song_cache_get_song(&song_cache, "/music/notfound.mp3") == NULL);
+    ASSERT_STREQ("Blixa Bargeld", song_cache_get_tag(s1, MPD_TAG_ARTIST, 1));
+    ASSERT_TRUE(song_cache_get_tag(s1, MPD_TAG_ARTIST, 2) == NULL);
+    ASSERT_TRUE(song_cache_get_tag(s1, MPD_TAG_TRACK, 0) == NULL);
+    ASSERT_STREQ("Wüste", song_cache_get_tag(s2, MPD_TAG_TITLE, 0));
+    // interned strings are shared
+    ASSERT_TRUE(song_cache_get_tag(s1, MPD_TAG_ALBUM, 0) == song_cache_get_tag(s2, MPD_TAG_ALBUM, 0));
+    // folded copy of the interned string
+    const struct t_song_cache_string *str = song_cache_get_string(song_cache_get_tag(s2, MPD_TAG_TITLE, 0));
+    ASSERT_STREQ("wüste", str->folded);
+    ASSERT_EQ(strlen("wüste"), str->folded_len);
+    ASSERT_EQ(10U, song_cache_get_duration(s1));
+
+    struct mpd_song *mpd_song = song_cache_to_mpd_song(s1);
+    ASSERT_STREQ("/music/test.mp3", mpd_song_get_uri(mpd_song));
+    ASSERT_STREQ("Einstürzende Neubauten", mpd_song_get_tag(mpd_song, MPD_TAG_ARTIST, 0));
+    ASSERT_EQ(1699304451, mpd_song_get_added(mpd_song));
+    sds key = song_cache_get_sort_key(sdsempty(), SORT_BY_TAG, MPD_TAG_DISC, s1);
+    sds expected = get_sort_key(sdsempty(), SORT_BY_TAG, MPD_TAG_DISC, mpd_song);
+    ASSERT_STREQ(expected, key);
+    sdsfree(key);
+    sdsfree(expected);
+    mpd_song_free(mpd_song);
+
+    song_cache_free(&song_cache);
+    cache_free(&song_cache);
+}
+
+UTEST(song_cache, test_search_expression_cached_song) {
+    struct t_mpd_tags tags;
+    set_tags(&tags);
+    struct t_cache song_cache;
+    populate_cache(&song_cache, &tags);
+    struct t_song_cache_song *song = song_cache_get_song(&song_cache, "/music/test2.mp3");
+
+    const char *expression = "((Title == 'wüste') AND (AlbumArtist == 'Blixa Bargeld'))";
+    struct t_list *expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    ASSERT_TRUE(search_expression_is_complete(expression, expr_list));
+    // AlbumArtist falls back to Artist
+    ASSERT_TRUE(search_expression_cached_song(song, expr_list, &tags, false));
+    // exact match is case-sensitive
+    ASSERT_FALSE(search_expression_cached_song(song, expr_list, &tags, true));
+    free_search_expression_list(expr_list);
+
+    expression = "((Title contains 'WÜS') AND (any contains 'neubau'))";
+    expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    ASSERT_TRUE(search_expression_cached_song(song, expr_list, &tags, false));
+    ASSERT_FALSE(search_expression_cached_song(song, expr_list, &tags, true));
+    free_search_expression_list(expr_list);
+
+    // value containing the separator of the expression parts
+    expression = "((Title == 'a) AND (b'))";
+    expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    ASSERT_FALSE(search_expression_is_complete(expression, expr_list));
+    free_search_expression_list(expr_list);
+
+    expression = "((Title == 'Tabula Rasa') AND (invalid == 'x'))";
+    expr_list = parse_search_expression_to_list(expression, SEARCH_TYPE_SONG);
+    ASSERT_FALSE(search_expression_is_complete(expression, expr_list));
+    ASSERT_FALSE(search_expression_cached_song(song, expr_list, &tags, false));
+    free_search_expression_list(expr_list);
+
+    song_cache_free(&song_cache);
+    cache_free(&song_cache);
+}
+
+UTEST(song_cache, test_song_cache_write_read) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/"DIR_WORK_TAGS, 0770);
+    struct t_mpd_tags tags;
+    set_tags(&tags);
+    struct t_cache song_cache;
+    populate_cache(&song_cache, &tags);
+
+    bool rc = song_cache_write(&song_cache, workdir, &tags, true);
+    ASSERT_TRUE(rc);
+    ASSERT_TRUE(song_cache.cache == NULL);
+    rc = song_cache_read(&song_cache, workdir);
+    ASSERT_TRUE(rc);
+    ASSERT_EQ(2U, (unsigned)song_cache.cache->numele);
+    struct t_song_cache_song *song = song_cache_get_song(&song_cache, "/music/test.mp3");
+    ASSERT_TRUE(song != NULL);
+    ASSERT_STREQ("Blixa Bargeld", song_cache_get_tag(song, MPD_TAG_ARTIST, 1));
+    ASSERT_EQ(1699304451, song->last_modified);
+    ASSERT_EQ(10U, song_cache_get_duration(song));
+
+    song_cache_free(&song_cache);
+    cache_free(&song_cache);
+    ASSERT_TRUE(song_cache_remove(workdir));
+    clean_testenv();
+}
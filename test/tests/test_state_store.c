@@ -0,0 +1,94 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/sds_extras.h"
+#include "src/lib/state_store.h"
+
+UTEST(state_store, test_state_store_defaults) {
+    init_testenv();
+
+    struct t_state_store store;
+    state_store_init(&store);
+    ASSERT_FALSE(state_store_load(&store, workdir, "state"));
+    ASSERT_FALSE(state_store_exists(&store, "test"));
+
+    sds value = state_store_rw_string(&store, "test", "blub", vcb_isalnum, true);
+    ASSERT_STREQ("blub", value);
+    sdsfree(value);
+    ASSERT_TRUE(state_store_exists(&store, "test"));
+    ASSERT_EQ(10, state_store_rw_int(&store, "int", 10, 1, 20, true));
+    ASSERT_EQ(10U, state_store_rw_uint(&store, "uint", 10, 1, 20, true));
+    ASSERT_TRUE(state_store_rw_bool(&store, "bool", true, true));
+    ASSERT_EQ(MPD_TAG_ARTIST, state_store_rw_tag(&store, "tag", MPD_TAG_ARTIST, true));
+    // not written
+    ASSERT_EQ(5, state_store_rw_int(&store, "int_ro", 5, 1, 20, false));
+    ASSERT_FALSE(state_store_exists(&store, "int_ro"));
+    state_store_clear(&store);
+
+    clean_testenv();
+}
+
+UTEST(state_store, test_state_store_save_load) {
+    init_testenv();
+
+    struct t_state_store store;
+    state_store_init(&store);
+    state_store_load(&store, workdir, "state/default");
+    state_store_set(&store, "test", "blub");
+    state_store_set(&store, "int", "15");
+    state_store_set(&store, "invalid", "bl ub");
+    ASSERT_TRUE(store.dirty);
+    ASSERT_TRUE(state_store_save(&store));
+    ASSERT_FALSE(store.dirty);
+    state_store_clear(&store);
+
+    ASSERT_TRUE(testfile_read("/tmp/mympd-test/state/default/"FILENAME_STATE));
+    ASSERT_TRUE(state_store_load(&store, workdir, "state/default"));
+    sds value = state_store_rw_string(&store, "test", "default", vcb_isalnum, true);
+    ASSERT_STREQ("blub", value);
+    sdsfree(value);
+    ASSERT_EQ(15, state_store_rw_int(&store, "int", 10, 1, 20, true));
+    // out of range
+    ASSERT_EQ(10, state_store_rw_int(&store, "int", 10, 1, 12, true));
+    // validation fails
+    value = state_store_rw_string(&store, "invalid", "default", vcb_isalnum, true);
+    ASSERT_STREQ("default", value);
+    sdsfree(value);
+    ASSERT_FALSE(store.dirty);
+    state_store_clear(&store);
+
+    clean_testenv();
+}
+
+UTEST(state_store, test_state_store_import) {
+    init_testenv();
+
+    ASSERT_TRUE(write_data_to_file("/tmp/mympd-test/state/test", "blub\n", 5));
+    struct t_state_store store;
+    state_store_init(&store);
+    ASSERT_FALSE(state_store_load(&store, workdir, "state"));
+    ASSERT_TRUE(state_store_exists(&store, "test"));
+    sds value = state_store_rw_string(&store, "test", "default", vcb_isalnum, true);
+    ASSERT_STREQ("blub", value);
+    sdsfree(value);
+    ASSERT_TRUE(state_store_save(&store));
+    // plain state file is removed after save
+    ASSERT_FALSE(testfile_read("/tmp/mympd-test/state/test"));
+    state_store_clear(&store);
+
+    ASSERT_TRUE(state_store_load(&store, workdir, "state"));
+    value = state_store_rw_string(&store, "test", "default", vcb_isalnum, true);
+    ASSERT_STREQ("blub", value);
+    sdsfree(value);
+    state_store_clear(&store);
+
+    clean_testenv();
+}
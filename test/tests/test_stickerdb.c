@@ -0,0 +1,149 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2024 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/rax/rax.h"
+#include "dist/utest/utest.h"
+#include "src/lib/mem.h"
+#include "src/lib/mympd_state.h"
+#include "src/lib/sticker.h"
+#include "src/mpd_client/stickerdb.h"
+
+/**
+ * Creates a stickerdb state that reads from an empty sticker mirror
+ * and coalesces the writes without a MPD connection
+ */
+static struct t_stickerdb_state *stickerdb_new_test(void) {
+    struct t_stickerdb_state *stickerdb = malloc_assert(sizeof(struct t_stickerdb_state));
+    stickerdb_state_default(stickerdb, NULL);
+    stickerdb->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+    mpd_state_default(stickerdb->mpd_state, NULL);
+    stickerdb->mpd_state->feat.advsticker = false;
+    stickerdb->conn_state = MPD_CONNECTED;
+    stickerdb->mirror_enabled = true;
+    stickerdb->mirror = raxNew();
+    stickerdb->pending = raxNew();
+    return stickerdb;
+}
+
+static void stickerdb_free_test(struct t_stickerdb_state *stickerdb) {
+    stickerdb->conn_state = MPD_DISCONNECTED;
+    mpd_state_free(stickerdb->mpd_state);
+    stickerdb_state_free(stickerdb);
+}
+
+UTEST(stickerdb, test_stickerdb_pending_coalesce) {
+    struct t_stickerdb_state *stickerdb = stickerdb_new_test();
+    const char *uri = "music/song.mp3";
+    const char *play_count = sticker_name_lookup(STICKER_PLAY_COUNT);
+    const char *last_played = sticker_name_lookup(STICKER_LAST_PLAYED);
+
+    ASSERT_TRUE(stickerdb_inc_play_count(stickerdb, STICKER_TYPE_SONG, uri, 100));
+    ASSERT_TRUE(stickerdb_inc_play_count(stickerdb, STICKER_TYPE_SONG, uri, 200));
+    ASSERT_TRUE(stickerdb_inc(stickerdb, STICKER_TYPE_SONG, uri, play_count));
+    // one pending write per sticker
+    ASSERT_EQ(2U, (unsigned)stickerdb->pending->numele);
+
+    // reads include the pending writes
+    ASSERT_EQ(3, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, play_count));
+    ASSERT_EQ(200, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, last_played));
+    struct t_sticker sticker;
+    ASSERT_TRUE(stickerdb_get_all_batch(stickerdb, STICKER_TYPE_SONG, uri, &sticker, false) != NULL);
+    ASSERT_EQ(3, sticker.mympd[STICKER_PLAY_COUNT]);
+    ASSERT_EQ(200, sticker.mympd[STICKER_LAST_PLAYED]);
+    ASSERT_EQ(0, sticker.mympd[STICKER_SKIP_COUNT]);
+    sticker_struct_clear(&sticker);
+
+    // other uris are not affected
+    ASSERT_EQ(0, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, "music/other.mp3", play_count));
+
+    stickerdb_free_test(stickerdb);
+}
+
+UTEST(stickerdb, test_stickerdb_pending_discard) {
+    struct t_stickerdb_state *stickerdb = stickerdb_new_test();
+    const char *uri = "music/song.mp3";
+    const char *play_count = sticker_name_lookup(STICKER_PLAY_COUNT);
+    const char *last_played = sticker_name_lookup(STICKER_LAST_PLAYED);
+
+    ASSERT_TRUE(stickerdb_inc_play_count(stickerdb, STICKER_TYPE_SONG, uri, 100));
+    ASSERT_EQ(2U, (unsigned)stickerdb->pending->numele);
+    // a direct write of the sticker supersedes the pending write
+    stickerdb_pending_discard(stickerdb, STICKER_TYPE_SONG, uri, last_played);
+    ASSERT_EQ(1U, (unsigned)stickerdb->pending->numele);
+    ASSERT_EQ(0, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, last_played));
+    ASSERT_EQ(1, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, play_count));
+    // unknown stickers are ignored
+    stickerdb_pending_discard(stickerdb, STICKER_TYPE_SONG, "music/other.mp3", play_count);
+    ASSERT_EQ(1U, (unsigned)stickerdb->pending->numele);
+
+    stickerdb_free_test(stickerdb);
+}
+
+UTEST(stickerdb, test_stickerdb_pending_stream) {
+    struct t_stickerdb_state *stickerdb = stickerdb_new_test();
+    // stream uris are never written
+    ASSERT_TRUE(stickerdb_inc_skip_count(stickerdb, STICKER_TYPE_SONG, "http://stream"));
+    ASSERT_EQ(0U, (unsigned)stickerdb->pending->numele);
+
+    stickerdb_free_test(stickerdb);
+}
+
+UTEST(stickerdb, test_stickerdb_mirror_update) {
+    struct t_stickerdb_state *stickerdb = stickerdb_new_test();
+    const char *uri = "music/song.mp3";
+    const char *like = sticker_name_lookup(STICKER_LIKE);
+    const char *rating = sticker_name_lookup(STICKER_RATING);
+
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, rating, "8");
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, like, "2");
+    ASSERT_EQ(1U, (unsigned)stickerdb->mirror->numele);
+    ASSERT_EQ(8, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, rating));
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, rating, "4");
+    ASSERT_EQ(4, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, rating));
+
+    // removed stickers are reset to their defaults
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, like, NULL);
+    struct t_sticker sticker;
+    ASSERT_TRUE(stickerdb_get_all_batch(stickerdb, STICKER_TYPE_SONG, uri, &sticker, false) != NULL);
+    ASSERT_EQ(STICKER_LIKE_NEUTRAL, sticker.mympd[STICKER_LIKE]);
+    ASSERT_EQ(4, sticker.mympd[STICKER_RATING]);
+    sticker_struct_clear(&sticker);
+
+    // removing a sticker of an unknown uri does not add it
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, "music/other.mp3", like, NULL);
+    ASSERT_EQ(1U, (unsigned)stickerdb->mirror->numele);
+    // only song stickers are mirrored
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_PLAYLIST, "playlist", rating, "2");
+    ASSERT_EQ(1U, (unsigned)stickerdb->mirror->numele);
+
+    stickerdb_free_test(stickerdb);
+}
+
+UTEST(stickerdb, test_stickerdb_mirror_update_user_defined) {
+    struct t_stickerdb_state *stickerdb = stickerdb_new_test();
+    const char *uri = "music/song.mp3";
+
+    // user defined stickers are only mirrored with advanced sticker support
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, "mood", "5");
+    ASSERT_EQ(0U, (unsigned)stickerdb->mirror->numele);
+
+    stickerdb->mirror_user_defined = true;
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, "mood", "5");
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, "mood", "6");
+    struct t_sticker sticker;
+    ASSERT_TRUE(stickerdb_get_all_batch(stickerdb, STICKER_TYPE_SONG, uri, &sticker, true) != NULL);
+    ASSERT_EQ(1U, sticker.user.length);
+    ASSERT_STREQ("6", sticker.user.head->value_p);
+    sticker_struct_clear(&sticker);
+
+    stickerdb_mirror_update(stickerdb, STICKER_TYPE_SONG, uri, "mood", NULL);
+    ASSERT_EQ(0, stickerdb_get_int64_batch(stickerdb, STICKER_TYPE_SONG, uri, "mood"));
+
+    stickerdb_free_test(stickerdb);
+}
@@ -8,14 +8,17 @@
 #include "utility.h"
 
 #include "dist/utest/utest.h"
+#include "src/lib/timer.h"
 #include "src/mympd_api/timer.h"
 #include "src/mympd_api/timer_handlers.h"
 
 #include <sys/stat.h>
 
 UTEST(timer, test_timer_add_replace_remove) {
+    struct t_timer_heap heap;
+    mympd_timer_heap_init(&heap);
     struct t_timer_list l;
-    mympd_api_timer_timerlist_init(&l);
+    mympd_api_timer_timerlist_init(&l, &heap);
     ASSERT_EQ((unsigned)USER_TIMER_ID_START, l.last_id);
 
     bool rc = mympd_api_timer_add(&l, 10, 0, timer_handler_by_id, TIMER_ID_DISK_CACHE_CROP, NULL);
@@ -26,20 +29,73 @@ UTEST(timer, test_timer_add_replace_remove) {
     mympd_api_timer_add(&l, 10, 0, timer_handler_by_id, TIMER_ID_SMARTPLS_UPDATE, NULL);
     mympd_api_timer_add(&l, 10, 0, timer_handler_by_id, TIMER_ID_CACHES_CREATE, NULL);
     ASSERT_EQ(3U, l.list.length);
+    ASSERT_EQ(3U, heap.len);
     
     rc = mympd_api_timer_replace(&l, 10, 0, timer_handler_by_id, TIMER_ID_CACHES_CREATE, NULL);
     ASSERT_TRUE(rc);
     ASSERT_EQ(3U, l.list.length);
+    ASSERT_EQ(3U, heap.len);
     
     mympd_api_timer_remove(&l, TIMER_ID_CACHES_CREATE);
     ASSERT_EQ(2U, l.list.length);
+    ASSERT_EQ(2U, heap.len);
 
     mympd_api_timer_timerlist_clear(&l);
+    mympd_timer_heap_clear(&heap);
+}
+
+UTEST(timer, test_timer_heap) {
+    struct t_timer_heap heap;
+    mympd_timer_heap_init(&heap);
+    ASSERT_NE(-1, heap.fd);
+
+    struct t_timer_entry timers[5];
+    int timeouts[5] = {30, 10, 50, 20, 40};
+    for (int i = 0; i < 5; i++) {
+        mympd_timer_entry_init(&timers[i], &heap, PFD_TYPE_TIMER, NULL, NULL);
+        ASSERT_TRUE(mympd_timer_entry_set(&timers[i], timeouts[i], 0));
+    }
+    ASSERT_EQ(5U, heap.len);
+    ASSERT_TRUE(mympd_timer_heap_arm(&heap));
+    ASSERT_EQ(timers[1].expires, heap.armed);
+
+    // cancel the timer with the earliest expiration
+    mympd_timer_entry_cancel(&timers[1]);
+    ASSERT_EQ(4U, heap.len);
+    ASSERT_EQ(TIMER_HEAP_POS_NONE, timers[1].pos);
+    // reschedule as interval timer
+    ASSERT_TRUE(mympd_timer_entry_set(&timers[2], 5, 60));
+
+    // nothing is expired yet
+    int64_t now = mympd_timer_now();
+    ASSERT_TRUE(mympd_timer_heap_next_expired(&heap, now) == NULL);
+
+    // timers expire in order of their expiration time
+    now += 45LL * 1000000000LL;
+    ASSERT_TRUE(mympd_timer_heap_next_expired(&heap, now) == &timers[2]);
+    ASSERT_TRUE(mympd_timer_heap_next_expired(&heap, now) == &timers[3]);
+    ASSERT_TRUE(mympd_timer_heap_next_expired(&heap, now) == &timers[0]);
+    ASSERT_TRUE(mympd_timer_heap_next_expired(&heap, now) == &timers[4]);
+    ASSERT_TRUE(mympd_timer_heap_next_expired(&heap, now) == NULL);
+    // the interval timer is rescheduled
+    ASSERT_EQ(1U, heap.len);
+    ASSERT_EQ(0U, timers[2].pos);
+    ASSERT_EQ(TIMER_HEAP_POS_NONE, timers[0].pos);
+
+    // timer is disabled without heap
+    struct t_timer_entry disabled;
+    mympd_timer_entry_init(&disabled, NULL, PFD_TYPE_TIMER_JUKEBOX, NULL, NULL);
+    ASSERT_FALSE(mympd_timer_entry_set(&disabled, 10, 0));
+
+    mympd_timer_heap_clear(&heap);
+    ASSERT_EQ(TIMER_HEAP_POS_NONE, timers[2].pos);
 }
 
 UTEST(timer, test_timer_parse_definition) {
+    struct t_timer_heap heap;
+    mympd_timer_heap_init(&heap);
     struct t_timer_list l;
-    mympd_api_timer_timerlist_init(&l);
+    mympd_api_timer_timerlist_init(&l, &heap);
     sds e = sdsempty();
     sds s1 = sdsnew("{\"params\":{\"partition\":\"default\",\"timerid\":103,\"name\":\"example timer1\",\"interval\":86400,\"enabled\":true,\"startHour\":7,\"startMinute\":0,\"action\":\"player\",\"subaction\":\"startplay\",\"playlist\":\"test\",\"volume\":50,\"preset\":\"\",\"weekdays\":[false,false,false,false,false,true,true],\"arguments\": {\"arg1\":\"value1\"}}}");
     struct t_jsonrpc_parse_error parse_error;
@@ -69,14 +125,17 @@ UTEST(timer, test_timer_parse_definition) {
     sdsfree(s1);
     sdsfree(s2);
     mympd_api_timer_timerlist_clear(&l);
+    mympd_timer_heap_clear(&heap);
     jsonrpc_parse_error_clear(&parse_error);
 }
 
 UTEST(timer, test_timer_write_read) {
     init_testenv();
 
+    struct t_timer_heap heap;
+    mympd_timer_heap_init(&heap);
     struct t_timer_list l;
-    mympd_api_timer_timerlist_init(&l);
+    mympd_api_timer_timerlist_init(&l, &heap);
     sds s1 = sdsnew("{\"params\":{\"partition\":\"default\",\"timerid\":103,\"name\":\"example timer1\",\"interval\":86400,\"enabled\":true,\"startHour\":7,\"startMinute\":0,\"action\":\"player\",\"subaction\":\"startplay\",\"playlist\":\"\",\"volume\":50,\"preset\":\"test-preset\",\"weekdays\":[false,false,false,false,false,true,true],\"arguments\": {\"arg1\":\"value1\"}}}");
     struct t_jsonrpc_parse_error parse_error;
     jsonrpc_parse_error_init(&parse_error);
@@ -88,7 +147,11 @@ UTEST(timer, test_timer_write_read) {
     rc = mympd_api_timer_file_save(&l, workdir);
     ASSERT_TRUE(rc);
     mympd_api_timer_timerlist_clear(&l);
+    mympd_timer_heap_clear(&heap);
 
+    //the cleared heap has no timerfd
+    mympd_timer_heap_init(&heap);
+    ASSERT_TRUE(heap.fd > -1);
     rc = mympd_api_timer_file_read(&l, workdir);
     ASSERT_EQ(1U, l.list.length);
     ASSERT_TRUE(rc);
@@ -96,6 +159,7 @@ UTEST(timer, test_timer_write_read) {
     ASSERT_STREQ("example timer1", timer_node->definition->name);
 
     mympd_api_timer_timerlist_clear(&l);
+    mympd_timer_heap_clear(&heap);
     sdsfree(s1);
 
     clean_testenv();